@@ -47,6 +47,7 @@
 #include "libavutil/avstring.h"
 #include "libavutil/libm.h"
 #include "libavutil/imgutils.h"
+#include "libavutil/slicepool.h"
 #include "libavutil/time.h"
 #include "libavformat/os_support.h"
 
@@ -140,6 +141,60 @@ static int decode_interrupt_cb(void *ctx)
 
 const AVIOInterruptCB int_cb = { decode_interrupt_cb, NULL };
 
+/* what the -vstats log reports for a video packet */
+typedef struct VideoStats {
+    int frame_number;
+    int64_t sync_opts;
+    int pict_type;
+    uint64_t error[3];
+} VideoStats;
+
+#if HAVE_PTHREADS
+/* a packet queued by an encoder thread */
+typedef struct EncoderPacket {
+    AVPacket pkt;
+    int flushed;            /* returned while draining the encoder */
+    VideoStats stats;       /* the state of the encoder when it returned pkt */
+} EncoderPacket;
+
+/*
+ * Stop the encoder thread of ost without draining the encoder and free the
+ * queued frames and packets.
+ */
+static void free_encoder_thread(OutputStream *ost)
+{
+    AVFrame *frame;
+    EncoderPacket ep;
+
+    if (ost->enc_thread_started) {
+        pthread_mutex_lock(&ost->enc_lock);
+        ost->enc_abort = 1;
+        pthread_cond_broadcast(&ost->enc_cond);
+        pthread_mutex_unlock(&ost->enc_lock);
+
+        pthread_join(ost->enc_thread, NULL);
+        ost->enc_thread_started = 0;
+    }
+
+    if (ost->enc_frames) {
+        while (av_fifo_size(ost->enc_frames)) {
+            av_fifo_generic_read(ost->enc_frames, &frame, sizeof(frame), NULL);
+            av_frame_free(&frame);
+        }
+        av_fifo_free(ost->enc_frames);
+        ost->enc_frames = NULL;
+    }
+    if (ost->enc_packets) {
+        while (av_fifo_size(ost->enc_packets)) {
+            av_fifo_generic_read(ost->enc_packets, &ep, sizeof(ep), NULL);
+            av_packet_unref(&ep.pkt);
+        }
+        av_fifo_free(ost->enc_packets);
+        ost->enc_packets = NULL;
+    }
+}
+#endif
+
 static void avconv_cleanup(int ret)
 {
     int i, j;
@@ -188,6 +243,10 @@ static void avconv_cleanup(int ret)
     for (i = 0; i < nb_output_streams; i++) {
         OutputStream *ost = output_streams[i];
 
+#if HAVE_PTHREADS
+        free_encoder_thread(ost);
+#endif
+
         for (j = 0; j < ost->nb_bitstream_filters; j++)
             av_bsf_free(&ost->bsf_ctx[j]);
         av_freep(&ost->bsf_ctx);
@@ -240,6 +299,8 @@ static void avconv_cleanup(int ret)
     av_freep(&output_streams);
     av_freep(&output_files);
 
+    av_slice_pool_uninit();
+
     uninit_opts();
 
     avformat_network_deinit();
@@ -422,6 +483,177 @@ static int check_recording_time(OutputStream *ost)
     return 1;
 }
 
+/*
+ * Get the type and the error of the frame enc has just coded.
+ */
+static void get_coded_frame_stats(AVCodecContext *enc, VideoStats *stats)
+{
+    stats->pict_type = 0;
+    memset(stats->error, 0, sizeof(stats->error));
+#if FF_API_CODED_FRAME
+FF_DISABLE_DEPRECATION_WARNINGS
+    stats->pict_type = enc->coded_frame->pict_type;
+#if FF_API_ERROR_FRAME
+    memcpy(stats->error, enc->coded_frame->error, sizeof(stats->error));
+#endif
+FF_ENABLE_DEPRECATION_WARNINGS
+#endif
+}
+
+#if HAVE_PTHREADS
+/*
+ * Encode the frames queued by the main thread and queue the packets for it to
+ * write, until the encoder is drained or fails.
+ *
+ * The frame number and sync_opts of the packets are counted here as
+ * do_video_out() counts them without a thread, by the packets returned after
+ * each frame.
+ */
+static void *encoder_thread(void *arg)
+{
+    OutputStream   *ost = arg;
+    AVCodecContext *enc = ost->enc_ctx;
+    AVFrame *frame;
+    EncoderPacket ep = { { 0 } };
+    int64_t sync_opts = 0;
+    int frame_number = 0, flushing;
+    int ret = 0;
+
+    while (1) {
+        pthread_mutex_lock(&ost->enc_lock);
+        while (!av_fifo_size(ost->enc_frames) && !ost->enc_abort)
+            pthread_cond_wait(&ost->enc_cond, &ost->enc_lock);
+        if (ost->enc_abort) {
+            pthread_mutex_unlock(&ost->enc_lock);
+            break;
+        }
+        av_fifo_generic_read(ost->enc_frames, &frame, sizeof(frame), NULL);
+        ost->enc_busy = 1;
+        pthread_cond_broadcast(&ost->enc_cond);
+        pthread_mutex_unlock(&ost->enc_lock);
+
+        /* flush_encoders() does not drain these either */
+        if (!frame && enc->codec_type == AVMEDIA_TYPE_AUDIO && enc->frame_size <= 1)
+            break;
+
+        flushing = !frame;
+        if (frame)
+            sync_opts = frame->pts;
+        if (frame && enc->codec_type == AVMEDIA_TYPE_VIDEO && !ost->frame_aspect_ratio)
+            enc->sample_aspect_ratio = frame->sample_aspect_ratio;
+
+        ret = avcodec_send_frame(enc, frame);
+        av_frame_free(&frame);
+        if (ret < 0)
+            break;
+        if (!flushing)
+            frame_number++;
+
+        while (1) {
+            av_init_packet(&ep.pkt);
+            ep.pkt.data = NULL;
+            ep.pkt.size = 0;
+
+            ret = avcodec_receive_packet(enc, &ep.pkt);
+            if (ret < 0)
+                break;
+
+            /* if two pass, output log */
+            if (ost->logfile && enc->stats_out)
+                fprintf(ost->logfile, "%s", enc->stats_out);
+
+            if (!flushing)
+                sync_opts++;
+            ep.flushed            = flushing;
+            ep.stats.frame_number = frame_number;
+            ep.stats.sync_opts    = sync_opts;
+            if (enc->codec_type == AVMEDIA_TYPE_VIDEO)
+                get_coded_frame_stats(enc, &ep.stats);
+
+            pthread_mutex_lock(&ost->enc_lock);
+            if (!av_fifo_space(ost->enc_packets))
+                ret = av_fifo_realloc2(ost->enc_packets,
+                                       2 * av_fifo_size(ost->enc_packets));
+            if (ret >= 0)
+                av_fifo_generic_write(ost->enc_packets, &ep, sizeof(ep), NULL);
+            pthread_mutex_unlock(&ost->enc_lock);
+
+            if (ret < 0) {
+                av_packet_unref(&ep.pkt);
+                break;
+            }
+        }
+        if (ret == AVERROR_EOF) {
+            ret = 0;
+            break;
+        } else if (ret != AVERROR(EAGAIN))
+            break;
+        ret = 0;
+
+        pthread_mutex_lock(&ost->enc_lock);
+        ost->enc_busy = 0;
+        pthread_cond_broadcast(&ost->enc_cond);
+        pthread_mutex_unlock(&ost->enc_lock);
+    }
+
+    pthread_mutex_lock(&ost->enc_lock);
+    ost->enc_error    = ret;
+    ost->enc_busy     = 0;
+    ost->enc_finished = 1;
+    pthread_cond_broadcast(&ost->enc_cond);
+    pthread_mutex_unlock(&ost->enc_lock);
+
+    return NULL;
+}
+
+/*
+ * Pass a frame, or EOF if frame is NULL, to the encoder thread of ost. Blocks
+ * while its queue is full. The frame is moved, not copied.
+ */
+static void encoder_thread_send_frame(OutputStream *ost, AVFrame *frame)
+{
+    AVFrame *tmp = NULL;
+    int finished;
+
+    if (frame) {
+        tmp = av_frame_alloc();
+        if (!tmp)
+            exit_program(1);
+        av_frame_move_ref(tmp, frame);
+    }
+
+    pthread_mutex_lock(&ost->enc_lock);
+    while (!av_fifo_space(ost->enc_frames) && !ost->enc_finished)
+        pthread_cond_wait(&ost->enc_cond, &ost->enc_lock);
+    /* if the thread failed, the error is reported with its packets */
+    finished = ost->enc_finished;
+    if (!finished) {
+        av_fifo_generic_write(ost->enc_frames, &tmp, sizeof(tmp), NULL);
+        pthread_cond_broadcast(&ost->enc_cond);
+    }
+    pthread_mutex_unlock(&ost->enc_lock);
+
+    if (finished)
+        av_frame_free(&tmp);
+}
+
+static void output_encoded_packets(OutputStream *ost);
+
+/*
+ * Wait for the encoder thread of ost to encode the queued frames and write
+ * their packets, which brings sync_opts up to date.
+ */
+static void sync_encoder_thread(OutputStream *ost)
+{
+    pthread_mutex_lock(&ost->enc_lock);
+    while ((av_fifo_size(ost->enc_frames) || ost->enc_busy) && !ost->enc_finished)
+        pthread_cond_wait(&ost->enc_cond, &ost->enc_lock);
+    pthread_mutex_unlock(&ost->enc_lock);
+
+    output_encoded_packets(ost);
+}
+#endif
+
 static void do_audio_out(OutputFile *of, OutputStream *ost,
                          AVFrame *frame)
 {
@@ -440,6 +672,13 @@ static void do_audio_out(OutputFile *of, OutputStream *ost,
     ost->samples_encoded += frame->nb_samples;
     ost->frames_encoded++;
 
+#if HAVE_PTHREADS
+    if (ost->enc_thread_started) {
+        encoder_thread_send_frame(ost, frame);
+        return;
+    }
+#endif
+
     ret = avcodec_send_frame(enc, frame);
     if (ret < 0)
         goto error;
@@ -544,6 +783,16 @@ static void do_video_out(OutputFile *of,
     if (format_video_sync == VSYNC_AUTO)
         format_video_sync = (of->ctx->oformat->flags & AVFMT_NOTIMESTAMPS) ? VSYNC_PASSTHROUGH :
                             (of->ctx->oformat->flags & AVFMT_VARIABLE_FPS) ? VSYNC_VFR : VSYNC_CFR;
+#if HAVE_PTHREADS
+    /*
+     * sync_opts only advances once the packets of the previous frame are
+     * back. Encoders return at most one packet per frame, so only a frame
+     * without a pts or at sync_opts depends on those still being encoded.
+     */
+    if (ost->enc_thread_started && ost->frame_number &&
+        (in_picture->pts == AV_NOPTS_VALUE || in_picture->pts == ost->sync_opts))
+        sync_encoder_thread(ost);
+#endif
     if (format_video_sync != VSYNC_PASSTHROUGH &&
         ost->frame_number &&
         in_picture->pts != AV_NOPTS_VALUE &&
@@ -584,6 +833,15 @@ static void do_video_out(OutputFile *of,
 
     ost->frames_encoded++;
 
+#if HAVE_PTHREADS
+    if (ost->enc_thread_started) {
+        /* sync_opts is advanced as the packets come back */
+        ost->frame_number++;
+        encoder_thread_send_frame(ost, in_picture);
+        return;
+    }
+#endif
+
     ret = avcodec_send_frame(enc, in_picture);
     if (ret < 0)
         goto error;
@@ -601,8 +859,8 @@ static void do_video_out(OutputFile *of,
         if (ret < 0)
             goto error;
 
-        output_packet(of, &pkt, ost, 0);
         *frame_size = pkt.size;
+        output_packet(of, &pkt, ost, 0);
 
         /* if two pass, output log */
         if (ost->logfile && enc->stats_out) {
@@ -626,10 +884,10 @@ static double psnr(double d)
 }
 #endif
 
-static void do_video_stats(OutputStream *ost, int frame_size)
+static void do_video_stats(OutputStream *ost, int frame_size,
+                           const VideoStats *stats)
 {
     AVCodecContext *enc;
-    int frame_number;
     double ti1, bitrate, avg_bitrate;
 
     /* this is executed just the first time do_video_stats is called */
@@ -643,20 +901,17 @@ static void do_video_stats(OutputStream *ost, int frame_size)
 
     enc = ost->enc_ctx;
     if (enc->codec_type == AVMEDIA_TYPE_VIDEO) {
-        frame_number = ost->frame_number;
-        fprintf(vstats_file, "frame= %5d q= %2.1f ", frame_number,
+        fprintf(vstats_file, "frame= %5d q= %2.1f ", stats->frame_number,
                 ost->quality / (float)FF_QP2LAMBDA);
 
 #if FF_API_CODED_FRAME && FF_API_ERROR_FRAME
-FF_DISABLE_DEPRECATION_WARNINGS
         if (enc->flags & AV_CODEC_FLAG_PSNR)
-            fprintf(vstats_file, "PSNR= %6.2f ", psnr(enc->coded_frame->error[0] / (enc->width * enc->height * 255.0 * 255.0)));
-FF_ENABLE_DEPRECATION_WARNINGS
+            fprintf(vstats_file, "PSNR= %6.2f ", psnr(stats->error[0] / (enc->width * enc->height * 255.0 * 255.0)));
 #endif
 
         fprintf(vstats_file,"f_size= %6d ", frame_size);
         /* compute pts value */
-        ti1 = ost->sync_opts * av_q2d(enc->time_base);
+        ti1 = stats->sync_opts * av_q2d(enc->time_base);
         if (ti1 < 0.01)
             ti1 = 0.01;
 
@@ -665,13 +920,83 @@ FF_ENABLE_DEPRECATION_WARNINGS
         fprintf(vstats_file, "s_size= %8.0fkB time= %0.3f br= %7.1fkbits/s avg_br= %7.1fkbits/s ",
                (double)ost->data_size / 1024, ti1, bitrate, avg_bitrate);
 #if FF_API_CODED_FRAME
-FF_DISABLE_DEPRECATION_WARNINGS
-        fprintf(vstats_file, "type= %c\n", av_get_picture_type_char(enc->coded_frame->pict_type));
-FF_ENABLE_DEPRECATION_WARNINGS
+        fprintf(vstats_file, "type= %c\n", av_get_picture_type_char(stats->pict_type));
 #endif
     }
 }
 
+#if HAVE_PTHREADS
+/*
+ * Write the packets the encoder thread of ost has produced so far.
+ */
+static void output_encoded_packets(OutputStream *ost)
+{
+    OutputFile *of = output_files[ost->file_index];
+    int video = ost->enc_ctx->codec_type == AVMEDIA_TYPE_VIDEO;
+    EncoderPacket ep;
+    int frame_size, ret;
+
+    pthread_mutex_lock(&ost->enc_lock);
+    while (av_fifo_size(ost->enc_packets)) {
+        av_fifo_generic_read(ost->enc_packets, &ep, sizeof(ep), NULL);
+        /* the packets of older frames do not move it back */
+        if (video && !ep.flushed) {
+            ost->sync_opts = FFMAX(ost->sync_opts, ep.stats.sync_opts);
+            memcpy(ost->coded_error, ep.stats.error, sizeof(ost->coded_error));
+        }
+        pthread_mutex_unlock(&ost->enc_lock);
+
+        frame_size = ep.pkt.size;
+        output_packet(of, &ep.pkt, ost, 0);
+        if (video && !ep.flushed && vstats_filename && frame_size)
+            do_video_stats(ost, frame_size, &ep.stats);
+
+        pthread_mutex_lock(&ost->enc_lock);
+    }
+    ret = ost->enc_error;
+    pthread_mutex_unlock(&ost->enc_lock);
+
+    if (ret < 0) {
+        av_log(NULL, AV_LOG_FATAL, "%s encoding failed\n",
+               ost->enc_ctx->codec_type == AVMEDIA_TYPE_VIDEO ? "Video" : "Audio");
+        exit_program(1);
+    }
+}
+
+static int init_encoder_thread(OutputStream *ost)
+{
+    int ret;
+
+    ost->enc_frames  = av_fifo_alloc(enc_queue_size * sizeof(AVFrame *));
+    ost->enc_packets = av_fifo_alloc(8 * sizeof(EncoderPacket));
+    if (!ost->enc_frames || !ost->enc_packets)
+        return AVERROR(ENOMEM);
+
+    pthread_mutex_init(&ost->enc_lock, NULL);
+    pthread_cond_init (&ost->enc_cond, NULL);
+
+    if ((ret = pthread_create(&ost->enc_thread, NULL, encoder_thread, ost)))
+        return AVERROR(ret);
+    ost->enc_thread_started = 1;
+
+    return 0;
+}
+
+/*
+ * Send EOF to the encoder thread of ost, wait for it to drain the encoder and
+ * write the remaining packets.
+ */
+static void finish_encoder_thread(OutputStream *ost)
+{
+    encoder_thread_send_frame(ost, NULL);
+    pthread_join(ost->enc_thread, NULL);
+    ost->enc_thread_started = 0;
+
+    output_encoded_packets(ost);
+}
+
+#endif
+
 static int init_output_stream(OutputStream *ost, char *error, int error_len);
 
 /*
@@ -698,6 +1023,17 @@ static int poll_filter(OutputStream *ost)
         }
     }
 
+#if HAVE_PTHREADS
+    if (enc_queue_size > 0 && !ost->enc_frames) {
+        ret = init_encoder_thread(ost);
+        if (ret < 0) {
+            av_log(NULL, AV_LOG_ERROR, "Error starting the encoder thread for "
+                   "output stream %d:%d\n", ost->file_index, ost->index);
+            exit_program(1);
+        }
+    }
+#endif
+
     if (ost->enc->type == AVMEDIA_TYPE_AUDIO &&
         !(ost->enc->capabilities & AV_CODEC_CAP_VARIABLE_FRAME_SIZE))
         ret = av_buffersink_get_samples(ost->filter->filter, filtered_frame,
@@ -720,12 +1056,21 @@ static int poll_filter(OutputStream *ost)
 
     switch (ost->filter->filter->inputs[0]->type) {
     case AVMEDIA_TYPE_VIDEO:
+        /* with an encoder thread, it sets the aspect ratio itself */
+#if HAVE_PTHREADS
+        if (!ost->frame_aspect_ratio && !ost->enc_thread_started)
+#else
         if (!ost->frame_aspect_ratio)
+#endif
             ost->enc_ctx->sample_aspect_ratio = filtered_frame->sample_aspect_ratio;
 
         do_video_out(of, ost, filtered_frame, &frame_size);
-        if (vstats_filename && frame_size)
-            do_video_stats(ost, frame_size);
+        if (vstats_filename && frame_size) {
+            VideoStats stats = { ost->frame_number, ost->sync_opts };
+
+            get_coded_frame_stats(ost->enc_ctx, &stats);
+            do_video_stats(ost, frame_size, &stats);
+        }
         break;
     case AVMEDIA_TYPE_AUDIO:
         do_audio_out(of, ost, filtered_frame);
@@ -765,6 +1110,12 @@ static int poll_filters(void)
 {
     int i, ret = 0;
 
+#if HAVE_PTHREADS
+    for (i = 0; i < nb_output_streams; i++)
+        if (output_streams[i]->enc_thread_started)
+            output_encoded_packets(output_streams[i]);
+#endif
+
     while (ret >= 0 && !received_sigterm) {
         OutputStream *ost = NULL;
         int64_t min_pts = INT64_MAX;
@@ -998,6 +1349,12 @@ FF_DISABLE_DEPRECATION_WARNINGS
                         error = enc->error[j];
                         scale = enc->width * enc->height * 255.0 * 255.0 * frame_number;
                     } else {
+#if HAVE_PTHREADS
+                        /* the thread may be coding the next frame */
+                        if (ost->enc_thread_started)
+                            error = ost->coded_error[j];
+                        else
+#endif
                         error = enc->coded_frame->error[j];
                         scale = enc->width * enc->height * 255.0 * 255.0;
                     }
@@ -1048,17 +1405,36 @@ static void flush_encoders(void)
         OutputStream   *ost = output_streams[i];
         AVCodecContext *enc = ost->enc_ctx;
         OutputFile      *of = output_files[ost->file_index];
-        int stop_encoding = 0;
+        int stop_encoding = 0, threaded = 0;
 
         if (!ost->encoding_needed)
             continue;
 
+#if HAVE_PTHREADS
+        if (ost->enc_thread_started) {
+            /* the thread drains the encoder itself */
+            finish_encoder_thread(ost);
+            threaded = 1;
+        }
+#endif
+
         if (enc->codec_type == AVMEDIA_TYPE_AUDIO && enc->frame_size <= 1)
             continue;
 
         if (enc->codec_type != AVMEDIA_TYPE_VIDEO && enc->codec_type != AVMEDIA_TYPE_AUDIO)
             continue;
 
+        if (threaded) {
+            AVPacket pkt;
+            av_init_packet(&pkt);
+            pkt.data = NULL;
+            pkt.size = 0;
+
+            /* flush the bitstream filters */
+            output_packet(of, &pkt, ost, 1);
+            continue;
+        }
+
         avcodec_send_frame(enc, NULL);
 
         for (;;) {
@@ -2380,6 +2756,39 @@ static InputFile *select_input_file(void)
 }
 
 #if HAVE_PTHREADS
+/*
+ * Whether the read-ahead limits of f are reached. Called from the reading
+ * thread with fifo_lock held. Without limits, up to 8 packets are read ahead.
+ */
+static int input_fifo_full(InputFile *f)
+{
+    const AVPacket *first;
+    int64_t first_dts;
+
+    if (!f->read_ahead_size && !f->read_ahead_time)
+        return !av_fifo_space(f->fifo);
+
+    /* always allow one packet, however big */
+    if (!av_fifo_size(f->fifo))
+        return 0;
+
+    if (f->read_ahead_size && f->fifo_bytes >= f->read_ahead_size)
+        return 1;
+
+    if (f->read_ahead_time) {
+        first = (const AVPacket *)av_fifo_peek2(f->fifo, 0);
+        if (first->dts != AV_NOPTS_VALUE && f->fifo_last_dts != AV_NOPTS_VALUE) {
+            first_dts = av_rescale_q(first->dts,
+                                     f->ctx->streams[first->stream_index]->time_base,
+                                     AV_TIME_BASE_Q);
+            if (f->fifo_last_dts - first_dts >= f->read_ahead_time)
+                return 1;
+        }
+    }
+
+    return 0;
+}
+
 static void *input_thread(void *arg)
 {
     InputFile *f = arg;
@@ -2397,10 +2806,21 @@ static void *input_thread(void *arg)
             break;
 
         pthread_mutex_lock(&f->fifo_lock);
-        while (!av_fifo_space(f->fifo))
+        while (input_fifo_full(f))
             pthread_cond_wait(&f->fifo_cond, &f->fifo_lock);
 
-        av_fifo_generic_write(f->fifo, &pkt, sizeof(pkt), NULL);
+        /* with read-ahead limits, the fifo grows until they are reached */
+        if (!av_fifo_space(f->fifo))
+            ret = av_fifo_realloc2(f->fifo, 2 * av_fifo_size(f->fifo));
+        if (ret >= 0) {
+            av_fifo_generic_write(f->fifo, &pkt, sizeof(pkt), NULL);
+            f->fifo_bytes += pkt.size;
+            if (pkt.dts != AV_NOPTS_VALUE)
+                f->fifo_last_dts = av_rescale_q(pkt.dts,
+                                                f->ctx->streams[pkt.stream_index]->time_base,
+                                                AV_TIME_BASE_Q);
+        } else
+            av_packet_unref(&pkt);
 
         pthread_mutex_unlock(&f->fifo_lock);
     }
@@ -2413,9 +2833,6 @@ static void free_input_threads(void)
 {
     int i;
 
-    if (nb_input_files == 1)
-        return;
-
     transcoding_finished = 1;
 
     for (i = 0; i < nb_input_files; i++) {
@@ -2441,6 +2858,7 @@ static void free_input_threads(void)
             av_packet_unref(&pkt);
         }
         av_fifo_free(f->fifo);
+        f->fifo = NULL;
     }
 }
 
@@ -2448,14 +2866,18 @@ static int init_input_threads(void)
 {
     int i, ret;
 
-    if (nb_input_files == 1)
-        return 0;
-
     for (i = 0; i < nb_input_files; i++) {
         InputFile *f = input_files[i];
 
+        /* a single input is only read on its own thread if read-ahead is
+         * requested; looping seeks from the main thread, so it is never */
+        if ((nb_input_files == 1 && !f->read_ahead_size && !f->read_ahead_time) ||
+            f->loop)
+            continue;
+
         if (!(f->fifo = av_fifo_alloc(8*sizeof(AVPacket))))
             return AVERROR(ENOMEM);
+        f->fifo_last_dts = AV_NOPTS_VALUE;
 
         pthread_mutex_init(&f->fifo_lock, NULL);
         pthread_cond_init (&f->fifo_cond, NULL);
@@ -2474,6 +2896,7 @@ static int get_input_packet_mt(InputFile *f, AVPacket *pkt)
 
     if (av_fifo_size(f->fifo)) {
         av_fifo_generic_read(f->fifo, pkt, sizeof(*pkt), NULL);
+        f->fifo_bytes -= pkt->size;
         pthread_cond_signal(&f->fifo_cond);
     } else {
         if (f->finished)
@@ -2502,7 +2925,7 @@ static int get_input_packet(InputFile *f, AVPacket *pkt)
     }
 
 #if HAVE_PTHREADS
-    if (nb_input_files > 1)
+    if (f->fifo)
         return get_input_packet_mt(f, pkt);
 #endif
     return av_read_frame(f->ctx, pkt);
@@ -112,6 +112,8 @@ typedef struct OptionsContext {
     int loop;
     int rate_emu;
     int accurate_seek;
+    int64_t read_ahead_size;
+    int64_t read_ahead_time;
 
     SpecifierOpt *ts_scale;
     int        nb_ts_scale;
@@ -335,6 +337,8 @@ typedef struct InputFile {
                              from ctx.nb_streams if new streams appear during av_read_frame() */
     int rate_emu;
     int accurate_seek;
+    int64_t read_ahead_size;    /* max bytes of packets read ahead by the thread, 0 for no limit */
+    int64_t read_ahead_time;    /* max duration of packets read ahead by the thread, 0 for no limit */
 
 #if HAVE_PTHREADS
     pthread_t thread;           /* thread reading from this file */
@@ -343,6 +347,8 @@ typedef struct InputFile {
     pthread_mutex_t fifo_lock;  /* lock for access to fifo */
     pthread_cond_t  fifo_cond;  /* the main thread will signal on this cond after reading from fifo */
     AVFifoBuffer *fifo;         /* demuxed packets are stored here; freed by the main thread */
+    int64_t fifo_bytes;         /* size of the packets in fifo */
+    int64_t fifo_last_dts;      /* dts of the last packet written to fifo, in AV_TIME_BASE */
 #endif
 } InputFile;
 
@@ -433,6 +439,20 @@ typedef struct OutputStream {
 
     /* the packets are buffered here until the muxer is ready to be initialized */
     AVFifoBuffer *muxing_queue;
+
+#if HAVE_PTHREADS
+    pthread_t enc_thread;           /* thread running the encoder, with -enc_queue_size */
+    int enc_thread_started;         /* the thread has been created and not joined yet */
+    pthread_mutex_t enc_lock;       /* lock for access to the queues and the flags below */
+    pthread_cond_t  enc_cond;       /* signaled whenever one of the queues changes */
+    AVFifoBuffer *enc_frames;       /* filtered frames to encode, a NULL frame signals EOF */
+    AVFifoBuffer *enc_packets;      /* encoded packets, written to the muxer by the main thread */
+    int enc_busy;                   /* the thread is encoding a frame taken from the queue */
+    int enc_finished;               /* the thread has drained the encoder or failed */
+    int enc_abort;                  /* the main thread asks the thread to exit */
+    int enc_error;                  /* error the encoding failed with */
+    uint64_t coded_error[3];        /* coded_frame->error of the last packet written */
+#endif
 } OutputStream;
 
 typedef struct OutputFile {
@@ -478,6 +498,8 @@ extern int copy_tb;
 extern int exit_on_error;
 extern int print_stats;
 extern int qp_hist;
+extern int filter_pipeline;
+extern int enc_queue_size;
 
 extern const AVIOInterruptCB int_cb;
 
@@ -40,6 +40,7 @@
 #include "libavutil/parseutils.h"
 #include "libavutil/pixdesc.h"
 #include "libavutil/pixfmt.h"
+#include "libavutil/slicepool.h"
 
 #define DEFAULT_PASS_LOGFILENAME_PREFIX "av2pass"
 
@@ -84,6 +85,8 @@ int copy_tb           = 1;
 int exit_on_error     = 0;
 int print_stats       = 1;
 int qp_hist           = 0;
+int filter_pipeline   = 0;
+int enc_queue_size    = 0;
 
 static int file_overwrite     = 0;
 static int file_skip          = 0;
@@ -860,6 +863,8 @@ static int open_input_file(OptionsContext *o, const char *filename)
     f->rate_emu   = o->rate_emu;
     f->accurate_seek = o->accurate_seek;
     f->loop = o->loop;
+    f->read_ahead_size = o->read_ahead_size;
+    f->read_ahead_time = o->read_ahead_time;
     f->duration = 0;
     f->time_base = (AVRational){ 1, 1 };
 
@@ -2218,6 +2223,17 @@ static int opt_vstats_file(void *optctx, const char *opt, const char *arg)
     return 0;
 }
 
+static int opt_slice_threads(void *optctx, const char *opt, const char *arg)
+{
+    int ret = av_slice_pool_init(parse_number_or_die(opt, arg, OPT_INT, 0, INT_MAX));
+
+    if (ret < 0) {
+        av_log(NULL, AV_LOG_FATAL, "Error creating the shared slice thread pool\n");
+        exit_program(1);
+    }
+    return 0;
+}
+
 static int opt_vstats(void *optctx, const char *opt, const char *arg)
 {
     char filename[40];
@@ -2639,6 +2655,12 @@ const OptionDef options[] = {
         "create a complex filtergraph", "graph_description" },
     { "filter_complex_script", HAS_ARG | OPT_EXPERT,                 { .func_arg = opt_filter_complex_script },
         "read complex filtergraph description from a file", "filename" },
+    { "filter_pipeline", OPT_BOOL | OPT_EXPERT,                      { &filter_pipeline },
+        "run the parts of filtergraphs on separate threads" },
+    { "enc_queue_size", HAS_ARG | OPT_INT | OPT_EXPERT,              { &enc_queue_size },
+        "run every encoder on its own thread, buffering up to this many frames", "frames" },
+    { "slice_threads",  HAS_ARG | OPT_EXPERT,                        { .func_arg = opt_slice_threads },
+        "run the slice threading of all the codecs, filters and scalers on this many shared threads", "number" },
     { "stats",          OPT_BOOL,                                    { &print_stats },
         "print progress report during encoding", },
     { "attach",         HAS_ARG | OPT_PERFILE | OPT_EXPERT |
@@ -2649,6 +2671,12 @@ const OptionDef options[] = {
         "extract an attachment into a file", "filename" },
     { "loop", OPT_INT | HAS_ARG | OPT_EXPERT | OPT_INPUT |
                         OPT_OFFSET,                                  { .off = OFFSET(loop) }, "set number of times input stream shall be looped", "loop count" },
+    { "read_ahead_size", HAS_ARG | OPT_INT64 | OPT_EXPERT | OPT_INPUT |
+                        OPT_OFFSET,                                  { .off = OFFSET(read_ahead_size) },
+        "demux the input on its own thread, reading ahead up to this many bytes", "size" },
+    { "read_ahead_time", HAS_ARG | OPT_TIME | OPT_EXPERT | OPT_INPUT |
+                        OPT_OFFSET,                                  { .off = OFFSET(read_ahead_time) },
+        "demux the input on its own thread, reading ahead up to this duration", "duration" },
 
     /* video options */
     { "vframes",      OPT_VIDEO | HAS_ARG  | OPT_PERFILE | OPT_OUTPUT,           { .func_arg = opt_video_frames },
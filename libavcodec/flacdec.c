@@ -106,7 +106,7 @@ static av_cold int flac_decode_init(AVCodecContext *avctx)
     if (ret < 0)
         return ret;
     flac_set_bps(s);
-    ff_flacdsp_init(&s->dsp, avctx->sample_fmt, s->bps);
+    ff_flacdsp_init(&s->dsp, avctx->sample_fmt, s->channels, s->bps);
     s->got_streaminfo = 1;
 
     return 0;
@@ -130,6 +130,9 @@ static int allocate_buffers(FLACContext *s)
     if (buf_size < 0)
         return buf_size;
 
+    /* the SIMD LPC reads a few samples past the end of each channel */
+    buf_size += 32 * sizeof(int32_t);
+
     av_fast_malloc(&s->decoded_buffer, &s->decoded_buffer_size, buf_size);
     if (!s->decoded_buffer)
         return AVERROR(ENOMEM);
@@ -164,7 +167,7 @@ static int parse_streaminfo(FLACContext *s, const uint8_t *buf, int buf_size)
     if (ret < 0)
         return ret;
     flac_set_bps(s);
-    ff_flacdsp_init(&s->dsp, s->avctx->sample_fmt, s->bps);
+    ff_flacdsp_init(&s->dsp, s->avctx->sample_fmt, s->channels, s->bps);
     s->got_streaminfo = 1;
 
     return 0;
@@ -417,6 +420,7 @@ static int decode_frame(FLACContext *s)
         ret = allocate_buffers(s);
         if (ret < 0)
             return ret;
+        ff_flacdsp_init(&s->dsp, s->avctx->sample_fmt, s->channels, s->bps);
     }
     s->channels = s->avctx->channels = fi.channels;
     if (!s->avctx->channel_layout)
@@ -462,7 +466,7 @@ static int decode_frame(FLACContext *s)
         ret = allocate_buffers(s);
         if (ret < 0)
             return ret;
-        ff_flacdsp_init(&s->dsp, s->avctx->sample_fmt, s->bps);
+        ff_flacdsp_init(&s->dsp, s->avctx->sample_fmt, s->channels, s->bps);
         s->got_streaminfo = 1;
         dump_headers(s->avctx, (FLACStreaminfo *)s);
     }
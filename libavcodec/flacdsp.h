@@ -31,7 +31,10 @@ typedef struct FLACDSPContext {
                        const int32_t *coefs, int shift);
 } FLACDSPContext;
 
-void ff_flacdsp_init(FLACDSPContext *c, enum AVSampleFormat fmt, int bps);
+void ff_flacdsp_init(FLACDSPContext *c, enum AVSampleFormat fmt, int channels,
+                     int bps);
 void ff_flacdsp_init_arm(FLACDSPContext *c, enum AVSampleFormat fmt, int bps);
+void ff_flacdsp_init_x86(FLACDSPContext *c, enum AVSampleFormat fmt,
+                         int channels, int bps);
 
 #endif /* AVCODEC_FLACDSP_H */
@@ -90,11 +90,20 @@ typedef struct FlacFrame {
     uint8_t crc8;
     int ch_mode;
     int verbatim_only;
+
+    uint32_t frame_number;  ///< coded frame number
+    int max_framesize;      ///< size limit before falling back to verbatim
+    int64_t pts;
+    int nb_samples;
+    LPCContext lpc_ctx;
+
+    PutBitContext pb;
+    uint8_t *buf;           ///< encoded frame
+    int frame_bytes;        ///< size of the encoded frame, or an error code
 } FlacFrame;
 
 typedef struct FlacEncodeContext {
     AVClass *class;
-    PutBitContext pb;
     int channels;
     int samplerate;
     int sr_code[2];
@@ -103,19 +112,29 @@ typedef struct FlacEncodeContext {
     int min_framesize;
     int max_framesize;
     int max_encoded_framesize;
+    int max_verbatim_framesize;
     uint32_t frame_count;
     uint64_t sample_count;
     uint8_t md5sum[16];
-    FlacFrame frame;
     CompressionOptions options;
     AVCodecContext *avctx;
-    LPCContext lpc_ctx;
     struct AVMD5 *md5ctx;
     uint8_t *md5_buffer;
     unsigned int md5_buffer_size;
     BswapDSPContext bdsp;
     FLACDSPContext flac_dsp;
 
+    /**
+     * With slice threading, up to nb_frames input frames are queued and
+     * then encoded in parallel, one frame per job. The packets are returned
+     * in order, one per call, while the next batch is being queued.
+     */
+    FlacFrame *frames;
+    int nb_frames;
+    int nb_queued;          ///< frames[0..nb_queued-1] wait to be encoded
+    int nb_encoded;         ///< number of frames in the last encoded batch
+    int next_output;        ///< next encoded frame to return
+
     int flushed;
     int64_t next_pts;
 } FlacEncodeContext;
@@ -419,12 +438,27 @@ FF_ENABLE_DEPRECATION_WARNINGS
 
     s->frame_count   = 0;
     s->min_framesize = s->max_framesize;
+    s->max_verbatim_framesize = s->max_framesize;
 
-    ret = ff_lpc_init(&s->lpc_ctx, avctx->frame_size,
-                      s->options.max_prediction_order, FF_LPC_TYPE_LEVINSON);
+    s->nb_frames = avctx->active_thread_type & FF_THREAD_SLICE ?
+                   avctx->thread_count : 1;
+    s->frames    = av_mallocz_array(s->nb_frames, sizeof(*s->frames));
+    if (!s->frames)
+        return AVERROR(ENOMEM);
+    for (i = 0; i < s->nb_frames; i++) {
+        FlacFrame *frame = &s->frames[i];
+
+        frame->buf = av_malloc(s->max_verbatim_framesize);
+        if (!frame->buf)
+            return AVERROR(ENOMEM);
+        ret = ff_lpc_init(&frame->lpc_ctx, avctx->frame_size,
+                          s->options.max_prediction_order, FF_LPC_TYPE_LEVINSON);
+        if (ret < 0)
+            return ret;
+    }
 
     ff_bswapdsp_init(&s->bdsp);
-    ff_flacdsp_init(&s->flac_dsp, avctx->sample_fmt,
+    ff_flacdsp_init(&s->flac_dsp, avctx->sample_fmt, s->channels,
                     avctx->bits_per_raw_sample);
 
     dprint_compression_options(s);
@@ -433,12 +467,9 @@ FF_ENABLE_DEPRECATION_WARNINGS
 }
 
 
-static void init_frame(FlacEncodeContext *s, int nb_samples)
+static void init_frame(FlacEncodeContext *s, FlacFrame *frame, int nb_samples)
 {
     int i, ch;
-    FlacFrame *frame;
-
-    frame = &s->frame;
 
     for (i = 0; i < 16; i++) {
         if (nb_samples == ff_flac_blocksize_table[i]) {
@@ -478,16 +509,15 @@ static void init_frame(FlacEncodeContext *s, int nb_samples)
 /**
  * Copy channel-interleaved input samples into separate subframes.
  */
-static void copy_samples(FlacEncodeContext *s, const void *samples)
+static void copy_samples(FlacEncodeContext *s, FlacFrame *frame,
+                         const void *samples)
 {
     int i, j, ch;
-    FlacFrame *frame;
     int shift = av_get_bytes_per_sample(s->avctx->sample_fmt) * 8 -
                 s->avctx->bits_per_raw_sample;
 
 #define COPY_SAMPLES(bits) do {                                     \
     const int ## bits ## _t *samples0 = samples;                    \
-    frame = &s->frame;                                              \
     for (i = 0, j = 0; i < frame->blocksize; i++)                   \
         for (ch = 0; ch < s->channels; ch++, j++)                   \
             frame->subframes[ch].samples[i] = samples0[j] >> shift; \
@@ -514,8 +544,8 @@ static uint64_t rice_count_exact(int32_t *res, int n, int k)
 }
 
 
-static uint64_t subframe_count_exact(FlacEncodeContext *s, FlacSubframe *sub,
-                                     int pred_order)
+static uint64_t subframe_count_exact(FlacEncodeContext *s, FlacFrame *frame,
+                                     FlacSubframe *sub, int pred_order)
 {
     int p, porder, psize;
     int i, part_end;
@@ -528,7 +558,7 @@ static uint64_t subframe_count_exact(FlacEncodeContext *s, FlacSubframe *sub,
     if (sub->type == FLAC_SUBFRAME_CONSTANT) {
         count += sub->obits;
     } else if (sub->type == FLAC_SUBFRAME_VERBATIM) {
-        count += s->frame.blocksize * sub->obits;
+        count += frame->blocksize * sub->obits;
     } else {
         /* warm-up samples */
         count += pred_order * sub->obits;
@@ -542,7 +572,7 @@ static uint64_t subframe_count_exact(FlacEncodeContext *s, FlacSubframe *sub,
 
         /* partition order */
         porder = sub->rc.porder;
-        psize  = s->frame.blocksize >> porder;
+        psize  = frame->blocksize >> porder;
         count += 4;
 
         /* residual */
@@ -553,7 +583,7 @@ static uint64_t subframe_count_exact(FlacEncodeContext *s, FlacSubframe *sub,
             count += sub->rc.coding_mode;
             count += rice_count_exact(&sub->residual[i], part_end - i, k);
             i = part_end;
-            part_end = FFMIN(s->frame.blocksize, part_end + psize);
+            part_end = FFMIN(frame->blocksize, part_end + psize);
         }
     }
 
@@ -676,18 +706,19 @@ static int get_max_p_order(int max_porder, int n, int order)
 
 
 static uint64_t find_subframe_rice_params(FlacEncodeContext *s,
+                                          FlacFrame *frame,
                                           FlacSubframe *sub, int pred_order)
 {
     int pmin = get_max_p_order(s->options.min_partition_order,
-                               s->frame.blocksize, pred_order);
+                               frame->blocksize, pred_order);
     int pmax = get_max_p_order(s->options.max_partition_order,
-                               s->frame.blocksize, pred_order);
+                               frame->blocksize, pred_order);
 
     uint64_t bits = 8 + pred_order * sub->obits + 2 + sub->rc.coding_mode;
     if (sub->type == FLAC_SUBFRAME_LPC)
         bits += 4 + 5 + pred_order * s->options.lpc_coeff_precision;
     bits += calc_rice_params(&sub->rc, pmin, pmax, sub->residual,
-                             s->frame.blocksize, pred_order);
+                             frame->blocksize, pred_order);
     return bits;
 }
 
@@ -743,17 +774,15 @@ static void encode_residual_fixed(int32_t *res, const int32_t *smp, int n,
 }
 
 
-static int encode_residual_ch(FlacEncodeContext *s, int ch)
+static int encode_residual_ch(FlacEncodeContext *s, FlacFrame *frame, int ch)
 {
     int i, n;
     int min_order, max_order, opt_order, omethod;
-    FlacFrame *frame;
     FlacSubframe *sub;
     int32_t coefs[MAX_LPC_ORDER][MAX_LPC_ORDER];
     int shift[MAX_LPC_ORDER];
     int32_t *res, *smp;
 
-    frame = &s->frame;
     sub   = &frame->subframes[ch];
     res   = sub->residual;
     smp   = sub->samples;
@@ -766,14 +795,14 @@ static int encode_residual_ch(FlacEncodeContext *s, int ch)
     if (i == n) {
         sub->type = sub->type_code = FLAC_SUBFRAME_CONSTANT;
         res[0] = smp[0];
-        return subframe_count_exact(s, sub, 0);
+        return subframe_count_exact(s, frame, sub, 0);
     }
 
     /* VERBATIM */
     if (frame->verbatim_only || n < 5) {
         sub->type = sub->type_code = FLAC_SUBFRAME_VERBATIM;
         memcpy(res, smp, n * sizeof(int32_t));
-        return subframe_count_exact(s, sub, 0);
+        return subframe_count_exact(s, frame, sub, 0);
     }
 
     min_order  = s->options.min_prediction_order;
@@ -791,7 +820,7 @@ static int encode_residual_ch(FlacEncodeContext *s, int ch)
         bits[0]   = UINT32_MAX;
         for (i = min_order; i <= max_order; i++) {
             encode_residual_fixed(res, smp, n, i);
-            bits[i] = find_subframe_rice_params(s, sub, i);
+            bits[i] = find_subframe_rice_params(s, frame, sub, i);
             if (bits[i] < bits[opt_order])
                 opt_order = i;
         }
@@ -799,14 +828,14 @@ static int encode_residual_ch(FlacEncodeContext *s, int ch)
         sub->type_code = sub->type | sub->order;
         if (sub->order != max_order) {
             encode_residual_fixed(res, smp, n, sub->order);
-            find_subframe_rice_params(s, sub, sub->order);
+            find_subframe_rice_params(s, frame, sub, sub->order);
         }
-        return subframe_count_exact(s, sub, sub->order);
+        return subframe_count_exact(s, frame, sub, sub->order);
     }
 
     /* LPC */
     sub->type = FLAC_SUBFRAME_LPC;
-    opt_order = ff_lpc_calc_coefs(&s->lpc_ctx, smp, n, min_order, max_order,
+    opt_order = ff_lpc_calc_coefs(&frame->lpc_ctx, smp, n, min_order, max_order,
                                   s->options.lpc_coeff_precision, coefs, shift, s->options.lpc_type,
                                   s->options.lpc_passes, omethod,
                                   MAX_LPC_SHIFT, 0);
@@ -828,7 +857,7 @@ static int encode_residual_ch(FlacEncodeContext *s, int ch)
                 continue;
             s->flac_dsp.lpc_encode(res, smp, n, order+1, coefs[order],
                                    shift[order]);
-            bits[i] = find_subframe_rice_params(s, sub, order+1);
+            bits[i] = find_subframe_rice_params(s, frame, sub, order+1);
             if (bits[i] < bits[opt_index]) {
                 opt_index = i;
                 opt_order = order;
@@ -842,7 +871,7 @@ static int encode_residual_ch(FlacEncodeContext *s, int ch)
         bits[0]   = UINT32_MAX;
         for (i = min_order-1; i < max_order; i++) {
             s->flac_dsp.lpc_encode(res, smp, n, i+1, coefs[i], shift[i]);
-            bits[i] = find_subframe_rice_params(s, sub, i+1);
+            bits[i] = find_subframe_rice_params(s, frame, sub, i+1);
             if (bits[i] < bits[opt_order])
                 opt_order = i;
         }
@@ -860,7 +889,7 @@ static int encode_residual_ch(FlacEncodeContext *s, int ch)
                 if (i < min_order-1 || i >= max_order || bits[i] < UINT32_MAX)
                     continue;
                 s->flac_dsp.lpc_encode(res, smp, n, i+1, coefs[i], shift[i]);
-                bits[i] = find_subframe_rice_params(s, sub, i+1);
+                bits[i] = find_subframe_rice_params(s, frame, sub, i+1);
                 if (bits[i] < bits[opt_order])
                     opt_order = i;
             }
@@ -876,13 +905,13 @@ static int encode_residual_ch(FlacEncodeContext *s, int ch)
 
     s->flac_dsp.lpc_encode(res, smp, n, sub->order, sub->coefs, sub->shift);
 
-    find_subframe_rice_params(s, sub, sub->order);
+    find_subframe_rice_params(s, frame, sub, sub->order);
 
-    return subframe_count_exact(s, sub, sub->order);
+    return subframe_count_exact(s, frame, sub, sub->order);
 }
 
 
-static int count_frame_header(FlacEncodeContext *s)
+static int count_frame_header(FlacEncodeContext *s, FlacFrame *frame)
 {
     uint8_t av_unused tmp;
     int count;
@@ -900,12 +929,12 @@ static int count_frame_header(FlacEncodeContext *s)
     count = 32;
 
     /* coded frame number */
-    PUT_UTF8(s->frame_count, tmp, count += 8;)
+    PUT_UTF8(frame->frame_number, tmp, count += 8;)
 
     /* explicit block size */
-    if (s->frame.bs_code[0] == 6)
+    if (frame->bs_code[0] == 6)
         count += 8;
-    else if (s->frame.bs_code[0] == 7)
+    else if (frame->bs_code[0] == 7)
         count += 16;
 
     /* explicit sample rate */
@@ -918,15 +947,15 @@ static int count_frame_header(FlacEncodeContext *s)
 }
 
 
-static int encode_frame(FlacEncodeContext *s)
+static int encode_frame(FlacEncodeContext *s, FlacFrame *frame)
 {
     int ch;
     uint64_t count;
 
-    count = count_frame_header(s);
+    count = count_frame_header(s, frame);
 
     for (ch = 0; ch < s->channels; ch++)
-        count += encode_residual_ch(s, ch);
+        count += encode_residual_ch(s, frame, ch);
 
     count += (8 - (count & 7)) & 7; // byte alignment
     count += 16;                    // CRC-16
@@ -938,15 +967,15 @@ static int encode_frame(FlacEncodeContext *s)
 }
 
 
-static void remove_wasted_bits(FlacEncodeContext *s)
+static void remove_wasted_bits(FlacEncodeContext *s, FlacFrame *frame)
 {
     int ch, i;
 
     for (ch = 0; ch < s->channels; ch++) {
-        FlacSubframe *sub = &s->frame.subframes[ch];
+        FlacSubframe *sub = &frame->subframes[ch];
         int32_t v         = 0;
 
-        for (i = 0; i < s->frame.blocksize; i++) {
+        for (i = 0; i < frame->blocksize; i++) {
             v |= sub->samples[i];
             if (v & 1)
                 break;
@@ -955,7 +984,7 @@ static void remove_wasted_bits(FlacEncodeContext *s)
         if (v && !(v & 1)) {
             v = av_ctz(v);
 
-            for (i = 0; i < s->frame.blocksize; i++)
+            for (i = 0; i < frame->blocksize; i++)
                 sub->samples[i] >>= v;
 
             sub->wasted = v;
@@ -1014,13 +1043,11 @@ static int estimate_stereo_mode(int32_t *left_ch, int32_t *right_ch, int n,
 /**
  * Perform stereo channel decorrelation.
  */
-static void channel_decorrelation(FlacEncodeContext *s)
+static void channel_decorrelation(FlacEncodeContext *s, FlacFrame *frame)
 {
-    FlacFrame *frame;
     int32_t *left, *right;
     int i, n;
 
-    frame = &s->frame;
     n     = frame->blocksize;
     left  = frame->subframes[0].samples;
     right = frame->subframes[1].samples;
@@ -1066,96 +1093,93 @@ static void write_utf8(PutBitContext *pb, uint32_t val)
 }
 
 
-static void write_frame_header(FlacEncodeContext *s)
+static void write_frame_header(FlacEncodeContext *s, FlacFrame *frame)
 {
-    FlacFrame *frame;
     int crc;
 
-    frame = &s->frame;
-
-    put_bits(&s->pb, 16, 0xFFF8);
-    put_bits(&s->pb, 4, frame->bs_code[0]);
-    put_bits(&s->pb, 4, s->sr_code[0]);
+    put_bits(&frame->pb, 16, 0xFFF8);
+    put_bits(&frame->pb, 4, frame->bs_code[0]);
+    put_bits(&frame->pb, 4, s->sr_code[0]);
 
     if (frame->ch_mode == FLAC_CHMODE_INDEPENDENT)
-        put_bits(&s->pb, 4, s->channels-1);
+        put_bits(&frame->pb, 4, s->channels-1);
     else
-        put_bits(&s->pb, 4, frame->ch_mode + FLAC_MAX_CHANNELS - 1);
+        put_bits(&frame->pb, 4, frame->ch_mode + FLAC_MAX_CHANNELS - 1);
 
-    put_bits(&s->pb, 3, s->bps_code);
-    put_bits(&s->pb, 1, 0);
-    write_utf8(&s->pb, s->frame_count);
+    put_bits(&frame->pb, 3, s->bps_code);
+    put_bits(&frame->pb, 1, 0);
+    write_utf8(&frame->pb, frame->frame_number);
 
     if (frame->bs_code[0] == 6)
-        put_bits(&s->pb, 8, frame->bs_code[1]);
+        put_bits(&frame->pb, 8, frame->bs_code[1]);
     else if (frame->bs_code[0] == 7)
-        put_bits(&s->pb, 16, frame->bs_code[1]);
+        put_bits(&frame->pb, 16, frame->bs_code[1]);
 
     if (s->sr_code[0] == 12)
-        put_bits(&s->pb, 8, s->sr_code[1]);
+        put_bits(&frame->pb, 8, s->sr_code[1]);
     else if (s->sr_code[0] > 12)
-        put_bits(&s->pb, 16, s->sr_code[1]);
+        put_bits(&frame->pb, 16, s->sr_code[1]);
 
-    flush_put_bits(&s->pb);
-    crc = av_crc(av_crc_get_table(AV_CRC_8_ATM), 0, s->pb.buf,
-                 put_bits_count(&s->pb) >> 3);
-    put_bits(&s->pb, 8, crc);
+    flush_put_bits(&frame->pb);
+    crc = av_crc(av_crc_get_table(AV_CRC_8_ATM), 0, frame->pb.buf,
+                 put_bits_count(&frame->pb) >> 3);
+    put_bits(&frame->pb, 8, crc);
 }
 
 
-static void write_subframes(FlacEncodeContext *s)
+static void write_subframes(FlacEncodeContext *s, FlacFrame *frame)
 {
     int ch;
 
     for (ch = 0; ch < s->channels; ch++) {
-        FlacSubframe *sub = &s->frame.subframes[ch];
+        FlacSubframe *sub = &frame->subframes[ch];
         int i, p, porder, psize;
         int32_t *part_end;
         int32_t *res       =  sub->residual;
-        int32_t *frame_end = &sub->residual[s->frame.blocksize];
+        int32_t *frame_end = &sub->residual[frame->blocksize];
 
         /* subframe header */
-        put_bits(&s->pb, 1, 0);
-        put_bits(&s->pb, 6, sub->type_code);
-        put_bits(&s->pb, 1, !!sub->wasted);
+        put_bits(&frame->pb, 1, 0);
+        put_bits(&frame->pb, 6, sub->type_code);
+        put_bits(&frame->pb, 1, !!sub->wasted);
         if (sub->wasted)
-            put_bits(&s->pb, sub->wasted, 1);
+            put_bits(&frame->pb, sub->wasted, 1);
 
         /* subframe */
         if (sub->type == FLAC_SUBFRAME_CONSTANT) {
-            put_sbits(&s->pb, sub->obits, res[0]);
+            put_sbits(&frame->pb, sub->obits, res[0]);
         } else if (sub->type == FLAC_SUBFRAME_VERBATIM) {
             while (res < frame_end)
-                put_sbits(&s->pb, sub->obits, *res++);
+                put_sbits(&frame->pb, sub->obits, *res++);
         } else {
             /* warm-up samples */
             for (i = 0; i < sub->order; i++)
-                put_sbits(&s->pb, sub->obits, *res++);
+                put_sbits(&frame->pb, sub->obits, *res++);
 
             /* LPC coefficients */
             if (sub->type == FLAC_SUBFRAME_LPC) {
                 int cbits = s->options.lpc_coeff_precision;
-                put_bits( &s->pb, 4, cbits-1);
-                put_sbits(&s->pb, 5, sub->shift);
+                put_bits( &frame->pb, 4, cbits-1);
+                put_sbits(&frame->pb, 5, sub->shift);
                 for (i = 0; i < sub->order; i++)
-                    put_sbits(&s->pb, cbits, sub->coefs[i]);
+                    put_sbits(&frame->pb, cbits, sub->coefs[i]);
             }
 
             /* rice-encoded block */
-            put_bits(&s->pb, 2, sub->rc.coding_mode - 4);
+            put_bits(&frame->pb, 2, sub->rc.coding_mode - 4);
 
             /* partition order */
             porder  = sub->rc.porder;
-            psize   = s->frame.blocksize >> porder;
-            put_bits(&s->pb, 4, porder);
+            psize   = frame->blocksize >> porder;
+            put_bits(&frame->pb, 4, porder);
 
             /* residual */
             part_end  = &sub->residual[psize];
             for (p = 0; p < 1 << porder; p++) {
                 int k = sub->rc.params[p];
-                put_bits(&s->pb, sub->rc.coding_mode, k);
+                put_bits(&frame->pb, sub->rc.coding_mode, k);
                 while (res < part_end)
-                    set_sr_golomb_flac(&s->pb, *res++, k, INT32_MAX, 0);
+                    set_sr_golomb_flac(&frame->pb, *res++, k, INT32_MAX, 0);
                 part_end = FFMIN(frame_end, part_end + psize);
             }
         }
@@ -1163,31 +1187,32 @@ static void write_subframes(FlacEncodeContext *s)
 }
 
 
-static void write_frame_footer(FlacEncodeContext *s)
+static void write_frame_footer(FlacFrame *frame)
 {
     int crc;
-    flush_put_bits(&s->pb);
-    crc = av_bswap16(av_crc(av_crc_get_table(AV_CRC_16_ANSI), 0, s->pb.buf,
-                            put_bits_count(&s->pb)>>3));
-    put_bits(&s->pb, 16, crc);
-    flush_put_bits(&s->pb);
+    flush_put_bits(&frame->pb);
+    crc = av_bswap16(av_crc(av_crc_get_table(AV_CRC_16_ANSI), 0, frame->pb.buf,
+                            put_bits_count(&frame->pb)>>3));
+    put_bits(&frame->pb, 16, crc);
+    flush_put_bits(&frame->pb);
 }
 
 
-static int write_frame(FlacEncodeContext *s, AVPacket *avpkt)
+static int write_frame(FlacEncodeContext *s, FlacFrame *frame)
 {
-    init_put_bits(&s->pb, avpkt->data, avpkt->size);
-    write_frame_header(s);
-    write_subframes(s);
-    write_frame_footer(s);
-    return put_bits_count(&s->pb) >> 3;
+    init_put_bits(&frame->pb, frame->buf, s->max_verbatim_framesize);
+    write_frame_header(s, frame);
+    write_subframes(s, frame);
+    write_frame_footer(frame);
+    return put_bits_count(&frame->pb) >> 3;
 }
 
 
-static int update_md5_sum(FlacEncodeContext *s, const void *samples)
+static int update_md5_sum(FlacEncodeContext *s, FlacFrame *frame,
+                          const void *samples)
 {
     const uint8_t *buf;
-    int buf_size = s->frame.blocksize * s->channels *
+    int buf_size = frame->blocksize * s->channels *
                    ((s->avctx->bits_per_raw_sample + 7) / 8);
 
     if (s->avctx->bits_per_raw_sample > 16 || HAVE_BIGENDIAN) {
@@ -1208,7 +1233,7 @@ static int update_md5_sum(FlacEncodeContext *s, const void *samples)
         const int32_t *samples0 = samples;
         uint8_t *tmp            = s->md5_buffer;
 
-        for (i = 0; i < s->frame.blocksize * s->channels; i++) {
+        for (i = 0; i < frame->blocksize * s->channels; i++) {
             int32_t v = samples0[i] >> 8;
             *tmp++    = (v      ) & 0xFF;
             *tmp++    = (v >>  8) & 0xFF;
@@ -1222,83 +1247,86 @@ static int update_md5_sum(FlacEncodeContext *s, const void *samples)
 }
 
 
-static int flac_encode_frame(AVCodecContext *avctx, AVPacket *avpkt,
-                             const AVFrame *frame, int *got_packet_ptr)
+/**
+ * Copy an input frame into the next free slot of the queue.
+ */
+static int queue_frame(FlacEncodeContext *s, const AVFrame *frame)
 {
-    FlacEncodeContext *s;
-    int frame_bytes, out_bytes, ret;
+    FlacFrame *f = &s->frames[s->nb_queued];
+    int ret;
 
-    s = avctx->priv_data;
-
-    /* when the last block is reached, update the header in extradata */
-    if (!frame) {
-        s->max_framesize = s->max_encoded_framesize;
-        av_md5_final(s->md5ctx, s->md5sum);
-        write_streaminfo(s, avctx->extradata);
+    /* change max_framesize for small final frame */
+    if (frame->nb_samples < s->max_blocksize) {
+        s->max_framesize = ff_flac_get_max_frame_size(frame->nb_samples,
+                                                      s->channels,
+                                                      s->avctx->bits_per_raw_sample);
+    }
 
-#if FF_API_SIDEDATA_ONLY_PKT
-FF_DISABLE_DEPRECATION_WARNINGS
-        if (avctx->side_data_only_packets && !s->flushed) {
-FF_ENABLE_DEPRECATION_WARNINGS
-#else
-        if (!s->flushed) {
-#endif
-            uint8_t *side_data = av_packet_new_side_data(avpkt, AV_PKT_DATA_NEW_EXTRADATA,
-                                                         avctx->extradata_size);
-            if (!side_data)
-                return AVERROR(ENOMEM);
-            memcpy(side_data, avctx->extradata, avctx->extradata_size);
+    init_frame(s, f, frame->nb_samples);
 
-            avpkt->pts = s->next_pts;
+    copy_samples(s, f, frame->data[0]);
 
-            *got_packet_ptr = 1;
-            s->flushed = 1;
-        }
+    f->frame_number  = s->frame_count++;
+    f->max_framesize = s->max_framesize;
+    f->pts           = frame->pts;
+    f->nb_samples    = frame->nb_samples;
 
-        return 0;
+    s->sample_count += frame->nb_samples;
+    if ((ret = update_md5_sum(s, f, frame->data[0])) < 0) {
+        av_log(s->avctx, AV_LOG_ERROR, "Error updating MD5 checksum\n");
+        return ret;
     }
 
-    /* change max_framesize for small final frame */
-    if (frame->nb_samples < s->frame.blocksize) {
-        s->max_framesize = ff_flac_get_max_frame_size(frame->nb_samples,
-                                                      s->channels,
-                                                      avctx->bits_per_raw_sample);
-    }
+    s->nb_queued++;
+    return 0;
+}
 
-    init_frame(s, frame->nb_samples);
 
-    copy_samples(s, frame->data[0]);
+static int encode_frame_thread(AVCodecContext *avctx, void *arg)
+{
+    FlacEncodeContext *s = avctx->priv_data;
+    FlacFrame *frame     = arg;
+    int frame_bytes;
 
-    channel_decorrelation(s);
+    channel_decorrelation(s, frame);
 
-    remove_wasted_bits(s);
+    remove_wasted_bits(s, frame);
 
-    frame_bytes = encode_frame(s);
+    frame_bytes = encode_frame(s, frame);
 
     /* Fall back on verbatim mode if the compressed frame is larger than it
        would be if encoded uncompressed. */
-    if (frame_bytes < 0 || frame_bytes > s->max_framesize) {
-        s->frame.verbatim_only = 1;
-        frame_bytes = encode_frame(s);
+    if (frame_bytes < 0 || frame_bytes > frame->max_framesize) {
+        frame->verbatim_only = 1;
+        frame_bytes = encode_frame(s, frame);
         if (frame_bytes < 0) {
             av_log(avctx, AV_LOG_ERROR, "Bad frame count\n");
+            frame->frame_bytes = frame_bytes;
             return frame_bytes;
         }
     }
 
-    if ((ret = ff_alloc_packet(avpkt, frame_bytes))) {
-        av_log(avctx, AV_LOG_ERROR, "Error getting output packet\n");
-        return ret;
-    }
+    frame->frame_bytes = write_frame(s, frame);
+    return 0;
+}
 
-    out_bytes = write_frame(s, avpkt);
 
-    s->frame_count++;
-    s->sample_count += frame->nb_samples;
-    if ((ret = update_md5_sum(s, frame->data[0])) < 0) {
-        av_log(avctx, AV_LOG_ERROR, "Error updating MD5 checksum\n");
+static int output_frame(AVCodecContext *avctx, AVPacket *avpkt,
+                        FlacFrame *frame)
+{
+    FlacEncodeContext *s = avctx->priv_data;
+    int out_bytes        = frame->frame_bytes;
+    int ret;
+
+    if (out_bytes < 0)
+        return out_bytes;
+
+    if ((ret = ff_alloc_packet(avpkt, out_bytes))) {
+        av_log(avctx, AV_LOG_ERROR, "Error getting output packet\n");
         return ret;
     }
+    memcpy(avpkt->data, frame->buf, out_bytes);
+
     if (out_bytes > s->max_encoded_framesize)
         s->max_encoded_framesize = out_bytes;
     if (out_bytes < s->min_framesize)
@@ -1310,7 +1338,66 @@ FF_ENABLE_DEPRECATION_WARNINGS
 
     s->next_pts = avpkt->pts + avpkt->duration;
 
-    *got_packet_ptr = 1;
+    return 0;
+}
+
+
+static int flac_encode_frame(AVCodecContext *avctx, AVPacket *avpkt,
+                             const AVFrame *frame, int *got_packet_ptr)
+{
+    FlacEncodeContext *s;
+    int ret;
+
+    s = avctx->priv_data;
+
+    /* Every call returns at most one packet, so the slot for a new frame
+     * has always been returned already. */
+    if (frame && (ret = queue_frame(s, frame)) < 0)
+        return ret;
+
+    if (s->next_output == s->nb_encoded && s->nb_queued &&
+        (s->nb_queued == s->nb_frames || !frame)) {
+        avctx->execute(avctx, encode_frame_thread, s->frames, NULL,
+                       s->nb_queued, sizeof(*s->frames));
+        s->nb_encoded  = s->nb_queued;
+        s->nb_queued   = 0;
+        s->next_output = 0;
+    }
+
+    if (s->next_output < s->nb_encoded) {
+        ret = output_frame(avctx, avpkt, &s->frames[s->next_output++]);
+        if (ret < 0)
+            return ret;
+        *got_packet_ptr = 1;
+        return 0;
+    }
+
+    /* when the last block is reached, update the header in extradata */
+    if (!frame) {
+        s->max_framesize = s->max_encoded_framesize;
+        av_md5_final(s->md5ctx, s->md5sum);
+        write_streaminfo(s, avctx->extradata);
+
+#if FF_API_SIDEDATA_ONLY_PKT
+FF_DISABLE_DEPRECATION_WARNINGS
+        if (avctx->side_data_only_packets && !s->flushed) {
+FF_ENABLE_DEPRECATION_WARNINGS
+#else
+        if (!s->flushed) {
+#endif
+            uint8_t *side_data = av_packet_new_side_data(avpkt, AV_PKT_DATA_NEW_EXTRADATA,
+                                                         avctx->extradata_size);
+            if (!side_data)
+                return AVERROR(ENOMEM);
+            memcpy(side_data, avctx->extradata, avctx->extradata_size);
+
+            avpkt->pts = s->next_pts;
+
+            *got_packet_ptr = 1;
+            s->flushed = 1;
+        }
+    }
+
     return 0;
 }
 
@@ -1319,9 +1406,17 @@ static av_cold int flac_encode_close(AVCodecContext *avctx)
 {
     if (avctx->priv_data) {
         FlacEncodeContext *s = avctx->priv_data;
+        int i;
+
         av_freep(&s->md5ctx);
         av_freep(&s->md5_buffer);
-        ff_lpc_end(&s->lpc_ctx);
+        if (s->frames) {
+            for (i = 0; i < s->nb_frames; i++) {
+                av_freep(&s->frames[i].buf);
+                ff_lpc_end(&s->frames[i].lpc_ctx);
+            }
+        }
+        av_freep(&s->frames);
     }
     av_freep(&avctx->extradata);
     avctx->extradata_size = 0;
@@ -1374,7 +1469,9 @@ AVCodec ff_flac_encoder = {
     .init           = flac_encode_init,
     .encode2        = flac_encode_frame,
     .close          = flac_encode_close,
-    .capabilities   = AV_CODEC_CAP_SMALL_LAST_FRAME | AV_CODEC_CAP_DELAY,
+    .capabilities   = AV_CODEC_CAP_SMALL_LAST_FRAME | AV_CODEC_CAP_DELAY |
+                      AV_CODEC_CAP_SLICE_THREADS,
+    .caps_internal  = FF_CODEC_CAP_INIT_CLEANUP,
     .sample_fmts    = (const enum AVSampleFormat[]){ AV_SAMPLE_FMT_S16,
                                                      AV_SAMPLE_FMT_S32,
                                                      AV_SAMPLE_FMT_NONE },
@@ -413,6 +413,16 @@ void ff_hevc_cabac_init(HEVCContext *s, int ctb_addr_ts)
     }
 }
 
+void ff_hevc_cabac_init_substream(HEVCContext *s, const uint8_t *buf, int size,
+                                  const uint8_t *states)
+{
+    ff_init_cabac_decoder(&s->HEVClc.cc, buf, size);
+    if (states)
+        memcpy(s->HEVClc.cabac_state, states, HEVC_CONTEXTS);
+    else
+        cabac_init_state(s);
+}
+
 #define GET_CABAC(ctx) get_cabac(&s->HEVClc.cc, &s->HEVClc.cabac_state[ctx])
 
 int ff_hevc_sao_merge_flag_decode(HEVCContext *s)
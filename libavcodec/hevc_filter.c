@@ -183,6 +183,219 @@ static void copy_CTB(uint8_t *dst, uint8_t *src,
     }
 }
 
+static void copy_pixel(uint8_t *dst, const uint8_t *src, int pixel_shift)
+{
+    if (pixel_shift)
+        AV_COPY16(dst, src);
+    else
+        *dst = *src;
+}
+
+static void copy_vert(uint8_t *dst, const uint8_t *src, int pixel_shift,
+                      int height, ptrdiff_t stride)
+{
+    int i;
+
+    for (i = 0; i < height; i++) {
+        copy_pixel(dst, src, pixel_shift);
+        dst += stride;
+        src += stride;
+    }
+}
+
+/*
+ * The SAO of a CTB is applied in four parts: class 0 is the CTB itself minus
+ * its right and bottom margins, which depend on deblocking of the next CTBs,
+ * and classes 1 to 3 are the margins of the above, left and above-left CTBs
+ * which can only be filtered now.
+ */
+static void sao_band_filter_class(HEVCContext *s, uint8_t *dst, uint8_t *src,
+                                  ptrdiff_t stride, SAOParams *sao,
+                                  int *borders, int width, int height,
+                                  int c_idx, int class)
+{
+    int pixel_shift = s->ps.sps->pixel_shift;
+    int chroma      = !!c_idx;
+    int x_margin    = (8 >> chroma) + 2;
+    int y_margin    = (4 >> chroma) + 2;
+    int init_x = 0, init_y = 0;
+    ptrdiff_t offset;
+
+    switch (class) {
+    case 0:
+        if (!borders[2])
+            width -= x_margin;
+        if (!borders[3])
+            height -= y_margin;
+        break;
+    case 1:
+        init_y = -y_margin;
+        height =  y_margin;
+        if (!borders[2])
+            width -= x_margin;
+        break;
+    case 2:
+        init_x = -x_margin;
+        width  =  x_margin;
+        if (!borders[3])
+            height -= y_margin;
+        break;
+    case 3:
+        init_x = -x_margin;
+        init_y = -y_margin;
+        width  =  x_margin;
+        height =  y_margin;
+        break;
+    }
+
+    if (width <= 0 || height <= 0)
+        return;
+
+    offset = init_y * stride + (init_x << pixel_shift);
+    s->hevcdsp.sao_band_filter(dst + offset, src + offset, stride,
+                               sao->offset_val[c_idx],
+                               sao->band_position[c_idx], width, height);
+}
+
+static void sao_edge_filter_class(HEVCContext *s, uint8_t *dst, uint8_t *src,
+                                  ptrdiff_t stride, SAOParams *sao,
+                                  int *borders, int width, int height,
+                                  int c_idx, int class, uint8_t vert_edge,
+                                  uint8_t horiz_edge, uint8_t diag_edge)
+{
+    int pixel_shift = s->ps.sps->pixel_shift;
+    int chroma      = !!c_idx;
+    int x_margin    = (8 >> chroma) + 2;
+    int y_margin    = (4 >> chroma) + 2;
+    int eo_class    = sao->eo_class[c_idx];
+    int init_x = 0, init_y = 0, save;
+    ptrdiff_t offset;
+
+    switch (class) {
+    case 0:
+        if (!borders[2])
+            width -= x_margin;
+        if (!borders[3])
+            height -= y_margin;
+        break;
+    case 1:
+        dst   -= y_margin * stride;
+        src   -= y_margin * stride;
+        height = y_margin;
+        if (!borders[2])
+            width -= x_margin;
+        break;
+    case 2:
+        dst   -= x_margin << pixel_shift;
+        src   -= x_margin << pixel_shift;
+        width  = x_margin;
+        if (!borders[3])
+            height -= y_margin;
+        break;
+    case 3:
+        dst   -= y_margin * stride + (x_margin << pixel_shift);
+        src   -= y_margin * stride + (x_margin << pixel_shift);
+        width  = x_margin;
+        height = y_margin;
+        break;
+    }
+
+    /* Samples on the picture border have no neighbour in the direction of
+     * the edge class and are left unmodified (SaoOffsetVal[0] is always 0). */
+    if (class < 2 && eo_class != SAO_EO_VERT) {
+        if (borders[0]) {
+            copy_vert(dst, src, pixel_shift, height, stride);
+            init_x = 1;
+        }
+        if (borders[2]) {
+            copy_vert(dst + ((width - 1) << pixel_shift),
+                      src + ((width - 1) << pixel_shift),
+                      pixel_shift, height, stride);
+            width--;
+        }
+    }
+    if (!(class & 1) && eo_class != SAO_EO_HORIZ) {
+        if (borders[1]) {
+            if (width > init_x)
+                memcpy(dst + (init_x << pixel_shift),
+                       src + (init_x << pixel_shift),
+                       (width - init_x) << pixel_shift);
+            init_y = 1;
+        }
+        if (borders[3]) {
+            offset = (height - 1) * stride + (init_x << pixel_shift);
+            if (width > init_x)
+                memcpy(dst + offset, src + offset,
+                       (width - init_x) << pixel_shift);
+            height--;
+        }
+    }
+
+    if (width > init_x && height > init_y) {
+        offset = init_y * stride + (init_x << pixel_shift);
+        s->hevcdsp.sao_edge_filter(dst + offset, src + offset, stride,
+                                   sao->offset_val[c_idx], eo_class,
+                                   width - init_x, height - init_y);
+    }
+
+    // Restore pixels that can't be modified
+    switch (class) {
+    case 0:
+        save = !diag_edge && eo_class == SAO_EO_135D && !borders[0] && !borders[1];
+        if (vert_edge && eo_class != SAO_EO_VERT)
+            copy_vert(dst + (init_y + save) * stride,
+                      src + (init_y + save) * stride,
+                      pixel_shift, height - init_y - save, stride);
+        if (horiz_edge && eo_class != SAO_EO_HORIZ &&
+            width > init_x + save)
+            memcpy(dst + ((init_x + save) << pixel_shift),
+                   src + ((init_x + save) << pixel_shift),
+                   (width - init_x - save) << pixel_shift);
+        if (diag_edge && eo_class == SAO_EO_135D)
+            copy_pixel(dst, src, pixel_shift);
+        break;
+    case 1:
+        save   = !diag_edge && eo_class == SAO_EO_45D && !borders[0];
+        offset = (height - 1) * stride;
+        if (vert_edge && eo_class != SAO_EO_VERT)
+            copy_vert(dst, src, pixel_shift, height - save, stride);
+        if (horiz_edge && eo_class != SAO_EO_HORIZ &&
+            width > init_x + save)
+            memcpy(dst + offset + ((init_x + save) << pixel_shift),
+                   src + offset + ((init_x + save) << pixel_shift),
+                   (width - init_x - save) << pixel_shift);
+        if (diag_edge && eo_class == SAO_EO_45D)
+            copy_pixel(dst + offset, src + offset, pixel_shift);
+        break;
+    case 2:
+        save   = !diag_edge && eo_class == SAO_EO_45D && !borders[1];
+        offset = (width - 1) << pixel_shift;
+        if (vert_edge && eo_class != SAO_EO_VERT)
+            copy_vert(dst + (init_y + save) * stride + offset,
+                      src + (init_y + save) * stride + offset,
+                      pixel_shift, height - init_y - save, stride);
+        if (horiz_edge && eo_class != SAO_EO_HORIZ)
+            memcpy(dst, src, (width - save) << pixel_shift);
+        if (diag_edge && eo_class == SAO_EO_45D)
+            copy_pixel(dst + offset, src + offset, pixel_shift);
+        break;
+    case 3:
+        save   = !diag_edge && eo_class == SAO_EO_135D;
+        offset = (height - 1) * stride;
+        if (vert_edge && eo_class != SAO_EO_VERT)
+            copy_vert(dst + ((width - 1) << pixel_shift),
+                      src + ((width - 1) << pixel_shift),
+                      pixel_shift, height - save, stride);
+        if (horiz_edge && eo_class != SAO_EO_HORIZ)
+            memcpy(dst + offset, src + offset, (width - save) << pixel_shift);
+        if (diag_edge && eo_class == SAO_EO_135D)
+            copy_pixel(dst + offset + ((width - 1) << pixel_shift),
+                       src + offset + ((width - 1) << pixel_shift),
+                       pixel_shift);
+        break;
+    }
+}
+
 #define CTB(tab, x, y) ((tab)[(y) * s->ps.sps->ctb_width + (x)])
 
 static void sao_filter_CTB(HEVCContext *s, int x, int y)
@@ -292,21 +505,17 @@ static void sao_filter_CTB(HEVCContext *s, int x, int y)
 
             switch (sao[class_index]->type_idx[c_idx]) {
             case SAO_BAND:
-                s->hevcdsp.sao_band_filter[classes[class_index]](dst, src,
-                                                                 stride,
-                                                                 sao[class_index],
-                                                                 edges, width,
-                                                                 height, c_idx);
+                sao_band_filter_class(s, dst, src, stride, sao[class_index],
+                                      edges, width, height, c_idx,
+                                      classes[class_index]);
                 break;
             case SAO_EDGE:
-                s->hevcdsp.sao_edge_filter[classes[class_index]](dst, src,
-                                                                 stride,
-                                                                 sao[class_index],
-                                                                 edges, width,
-                                                                 height, c_idx,
-                                                                 vert_edge[classes[class_index]],
-                                                                 horiz_edge[classes[class_index]],
-                                                                 diag_edge[classes[class_index]]);
+                sao_edge_filter_class(s, dst, src, stride, sao[class_index],
+                                      edges, width, height, c_idx,
+                                      classes[class_index],
+                                      vert_edge[classes[class_index]],
+                                      horiz_edge[classes[class_index]],
+                                      diag_edge[classes[class_index]]);
                 break;
             }
         }
@@ -601,7 +810,8 @@ void ff_hevc_deblocking_boundary_strengths(HEVCContext *s, int x0, int y0,
         ((!s->sh.slice_loop_filter_across_slices_enabled_flag &&
           lc->boundary_flags & BOUNDARY_UPPER_SLICE &&
           (y0 % (1 << s->ps.sps->log2_ctb_size)) == 0) ||
-         (!s->ps.pps->loop_filter_across_tiles_enabled_flag &&
+         ((!s->ps.pps->loop_filter_across_tiles_enabled_flag ||
+           (lc->defer_tile_edges && !(lc->boundary_flags & BOUNDARY_UPPER_SLICE))) &&
           lc->boundary_flags & BOUNDARY_UPPER_TILE &&
           (y0 % (1 << s->ps.sps->log2_ctb_size)) == 0)))
         boundary_upper = 0;
@@ -663,7 +873,8 @@ void ff_hevc_deblocking_boundary_strengths(HEVCContext *s, int x0, int y0,
         ((!s->sh.slice_loop_filter_across_slices_enabled_flag &&
           lc->boundary_flags & BOUNDARY_LEFT_SLICE &&
           (x0 % (1 << s->ps.sps->log2_ctb_size)) == 0) ||
-         (!s->ps.pps->loop_filter_across_tiles_enabled_flag &&
+         ((!s->ps.pps->loop_filter_across_tiles_enabled_flag ||
+           (lc->defer_tile_edges && !(lc->boundary_flags & BOUNDARY_LEFT_SLICE))) &&
           lc->boundary_flags & BOUNDARY_LEFT_TILE &&
           (x0 % (1 << s->ps.sps->log2_ctb_size)) == 0)))
         boundary_left = 0;
@@ -721,6 +932,76 @@ void ff_hevc_deblocking_boundary_strengths(HEVCContext *s, int x0, int y0,
     }
 }
 
+/**
+ * Compute the boundary strengths of the upper and left edges of a CTB when
+ * they are shared with another tile of the same slice. Those are skipped
+ * while the tiles are decoded concurrently, since the neighbouring tile may
+ * not be available yet.
+ */
+void ff_hevc_tile_boundary_strengths(HEVCContext *s, int x0, int y0)
+{
+    MvField *tab_mvf     = s->ref->tab_mvf;
+    RefPicList *rpl      = s->ref->refPicList;
+    int log2_min_pu_size = s->ps.sps->log2_min_pu_size;
+    int log2_min_tu_size = s->ps.sps->log2_min_tb_size;
+    int min_pu_width     = s->ps.sps->min_pu_width;
+    int min_tu_width     = s->ps.sps->min_tb_width;
+    int ctb_width        = s->ps.sps->ctb_width;
+    int ctb_size         = 1 << s->ps.sps->log2_ctb_size;
+    int ctb_addr_rs      = (y0 >> s->ps.sps->log2_ctb_size) * ctb_width +
+                           (x0 >> s->ps.sps->log2_ctb_size);
+    int tile_id          = s->ps.pps->tile_id[s->ps.pps->ctb_addr_rs_to_ts[ctb_addr_rs]];
+    int x_end            = FFMIN(x0 + ctb_size, s->ps.sps->width);
+    int y_end            = FFMIN(y0 + ctb_size, s->ps.sps->height);
+    int i, bs;
+
+    if (y0 > 0 &&
+        tile_id != s->ps.pps->tile_id[s->ps.pps->ctb_addr_rs_to_ts[ctb_addr_rs - ctb_width]] &&
+        s->tab_slice_address[ctb_addr_rs] == s->tab_slice_address[ctb_addr_rs - ctb_width]) {
+        int yp_pu = (y0 - 1) >> log2_min_pu_size;
+        int yq_pu =  y0      >> log2_min_pu_size;
+        int yp_tu = (y0 - 1) >> log2_min_tu_size;
+        int yq_tu =  y0      >> log2_min_tu_size;
+
+        for (i = x0; i < x_end; i += 4) {
+            int x_pu = i >> log2_min_pu_size;
+            int x_tu = i >> log2_min_tu_size;
+            MvField *top  = &tab_mvf[yp_pu * min_pu_width + x_pu];
+            MvField *curr = &tab_mvf[yq_pu * min_pu_width + x_pu];
+            uint8_t top_cbf_luma  = s->cbf_luma[yp_tu * min_tu_width + x_tu];
+            uint8_t curr_cbf_luma = s->cbf_luma[yq_tu * min_tu_width + x_tu];
+
+            bs = boundary_strength(s, curr, curr_cbf_luma,
+                                   top, top_cbf_luma, rpl, 1);
+            if (bs)
+                s->horizontal_bs[(i + y0 * s->bs_width) >> 2] = bs;
+        }
+    }
+
+    if (x0 > 0 &&
+        tile_id != s->ps.pps->tile_id[s->ps.pps->ctb_addr_rs_to_ts[ctb_addr_rs - 1]] &&
+        s->tab_slice_address[ctb_addr_rs] == s->tab_slice_address[ctb_addr_rs - 1]) {
+        int xp_pu = (x0 - 1) >> log2_min_pu_size;
+        int xq_pu =  x0      >> log2_min_pu_size;
+        int xp_tu = (x0 - 1) >> log2_min_tu_size;
+        int xq_tu =  x0      >> log2_min_tu_size;
+
+        for (i = y0; i < y_end; i += 4) {
+            int y_pu      = i >> log2_min_pu_size;
+            int y_tu      = i >> log2_min_tu_size;
+            MvField *left = &tab_mvf[y_pu * min_pu_width + xp_pu];
+            MvField *curr = &tab_mvf[y_pu * min_pu_width + xq_pu];
+            uint8_t left_cbf_luma = s->cbf_luma[y_tu * min_tu_width + xp_tu];
+            uint8_t curr_cbf_luma = s->cbf_luma[y_tu * min_tu_width + xq_tu];
+
+            bs = boundary_strength(s, curr, curr_cbf_luma,
+                                   left, left_cbf_luma, rpl, 1);
+            if (bs)
+                s->vertical_bs[(x0 >> 3) + (i >> 2) * s->bs_width] = bs;
+        }
+    }
+}
+
 #undef LUMA
 #undef CB
 #undef CR
@@ -769,13 +769,45 @@ static int hls_slice_header(HEVCContext *s)
 
     sh->num_entry_point_offsets = 0;
     if (s->ps.pps->tiles_enabled_flag || s->ps.pps->entropy_coding_sync_enabled_flag) {
-        sh->num_entry_point_offsets = get_ue_golomb_long(gb);
-        if (sh->num_entry_point_offsets > 0) {
+        unsigned int num_entry_point_offsets = get_ue_golomb_long(gb);
+        unsigned int max_entry_point_offsets;
+
+        if (s->ps.pps->entropy_coding_sync_enabled_flag)
+            max_entry_point_offsets = s->ps.pps->num_tile_columns * s->ps.sps->ctb_height - 1;
+        else
+            max_entry_point_offsets = s->ps.pps->num_tile_columns * s->ps.pps->num_tile_rows - 1;
+        if (num_entry_point_offsets > max_entry_point_offsets) {
+            av_log(s->avctx, AV_LOG_ERROR, "Too many entry points: %u.\n",
+                   num_entry_point_offsets);
+            return AVERROR_INVALIDDATA;
+        }
+
+        if (num_entry_point_offsets > 0) {
             int offset_len = get_ue_golomb_long(gb) + 1;
 
-            for (i = 0; i < sh->num_entry_point_offsets; i++)
-                skip_bits(gb, offset_len);
+            if (offset_len < 1 || offset_len > 32) {
+                av_log(s->avctx, AV_LOG_ERROR,
+                       "Invalid entry point offset length: %d.\n", offset_len);
+                return AVERROR_INVALIDDATA;
+            }
+
+            ret = av_reallocp_array(&sh->entry_point_offset, num_entry_point_offsets,
+                                    sizeof(*sh->entry_point_offset));
+            if (ret < 0)
+                return ret;
+            ret = av_reallocp_array(&sh->substream_offset, num_entry_point_offsets + 1,
+                                    sizeof(*sh->substream_offset));
+            if (ret < 0)
+                return ret;
+            ret = av_reallocp_array(&sh->substream_size, num_entry_point_offsets + 1,
+                                    sizeof(*sh->substream_size));
+            if (ret < 0)
+                return ret;
+
+            for (i = 0; i < num_entry_point_offsets; i++)
+                sh->entry_point_offset[i] = get_bits_long(gb, offset_len) + 1;
         }
+        sh->num_entry_point_offsets = num_entry_point_offsets;
     }
 
     if (s->ps.pps->slice_header_extension_present_flag) {
@@ -2300,14 +2332,30 @@ static void hls_decode_neighbour(HEVCContext *s, int x_ctb, int y_ctb,
     lc->ctb_up_left_flag = ((x_ctb > 0) && (y_ctb > 0)  && (ctb_addr_in_slice-1 >= s->ps.sps->ctb_width) && (s->ps.pps->tile_id[ctb_addr_ts] == s->ps.pps->tile_id[s->ps.pps->ctb_addr_rs_to_ts[ctb_addr_rs-1 - s->ps.sps->ctb_width]]));
 }
 
-static int hls_slice_data(HEVCContext *s)
+static int hls_decode_ctb(HEVCContext *s, int x_ctb, int y_ctb, int ctb_addr_rs)
+{
+    int ret;
+
+    hls_sao_param(s, x_ctb >> s->ps.sps->log2_ctb_size, y_ctb >> s->ps.sps->log2_ctb_size);
+
+    s->deblock[ctb_addr_rs].beta_offset = s->sh.beta_offset;
+    s->deblock[ctb_addr_rs].tc_offset   = s->sh.tc_offset;
+    s->filter_slice_edges[ctb_addr_rs]  = s->sh.slice_loop_filter_across_slices_enabled_flag;
+
+    ret = hls_coding_quadtree(s, x_ctb, y_ctb, s->ps.sps->log2_ctb_size, 0);
+    if (ret < 0)
+        return ret;
+
+    return !ff_hevc_end_of_slice_flag_decode(s);
+}
+
+static int hls_slice_data_serial(HEVCContext *s)
 {
     int ctb_size    = 1 << s->ps.sps->log2_ctb_size;
     int more_data   = 1;
     int x_ctb       = 0;
     int y_ctb       = 0;
     int ctb_addr_ts = s->ps.pps->ctb_addr_rs_to_ts[s->sh.slice_ctb_addr_rs];
-    int ret;
 
     while (more_data && ctb_addr_ts < s->ps.sps->ctb_size) {
         int ctb_addr_rs = s->ps.pps->ctb_addr_ts_to_rs[ctb_addr_ts];
@@ -2318,29 +2366,387 @@ static int hls_slice_data(HEVCContext *s)
 
         ff_hevc_cabac_init(s, ctb_addr_ts);
 
-        hls_sao_param(s, x_ctb >> s->ps.sps->log2_ctb_size, y_ctb >> s->ps.sps->log2_ctb_size);
-
-        s->deblock[ctb_addr_rs].beta_offset = s->sh.beta_offset;
-        s->deblock[ctb_addr_rs].tc_offset   = s->sh.tc_offset;
-        s->filter_slice_edges[ctb_addr_rs]  = s->sh.slice_loop_filter_across_slices_enabled_flag;
-
-        ret = hls_coding_quadtree(s, x_ctb, y_ctb, s->ps.sps->log2_ctb_size, 0);
-        if (ret < 0)
-            return ret;
-        more_data = !ff_hevc_end_of_slice_flag_decode(s);
+        more_data = hls_decode_ctb(s, x_ctb, y_ctb, ctb_addr_rs);
+        if (more_data < 0)
+            return more_data;
 
         ctb_addr_ts++;
         ff_hevc_save_states(s, ctb_addr_ts);
-        ff_hevc_hls_filters(s, x_ctb, y_ctb, ctb_size);
+        if (!s->deferred_filters)
+            ff_hevc_hls_filters(s, x_ctb, y_ctb, ctb_size);
     }
 
     if (x_ctb + ctb_size >= s->ps.sps->width &&
-        y_ctb + ctb_size >= s->ps.sps->height)
+        y_ctb + ctb_size >= s->ps.sps->height && !s->deferred_filters)
         ff_hevc_hls_filter(s, x_ctb, y_ctb);
 
     return ctb_addr_ts;
 }
 
+#if HAVE_THREADS
+static void await_ctb(HEVCThreadData *td, int pos)
+{
+    if (atomic_load_explicit(&td->ctb_pos, memory_order_acquire) >= pos)
+        return;
+
+    pthread_mutex_lock(&td->lock);
+    while (atomic_load_explicit(&td->ctb_pos, memory_order_relaxed) < pos)
+        pthread_cond_wait(&td->cond, &td->lock);
+    pthread_mutex_unlock(&td->lock);
+}
+
+static void report_ctb(HEVCThreadData *td, int pos)
+{
+    pthread_mutex_lock(&td->lock);
+    atomic_store_explicit(&td->ctb_pos, pos, memory_order_release);
+    pthread_cond_broadcast(&td->cond);
+    pthread_mutex_unlock(&td->lock);
+}
+#else
+static void await_ctb(HEVCThreadData *td, int pos) { }
+static void report_ctb(HEVCThreadData *td, int pos) { }
+#endif
+
+/**
+ * Claim the next CTB row of a WPP slice segment for the job td.
+ *
+ * The rows are handed out in order, so the job decoding the row above has
+ * always started already, whichever order the jobs are run in.
+ *
+ * @param prev set to the job that claimed the row above
+ * @return the index of the row in the slice segment
+ */
+static int claim_wpp_row(HEVCContext *s0, int job, HEVCThreadData **prev)
+{
+    int claim = atomic_load_explicit(&s0->wpp_claim, memory_order_relaxed);
+
+    /* the next row index in the upper bits, the job that got the last one
+     * in the lower 16 */
+    while (!atomic_compare_exchange_weak_explicit(&s0->wpp_claim, &claim,
+                                                  (((claim >> 16) + 1) << 16) | job,
+                                                  memory_order_relaxed,
+                                                  memory_order_relaxed))
+        ;
+
+    *prev = &s0->thread_data[claim & 0xFFFF];
+    return claim >> 16;
+}
+
+/**
+ * Decode the CTB rows of a slice segment with entropy_coding_sync_enabled_flag
+ * set. The jobs claim the rows one at a time; each CTB is only decoded once
+ * the row above has progressed two CTBs further, which is also where the
+ * CABAC context variables of the row are inherited from.
+ */
+static int hls_decode_entry_wpp(AVCodecContext *avctx, void *arg, int job,
+                                int thread)
+{
+    HEVCContext *s0         = avctx->priv_data;
+    HEVCThreadData *td      = &s0->thread_data[job];
+    HEVCThreadData *prev_td;
+    HEVCContext *s          = td->s;
+    const uint8_t *data     = s->HEVClc.gb.buffer;
+    int log2_ctb_size       = s->ps.sps->log2_ctb_size;
+    int ctb_width           = s->ps.sps->ctb_width;
+    int first_row           = s->sh.slice_ctb_addr_rs / ctb_width;
+    int ctb_addr_ts         = 0;
+    int more_data           = 1;
+    int i, ret;
+
+    while ((i = claim_wpp_row(s0, job, &prev_td)) <= s->sh.num_entry_point_offsets) {
+        int y = first_row + i;
+
+        td->last_row = i;
+        if (i) {
+            ctb_addr_ts = y * ctb_width;
+            await_ctb(prev_td, ((y - 1) << 16) | FFMIN(2, ctb_width));
+            ff_hevc_cabac_init_substream(s, data + s->sh.substream_offset[i],
+                                         s->sh.substream_size[i],
+                                         ctb_width > 1 ? prev_td->s->cabac_state : NULL);
+        } else {
+            ctb_addr_ts = s->sh.slice_ctb_addr_rs;
+        }
+
+        do {
+            int x = ctb_addr_ts % ctb_width;
+
+            if (i)
+                await_ctb(prev_td, ((y - 1) << 16) | FFMIN(x + 2, ctb_width));
+
+            hls_decode_neighbour(s, x << log2_ctb_size, y << log2_ctb_size,
+                                 ctb_addr_ts);
+            if (!i && ctb_addr_ts == s->sh.slice_ctb_addr_rs)
+                ff_hevc_cabac_init(s, ctb_addr_ts);
+
+            more_data = hls_decode_ctb(s, x << log2_ctb_size, y << log2_ctb_size,
+                                       ctb_addr_ts);
+            if (more_data < 0) {
+                ret = more_data;
+                goto fail;
+            }
+
+            ctb_addr_ts++;
+            ff_hevc_save_states(s, ctb_addr_ts);
+            report_ctb(td, (y << 16) | (x + 1));
+        } while (more_data && ctb_addr_ts % ctb_width);
+
+        /* only the last row may end the slice segment, and it must */
+        if (!more_data != (i == s->sh.num_entry_point_offsets)) {
+            ret = AVERROR_INVALIDDATA;
+            goto fail;
+        }
+    }
+
+    td->ctb_addr_ts = ctb_addr_ts;
+    report_ctb(td, INT_MAX);
+    return 0;
+fail:
+    td->ctb_addr_ts = ret;
+    report_ctb(td, INT_MAX);
+    return ret;
+}
+
+/**
+ * Decode the tiles of a slice segment, job n decodes tiles n, n + nb_jobs, ...
+ */
+static int hls_decode_entry_tiles(AVCodecContext *avctx, void *arg, int job,
+                                  int thread)
+{
+    HEVCContext *s0     = avctx->priv_data;
+    HEVCThreadData *td  = &s0->thread_data[job];
+    HEVCContext *s      = td->s;
+    const uint8_t *data = s->HEVClc.gb.buffer;
+    int log2_ctb_size   = s->ps.sps->log2_ctb_size;
+    int ctb_width       = s->ps.sps->ctb_width;
+    int first_ctb       = s->ps.pps->ctb_addr_rs_to_ts[s->sh.slice_ctb_addr_rs];
+    int first_tile      = s->ps.pps->tile_id[first_ctb];
+    int ctb_addr_ts     = 0;
+    int more_data       = 1;
+    int i;
+
+    for (i = job; i <= s->sh.num_entry_point_offsets; i += s0->nb_jobs) {
+        int tile = first_tile + i;
+
+        if (!more_data) {
+            td->ctb_addr_ts = AVERROR_INVALIDDATA;
+            return AVERROR_INVALIDDATA;
+        }
+
+        if (i) {
+            ctb_addr_ts = s->ps.pps->ctb_addr_rs_to_ts[s->ps.pps->tile_pos_rs[tile]];
+            s->HEVClc.defer_tile_edges = 1;
+            ff_hevc_cabac_init_substream(s, data + s->sh.substream_offset[i],
+                                         s->sh.substream_size[i], NULL);
+        } else {
+            ctb_addr_ts = first_ctb;
+        }
+
+        do {
+            int ctb_addr_rs = s->ps.pps->ctb_addr_ts_to_rs[ctb_addr_ts];
+            int x_ctb       = (ctb_addr_rs % ctb_width) << log2_ctb_size;
+            int y_ctb       = (ctb_addr_rs / ctb_width) << log2_ctb_size;
+
+            hls_decode_neighbour(s, x_ctb, y_ctb, ctb_addr_ts);
+            if (ctb_addr_ts == first_ctb)
+                ff_hevc_cabac_init(s, ctb_addr_ts);
+
+            more_data = hls_decode_ctb(s, x_ctb, y_ctb, ctb_addr_rs);
+            if (more_data < 0) {
+                td->ctb_addr_ts = more_data;
+                return more_data;
+            }
+            ctb_addr_ts++;
+        } while (more_data && ctb_addr_ts < s->ps.sps->ctb_size &&
+                 s->ps.pps->tile_id[ctb_addr_ts] == tile);
+
+        if (more_data && i == s->sh.num_entry_point_offsets) {
+            td->ctb_addr_ts = AVERROR_INVALIDDATA;
+            return AVERROR_INVALIDDATA;
+        }
+    }
+
+    td->ctb_addr_ts = ctb_addr_ts;
+    return 0;
+}
+
+/**
+ * Locate the substreams of the slice segment data in the unescaped NAL unit.
+ * The entry point offsets count the emulation prevention bytes, which are
+ * not present in the buffer the CABAC decoder reads.
+ */
+static int hls_substreams(HEVCContext *s, const H2645NAL *nal)
+{
+    SliceHeader *sh    = &s->sh;
+    const uint8_t *raw = nal->raw_data;
+    /* slice_segment_data() follows the byte_alignment() ending the header */
+    int data_offset    = (get_bits_count(&s->HEVClc.gb) + 8) >> 3;
+    int nb_entries     = sh->num_entry_point_offsets;
+    int first_ctb      = s->ps.pps->ctb_addr_rs_to_ts[sh->slice_ctb_addr_rs];
+    int64_t target     = -1;
+    int i, pos = 0, zeros = 0, nb_substreams = 0;
+
+    /* a slice segment with several substreams starts a CTB row or a tile */
+    if (s->ps.pps->entropy_coding_sync_enabled_flag) {
+        if (sh->slice_ctb_addr_rs % s->ps.sps->ctb_width ||
+            sh->slice_ctb_addr_rs / s->ps.sps->ctb_width + nb_entries >= s->ps.sps->ctb_height)
+            return AVERROR_INVALIDDATA;
+    } else {
+        int first_tile = s->ps.pps->tile_id[first_ctb];
+
+        if (first_tile + nb_entries >= s->ps.pps->num_tile_columns * s->ps.pps->num_tile_rows ||
+            s->ps.pps->ctb_addr_rs_to_ts[s->ps.pps->tile_pos_rs[first_tile]] != first_ctb)
+            return AVERROR_INVALIDDATA;
+    }
+
+    for (i = 0; i < nal->raw_size && nb_substreams <= nb_entries; i++) {
+        int escape = zeros >= 2 && raw[i] == 3;
+
+        if (target < 0 && !escape && pos == data_offset)
+            target = i;
+        if (i == target) {
+            sh->substream_offset[nb_substreams] = pos;
+            if (nb_substreams < nb_entries)
+                target += sh->entry_point_offset[nb_substreams];
+            nb_substreams++;
+        }
+
+        if (escape) {
+            zeros = 0;
+        } else {
+            zeros = raw[i] ? 0 : zeros + 1;
+            pos++;
+        }
+    }
+    if (nb_substreams <= nb_entries)
+        return AVERROR_INVALIDDATA;
+
+    for (i = 0; i <= nb_entries; i++) {
+        int end = i < nb_entries ? sh->substream_offset[i + 1] : nal->size;
+
+        sh->substream_size[i] = end - sh->substream_offset[i];
+        if (sh->substream_size[i] <= 0)
+            return AVERROR_INVALIDDATA;
+    }
+
+    return 0;
+}
+
+/**
+ * Get the job that decoded the given substream of the slice segment. With
+ * WPP, that is only known for the last substream each job decoded, NULL is
+ * returned for the others.
+ */
+static HEVCThreadData *substream_job(HEVCContext *s, int substream)
+{
+    int i;
+
+    if (!s->ps.pps->entropy_coding_sync_enabled_flag)
+        return &s->thread_data[substream % s->nb_jobs];
+
+    for (i = 0; i < s->nb_jobs; i++)
+        if (s->thread_data[i].last_row == substream)
+            return &s->thread_data[i];
+    return NULL;
+}
+
+static int hls_slice_data_mt(HEVCContext *s)
+{
+    int nb_substreams = s->sh.num_entry_point_offsets + 1;
+    int first_ctb     = s->ps.pps->ctb_addr_rs_to_ts[s->sh.slice_ctb_addr_rs];
+    int wpp           = s->ps.pps->entropy_coding_sync_enabled_flag;
+    HEVCThreadData *last;
+    int i;
+
+    if (!wpp) {
+        int first_tile = s->ps.pps->tile_id[first_ctb];
+        int end;
+
+        /* the neighbour derivation looks at the slice address of the CTBs
+         * of the adjacent tiles, which may be decoded concurrently */
+        for (end = first_ctb; end < s->ps.sps->ctb_size &&
+             s->ps.pps->tile_id[end] < first_tile + nb_substreams; end++)
+            s->tab_slice_address[s->ps.pps->ctb_addr_ts_to_rs[end]] = s->sh.slice_addr;
+    }
+
+    s->nb_jobs = FFMIN(nb_substreams, s->nb_thread_data);
+    for (i = 0; i < s->nb_jobs; i++) {
+        HEVCThreadData *td = &s->thread_data[i];
+
+        memcpy(td->s, s, sizeof(*s));
+        atomic_store_explicit(&td->ctb_pos, 0, memory_order_relaxed);
+        td->ctb_addr_ts = 0;
+        td->last_row    = -1;
+    }
+    atomic_store_explicit(&s->wpp_claim, 0, memory_order_relaxed);
+
+    s->avctx->execute2(s->avctx, wpp ? hls_decode_entry_wpp : hls_decode_entry_tiles,
+                       s->thread_data, NULL, s->nb_jobs);
+
+    for (i = 0; i < s->nb_jobs; i++)
+        if (s->thread_data[i].ctb_addr_ts < 0)
+            return s->thread_data[i].ctb_addr_ts;
+
+    /* carry the state at the end of the slice segment over to the next one */
+    last = substream_job(s, nb_substreams - 1);
+    memcpy(&s->HEVClc, &last->s->HEVClc, sizeof(s->HEVClc));
+    s->HEVClc.defer_tile_edges = 0;
+
+    if (wpp) {
+        int last_row_ctbs = last->ctb_addr_ts % s->ps.sps->ctb_width;
+        HEVCThreadData *td = last;
+
+        if (!last_row_ctbs)
+            last_row_ctbs = s->ps.sps->ctb_width;
+        /* if no job stopped at the row above, its job went on to decode
+         * the last row */
+        if (last_row_ctbs < 2 && nb_substreams > 1 &&
+            substream_job(s, nb_substreams - 2))
+            td = substream_job(s, nb_substreams - 2);
+        memcpy(s->cabac_state, td->s->cabac_state, HEVC_CONTEXTS);
+    } else if (s->ps.pps->loop_filter_across_tiles_enabled_flag &&
+               !s->sh.disable_deblocking_filter_flag) {
+        int first_tile = s->ps.pps->tile_id[first_ctb];
+        int ctb_addr_ts;
+
+        for (ctb_addr_ts = first_ctb; ctb_addr_ts < last->ctb_addr_ts; ctb_addr_ts++) {
+            int ctb_addr_rs = s->ps.pps->ctb_addr_ts_to_rs[ctb_addr_ts];
+
+            if (s->ps.pps->tile_id[ctb_addr_ts] == first_tile)
+                continue;
+            ff_hevc_tile_boundary_strengths(s,
+                (ctb_addr_rs % s->ps.sps->ctb_width) << s->ps.sps->log2_ctb_size,
+                (ctb_addr_rs / s->ps.sps->ctb_width) << s->ps.sps->log2_ctb_size);
+        }
+    }
+
+    return last->ctb_addr_ts;
+}
+
+static int hls_slice_data(HEVCContext *s, const H2645NAL *nal)
+{
+    if (s->deferred_filters && s->sh.num_entry_point_offsets > 0) {
+        if (hls_substreams(s, nal) >= 0)
+            return hls_slice_data_mt(s);
+        av_log(s->avctx, AV_LOG_WARNING,
+               "Invalid entry points, decoding the slice in one thread.\n");
+    }
+
+    return hls_slice_data_serial(s);
+}
+
+/* run the in-loop filters on a frame whose slices did not filter it */
+static void hls_filter_frame(HEVCContext *s)
+{
+    int ctb_size = 1 << s->ps.sps->log2_ctb_size;
+    int x, y;
+
+    for (y = 0; y < s->ps.sps->height; y += ctb_size) {
+        for (x = 0; x < s->ps.sps->width; x += ctb_size)
+            ff_hevc_hls_filter(s, x, y);
+        ff_thread_report_progress(&s->ref->tf, y, 0);
+    }
+}
+
 static void restore_tqb_pixels(HEVCContext *s)
 {
     int min_pu_size = 1 << s->ps.sps->log2_min_pu_size;
@@ -2449,6 +2855,12 @@ static int hevc_frame_start(HEVCContext *s)
     if (s->ps.pps->tiles_enabled_flag)
         lc->end_of_tiles_x = s->ps.pps->column_width[0] << s->ps.sps->log2_ctb_size;
 
+    /* either the WPP rows or the tiles of a slice segment may be decoded
+     * concurrently, the in-loop filters then have to wait for the whole frame */
+    s->deferred_filters = s->nb_thread_data > 1 && !s->avctx->hwaccel &&
+                          s->ps.pps->entropy_coding_sync_enabled_flag !=
+                          s->ps.pps->tiles_enabled_flag;
+
     ret = ff_hevc_set_new_ref(s, s->ps.sps->sao_enabled ? &s->sao_frame : &s->frame,
                               s->poc);
     if (ret < 0)
@@ -2591,9 +3003,11 @@ static int decode_nal_unit(HEVCContext *s, const H2645NAL *nal)
             if (ret < 0)
                 goto fail;
         } else {
-            ctb_addr_ts = hls_slice_data(s);
+            ctb_addr_ts = hls_slice_data(s, nal);
             if (ctb_addr_ts >= (s->ps.sps->ctb_width * s->ps.sps->ctb_height)) {
                 s->is_decoded = 1;
+                if (s->deferred_filters)
+                    hls_filter_frame(s);
                 if ((s->ps.pps->transquant_bypass_enable_flag ||
                      (s->ps.sps->pcm.loop_filter_disable_flag && s->ps.sps->pcm_enabled_flag)) &&
                     s->ps.sps->sao_enabled)
@@ -2918,6 +3332,20 @@ static av_cold int hevc_decode_free(AVCodecContext *avctx)
 
     av_freep(&s->md5_ctx);
 
+    for (i = 0; i < s->nb_thread_data; i++) {
+        av_freep(&s->thread_data[i].s);
+#if HAVE_THREADS
+        pthread_mutex_destroy(&s->thread_data[i].lock);
+        pthread_cond_destroy(&s->thread_data[i].cond);
+#endif
+    }
+    av_freep(&s->thread_data);
+    s->nb_thread_data = 0;
+
+    av_freep(&s->sh.entry_point_offset);
+    av_freep(&s->sh.substream_offset);
+    av_freep(&s->sh.substream_size);
+
     av_frame_free(&s->tmp_frame);
     av_frame_free(&s->output_frame);
 
@@ -2968,6 +3396,26 @@ static av_cold int hevc_init_context(AVCodecContext *avctx)
 
     ff_bswapdsp_init(&s->bdsp);
 
+    if (avctx->active_thread_type & FF_THREAD_SLICE) {
+        s->thread_data = av_mallocz_array(avctx->thread_count,
+                                          sizeof(*s->thread_data));
+        if (!s->thread_data)
+            goto fail;
+
+        for (i = 0; i < avctx->thread_count; i++) {
+            HEVCThreadData *td = &s->thread_data[i];
+
+            td->s = av_malloc(sizeof(*td->s));
+            if (!td->s)
+                goto fail;
+#if HAVE_THREADS
+            pthread_mutex_init(&td->lock, NULL);
+            pthread_cond_init(&td->cond, NULL);
+#endif
+            s->nb_thread_data++;
+        }
+    }
+
     s->context_initialized = 1;
 
     return 0;
@@ -3118,7 +3566,7 @@ AVCodec ff_hevc_decoder = {
     .update_thread_context = hevc_update_thread_context,
     .init_thread_copy      = hevc_init_thread_copy,
     .capabilities          = AV_CODEC_CAP_DR1 | AV_CODEC_CAP_DELAY |
-                             AV_CODEC_CAP_FRAME_THREADS,
+                             AV_CODEC_CAP_SLICE_THREADS | AV_CODEC_CAP_FRAME_THREADS,
     .profiles              = NULL_IF_CONFIG_SMALL(ff_hevc_profiles),
     .caps_internal         = FF_CODEC_CAP_EXPORTS_CROPPING | FF_CODEC_CAP_INIT_THREADSAFE,
     .hw_configs            = (const AVCodecHWConfigInternal*[]) {
@@ -23,11 +23,13 @@
 #ifndef AVCODEC_HEVCDEC_H
 #define AVCODEC_HEVCDEC_H
 
+#include <stdatomic.h>
 #include <stddef.h>
 #include <stdint.h>
 
 #include "libavutil/buffer.h"
 #include "libavutil/md5.h"
+#include "libavutil/thread.h"
 
 #include "avcodec.h"
 #include "bswapdsp.h"
@@ -281,6 +283,10 @@ typedef struct SliceHeader {
     unsigned int max_num_merge_cand; ///< 5 - 5_minus_max_num_merge_cand
 
     int num_entry_point_offsets;
+    unsigned int *entry_point_offset; ///< entry_point_offset_minus1 + 1
+    ///< start and size of each substream, in bytes of the unescaped NAL
+    int *substream_offset;
+    int *substream_size;
 
     int8_t slice_qp;
 
@@ -443,8 +449,31 @@ typedef struct HEVCLocalContext {
     /* properties of the boundary of the current CTB for the purposes
      * of the deblocking filter */
     int boundary_flags;
+
+    /* boundary strengths of edges shared with another tile are computed
+     * after all the tiles of the slice have been decoded */
+    uint8_t defer_tile_edges;
 } HEVCLocalContext;
 
+/**
+ * State of one job of the slice threaded (WPP or tiles) decoding path.
+ */
+typedef struct HEVCThreadData {
+    struct HEVCContext *s; ///< private copy of the decoder context
+
+#if HAVE_THREADS
+    pthread_mutex_t lock;
+    pthread_cond_t  cond;
+#endif
+    /**
+     * (ctb_y << 16) | ctb_x of the first CTB of the current row the job
+     * has not decoded yet, INT_MAX once the job is done
+     */
+    atomic_int ctb_pos;
+    int ctb_addr_ts;       ///< address of the CTB following the job's last one
+    int last_row;          ///< index of the last WPP row claimed by the job, -1 if none
+} HEVCThreadData;
+
 typedef struct HEVCContext {
     const AVClass *c;  // needed by private avoptions
     AVCodecContext *avctx;
@@ -453,6 +482,20 @@ typedef struct HEVCContext {
 
     uint8_t cabac_state[HEVC_CONTEXTS];
 
+    HEVCThreadData *thread_data;
+    int nb_thread_data;
+    int nb_jobs;    ///< number of jobs the current slice segment is split into
+    /**
+     * (next row << 16) | job that claimed the previous one, for handing out
+     * the CTB rows of a WPP slice segment in order
+     */
+    atomic_int wpp_claim;
+    /**
+     * 1 if the in-loop filters are run after the whole frame has been
+     * decoded, which is needed when slices are decoded with several threads
+     */
+    uint8_t deferred_filters;
+
     /** 1 if the independent slice segment header was successfully parsed */
     uint8_t slice_initialized;
 
@@ -564,6 +607,13 @@ int ff_hevc_slice_rpl(HEVCContext *s);
 
 void ff_hevc_save_states(HEVCContext *s, int ctb_addr_ts);
 void ff_hevc_cabac_init(HEVCContext *s, int ctb_addr_ts);
+/**
+ * Initialize the CABAC decoder for a WPP or tile substream starting at buf.
+ * The context variables are copied from states if it is not NULL and set
+ * to their initial values otherwise.
+ */
+void ff_hevc_cabac_init_substream(HEVCContext *s, const uint8_t *buf, int size,
+                                  const uint8_t *states);
 int ff_hevc_sao_merge_flag_decode(HEVCContext *s);
 int ff_hevc_sao_type_idx_decode(HEVCContext *s);
 int ff_hevc_sao_band_position_decode(HEVCContext *s);
@@ -646,6 +696,7 @@ void ff_hevc_deblocking_boundary_strengths(HEVCContext *s, int x0, int y0,
                                            int log2_trafo_size);
 int ff_hevc_cu_qp_delta_sign_flag(HEVCContext *s);
 int ff_hevc_cu_qp_delta_abs(HEVCContext *s);
+void ff_hevc_tile_boundary_strengths(HEVCContext *s, int x0, int y0);
 void ff_hevc_hls_filter(HEVCContext *s, int x, int y);
 void ff_hevc_hls_filters(HEVCContext *s, int x_ctb, int y_ctb, int ctb_size);
 
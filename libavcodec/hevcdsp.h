@@ -49,13 +49,12 @@ typedef struct HEVCDSPContext {
     void (*idct[4])(int16_t *coeffs, int col_limit);
     void (*idct_dc[4])(int16_t *coeffs);
 
-    void (*sao_band_filter[4])(uint8_t *dst, uint8_t *src, ptrdiff_t stride,
-                               struct SAOParams *sao, int *borders,
-                               int width, int height, int c_idx);
-    void (*sao_edge_filter[4])(uint8_t *dst, uint8_t *src, ptrdiff_t stride,
-                               struct SAOParams *sao, int *borders, int width,
-                               int height, int c_idx, uint8_t vert_edge,
-                               uint8_t horiz_edge, uint8_t diag_edge);
+    void (*sao_band_filter)(uint8_t *dst, uint8_t *src, ptrdiff_t stride,
+                            const int *offset_val, int band_position,
+                            int width, int height);
+    void (*sao_edge_filter)(uint8_t *dst, uint8_t *src, ptrdiff_t stride,
+                            const int *offset_val, int eo_class,
+                            int width, int height);
 
     void (*put_hevc_qpel[2][2][8])(int16_t *dst, ptrdiff_t dststride, uint8_t *src,
                                    ptrdiff_t srcstride, int height,
@@ -86,6 +86,17 @@ typedef struct HYuvContext {
     BswapDSPContext bdsp;
     HuffYUVDSPContext hdsp;
     HuffYUVEncDSPContext hencdsp;
+
+    /**
+     * Encoder frame batching. With slice threading and fixed tables, up to
+     * nb_frames input frames are queued and then coded in parallel, each
+     * with its own copy of the context.
+     */
+    struct HYuvFrame *frames;
+    int nb_frames;
+    int nb_queued;          ///< frames[0..nb_queued-1] wait to be encoded
+    int nb_encoded;         ///< number of frames in the last encoded batch
+    int next_output;        ///< next encoded frame to return
 } HYuvContext;
 
 void ff_huffyuv_common_init(AVCodecContext *s);
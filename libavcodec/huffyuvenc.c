@@ -26,6 +26,7 @@
  * huffyuv encoder
  */
 
+#include "libavutil/frame.h"
 #include "libavutil/opt.h"
 
 #include "avcodec.h"
@@ -35,6 +36,13 @@
 #include "internal.h"
 #include "put_bits.h"
 
+typedef struct HYuvFrame {
+    HYuvContext *ctx;       ///< context used to code this frame
+    AVFrame *frame;
+    AVPacket pkt;
+    int ret;
+} HYuvFrame;
+
 static inline int sub_left_prediction(HYuvContext *s, uint8_t *dst,
                                       uint8_t *src, int w, int left)
 {
@@ -296,10 +304,46 @@ FF_ENABLE_DEPRECATION_WARNINGS
                 s->stats[i][j]= 0;
     }
 
-    ff_huffyuv_alloc_temp(s);
+    if (ff_huffyuv_alloc_temp(s) < 0)
+        return AVERROR(ENOMEM);
 
     s->picture_number=0;
 
+    /*
+     * Frames only depend on each other through adaptive tables or pass 1
+     * statistics, without those a batch of frames can be coded in parallel.
+     */
+    s->nb_frames = 1;
+    if (avctx->active_thread_type & FF_THREAD_SLICE && !s->context &&
+        !(s->flags & AV_CODEC_FLAG_PASS1))
+        s->nb_frames = avctx->thread_count;
+
+    s->frames = av_mallocz_array(s->nb_frames, sizeof(*s->frames));
+    if (!s->frames)
+        return AVERROR(ENOMEM);
+
+    for (i = 0; i < s->nb_frames; i++) {
+        HYuvFrame *f = &s->frames[i];
+
+        f->frame = av_frame_alloc();
+        if (!f->frame)
+            return AVERROR(ENOMEM);
+
+        if (s->nb_frames == 1) {
+            f->ctx = s;
+            continue;
+        }
+
+        f->ctx = av_malloc(sizeof(*s));
+        if (!f->ctx)
+            return AVERROR(ENOMEM);
+        *f->ctx = *s;
+        memset(f->ctx->temp, 0, sizeof(f->ctx->temp));
+        f->ctx->frames = NULL;
+        if (ff_huffyuv_alloc_temp(f->ctx) < 0)
+            return AVERROR(ENOMEM);
+    }
+
     return 0;
 }
 static int encode_422_bitstream(HYuvContext *s, int offset, int count)
@@ -453,10 +497,9 @@ static inline int encode_bgra_bitstream(HYuvContext *s, int count, int planes)
     return 0;
 }
 
-static int encode_frame(AVCodecContext *avctx, AVPacket *pkt,
-                        const AVFrame *pict, int *got_packet)
+static int encode_picture(HYuvContext *s, AVPacket *pkt, const AVFrame *pict)
 {
-    HYuvContext *s = avctx->priv_data;
+    AVCodecContext *avctx = s->avctx;
     const int width = s->width;
     const int width2 = s->width>>1;
     const int height = s->height;
@@ -659,6 +702,76 @@ static int encode_frame(AVCodecContext *avctx, AVPacket *pkt,
     put_bits(&s->pb, 15, 0);
     size /= 4;
 
+    if (!(s->avctx->flags2 & AV_CODEC_FLAG2_NO_OUTPUT)) {
+        flush_put_bits(&s->pb);
+        s->bdsp.bswap_buf((uint32_t *) pkt->data, (uint32_t *) pkt->data, size);
+    }
+
+    pkt->size = size * 4;
+
+    return 0;
+}
+
+static int encode_frame_thread(AVCodecContext *avctx, void *arg)
+{
+    HYuvFrame *f = arg;
+
+    f->ret = encode_picture(f->ctx, &f->pkt, f->frame);
+    f->pkt.pts = f->pkt.dts = f->frame->pts;
+    av_frame_unref(f->frame);
+
+    return 0;
+}
+
+static int encode_frame(AVCodecContext *avctx, AVPacket *pkt,
+                        const AVFrame *pict, int *got_packet)
+{
+    HYuvContext *s = avctx->priv_data;
+    HYuvFrame *f;
+    int i, ret;
+
+    /* Every call returns at most one packet, so the slot for a new frame
+     * has always been returned already. */
+    if (pict) {
+        ret = av_frame_ref(s->frames[s->nb_queued].frame, pict);
+        if (ret < 0)
+            return ret;
+        s->nb_queued++;
+    }
+
+    if (s->next_output == s->nb_encoded && s->nb_queued &&
+        (s->nb_queued == s->nb_frames || !pict)) {
+        avctx->execute(avctx, encode_frame_thread, s->frames, NULL,
+                       s->nb_queued, sizeof(*s->frames));
+        s->nb_encoded  = s->nb_queued;
+        s->nb_queued   = 0;
+        s->next_output = 0;
+    }
+
+    if (s->next_output == s->nb_encoded)
+        return 0;
+
+    f = &s->frames[s->next_output++];
+    if (f->ret < 0) {
+        av_packet_unref(&f->pkt);
+        return f->ret;
+    }
+
+    if (!pkt->data) {
+        av_packet_move_ref(pkt, &f->pkt);
+    } else {
+        if (pkt->size < f->pkt.size) {
+            av_log(avctx, AV_LOG_ERROR, "Provided packet is too small.\n");
+            av_packet_unref(&f->pkt);
+            return AVERROR(EINVAL);
+        }
+        memcpy(pkt->data, f->pkt.data, f->pkt.size);
+        pkt->size = f->pkt.size;
+        pkt->pts  = f->pkt.pts;
+        pkt->dts  = f->pkt.dts;
+        av_packet_unref(&f->pkt);
+    }
+
     if ((s->flags & AV_CODEC_FLAG_PASS1) && (s->picture_number & 31) == 0) {
         int j;
         char *p = avctx->stats_out;
@@ -674,14 +787,9 @@ static int encode_frame(AVCodecContext *avctx, AVPacket *pkt,
         }
     } else
         avctx->stats_out[0] = '\0';
-    if (!(s->avctx->flags2 & AV_CODEC_FLAG2_NO_OUTPUT)) {
-        flush_put_bits(&s->pb);
-        s->bdsp.bswap_buf((uint32_t *) pkt->data, (uint32_t *) pkt->data, size);
-    }
 
     s->picture_number++;
 
-    pkt->size   = size * 4;
     pkt->flags |= AV_PKT_FLAG_KEY;
     *got_packet = 1;
 
@@ -691,6 +799,21 @@ static int encode_frame(AVCodecContext *avctx, AVPacket *pkt,
 static av_cold int encode_end(AVCodecContext *avctx)
 {
     HYuvContext *s = avctx->priv_data;
+    int i;
+
+    if (s->frames) {
+        for (i = 0; i < s->nb_frames; i++) {
+            HYuvFrame *f = &s->frames[i];
+
+            av_frame_free(&f->frame);
+            av_packet_unref(&f->pkt);
+            if (f->ctx && f->ctx != s) {
+                ff_huffyuv_common_end(f->ctx);
+                av_freep(&f->ctx);
+            }
+        }
+    }
+    av_freep(&s->frames);
 
     ff_huffyuv_common_end(s);
 
@@ -734,6 +857,7 @@ AVCodec ff_huffyuv_encoder = {
     .init           = encode_init,
     .encode2        = encode_frame,
     .close          = encode_end,
+    .capabilities   = AV_CODEC_CAP_SLICE_THREADS | AV_CODEC_CAP_DELAY,
     .pix_fmts       = (const enum AVPixelFormat[]){
         AV_PIX_FMT_YUV422P, AV_PIX_FMT_RGB24,
         AV_PIX_FMT_RGB32, AV_PIX_FMT_NONE
@@ -761,6 +885,7 @@ AVCodec ff_ffvhuff_encoder = {
     .init           = encode_init,
     .encode2        = encode_frame,
     .close          = encode_end,
+    .capabilities   = AV_CODEC_CAP_SLICE_THREADS | AV_CODEC_CAP_DELAY,
     .pix_fmts       = (const enum AVPixelFormat[]){
         AV_PIX_FMT_YUV420P, AV_PIX_FMT_YUV422P, AV_PIX_FMT_RGB24,
         AV_PIX_FMT_RGB32, AV_PIX_FMT_NONE
@@ -59,6 +59,13 @@
  * dimensions to coded rather than display values.
  */
 #define FF_CODEC_CAP_EXPORTS_CROPPING       (1 << 3)
+/**
+ * The jobs of one execute2() call wait on the progress of other jobs of
+ * the same call, so they must all run at the same time. Such codecs keep
+ * their own slice threads instead of using the shared slice thread pool,
+ * which does not guarantee that.
+ */
+#define FF_CODEC_CAP_SLICE_THREAD_SYNC      (1 << 4)
 
 #ifdef DEBUG
 #   define ff_dlog(ctx, ...) av_log(ctx, AV_LOG_DEBUG, __VA_ARGS__)
@@ -43,6 +43,7 @@
 #include "mjpegdec.h"
 #include "jpeglsdec.h"
 #include "put_bits.h"
+#include "thread.h"
 
 
 static int build_vlc(VLC *vlc, const uint8_t *bits_table,
@@ -68,34 +69,55 @@ static int build_vlc(VLC *vlc, const uint8_t *bits_table,
                               huff_code, 2, 2, huff_sym, 2, 2, use_static);
 }
 
-static int build_basic_mjpeg_vlc(MJpegDecodeContext *s)
+/* Set the Huffman table of a class and index, AC tables are also used as
+ * the progressive ones. */
+static int init_huffman_table(MJpegDecodeContext *s, int class, int index,
+                              const uint8_t *bits_table,
+                              const uint8_t *val_table, int nb_codes)
 {
-    int ret;
+    int i, n = 0, ret;
 
-    if ((ret = build_vlc(&s->vlcs[0][0], avpriv_mjpeg_bits_dc_luminance,
-                         avpriv_mjpeg_val_dc, 12, 0, 0)) < 0)
-        return ret;
+    for (i = 1; i <= 16; i++)
+        n += bits_table[i];
 
-    if ((ret = build_vlc(&s->vlcs[0][1], avpriv_mjpeg_bits_dc_chrominance,
-                         avpriv_mjpeg_val_dc, 12, 0, 0)) < 0)
+    ff_free_vlc(&s->vlcs[class][index]);
+    if ((ret = build_vlc(&s->vlcs[class][index], bits_table, val_table,
+                         nb_codes, 0, class > 0)) < 0)
         return ret;
 
-    if ((ret = build_vlc(&s->vlcs[1][0], avpriv_mjpeg_bits_ac_luminance,
-                         avpriv_mjpeg_val_ac_luminance, 251, 0, 1)) < 0)
-        return ret;
+    if (class > 0) {
+        ff_free_vlc(&s->vlcs[2][index]);
+        if ((ret = build_vlc(&s->vlcs[2][index], bits_table, val_table,
+                             nb_codes, 0, 0)) < 0)
+            return ret;
+    }
+
+    memcpy(s->huff_bits[class][index] + 1, bits_table + 1, 16);
+    memcpy(s->huff_val[class][index], val_table, n);
+    memset(s->huff_val[class][index] + n, 0, 256 - n);
+    s->huff_nb_codes[class][index] = nb_codes;
+    return 0;
+}
+
+static int build_basic_mjpeg_vlc(MJpegDecodeContext *s)
+{
+    int ret;
 
-    if ((ret = build_vlc(&s->vlcs[1][1], avpriv_mjpeg_bits_ac_chrominance,
-                         avpriv_mjpeg_val_ac_chrominance, 251, 0, 1)) < 0)
+    if ((ret = init_huffman_table(s, 0, 0, avpriv_mjpeg_bits_dc_luminance,
+                                  avpriv_mjpeg_val_dc, 12)) < 0)
         return ret;
 
-    if ((ret = build_vlc(&s->vlcs[2][0], avpriv_mjpeg_bits_ac_luminance,
-                         avpriv_mjpeg_val_ac_luminance, 251, 0, 0)) < 0)
+    if ((ret = init_huffman_table(s, 0, 1, avpriv_mjpeg_bits_dc_chrominance,
+                                  avpriv_mjpeg_val_dc, 12)) < 0)
         return ret;
 
-    if ((ret = build_vlc(&s->vlcs[2][1], avpriv_mjpeg_bits_ac_chrominance,
-                         avpriv_mjpeg_val_ac_chrominance, 251, 0, 0)) < 0)
+    if ((ret = init_huffman_table(s, 1, 0, avpriv_mjpeg_bits_ac_luminance,
+                                  avpriv_mjpeg_val_ac_luminance, 251)) < 0)
         return ret;
 
+    if ((ret = init_huffman_table(s, 1, 1, avpriv_mjpeg_bits_ac_chrominance,
+                                  avpriv_mjpeg_val_ac_chrominance, 251)) < 0)
+        return ret;
 
     return 0;
 }
@@ -221,19 +243,11 @@ int ff_mjpeg_decode_dht(MJpegDecodeContext *s)
         len -= n;
 
         /* build VLC and flush previous vlc if present */
-        ff_free_vlc(&s->vlcs[class][index]);
         av_log(s->avctx, AV_LOG_DEBUG, "class=%d index=%d nb_codes=%d\n",
                class, index, code_max + 1);
-        if ((ret = build_vlc(&s->vlcs[class][index], bits_table, val_table,
-                             code_max + 1, 0, class > 0)) < 0)
+        if ((ret = init_huffman_table(s, class, index, bits_table, val_table,
+                                      code_max + 1)) < 0)
             return ret;
-
-        if (class > 0) {
-            ff_free_vlc(&s->vlcs[2][index]);
-            if ((ret = build_vlc(&s->vlcs[2][index], bits_table, val_table,
-                                 code_max + 1, 0, 0)) < 0)
-                return ret;
-        }
     }
     return 0;
 }
@@ -243,6 +257,7 @@ int ff_mjpeg_decode_sof(MJpegDecodeContext *s)
     int h_count[MAX_COMPONENTS] = { 0 };
     int v_count[MAX_COMPONENTS] = { 0 };
     int len, nb_components, i, width, height, bits, pix_fmt_id, ret;
+    ThreadFrame frame = { .f = s->picture_ptr };
 
     /* XXX: verify len field validity */
     len     = get_bits(&s->gb, 16);
@@ -410,7 +425,7 @@ int ff_mjpeg_decode_sof(MJpegDecodeContext *s)
     }
 
     av_frame_unref(s->picture_ptr);
-    if (ff_get_buffer(s->avctx, s->picture_ptr, AV_GET_BUFFER_FLAG_REF) < 0) {
+    if (ff_thread_get_buffer(s->avctx, &frame, AV_GET_BUFFER_FLAG_REF) < 0) {
         av_log(s->avctx, AV_LOG_ERROR, "get_buffer() failed\n");
         return -1;
     }
@@ -446,10 +461,11 @@ int ff_mjpeg_decode_sof(MJpegDecodeContext *s)
     return 0;
 }
 
-static inline int mjpeg_decode_dc(MJpegDecodeContext *s, int dc_index)
+static inline int mjpeg_decode_dc(MJpegDecodeContext *s, GetBitContext *gb,
+                                  int dc_index)
 {
     int code;
-    code = get_vlc2(&s->gb, s->vlcs[0][dc_index].table, 9, 2);
+    code = get_vlc2(gb, s->vlcs[0][dc_index].table, 9, 2);
     if (code < 0) {
         av_log(s->avctx, AV_LOG_WARNING,
                "mjpeg_decode_dc: bad vlc: %d:%d (%p)\n",
@@ -458,46 +474,47 @@ static inline int mjpeg_decode_dc(MJpegDecodeContext *s, int dc_index)
     }
 
     if (code)
-        return get_xbits(&s->gb, code);
+        return get_xbits(gb, code);
     else
         return 0;
 }
 
 /* decode block and dequantize */
-static int decode_block(MJpegDecodeContext *s, int16_t *block, int component,
+static int decode_block(MJpegDecodeContext *s, GetBitContext *gb,
+                        int16_t *block, int *last_dc,
                         int dc_index, int ac_index, int16_t *quant_matrix)
 {
     int code, i, j, level, val;
 
     /* DC coef */
-    val = mjpeg_decode_dc(s, dc_index);
+    val = mjpeg_decode_dc(s, gb, dc_index);
     if (val == 0xffff) {
         av_log(s->avctx, AV_LOG_ERROR, "error dc\n");
         return AVERROR_INVALIDDATA;
     }
-    val = val * quant_matrix[0] + s->last_dc[component];
-    s->last_dc[component] = val;
+    val = val * quant_matrix[0] + *last_dc;
+    *last_dc = val;
     block[0] = val;
     /* AC coefs */
     i = 0;
-    {OPEN_READER(re, &s->gb);
+    {OPEN_READER(re, gb);
     do {
-        UPDATE_CACHE(re, &s->gb);
-        GET_VLC(code, re, &s->gb, s->vlcs[1][ac_index].table, 9, 2);
+        UPDATE_CACHE(re, gb);
+        GET_VLC(code, re, gb, s->vlcs[1][ac_index].table, 9, 2);
 
         i += ((unsigned)code) >> 4;
             code &= 0xf;
         if (code) {
             if (code > MIN_CACHE_BITS - 16)
-                UPDATE_CACHE(re, &s->gb);
+                UPDATE_CACHE(re, gb);
 
             {
-                int cache = GET_CACHE(re, &s->gb);
+                int cache = GET_CACHE(re, gb);
                 int sign  = (~cache) >> 31;
                 level     = (NEG_USR32(sign ^ cache,code) ^ sign) - sign;
             }
 
-            LAST_SKIP_BITS(re, &s->gb, code);
+            LAST_SKIP_BITS(re, gb, code);
 
             if (i > 63) {
                 av_log(s->avctx, AV_LOG_ERROR, "error count: %d\n", i);
@@ -507,24 +524,24 @@ static int decode_block(MJpegDecodeContext *s, int16_t *block, int component,
             block[j] = level * quant_matrix[j];
         }
     } while (i < 63);
-    CLOSE_READER(re, &s->gb);}
+    CLOSE_READER(re, gb);}
 
     return 0;
 }
 
-static int decode_dc_progressive(MJpegDecodeContext *s, int16_t *block,
-                                 int component, int dc_index,
+static int decode_dc_progressive(MJpegDecodeContext *s, GetBitContext *gb,
+                                 int16_t *block, int *last_dc, int dc_index,
                                  int16_t *quant_matrix, int Al)
 {
     int val;
     s->bdsp.clear_block(block);
-    val = mjpeg_decode_dc(s, dc_index);
+    val = mjpeg_decode_dc(s, gb, dc_index);
     if (val == 0xffff) {
         av_log(s->avctx, AV_LOG_ERROR, "error dc\n");
         return AVERROR_INVALIDDATA;
     }
-    val = (val * quant_matrix[0] << Al) + s->last_dc[component];
-    s->last_dc[component] = val;
+    val = (val * quant_matrix[0] << Al) + *last_dc;
+    *last_dc = val;
     block[0] = val;
     return 0;
 }
@@ -735,7 +752,7 @@ static int ljpeg_decode_rgb_scan(MJpegDecodeContext *s, int predictor,
                 PREDICT(pred, topleft[i], top[i], left[i], modified_predictor);
 
                 left[i] = buffer[mb_x][i] =
-                    mask & (pred + (mjpeg_decode_dc(s, s->dc_index[i]) << point_transform));
+                    mask & (pred + (mjpeg_decode_dc(s, &s->gb, s->dc_index[i]) << point_transform));
             }
 
             if (s->restart_interval && !--s->restart_count) {
@@ -810,7 +827,7 @@ static int ljpeg_decode_yuv_scan(MJpegDecodeContext *s, int predictor,
 
                         if (s->interlaced && s->bottom_field)
                             ptr += linesize >> 1;
-                        *ptr = pred + (mjpeg_decode_dc(s, s->dc_index[i]) << point_transform);
+                        *ptr = pred + (mjpeg_decode_dc(s, &s->gb, s->dc_index[i]) << point_transform);
 
                         if (++x == h) {
                             x = 0;
@@ -839,7 +856,7 @@ static int ljpeg_decode_yuv_scan(MJpegDecodeContext *s, int predictor,
                               (h * mb_x + x);
                         PREDICT(pred, ptr[-linesize - 1],
                                 ptr[-linesize], ptr[-1], predictor);
-                        *ptr = pred + (mjpeg_decode_dc(s, s->dc_index[i]) << point_transform);
+                        *ptr = pred + (mjpeg_decode_dc(s, &s->gb, s->dc_index[i]) << point_transform);
                         if (++x == h) {
                             x = 0;
                             y++;
@@ -856,119 +873,215 @@ static int ljpeg_decode_yuv_scan(MJpegDecodeContext *s, int predictor,
     return 0;
 }
 
-static int mjpeg_decode_scan(MJpegDecodeContext *s, int nb_components, int Ah,
-                             int Al, const uint8_t *mb_bitmask,
-                             const AVFrame *reference)
+/**
+ * Decode the MCUs from mb_start to mb_end of a sequential or DC scan.
+ * RST markers are skipped and reset the predictors if check_rst is set,
+ * otherwise gb must hold a single restart interval.
+ */
+static int decode_scan_mcus(MJpegDecodeContext *s, GetBitContext *gb,
+                            int16_t *block, int *last_dc, int nb_components,
+                            int Ah, int Al, int mb_start, int mb_end,
+                            int check_rst, const uint8_t *mb_bitmask,
+                            const AVFrame *reference)
 {
-    int i, mb_x, mb_y;
+    int i, mb, mb_x, mb_y;
     uint8_t *data[MAX_COMPONENTS];
     const uint8_t *reference_data[MAX_COMPONENTS];
     int linesize[MAX_COMPONENTS];
     GetBitContext mb_bitmask_gb;
 
-    if (mb_bitmask)
+    if (mb_bitmask) {
         init_get_bits(&mb_bitmask_gb, mb_bitmask, s->mb_width * s->mb_height);
+        skip_bits_long(&mb_bitmask_gb, mb_start);
+    }
 
     for (i = 0; i < nb_components; i++) {
         int c   = s->comp_index[i];
         data[c] = s->picture_ptr->data[c];
         reference_data[c] = reference ? reference->data[c] : NULL;
         linesize[c] = s->linesize[c];
-        s->coefs_finished[c] |= 1;
     }
 
-    for (mb_y = 0; mb_y < s->mb_height; mb_y++) {
-        for (mb_x = 0; mb_x < s->mb_width; mb_x++) {
-            const int copy_mb = mb_bitmask && !get_bits1(&mb_bitmask_gb);
+    mb_x = mb_start % s->mb_width;
+    mb_y = mb_start / s->mb_width;
+    for (mb = mb_start; mb < mb_end; mb++) {
+        const int copy_mb = mb_bitmask && !get_bits1(&mb_bitmask_gb);
 
-            if (s->restart_interval && !s->restart_count)
-                s->restart_count = s->restart_interval;
+        if (check_rst && s->restart_interval && !s->restart_count)
+            s->restart_count = s->restart_interval;
 
-            if (get_bits_left(&s->gb) < 0) {
-                av_log(s->avctx, AV_LOG_ERROR, "overread %d\n",
-                       -get_bits_left(&s->gb));
-                return AVERROR_INVALIDDATA;
-            }
-            for (i = 0; i < nb_components; i++) {
-                uint8_t *ptr;
-                int n, h, v, x, y, c, j;
-                int block_offset;
-                n = s->nb_blocks[i];
-                c = s->comp_index[i];
-                h = s->h_scount[i];
-                v = s->v_scount[i];
-                x = 0;
-                y = 0;
-                for (j = 0; j < n; j++) {
-                    block_offset = ((linesize[c] * (v * mb_y + y) * 8) +
-                                    (h * mb_x + x) * 8);
-
-                    if (s->interlaced && s->bottom_field)
-                        block_offset += linesize[c] >> 1;
-                    ptr = data[c] + block_offset;
-                    if (!s->progressive) {
-                        if (copy_mb)
-                            s->hdsp.put_pixels_tab[1][0](ptr,
-                                reference_data[c] + block_offset,
-                                linesize[c], 8);
-                        else {
-                            s->bdsp.clear_block(s->block);
-                            if (decode_block(s, s->block, i,
-                                             s->dc_index[i], s->ac_index[i],
-                                             s->quant_matrixes[s->quant_index[c]]) < 0) {
-                                av_log(s->avctx, AV_LOG_ERROR,
-                                       "error y=%d x=%d\n", mb_y, mb_x);
-                                return AVERROR_INVALIDDATA;
-                            }
-                            s->idsp.idct_put(ptr, linesize[c], s->block);
-                        }
-                    } else {
-                        int block_idx  = s->block_stride[c] * (v * mb_y + y) +
-                                         (h * mb_x + x);
-                        int16_t *block = s->blocks[c][block_idx];
-                        if (Ah)
-                            block[0] += get_bits1(&s->gb) *
-                                        s->quant_matrixes[s->quant_index[c]][0] << Al;
-                        else if (decode_dc_progressive(s, block, i, s->dc_index[i],
-                                                       s->quant_matrixes[s->quant_index[c]],
-                                                       Al) < 0) {
+        if (get_bits_left(gb) < 0) {
+            av_log(s->avctx, AV_LOG_ERROR, "overread %d\n",
+                   -get_bits_left(gb));
+            return AVERROR_INVALIDDATA;
+        }
+        for (i = 0; i < nb_components; i++) {
+            uint8_t *ptr;
+            int n, h, v, x, y, c, j;
+            int block_offset;
+            n = s->nb_blocks[i];
+            c = s->comp_index[i];
+            h = s->h_scount[i];
+            v = s->v_scount[i];
+            x = 0;
+            y = 0;
+            for (j = 0; j < n; j++) {
+                block_offset = ((linesize[c] * (v * mb_y + y) * 8) +
+                                (h * mb_x + x) * 8);
+
+                if (s->interlaced && s->bottom_field)
+                    block_offset += linesize[c] >> 1;
+                ptr = data[c] + block_offset;
+                if (!s->progressive) {
+                    if (copy_mb)
+                        s->hdsp.put_pixels_tab[1][0](ptr,
+                            reference_data[c] + block_offset,
+                            linesize[c], 8);
+                    else {
+                        s->bdsp.clear_block(block);
+                        if (decode_block(s, gb, block, &last_dc[i],
+                                         s->dc_index[i], s->ac_index[i],
+                                         s->quant_matrixes[s->quant_index[c]]) < 0) {
                             av_log(s->avctx, AV_LOG_ERROR,
                                    "error y=%d x=%d\n", mb_y, mb_x);
                             return AVERROR_INVALIDDATA;
                         }
+                        s->idsp.idct_put(ptr, linesize[c], block);
                     }
-                    ff_dlog(s->avctx, "mb: %d %d processed\n", mb_y, mb_x);
-                    ff_dlog(s->avctx, "%d %d %d %d %d %d %d %d \n",
-                            mb_x, mb_y, x, y, c, s->bottom_field,
-                            (v * mb_y + y) * 8, (h * mb_x + x) * 8);
-                    if (++x == h) {
-                        x = 0;
-                        y++;
+                } else {
+                    int block_idx  = s->block_stride[c] * (v * mb_y + y) +
+                                     (h * mb_x + x);
+                    int16_t *dc_block = s->blocks[c][block_idx];
+                    if (Ah)
+                        dc_block[0] += get_bits1(gb) *
+                                       s->quant_matrixes[s->quant_index[c]][0] << Al;
+                    else if (decode_dc_progressive(s, gb, dc_block, &last_dc[i],
+                                                   s->dc_index[i],
+                                                   s->quant_matrixes[s->quant_index[c]],
+                                                   Al) < 0) {
+                        av_log(s->avctx, AV_LOG_ERROR,
+                               "error y=%d x=%d\n", mb_y, mb_x);
+                        return AVERROR_INVALIDDATA;
                     }
                 }
+                ff_dlog(s->avctx, "mb: %d %d processed\n", mb_y, mb_x);
+                ff_dlog(s->avctx, "%d %d %d %d %d %d %d %d \n",
+                        mb_x, mb_y, x, y, c, s->bottom_field,
+                        (v * mb_y + y) * 8, (h * mb_x + x) * 8);
+                if (++x == h) {
+                    x = 0;
+                    y++;
+                }
             }
+        }
 
-            if (s->restart_interval) {
-                s->restart_count--;
-                i = 8 + ((-get_bits_count(&s->gb)) & 7);
-                /* skip RSTn */
-                if (show_bits(&s->gb, i) == (1 << i) - 1) {
-                    int pos = get_bits_count(&s->gb);
-                    align_get_bits(&s->gb);
-                    while (get_bits_left(&s->gb) >= 8 && show_bits(&s->gb, 8) == 0xFF)
-                        skip_bits(&s->gb, 8);
-                    if ((get_bits(&s->gb, 8) & 0xF8) == 0xD0) {
-                        for (i = 0; i < nb_components; i++) /* reset dc */
-                            s->last_dc[i] = 1024;
-                    } else
-                        skip_bits_long(&s->gb, pos - get_bits_count(&s->gb));
-                }
+        if (check_rst && s->restart_interval) {
+            s->restart_count--;
+            i = 8 + ((-get_bits_count(gb)) & 7);
+            /* skip RSTn */
+            if (show_bits(gb, i) == (1 << i) - 1) {
+                int pos = get_bits_count(gb);
+                align_get_bits(gb);
+                while (get_bits_left(gb) >= 8 && show_bits(gb, 8) == 0xFF)
+                    skip_bits(gb, 8);
+                if ((get_bits(gb, 8) & 0xF8) == 0xD0) {
+                    for (i = 0; i < nb_components; i++) /* reset dc */
+                        last_dc[i] = 1024;
+                } else
+                    skip_bits_long(gb, pos - get_bits_count(gb));
             }
         }
+
+        if (++mb_x == s->mb_width) {
+            mb_x = 0;
+            mb_y++;
+        }
     }
     return 0;
 }
 
+typedef struct ScanIntervalArgs {
+    int nb_components, Ah, Al;
+    const uint8_t *mb_bitmask;
+    const AVFrame *reference;
+    int start;      ///< byte offset of the first interval in s->buffer
+    int end;        ///< byte offset of the end of the scan in s->buffer
+    int end_bits;   ///< bits read by the last interval
+} ScanIntervalArgs;
+
+static int decode_scan_interval(AVCodecContext *avctx, void *arg,
+                                int jobnr, int threadnr)
+{
+    MJpegDecodeContext *s = avctx->priv_data;
+    ScanIntervalArgs *a   = arg;
+    LOCAL_ALIGNED_16(int16_t, block, [64]);
+    int last_dc[MAX_COMPONENTS];
+    int nb_mbs = s->mb_width * s->mb_height;
+    int start  = jobnr ? s->restart_pos[jobnr - 1] : a->start;
+    /* the RST marker left by the unescaping ends the interval */
+    int end    = jobnr < s->nb_restarts ? s->restart_pos[jobnr] - 2 : a->end;
+    int mb_start = jobnr * s->restart_interval;
+    GetBitContext gb;
+    int i, ret;
+
+    for (i = 0; i < a->nb_components; i++)
+        last_dc[i] = 1024;
+
+    if ((ret = init_get_bits8(&gb, s->buffer + start, end - start)) < 0)
+        return ret;
+    ret = decode_scan_mcus(s, &gb, block, last_dc, a->nb_components,
+                           a->Ah, a->Al, mb_start,
+                           FFMIN(mb_start + s->restart_interval, nb_mbs),
+                           0, a->mb_bitmask, a->reference);
+    if (jobnr == s->nb_restarts)
+        a->end_bits = start * 8 + get_bits_count(&gb);
+    return ret;
+}
+
+static int mjpeg_decode_scan(MJpegDecodeContext *s, int nb_components, int Ah,
+                             int Al, const uint8_t *mb_bitmask,
+                             const AVFrame *reference)
+{
+    int nb_mbs = s->mb_width * s->mb_height;
+    int i;
+
+    for (i = 0; i < nb_components; i++)
+        s->coefs_finished[s->comp_index[i]] |= 1;
+
+    /* Restart intervals do not depend on each other, decode them in
+     * parallel if the unescaping found all their markers. */
+    if (s->avctx->active_thread_type & FF_THREAD_SLICE &&
+        s->restart_interval && s->nb_restarts > 0 &&
+        s->nb_restarts == (nb_mbs - 1) / s->restart_interval &&
+        s->gb.buffer == s->buffer) {
+        ScanIntervalArgs a = {
+            .nb_components = nb_components,
+            .Ah            = Ah,
+            .Al            = Al,
+            .mb_bitmask    = mb_bitmask,
+            .reference     = reference,
+            .start         = get_bits_count(&s->gb) >> 3,
+            .end           = s->gb.size_in_bits >> 3,
+            .end_bits      = s->gb.size_in_bits,
+        };
+        int *rets = av_malloc_array(s->nb_restarts + 1, sizeof(*rets));
+        int ret   = 0;
+
+        if (!rets)
+            return AVERROR(ENOMEM);
+        s->avctx->execute2(s->avctx, decode_scan_interval, &a, rets,
+                           s->nb_restarts + 1);
+        skip_bits_long(&s->gb, a.end_bits - get_bits_count(&s->gb));
+        for (i = 0; i <= s->nb_restarts && !ret; i++)
+            ret = FFMIN(rets[i], 0);
+        av_free(rets);
+        return ret;
+    }
+
+    return decode_scan_mcus(s, &s->gb, s->block, s->last_dc, nb_components,
+                            Ah, Al, 0, nb_mbs, 1, mb_bitmask, reference);
+}
+
 static int mjpeg_decode_scan_progressive_ac(MJpegDecodeContext *s, int ss,
                                             int se, int Ah, int Al,
                                             const uint8_t *mb_bitmask,
@@ -1367,6 +1480,25 @@ static int mjpeg_decode_com(MJpegDecodeContext *s)
     return 0;
 }
 
+/* Record where the restart interval following an RST marker starts in the
+ * unescaped scan. The positions are only used to decode the intervals in
+ * parallel, so running out of memory just disables that. */
+static void add_restart_pos(MJpegDecodeContext *s, int pos)
+{
+    if (s->nb_restarts < 0)
+        return;
+    if (s->nb_restarts >= s->restart_pos_size / sizeof(*s->restart_pos)) {
+        int *tmp = av_fast_realloc(s->restart_pos, &s->restart_pos_size,
+                                   (s->nb_restarts + 1) * sizeof(*s->restart_pos));
+        if (!tmp) {
+            s->nb_restarts = -1;
+            return;
+        }
+        s->restart_pos = tmp;
+    }
+    s->restart_pos[s->nb_restarts++] = pos;
+}
+
 /* return the 8 bit start code value and update the search
    state. Return -1 if no start code found */
 static int find_marker(const uint8_t **pbuf_ptr, const uint8_t *buf_end)
@@ -1414,6 +1546,7 @@ int ff_mjpeg_find_marker(MJpegDecodeContext *s,
         const uint8_t *src = *buf_ptr;
         uint8_t *dst = s->buffer;
 
+        s->nb_restarts = 0;
         while (src < buf_end) {
             uint8_t x = *(src++);
 
@@ -1423,9 +1556,11 @@ int ff_mjpeg_find_marker(MJpegDecodeContext *s,
                     while (src < buf_end && x == 0xff)
                         x = *(src++);
 
-                    if (x >= 0xd0 && x <= 0xd7)
+                    if (x >= 0xd0 && x <= 0xd7) {
                         *(dst++) = x;
-                    else if (x)
+                        if (s->restart_interval)
+                            add_restart_pos(s, dst - s->buffer);
+                    } else if (x)
                         break;
                 }
             }
@@ -1498,7 +1633,8 @@ int ff_mjpeg_decode_frame(AVCodecContext *avctx, void *data, int *got_frame,
     int start_code;
     int ret = 0;
 
-    s->got_picture = 0; // picture from previous image can not be reused
+    s->got_picture    = 0; // picture from previous image can not be reused
+    s->setup_finished = 0;
     buf_ptr = buf;
     buf_end = buf + buf_size;
     while (buf_ptr < buf_end) {
@@ -1528,6 +1664,14 @@ int ff_mjpeg_decode_frame(AVCodecContext *avctx, void *data, int *got_frame,
         if (s->avctx->debug & FF_DEBUG_STARTCODE)
             av_log(avctx, AV_LOG_DEBUG, "startcode: %X\n", start_code);
 
+        /* The next frame thread already copied the headers. */
+        if (s->setup_finished && start_code != EOI &&
+            !(start_code >= RST0 && start_code <= RST7)) {
+            av_log(avctx, AV_LOG_DEBUG,
+                   "Ignoring marker 0x%x after the last scan\n", start_code);
+            goto not_the_end;
+        }
+
         /* process markers */
         if (start_code >= 0xd0 && start_code <= 0xd7) {
             av_log(avctx, AV_LOG_DEBUG,
@@ -1643,6 +1787,16 @@ eoi_parser:
                        "Can not process SOS before SOF, skipping\n");
                 break;
                 }
+            /* A sequential scan of all the components of the last field
+             * ends the picture, let the next frame thread start. */
+            if (avctx->active_thread_type & FF_THREAD_FRAME &&
+                !s->progressive && !s->ls &&
+                get_bits_left(&s->gb) >= 24 &&
+                (show_bits(&s->gb, 24) & 0xFF) == s->nb_components &&
+                !(s->interlaced && s->bottom_field == s->interlace_polarity)) {
+                s->setup_finished = 1;
+                ff_thread_finish_setup(avctx);
+            }
             if ((ret = ff_mjpeg_decode_sos(s, NULL, NULL)) < 0 &&
                 (avctx->err_recognition & AV_EF_EXPLODE))
                 return ret;
@@ -1702,6 +1856,7 @@ av_cold int ff_mjpeg_decode_end(AVCodecContext *avctx)
         av_frame_unref(s->picture_ptr);
 
     av_free(s->buffer);
+    av_freep(&s->restart_pos);
     av_freep(&s->ljpeg_buffer);
     s->ljpeg_buffer_size = 0;
 
@@ -1716,6 +1871,109 @@ av_cold int ff_mjpeg_decode_end(AVCodecContext *avctx)
     return 0;
 }
 
+#if HAVE_THREADS
+static av_cold int decode_init_thread_copy(AVCodecContext *avctx)
+{
+    MJpegDecodeContext *s = avctx->priv_data;
+    int class, index, ret;
+
+    /* Everything allocated was copied from the first thread's context. */
+    s->avctx             = avctx;
+    s->buffer            = NULL;
+    s->buffer_size       = 0;
+    s->restart_pos       = NULL;
+    s->restart_pos_size  = 0;
+    s->ljpeg_buffer      = NULL;
+    s->ljpeg_buffer_size = 0;
+    memset(s->blocks,   0, sizeof(s->blocks));
+    memset(s->last_nnz, 0, sizeof(s->last_nnz));
+    memset(s->vlcs,     0, sizeof(s->vlcs));
+
+    s->picture = av_frame_alloc();
+    if (!s->picture)
+        return AVERROR(ENOMEM);
+    s->picture_ptr = s->picture;
+
+    for (class = 0; class < 2; class++)
+        for (index = 0; index < 4; index++)
+            if (s->huff_nb_codes[class][index] &&
+                (ret = init_huffman_table(s, class, index,
+                                          s->huff_bits[class][index],
+                                          s->huff_val[class][index],
+                                          s->huff_nb_codes[class][index])) < 0)
+                return ret;
+
+    return 0;
+}
+
+static int decode_update_thread_context(AVCodecContext *dst,
+                                        const AVCodecContext *src)
+{
+    MJpegDecodeContext *s = dst->priv_data, *s1 = src->priv_data;
+    int class, index, ret;
+
+    if (s == s1)
+        return 0;
+
+    /* The tables and the picture parameters carry over to the next
+     * frames. s1 is still decoding, so only what ff_mjpeg_decode_frame()
+     * sets before ff_thread_finish_setup() can be read. */
+    memcpy(s->quant_matrixes, s1->quant_matrixes, sizeof(s->quant_matrixes));
+    memcpy(s->qscale,         s1->qscale,         sizeof(s->qscale));
+
+    for (class = 0; class < 2; class++) {
+        for (index = 0; index < 4; index++) {
+            int nb_codes = s1->huff_nb_codes[class][index];
+
+            if (!nb_codes ||
+                (nb_codes == s->huff_nb_codes[class][index] &&
+                 !memcmp(s->huff_bits[class][index], s1->huff_bits[class][index],
+                         sizeof(s->huff_bits[class][index])) &&
+                 !memcmp(s->huff_val[class][index], s1->huff_val[class][index],
+                         sizeof(s->huff_val[class][index]))))
+                continue;
+            if ((ret = init_huffman_table(s, class, index,
+                                          s1->huff_bits[class][index],
+                                          s1->huff_val[class][index],
+                                          nb_codes)) < 0)
+                return ret;
+        }
+    }
+
+    s->first_picture = s1->first_picture;
+    s->width         = s1->width;
+    s->height        = s1->height;
+    s->bits          = s1->bits;
+    s->nb_components = s1->nb_components;
+    memcpy(s->h_count, s1->h_count, sizeof(s->h_count));
+    memcpy(s->v_count, s1->v_count, sizeof(s->v_count));
+
+    /* If s1 started the next thread early, that was from the scan of the
+     * last field of its picture, whose EOI toggles bottom_field back to the
+     * first field. Otherwise s1 is done and its field state is final, the
+     * picture itself is not: like the serial path, every packet allocates a
+     * new one, so a packet holding a single field outputs a frame too. */
+    s->interlaced   = s1->interlaced;
+    s->bottom_field = s1->setup_finished ? s1->interlace_polarity
+                                         : s1->bottom_field;
+
+    s->buggy_avid  = s1->buggy_avid;
+    s->cs_itu601   = s1->cs_itu601;
+    s->flipped     = s1->flipped;
+    s->rgb         = s1->rgb;
+    s->rct         = s1->rct;
+    s->pegasus_rct = s1->pegasus_rct;
+
+    s->maxval = s1->maxval;
+    s->t1     = s1->t1;
+    s->t2     = s1->t2;
+    s->t3     = s1->t3;
+    s->reset  = s1->reset;
+
+    return 0;
+}
+#endif
+
 #define OFFSET(x) offsetof(MJpegDecodeContext, x)
 #define VD AV_OPT_FLAG_VIDEO_PARAM | AV_OPT_FLAG_DECODING_PARAM
 static const AVOption options[] = {
@@ -1740,7 +1998,10 @@ AVCodec ff_mjpeg_decoder = {
     .init           = ff_mjpeg_decode_init,
     .close          = ff_mjpeg_decode_end,
     .decode         = ff_mjpeg_decode_frame,
-    .capabilities   = AV_CODEC_CAP_DR1,
+    .init_thread_copy      = ONLY_IF_THREADS_ENABLED(decode_init_thread_copy),
+    .update_thread_context = ONLY_IF_THREADS_ENABLED(decode_update_thread_context),
+    .capabilities   = AV_CODEC_CAP_DR1 | AV_CODEC_CAP_FRAME_THREADS |
+                      AV_CODEC_CAP_SLICE_THREADS,
     .priv_class     = &mjpegdec_class,
     .caps_internal  = FF_CODEC_CAP_INIT_THREADSAFE,
 };
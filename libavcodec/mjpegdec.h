@@ -51,6 +51,11 @@ typedef struct MJpegDecodeContext {
 
     int16_t quant_matrixes[4][64];
     VLC vlcs[3][4];
+    /* The Huffman tables the VLCs were built from, to build them again in
+     * the other frame threads. */
+    uint8_t huff_bits[2][4][17];
+    uint8_t huff_val[2][4][256];
+    int huff_nb_codes[2][4];
     int qscale[4];      ///< quantizer scale calculated from quant_matrixes
 
     int org_height;  /* size given at codec init */
@@ -102,6 +107,9 @@ typedef struct MJpegDecodeContext {
 
     int restart_interval;
     int restart_count;
+    int *restart_pos;             ///< offsets of the restart intervals after the first in buffer
+    unsigned int restart_pos_size;
+    int nb_restarts;              ///< number of RST markers found in the scan, -1 on error
 
     int buggy_avid;
     int cs_itu601;
@@ -117,6 +125,8 @@ typedef struct MJpegDecodeContext {
 
     int extern_huff;
 
+    int setup_finished; ///< the next frame thread was started for this packet
+
     const AVPixFmtDescriptor *pix_desc;
 } MJpegDecodeContext;
 
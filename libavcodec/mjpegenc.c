@@ -43,6 +43,12 @@ av_cold int ff_mjpeg_encode_init(MpegEncContext *s)
 {
     MJpegContext *m;
 
+    if (s->restart_rows * ((s->width + 15) >> 4) > 0xFFFF) {
+        av_log(s->avctx, AV_LOG_ERROR,
+               "The restart interval of %d rows is too large\n", s->restart_rows);
+        return AVERROR(EINVAL);
+    }
+
     m = av_malloc(sizeof(MJpegContext));
     if (!m)
         return AVERROR(ENOMEM);
@@ -152,6 +158,22 @@ void ff_mjpeg_encode_mb(MpegEncContext *s, int16_t block[8][64])
     s->i_tex_bits += get_bits_diff(s);
 }
 
+void ff_mjpeg_encode_restart(MpegEncContext *s, int n)
+{
+    int i;
+
+    /* the marker must not be escaped, so escape the interval it ends now */
+    ff_mjpeg_encode_stuffing(&s->pb);
+    flush_put_bits(&s->pb);
+    ff_mjpeg_escape_FF(&s->pb, s->esc_pos);
+
+    put_marker(&s->pb, RST0 + (n & 7));
+    s->esc_pos = put_bits_count(&s->pb) >> 3;
+
+    for (i = 0; i < 3; i++)
+        s->last_dc[i] = 128 << s->intra_dc_precision;
+}
+
 #define OFFSET(x) offsetof(MpegEncContext, x)
 #define VE AV_OPT_FLAG_VIDEO_PARAM | AV_OPT_FLAG_ENCODING_PARAM
 static const AVOption options[] = {
@@ -159,6 +181,7 @@ static const AVOption options[] = {
     { "left",   NULL, 0, AV_OPT_TYPE_CONST, { .i64 = 1 }, INT_MIN, INT_MAX, VE, "pred" },
     { "plane",  NULL, 0, AV_OPT_TYPE_CONST, { .i64 = 2 }, INT_MIN, INT_MAX, VE, "pred" },
     { "median", NULL, 0, AV_OPT_TYPE_CONST, { .i64 = 3 }, INT_MIN, INT_MAX, VE, "pred" },
+{ "restart_rows", "Number of macroblock rows between restart markers, 0 to disable", OFFSET(restart_rows), AV_OPT_TYPE_INT, { .i64 = 0 }, 0, INT_MAX, VE },
 
     { NULL},
 };
@@ -60,5 +60,6 @@ static inline void put_marker(PutBitContext *p, enum JpegMarker code)
 int  ff_mjpeg_encode_init(MpegEncContext *s);
 void ff_mjpeg_encode_close(MpegEncContext *s);
 void ff_mjpeg_encode_mb(MpegEncContext *s, int16_t block[8][64]);
+void ff_mjpeg_encode_restart(MpegEncContext *s, int n);
 
 #endif /* AVCODEC_MJPEGENC_H */
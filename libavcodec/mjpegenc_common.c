@@ -135,7 +135,8 @@ static void jpeg_put_comments(AVCodecContext *avctx, PutBitContext *p)
 
 void ff_mjpeg_encode_picture_header(AVCodecContext *avctx, PutBitContext *pb,
                                     ScanTable *intra_scantable, int pred,
-                                    uint16_t intra_matrix[64])
+                                    uint16_t intra_matrix[64],
+                                    int restart_interval)
 {
     int chroma_h_shift, chroma_v_shift;
     const int lossless = avctx->codec_id != AV_CODEC_ID_MJPEG;
@@ -164,6 +165,12 @@ void ff_mjpeg_encode_picture_header(AVCodecContext *avctx, PutBitContext *pb,
 
     jpeg_table_header(pb, intra_scantable, intra_matrix);
 
+    if (restart_interval) {
+        put_marker(pb, DRI);
+        put_bits(pb, 16, 4);
+        put_bits(pb, 16, restart_interval);
+    }
+
     switch (avctx->codec_id) {
     case AV_CODEC_ID_MJPEG:  put_marker(pb, SOF0 ); break;
     case AV_CODEC_ID_LJPEG:  put_marker(pb, SOF3 ); break;
@@ -228,7 +235,7 @@ void ff_mjpeg_encode_picture_header(AVCodecContext *avctx, PutBitContext *pb,
     put_bits(pb, 8, 0); /* Ah/Al (not used) */
 }
 
-static void escape_FF(PutBitContext *pb, int start)
+void ff_mjpeg_escape_FF(PutBitContext *pb, int start)
 {
     int size = put_bits_count(pb) - start * 8;
     int i, ff_count;
@@ -294,7 +301,7 @@ void ff_mjpeg_encode_picture_trailer(PutBitContext *pb, int header_bits)
 
     assert((header_bits & 7) == 0);
 
-    escape_FF(pb, header_bits >> 3);
+    ff_mjpeg_escape_FF(pb, header_bits >> 3);
 
     put_marker(pb, EOI);
 }
@@ -29,7 +29,9 @@
 
 void ff_mjpeg_encode_picture_header(AVCodecContext *avctx, PutBitContext *pb,
                                     ScanTable *intra_scantable, int pred,
-                                    uint16_t intra_matrix[64]);
+                                    uint16_t intra_matrix[64],
+                                    int restart_interval);
+void ff_mjpeg_escape_FF(PutBitContext *pb, int start);
 void ff_mjpeg_encode_picture_trailer(PutBitContext *pb, int header_bits);
 void ff_mjpeg_encode_stuffing(PutBitContext *pbc);
 void ff_mjpeg_encode_dc(PutBitContext *pb, int val,
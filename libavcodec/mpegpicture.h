@@ -79,6 +79,10 @@ typedef struct Picture {
     int mc_mb_var_sum;          ///< motion compensated MB variance for current frame
 
     int b_frame_score;          /* */
+    int lookahead_cost;         ///< estimated cost of coding the frame as P, from the lookahead
+    int lookahead_intra_cost;   ///< estimated cost of coding the frame as I, from the lookahead
+    int lookahead_intra_mbs;    ///< number of macroblocks the lookahead found better coded intra
+    int lookahead_scenecut;     ///< whether the lookahead found a scene cut before the frame
     int needs_realloc;          ///< Picture needs to be reallocated (eg due to a frame size change)
 
     int reference;
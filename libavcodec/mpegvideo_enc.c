@@ -878,6 +878,12 @@ FF_ENABLE_DEPRECATION_WARNINGS
         }
     }
 
+    if (s->b_frame_strategy == 3) {
+        ret = ff_mpv_lookahead_init(s);
+        if (ret < 0)
+            return ret;
+    }
+
     cpb_props = ff_add_cpb_side_data(avctx);
     if (!cpb_props)
         return AVERROR(ENOMEM);
@@ -898,6 +904,7 @@ av_cold int ff_mpv_encode_end(AVCodecContext *avctx)
     int i;
 
     ff_rate_control_uninit(s);
+    ff_mpv_lookahead_uninit(s);
     ff_mpv_common_end(s);
     if (CONFIG_MJPEG_ENCODER &&
         s->out_format == FMT_MJPEG)
@@ -980,6 +987,9 @@ static int load_input_picture(MpegEncContext *s, const AVFrame *pic_arg)
     int flush_offset = 1;
     int direct = 1;
 
+    if (s->b_frame_strategy == 3)
+        encoding_delay = s->la.delay;
+
     if (pic_arg) {
         pts = pic_arg->pts;
         display_picture_number = s->input_picture_number++;
@@ -1089,6 +1099,10 @@ static int load_input_picture(MpegEncContext *s, const AVFrame *pic_arg)
 
         pic->f->display_picture_number = display_picture_number;
         pic->f->pts = pts; // we set this here to avoid modifying pic_arg
+
+        if (s->b_frame_strategy == 3)
+            ff_mpv_lookahead_analyze(s, pic, pic_arg->data[0],
+                                     pic_arg->linesize[0]);
     } else {
         /* Flushing: When we have not received enough input frames,
          * ensure s->input_picture[0] contains the first picture */
@@ -1384,6 +1398,8 @@ static int select_input_picture(MpegEncContext *s)
                 b_frames = estimate_best_b_count(s);
                 if (b_frames < 0)
                     return b_frames;
+            } else if (s->b_frame_strategy == 3) {
+                b_frames = ff_mpv_lookahead_decide(s);
             }
 
             emms_c();
@@ -1427,6 +1443,10 @@ static int select_input_picture(MpegEncContext *s)
                     s->coded_picture_number++;
             }
         }
+
+        if (s->b_frame_strategy == 3)
+            s->la.next_display =
+                s->reordered_input_picture[0]->f->display_picture_number + 1;
     }
 no_output_pic:
     ff_mpeg_unref_picture(s->avctx, &s->new_picture);
@@ -1722,7 +1742,7 @@ FF_ENABLE_DEPRECATION_WARNINGS
         *(int *)sd = s->current_picture.f->quality;
 
         if (CONFIG_MJPEG_ENCODER && s->out_format == FMT_MJPEG)
-            ff_mjpeg_encode_picture_trailer(&s->pb, s->header_bits);
+            ff_mjpeg_encode_picture_trailer(&s->pb, s->esc_pos << 3);
 
         if (avctx->rc_buffer_size) {
             RateControlContext *rcc = &s->rc_context;
@@ -2721,6 +2741,10 @@ static int encode_thread(AVCodecContext *c, void *arg){
         s->mb_x=0;
         s->mb_y= mb_y;
 
+        if (CONFIG_MJPEG_ENCODER && s->out_format == FMT_MJPEG &&
+            s->restart_rows && mb_y > s->start_mb_y && !(mb_y % s->restart_rows))
+            ff_mjpeg_encode_restart(s, mb_y / s->restart_rows - 1);
+
         ff_set_qscale(s, s->qscale);
         ff_init_block_index(s);
 
@@ -3570,9 +3594,12 @@ static int encode_picture(MpegEncContext *s, int picture_number)
     s->last_bits= put_bits_count(&s->pb);
     switch(s->out_format) {
     case FMT_MJPEG:
-        if (CONFIG_MJPEG_ENCODER)
+        if (CONFIG_MJPEG_ENCODER) {
             ff_mjpeg_encode_picture_header(s->avctx, &s->pb, &s->intra_scantable,
-                                           s->pred, s->intra_matrix);
+                                           s->pred, s->intra_matrix,
+                                           s->restart_rows * s->mb_width);
+            s->esc_pos = put_bits_count(&s->pb) >> 3;
+        }
         break;
     case FMT_H261:
         if (CONFIG_H261_ENCODER)
@@ -0,0 +1,292 @@
+/*
+ * This file is part of Libav.
+ *
+ * Libav is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * Libav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with Libav; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * Frame type decision lookahead for the mpegvideo encoders
+ */
+
+#include "libavutil/attributes.h"
+#include "libavutil/common.h"
+#include "libavutil/mem.h"
+
+#include "avcodec.h"
+#include "mpegvideo.h"
+#include "mpegvideo_lookahead.h"
+
+/* motion search range in half resolution pixels */
+#define SEARCH_RANGE 8
+/* intra must beat inter by about 2 per pixel to count, as in get_intra_count() */
+#define INTRA_BIAS   128
+
+typedef struct LookaheadJob {
+    MpegEncContext *s;
+    int start_y, end_y;
+} LookaheadJob;
+
+av_cold int ff_mpv_lookahead_init(MpegEncContext *s)
+{
+    MPVLookahead *la = &s->la;
+    int delay = s->max_b_frames ? s->max_b_frames : (s->low_delay ? 0 : 1);
+    int i;
+
+    /* the frames buffered ahead can only be returned by flushing */
+    la->delay = delay;
+    if (!s->low_delay && s->avctx->codec->capabilities & AV_CODEC_CAP_DELAY) {
+        /* the reordered and reference pictures come from the same pool */
+        if (delay + s->lookahead + 3 > MAX_PICTURE_COUNT) {
+            av_log(s->avctx, AV_LOG_ERROR,
+                   "A lookahead of %d frames is too long with %d B-frames, "
+                   "the maximum is %d.\n", s->lookahead, s->max_b_frames,
+                   MAX_PICTURE_COUNT - 3 - delay);
+            return AVERROR(EINVAL);
+        }
+        la->delay = delay + s->lookahead;
+        s->avctx->delay += s->lookahead;
+    }
+
+    la->mb_width  = s->width  >> 4;
+    la->mb_height = s->height >> 4;
+    la->stride    = FFALIGN(la->mb_width * 8, 32);
+
+    for (i = 0; i < 2; i++) {
+        la->plane[i] = av_malloc(la->stride * la->mb_height * 8);
+        if (!la->plane[i])
+            return AVERROR(ENOMEM);
+    }
+    la->row_cost       = av_malloc_array(la->mb_height, sizeof(*la->row_cost));
+    la->row_intra_cost = av_malloc_array(la->mb_height, sizeof(*la->row_intra_cost));
+    la->row_intra_mbs  = av_malloc_array(la->mb_height, sizeof(*la->row_intra_mbs));
+    if (!la->row_cost || !la->row_intra_cost || !la->row_intra_mbs)
+        return AVERROR(ENOMEM);
+
+    return 0;
+}
+
+av_cold void ff_mpv_lookahead_uninit(MpegEncContext *s)
+{
+    MPVLookahead *la = &s->la;
+
+    av_freep(&la->plane[0]);
+    av_freep(&la->plane[1]);
+    av_freep(&la->row_cost);
+    av_freep(&la->row_intra_cost);
+    av_freep(&la->row_intra_mbs);
+}
+
+static int block_intra_cost(const uint8_t *src, int stride)
+{
+    int x, y, mean, sum = 0, sae = 0;
+
+    for (y = 0; y < 8; y++)
+        for (x = 0; x < 8; x++)
+            sum += src[x + y * stride];
+    mean = (sum + 32) >> 6;
+
+    for (y = 0; y < 8; y++)
+        for (x = 0; x < 8; x++)
+            sae += FFABS(src[x + y * stride] - mean);
+
+    return sae;
+}
+
+/* A coarse search with a step of 2 pixels, refined around the best vector.
+ * Longer vectors are slightly penalised, as they cost bits to code. */
+static int block_inter_cost(MpegEncContext *s, uint8_t *cur, int bx, int by)
+{
+    MPVLookahead *la = &s->la;
+    const int stride = la->stride;
+    const int xmin   = -FFMIN(bx * 8, SEARCH_RANGE);
+    const int ymin   = -FFMIN(by * 8, SEARCH_RANGE);
+    const int xmax   = FFMIN((la->mb_width  - 1 - bx) * 8, SEARCH_RANGE);
+    const int ymax   = FFMIN((la->mb_height - 1 - by) * 8, SEARCH_RANGE);
+    uint8_t *ref     = la->plane[1] + by * 8 * stride + bx * 8;
+    int best = INT_MAX, best_x = 0, best_y = 0;
+    int x, y, cx, cy, cost;
+
+    for (y = ymin; y <= ymax; y += 2) {
+        for (x = xmin; x <= xmax; x += 2) {
+            cost = s->mecc.sad[1](NULL, cur, ref + x + y * stride, stride, 8) +
+                   2 * (FFABS(x) + FFABS(y));
+            if (cost < best) {
+                best   = cost;
+                best_x = x;
+                best_y = y;
+            }
+        }
+    }
+
+    cx = best_x;
+    cy = best_y;
+    for (y = FFMAX(cy - 1, ymin); y <= FFMIN(cy + 1, ymax); y++) {
+        for (x = FFMAX(cx - 1, xmin); x <= FFMIN(cx + 1, xmax); x++) {
+            if (!((x - xmin) & 1) && !((y - ymin) & 1))
+                continue;
+            cost = s->mecc.sad[1](NULL, cur, ref + x + y * stride, stride, 8) +
+                   2 * (FFABS(x) + FFABS(y));
+            best = FFMIN(best, cost);
+        }
+    }
+
+    return best;
+}
+
+static int analyze_rows(AVCodecContext *avctx, void *arg)
+{
+    LookaheadJob *job  = arg;
+    MpegEncContext *s  = job->s;
+    MPVLookahead *la   = &s->la;
+    const int stride   = la->stride;
+    int x, y;
+
+    for (y = job->start_y; y < job->end_y; y++) {
+        int cost = 0, intra_cost = 0, intra_mbs = 0;
+
+        for (x = 0; x < la->mb_width; x++) {
+            uint8_t *cur = la->plane[0] + y * 8 * stride + x * 8;
+            int intra    = block_intra_cost(cur, stride);
+            int inter    = intra;
+
+            if (la->have_prev) {
+                inter = block_inter_cost(s, cur, x, y);
+                if (intra + INTRA_BIAS < inter)
+                    intra_mbs++;
+            }
+            cost       += FFMIN(inter, intra);
+            intra_cost += intra;
+        }
+
+        la->row_cost[y]       = cost;
+        la->row_intra_cost[y] = intra_cost;
+        la->row_intra_mbs[y]  = intra_mbs;
+    }
+    emms_c();
+
+    return 0;
+}
+
+void ff_mpv_lookahead_analyze(MpegEncContext *s, Picture *pic,
+                              const uint8_t *src, int linesize)
+{
+    MPVLookahead *la = &s->la;
+    LookaheadJob jobs[MAX_THREADS];
+    int nb_jobs = av_clip(s->slice_context_count, 1, FFMAX(la->mb_height, 1));
+    int i;
+
+    pic->lookahead_cost       = 0;
+    pic->lookahead_intra_cost = 0;
+    pic->lookahead_intra_mbs  = 0;
+    pic->lookahead_scenecut   = 0;
+    if (!la->mb_width || !la->mb_height)
+        return;
+
+    FFSWAP(uint8_t *, la->plane[0], la->plane[1]);
+    s->mpvencdsp.shrink[1](la->plane[0], la->stride, src, linesize,
+                           la->mb_width * 8, la->mb_height * 8);
+
+    for (i = 0; i < nb_jobs; i++) {
+        jobs[i].s       = s;
+        jobs[i].start_y = la->mb_height *  i      / nb_jobs;
+        jobs[i].end_y   = la->mb_height * (i + 1) / nb_jobs;
+    }
+    s->avctx->execute(s->avctx, analyze_rows, jobs, NULL, nb_jobs,
+                      sizeof(*jobs));
+
+    for (i = 0; i < la->mb_height; i++) {
+        pic->lookahead_cost       += la->row_cost[i];
+        pic->lookahead_intra_cost += la->row_intra_cost[i];
+        pic->lookahead_intra_mbs  += la->row_intra_mbs[i];
+    }
+    /* a frame predicted to within 1 per pixel is no scene cut */
+    pic->lookahead_scenecut = la->have_prev &&
+        pic->lookahead_cost > la->mb_width * la->mb_height * 64 &&
+        10LL * pic->lookahead_cost >= 6LL * pic->lookahead_intra_cost;
+
+    la->have_prev = 1;
+}
+
+int ff_mpv_lookahead_decide(MpegEncContext *s)
+{
+    int i;
+
+    /* force an I picture at a detected scene cut, unless sc_threshold
+     * (>= 1000000000) disables the scene change detection */
+    if (s->scenechange_threshold < 1000000000) {
+        for (i = 0; i <= s->max_b_frames && s->input_picture[i]; i++) {
+            Picture *pic = s->input_picture[i];
+
+            if (pic->lookahead_scenecut) {
+                if (!pic->f->pict_type)
+                    pic->f->pict_type = AV_PICTURE_TYPE_I;
+                break;
+            }
+        }
+    }
+
+    for (i = 0; i < s->max_b_frames + 1; i++) {
+        if (!s->input_picture[i] ||
+            s->input_picture[i]->lookahead_intra_mbs >
+                s->mb_num / s->b_sensitivity)
+            break;
+    }
+
+    return FFMAX(0, i - 1);
+}
+
+static int frame_cost(const Picture *pic, int type)
+{
+    return type == AV_PICTURE_TYPE_I ? pic->lookahead_intra_cost
+                                     : pic->lookahead_cost;
+}
+
+int ff_mpv_lookahead_window(MpegEncContext *s, int *types, int *costs,
+                            int max)
+{
+    int i, n = 0;
+
+    /* the frame being coded and the B-frames already queued after it */
+    for (i = 0; i < MAX_PICTURE_COUNT && n < max; i++) {
+        Picture *pic = s->reordered_input_picture[i];
+        int type;
+
+        if (!pic)
+            break;
+        /* the coded frame may have been unreferenced already */
+        type       = i ? pic->f->pict_type : s->pict_type;
+        types[n]   = type;
+        costs[n++] = frame_cost(pic, type);
+    }
+
+    /* the input frames not given a type yet, P-frames unless forced */
+    for (i = 0; i < MAX_PICTURE_COUNT && n < max; i++) {
+        Picture *pic = s->input_picture[i];
+        int type;
+
+        if (!pic)
+            break;
+        if (!pic->f->buf[0] ||
+            pic->f->display_picture_number < s->la.next_display)
+            continue;
+        type       = pic->f->pict_type == AV_PICTURE_TYPE_I ? AV_PICTURE_TYPE_I
+                                                            : AV_PICTURE_TYPE_P;
+        types[n]   = type;
+        costs[n++] = frame_cost(pic, type);
+    }
+
+    return n;
+}
@@ -0,0 +1,79 @@
+/*
+ * This file is part of Libav.
+ *
+ * Libav is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * Libav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with Libav; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * Frame type decision lookahead for the mpegvideo encoders
+ */
+
+#ifndef AVCODEC_MPEGVIDEO_LOOKAHEAD_H
+#define AVCODEC_MPEGVIDEO_LOOKAHEAD_H
+
+#include <stdint.h>
+
+#include "mpegpicture.h"
+
+/**
+ * Lookahead used by b_frame_strategy 3.
+ *
+ * Every input frame is analysed as it enters the encoder: a motion search on
+ * its half resolution luma against the previous input frame estimates the
+ * cost of coding each macroblock as inter and as intra. The totals decide
+ * the frame types and scene cuts, and feed the rate control.
+ */
+typedef struct MPVLookahead {
+    int delay;                  ///< number of input frames buffered ahead of the coded one
+    int mb_width, mb_height;    ///< number of 8x8 blocks in the half resolution planes
+    int stride;
+    uint8_t *plane[2];          ///< half resolution luma of the current and previous input frame
+    int have_prev;              ///< whether plane[1] holds the previous input frame
+    int next_display;           ///< display number of the first input frame without a type
+
+    /* per block row sums for the frame being analysed */
+    int *row_cost;
+    int *row_intra_cost;
+    int *row_intra_mbs;
+} MPVLookahead;
+
+struct MpegEncContext;
+
+int ff_mpv_lookahead_init(struct MpegEncContext *s);
+void ff_mpv_lookahead_uninit(struct MpegEncContext *s);
+
+/**
+ * Analyse the luma plane of a new input frame and store the results in pic.
+ */
+void ff_mpv_lookahead_analyze(struct MpegEncContext *s, Picture *pic,
+                              const uint8_t *src, int linesize);
+
+/**
+ * Mark the first scene cut among the next input frames as an I-frame and
+ * return the number of B-frames to code before the next reference frame.
+ */
+int ff_mpv_lookahead_decide(struct MpegEncContext *s);
+
+/**
+ * Get the types and estimated costs of the frame being coded and of the
+ * frames buffered after it, in coding order as far as it is known.
+ *
+ * @return the number of frames written to types and costs, at most max
+ */
+int ff_mpv_lookahead_window(struct MpegEncContext *s, int *types, int *costs,
+                            int max);
+
+#endif /* AVCODEC_MPEGVIDEO_LOOKAHEAD_H */
@@ -28,6 +28,7 @@
 #include "internal.h"
 #include "png.h"
 #include "pngdsp.h"
+#include "thread.h"
 
 /* TODO:
  * - add 2, 4 and 16 bit depth support
@@ -39,7 +40,8 @@ typedef struct PNGDecContext {
     PNGDSPContext dsp;
 
     GetByteContext gb;
-    AVFrame *prev;
+    ThreadFrame picture;
+    ThreadFrame prev;
 
     int state;
     int width, height;
@@ -51,6 +53,7 @@ typedef struct PNGDecContext {
     int channels;
     int bits_per_pixel;
     int bpp;
+    int stereo_mode;
 
     uint8_t *image_buf;
     int image_linesize;
@@ -412,7 +415,7 @@ static int decode_frame(AVCodecContext *avctx,
     PNGDecContext *const s = avctx->priv_data;
     const uint8_t *buf     = avpkt->data;
     int buf_size           = avpkt->size;
-    AVFrame *p             = data;
+    AVFrame *p;
     uint8_t *crow_buf_base = NULL;
     uint32_t tag, length;
     int ret;
@@ -436,8 +439,15 @@ static int decode_frame(AVCodecContext *avctx,
         return AVERROR_INVALIDDATA;
     }
 
+    /* the frame decoded last becomes the reference for P-frames, with
+     * frame threading it was handed over by update_thread_context() */
+    ff_thread_release_buffer(avctx, &s->prev);
+    FFSWAP(ThreadFrame, s->picture, s->prev);
+    p = s->picture.f;
+
     bytestream2_init(&s->gb, buf + 8, buf_size - 8);
     s->y = s->state = 0;
+    s->stereo_mode = -1;
 
     /* init the zlib */
     s->zstream.zalloc = ff_png_zalloc;
@@ -530,7 +540,8 @@ static int decode_frame(AVCodecContext *avctx,
                     goto fail;
                 }
 
-                if (ff_get_buffer(avctx, p, AV_GET_BUFFER_FLAG_REF) < 0) {
+                if (ff_thread_get_buffer(avctx, &s->picture,
+                                         AV_GET_BUFFER_FLAG_REF) < 0) {
                     av_log(avctx, AV_LOG_ERROR, "get_buffer() failed\n");
                     goto fail;
                 }
@@ -555,6 +566,7 @@ static int decode_frame(AVCodecContext *avctx,
                 /* copy the palette if needed */
                 if (s->color_type == PNG_COLOR_TYPE_PALETTE)
                     memcpy(p->data[1], s->palette, 256 * sizeof(uint32_t));
+                ff_thread_finish_setup(avctx);
                 /* empty row is used if differencing to the first row */
                 s->last_row = av_mallocz(s->row_size);
                 if (!s->last_row)
@@ -584,7 +596,10 @@ static int decode_frame(AVCodecContext *avctx,
         {
             int n, i, r, g, b;
 
-            if ((length % 3) != 0 || length > 256 * 3)
+            /* the palette is shared with the next frame thread once the
+             * image data starts, and must precede it anyway */
+            if ((length % 3) != 0 || length > 256 * 3 ||
+                s->state & PNG_IDAT)
                 goto skip_tag;
             /* read the palette */
             n = length / 3;
@@ -607,7 +622,7 @@ static int decode_frame(AVCodecContext *avctx,
             /* read the transparency. XXX: Only palette mode supported */
             if (s->color_type != PNG_COLOR_TYPE_PALETTE ||
                 length > 256 ||
-                !(s->state & PNG_PLTE))
+                !(s->state & PNG_PLTE) || s->state & PNG_IDAT)
                 goto skip_tag;
             for (i = 0; i < length; i++) {
                 v = bytestream2_get_byte(&s->gb);
@@ -618,13 +633,11 @@ static int decode_frame(AVCodecContext *avctx,
         break;
         case MKTAG('s', 'T', 'E', 'R'): {
             int mode = bytestream2_get_byte(&s->gb);
-            AVStereo3D *stereo3d = av_stereo3d_create_side_data(p);
-            if (!stereo3d)
-                goto the_end;
 
+            /* the side data is attached to the output reference only, the
+             * picture may already be shared with another frame thread */
             if (mode == 0 || mode == 1) {
-                stereo3d->type  = AV_STEREO3D_SIDEBYSIDE;
-                stereo3d->flags = mode ? 0 : AV_STEREO3D_FLAG_INVERT;
+                s->stereo_mode = mode;
             } else {
                  av_log(avctx, AV_LOG_WARNING,
                         "Unknown value in sTER chunk (%d)\n", mode);
@@ -646,11 +659,13 @@ skip_tag:
     }
 exit_loop:
     /* handle P-frames only if a predecessor frame is available */
-    if (s->prev->data[0]) {
+    if (s->prev.f->data[0]) {
         if (!(avpkt->flags & AV_PKT_FLAG_KEY)) {
             int i, j;
             uint8_t *pd      = p->data[0];
-            uint8_t *pd_last = s->prev->data[0];
+            uint8_t *pd_last = s->prev.f->data[0];
+
+            ff_thread_await_progress(&s->prev, INT_MAX, 0);
 
             for (j = 0; j < s->height; j++) {
                 for (i = 0; i < s->width * s->bpp; i++)
@@ -661,9 +676,21 @@ exit_loop:
         }
     }
 
-    av_frame_unref(s->prev);
-    if ((ret = av_frame_ref(s->prev, p)) < 0)
-        goto fail;
+    ff_thread_report_progress(&s->picture, INT_MAX, 0);
+
+    if ((ret = av_frame_ref(data, p)) < 0)
+        goto the_end;
+
+    if (s->stereo_mode >= 0) {
+        AVStereo3D *stereo3d = av_stereo3d_create_side_data(data);
+        if (!stereo3d) {
+            av_frame_unref(data);
+            ret = AVERROR(ENOMEM);
+            goto the_end;
+        }
+        stereo3d->type  = AV_STEREO3D_SIDEBYSIDE;
+        stereo3d->flags = s->stereo_mode ? 0 : AV_STEREO3D_FLAG_INVERT;
+    }
 
     *got_frame = 1;
 
@@ -676,19 +703,66 @@ the_end:
     av_freep(&s->tmp_row);
     return ret;
 fail:
+    /* frame threads waiting on this picture must not block forever */
+    if (p->data[0])
+        ff_thread_report_progress(&s->picture, INT_MAX, 0);
     ret = -1;
     goto the_end;
 }
 
+#if HAVE_THREADS
+static int update_thread_context(AVCodecContext *dst,
+                                 const AVCodecContext *src)
+{
+    PNGDecContext *pdst = dst->priv_data;
+    PNGDecContext *psrc = src->priv_data;
+    int ret;
+
+    if (dst == src)
+        return 0;
+
+    memcpy(pdst->palette, psrc->palette, sizeof(pdst->palette));
+
+    ff_thread_release_buffer(dst, &pdst->picture);
+    if (psrc->picture.f->data[0]) {
+        ret = ff_thread_ref_frame(&pdst->picture, &psrc->picture);
+        if (ret < 0)
+            return ret;
+    }
+
+    return 0;
+}
+
+static av_cold int png_dec_init_thread_copy(AVCodecContext *avctx)
+{
+    PNGDecContext *s = avctx->priv_data;
+
+    s->picture.f = av_frame_alloc();
+    s->prev.f    = av_frame_alloc();
+    if (!s->picture.f || !s->prev.f) {
+        av_frame_free(&s->picture.f);
+        av_frame_free(&s->prev.f);
+        return AVERROR(ENOMEM);
+    }
+
+    return 0;
+}
+#endif
+
 static av_cold int png_dec_init(AVCodecContext *avctx)
 {
     PNGDecContext *s = avctx->priv_data;
 
     avctx->color_range = AVCOL_RANGE_JPEG;
+    avctx->internal->allocate_progress = 1;
 
-    s->prev = av_frame_alloc();
-    if (!s->prev)
+    s->picture.f = av_frame_alloc();
+    s->prev.f    = av_frame_alloc();
+    if (!s->picture.f || !s->prev.f) {
+        av_frame_free(&s->picture.f);
+        av_frame_free(&s->prev.f);
         return AVERROR(ENOMEM);
+    }
 
     ff_pngdsp_init(&s->dsp);
 
@@ -699,20 +773,27 @@ static av_cold int png_dec_end(AVCodecContext *avctx)
 {
     PNGDecContext *s = avctx->priv_data;
 
-    av_frame_free(&s->prev);
+    if (s->picture.f)
+        ff_thread_release_buffer(avctx, &s->picture);
+    av_frame_free(&s->picture.f);
+    if (s->prev.f)
+        ff_thread_release_buffer(avctx, &s->prev);
+    av_frame_free(&s->prev.f);
 
     return 0;
 }
 
 AVCodec ff_png_decoder = {
-    .name           = "png",
-    .long_name      = NULL_IF_CONFIG_SMALL("PNG (Portable Network Graphics) image"),
-    .type           = AVMEDIA_TYPE_VIDEO,
-    .id             = AV_CODEC_ID_PNG,
-    .priv_data_size = sizeof(PNGDecContext),
-    .init           = png_dec_init,
-    .close          = png_dec_end,
-    .decode         = decode_frame,
-    .capabilities   = AV_CODEC_CAP_DR1 /*| AV_CODEC_CAP_DRAW_HORIZ_BAND*/,
-    .caps_internal  = FF_CODEC_CAP_INIT_THREADSAFE,
+    .name                  = "png",
+    .long_name             = NULL_IF_CONFIG_SMALL("PNG (Portable Network Graphics) image"),
+    .type                  = AVMEDIA_TYPE_VIDEO,
+    .id                    = AV_CODEC_ID_PNG,
+    .priv_data_size        = sizeof(PNGDecContext),
+    .init                  = png_dec_init,
+    .close                 = png_dec_end,
+    .decode                = decode_frame,
+    .init_thread_copy      = ONLY_IF_THREADS_ENABLED(png_dec_init_thread_copy),
+    .update_thread_context = ONLY_IF_THREADS_ENABLED(update_thread_context),
+    .capabilities          = AV_CODEC_CAP_DR1 | AV_CODEC_CAP_FRAME_THREADS,
+    .caps_internal         = FF_CODEC_CAP_INIT_THREADSAFE,
 };
@@ -35,6 +35,17 @@
 
 #define IOBUF_SIZE 4096
 
+/* amount of filtered image data deflated as one independent stream when
+ * slice threading, small enough to keep all threads busy on common image
+ * sizes, large enough to make the lost history negligible */
+#define GROUP_SIZE (128 * 1024)
+
+typedef struct PNGRowGroup {
+    uint8_t *buf;
+    int size;
+    uLong adler;
+} PNGRowGroup;
+
 typedef struct PNGEncContext {
     AVClass *class;
     HuffYUVEncDSPContext hdsp;
@@ -47,6 +58,19 @@ typedef struct PNGEncContext {
 
     z_stream zstream;
     uint8_t buf[IOBUF_SIZE];
+
+    /* parallel deflate of row groups */
+    const AVFrame *frame;
+    int color_type;
+    int bits_per_pixel;
+    int row_size;
+    int compression_level;
+    int group_rows;
+    int group_buf_size;
+    PNGRowGroup *groups;
+    int nb_groups;
+    uint8_t *group_buf;
+    unsigned int group_buf_alloc;
 } PNGEncContext;
 
 static void png_get_interlaced_row(uint8_t *dst, int row_size,
@@ -233,6 +257,162 @@ static int png_write_row(PNGEncContext *s, const uint8_t *data, int size)
     return 0;
 }
 
+/**
+ * Filter and deflate the rows of one group into a raw deflate stream.
+ * All groups but the last end with a full flush so that their streams
+ * can be concatenated into a single zlib stream.
+ */
+static int deflate_row_group(AVCodecContext *avctx, void *arg,
+                             int jobnr, int threadnr)
+{
+    PNGEncContext *s   = avctx->priv_data;
+    PNGRowGroup *group = &s->groups[jobnr];
+    const AVFrame *p   = s->frame;
+    int y_start        = jobnr * s->group_rows;
+    int y_end          = FFMIN(y_start + s->group_rows, avctx->height);
+    int row_size       = s->row_size;
+    int bpp            = s->bits_per_pixel >> 3;
+    int is_rgba        = s->color_type == PNG_COLOR_TYPE_RGB_ALPHA;
+    uint8_t *crow_base = NULL, *rgba_buf = NULL, *top_buf = NULL;
+    uint8_t *ptr, *top, *crow_buf, *crow;
+    z_stream zstream;
+    int y, ret = -1;
+
+    zstream.zalloc = ff_png_zalloc;
+    zstream.zfree  = ff_png_zfree;
+    zstream.opaque = NULL;
+    if (deflateInit2(&zstream, s->compression_level,
+                     Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+        return -1;
+    zstream.next_out  = group->buf;
+    zstream.avail_out = s->group_buf_size;
+    group->adler      = adler32(0, Z_NULL, 0);
+
+    crow_base = av_malloc((row_size + 32) << (s->filter_type == PNG_FILTER_VALUE_MIXED));
+    if (!crow_base)
+        goto the_end;
+    crow_buf = crow_base + 15;
+    if (is_rgba) {
+        rgba_buf = av_malloc(row_size + 1);
+        top_buf  = av_malloc(row_size + 1);
+        if (!rgba_buf || !top_buf)
+            goto the_end;
+    }
+
+    /* the first row is predicted from the last row of the previous group */
+    top = NULL;
+    if (y_start > 0) {
+        top = p->data[0] + (y_start - 1) * p->linesize[0];
+        if (is_rgba) {
+            /* swapped into top_buf by the first iteration */
+            convert_from_rgb32(rgba_buf, top, avctx->width);
+            top = rgba_buf;
+        }
+    }
+
+    for (y = y_start; y < y_end; y++) {
+        ptr = p->data[0] + y * p->linesize[0];
+        if (is_rgba) {
+            FFSWAP(uint8_t *, rgba_buf, top_buf);
+            convert_from_rgb32(rgba_buf, ptr, avctx->width);
+            ptr = rgba_buf;
+        }
+        crow = png_choose_filter(s, crow_buf, ptr, top, row_size, bpp);
+        group->adler = adler32(group->adler, crow, row_size + 1);
+
+        zstream.next_in  = crow;
+        zstream.avail_in = row_size + 1;
+        if (deflate(&zstream, Z_NO_FLUSH) != Z_OK || zstream.avail_in)
+            goto the_end;
+        top = ptr;
+    }
+
+    if (y_end == avctx->height) {
+        if (deflate(&zstream, Z_FINISH) != Z_STREAM_END)
+            goto the_end;
+    } else {
+        if (deflate(&zstream, Z_FULL_FLUSH) != Z_OK || !zstream.avail_out)
+            goto the_end;
+    }
+    group->size = s->group_buf_size - zstream.avail_out;
+    ret         = 0;
+
+the_end:
+    av_free(crow_base);
+    av_free(rgba_buf);
+    av_free(top_buf);
+    deflateEnd(&zstream);
+    return ret;
+}
+
+/**
+ * Write the image data as one IDAT chunk per row group, the groups being
+ * deflated in parallel.
+ */
+static int write_row_groups(AVCodecContext *avctx, const AVFrame *p)
+{
+    PNGEncContext *s = avctx->priv_data;
+    int level        = s->compression_level;
+    int i, flevel, bound;
+    uLong adler;
+
+    s->frame      = p;
+    s->group_rows = FFMAX(1, GROUP_SIZE / (s->row_size + 1));
+    s->nb_groups  = (avctx->height + s->group_rows - 1) / s->group_rows;
+
+    /* raw deflate bound, with room for the flush marker and the zlib
+     * header and trailer */
+    bound = (s->row_size + 1) * s->group_rows;
+    s->group_buf_size = bound + (bound >> 12) + (bound >> 14) + (bound >> 25) +
+                        64;
+    av_fast_malloc(&s->group_buf, &s->group_buf_alloc,
+                   (size_t)s->nb_groups * s->group_buf_size);
+    if (!s->group_buf)
+        return AVERROR(ENOMEM);
+    if (av_reallocp_array(&s->groups, s->nb_groups, sizeof(*s->groups)) < 0)
+        return AVERROR(ENOMEM);
+    for (i = 0; i < s->nb_groups; i++) {
+        s->groups[i].buf  = s->group_buf + (size_t)i * s->group_buf_size + 2;
+        s->groups[i].size = 0;
+    }
+    s->group_buf_size -= 6;
+
+    avctx->execute2(avctx, deflate_row_group, NULL, NULL, s->nb_groups);
+
+    for (i = 0; i < s->nb_groups; i++)
+        if (!s->groups[i].size)
+            return -1;
+
+    /* zlib header, as written by deflateInit() for the same level */
+    if (level == Z_DEFAULT_COMPRESSION)
+        level = 6;
+    flevel = level < 2 ? 0 : level < 6 ? 1 : level == 6 ? 2 : 3;
+    s->groups[0].buf    -= 2;
+    s->groups[0].size   += 2;
+    s->groups[0].buf[0]  = 0x78;
+    s->groups[0].buf[1]  = flevel << 6;
+    s->groups[0].buf[1] += 31 - (0x7800 + s->groups[0].buf[1]) % 31;
+
+    adler = s->groups[0].adler;
+    for (i = 1; i < s->nb_groups; i++) {
+        int rows = FFMIN(s->group_rows, avctx->height - i * s->group_rows);
+        adler = adler32_combine(adler, s->groups[i].adler,
+                                (s->row_size + 1) * rows);
+    }
+    AV_WB32(s->groups[s->nb_groups - 1].buf + s->groups[s->nb_groups - 1].size,
+            adler);
+    s->groups[s->nb_groups - 1].size += 4;
+
+    for (i = 0; i < s->nb_groups; i++) {
+        if (s->bytestream_end - s->bytestream < s->groups[i].size + 12)
+            return -1;
+        png_write_chunk(&s->bytestream, MKTAG('I', 'D', 'A', 'T'),
+                        s->groups[i].buf, s->groups[i].size);
+    }
+
+    return 0;
+}
+
 static int encode_frame(AVCodecContext *avctx, AVPacket *pkt,
                         const AVFrame *pict, int *got_packet)
 {
@@ -241,7 +421,7 @@ static int encode_frame(AVCodecContext *avctx, AVPacket *pkt,
     const AVFrame *const p = pict;
     int bit_depth, color_type, y, len, row_size, ret, is_progressive;
     int bits_per_pixel, pass_row_size, enc_row_size, max_packet_size;
-    int compression_level;
+    int compression_level, row_groups;
     uint8_t *ptr, *top, *crow_buf, *crow;
     uint8_t *crow_base       = NULL;
     uint8_t *progressive_buf = NULL;
@@ -249,6 +429,8 @@ static int encode_frame(AVCodecContext *avctx, AVPacket *pkt,
     uint8_t *top_buf         = NULL;
 
     is_progressive = !!(avctx->flags & AV_CODEC_FLAG_INTERLACED_DCT);
+    row_groups     = avctx->active_thread_type & FF_THREAD_SLICE &&
+                     !is_progressive;
     switch (avctx->pix_fmt) {
     case AV_PIX_FMT_RGBA64BE:
         bit_depth = 16;
@@ -299,6 +481,11 @@ static int encode_frame(AVCodecContext *avctx, AVPacket *pkt,
     if (ret != Z_OK)
         return -1;
 
+    s->color_type        = color_type;
+    s->bits_per_pixel    = bits_per_pixel;
+    s->row_size          = row_size;
+    s->compression_level = compression_level;
+
     enc_row_size    = deflateBound(&s->zstream, row_size);
     max_packet_size = avctx->height * (enc_row_size +
                                        ((enc_row_size + IOBUF_SIZE - 1) / IOBUF_SIZE) * 12)
@@ -398,7 +585,11 @@ static int encode_frame(AVCodecContext *avctx, AVPacket *pkt,
     /* now put each row */
     s->zstream.avail_out = IOBUF_SIZE;
     s->zstream.next_out  = s->buf;
-    if (is_progressive) {
+    if (row_groups) {
+        ret = write_row_groups(avctx, p);
+        if (ret < 0)
+            goto the_end;
+    } else if (is_progressive) {
         int pass;
 
         for (pass = 0; pass < NB_PASSES; pass++) {
@@ -441,7 +632,7 @@ static int encode_frame(AVCodecContext *avctx, AVPacket *pkt,
         }
     }
     /* compress last bytes */
-    for (;;) {
+    while (!row_groups) {
         ret = deflate(&s->zstream, Z_FINISH);
         if (ret == Z_OK || ret == Z_STREAM_END) {
             len = IOBUF_SIZE - s->zstream.avail_out;
@@ -503,6 +694,17 @@ FF_ENABLE_DEPRECATION_WARNINGS
     return 0;
 }
 
+static av_cold int png_enc_close(AVCodecContext *avctx)
+{
+    PNGEncContext *s = avctx->priv_data;
+
+    av_freep(&s->groups);
+    av_freep(&s->group_buf);
+    s->group_buf_alloc = 0;
+
+    return 0;
+}
+
 #define OFFSET(x) offsetof(PNGEncContext, x)
 #define VE AV_OPT_FLAG_VIDEO_PARAM | AV_OPT_FLAG_ENCODING_PARAM
 static const AVOption options[] = {
@@ -531,7 +733,9 @@ AVCodec ff_png_encoder = {
     .priv_data_size = sizeof(PNGEncContext),
     .priv_class     = &png_class,
     .init           = png_enc_init,
+    .close          = png_enc_close,
     .encode2        = encode_frame,
+    .capabilities   = AV_CODEC_CAP_SLICE_THREADS,
     .pix_fmts       = (const enum AVPixelFormat[]) {
         AV_PIX_FMT_RGB24, AV_PIX_FMT_RGB32, AV_PIX_FMT_PAL8, AV_PIX_FMT_GRAY8,
         AV_PIX_FMT_RGBA64BE, AV_PIX_FMT_RGB48BE, AV_PIX_FMT_GRAY16BE,
@@ -88,6 +88,14 @@ typedef struct PerThreadContext {
 
     atomic_int state;
 
+    /**
+     * Lowest progress value awaited by a thread blocked on progress_cond since
+     * the last progress broadcast, INT_MAX if there is none. Lets
+     * ff_thread_report_progress() skip the broadcast, and the mutex, when
+     * nobody can be woken by it.
+     */
+    atomic_int progress_wait;
+
     /**
      * Array of frames passed to ff_thread_release_buffer().
      * Frames are released after all threads referencing them are finished.
@@ -513,10 +521,16 @@ void ff_thread_report_progress(ThreadFrame *f, int n, int field)
     if (f->owner->debug&FF_DEBUG_THREADS)
         av_log(f->owner, AV_LOG_DEBUG, "%p finished %d field %d\n", progress, n, field);
 
-    pthread_mutex_lock(&p->progress_mutex);
+    /* Sequentially consistent, pairs with ff_thread_await_progress(): either
+     * the waiter sees the new progress or this sees its progress_wait. */
+    atomic_store(&progress[field], n);
 
-    atomic_store_explicit(&progress[field], n, memory_order_release);
+    if (atomic_load(&p->progress_wait) > n)
+        return;
 
+    pthread_mutex_lock(&p->progress_mutex);
+    /* the woken threads register again if they still have to wait */
+    atomic_store(&p->progress_wait, INT_MAX);
     pthread_cond_broadcast(&p->progress_cond);
     pthread_mutex_unlock(&p->progress_mutex);
 }
@@ -536,8 +550,13 @@ void ff_thread_await_progress(ThreadFrame *f, int n, int field)
         av_log(f->owner, AV_LOG_DEBUG, "thread awaiting %d field %d from %p\n", n, field, progress);
 
     pthread_mutex_lock(&p->progress_mutex);
-    while (atomic_load_explicit(&progress[field], memory_order_relaxed) < n)
+    while (1) {
+        int wait = atomic_load_explicit(&p->progress_wait, memory_order_relaxed);
+        atomic_store(&p->progress_wait, FFMIN(wait, n));
+        if (atomic_load(&progress[field]) >= n)
+            break;
         pthread_cond_wait(&p->progress_cond, &p->progress_mutex);
+    }
     pthread_mutex_unlock(&p->progress_mutex);
 }
 
@@ -704,6 +723,7 @@ int ff_frame_thread_init(AVCodecContext *avctx)
         pthread_cond_init(&p->input_cond, NULL);
         pthread_cond_init(&p->progress_cond, NULL);
         pthread_cond_init(&p->output_cond, NULL);
+        atomic_init(&p->progress_wait, INT_MAX);
 
         p->frame = av_frame_alloc();
         if (!p->frame) {
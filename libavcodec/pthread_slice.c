@@ -38,6 +38,7 @@
 #include "libavutil/common.h"
 #include "libavutil/cpu.h"
 #include "libavutil/mem.h"
+#include "libavutil/slicepool_internal.h"
 
 typedef int (action_func)(AVCodecContext *c, void *arg);
 typedef int (action_func2)(AVCodecContext *c, void *arg, int jobnr, int threadnr);
@@ -58,8 +59,31 @@ typedef struct SliceThreadContext {
     unsigned current_execute;
     int current_job;
     int done;
+
+    int shared;                 ///< the jobs run on the shared slice thread pool
 } SliceThreadContext;
 
+/**
+ * Parameters of one execute() call on the shared slice thread pool.
+ */
+typedef struct SharedExecute {
+    AVCodecContext *avctx;
+    action_func *func;
+    action_func2 *func2;
+    void *args;
+    int *rets;
+    int rets_count;
+    int job_size;
+} SharedExecute;
+
+static void shared_worker(void *v, int jobnr, int threadnr)
+{
+    SharedExecute *e = v;
+
+    e->rets[jobnr % e->rets_count] = e->func ? e->func(e->avctx, (char*)e->args + jobnr * e->job_size) :
+                                               e->func2(e->avctx, e->args, jobnr, threadnr);
+}
+
 static void* attribute_align_arg worker(void *v)
 {
     AVCodecContext *avctx = v;
@@ -101,6 +125,11 @@ void ff_slice_thread_free(AVCodecContext *avctx)
     SliceThreadContext *c = avctx->internal->thread_ctx;
     int i;
 
+    if (c->shared) {
+        av_freep(&avctx->internal->thread_ctx);
+        return;
+    }
+
     pthread_mutex_lock(&c->current_job_lock);
     c->done = 1;
     pthread_cond_broadcast(&c->current_job_cond);
@@ -134,6 +163,20 @@ static int thread_execute(AVCodecContext *avctx, action_func* func, void *arg, i
     if (job_count <= 0)
         return 0;
 
+    if (c->shared) {
+        SharedExecute e = {
+            .avctx      = avctx,
+            .func       = func,
+            .func2      = c->func2,
+            .args       = arg,
+            .rets       = ret ? ret : &dummy_ret,
+            .rets_count = ret ? job_count : 1,
+            .job_size   = job_size,
+        };
+        avpriv_slice_pool_execute(shared_worker, &e, job_count, avctx->thread_count);
+        return 0;
+    }
+
     pthread_mutex_lock(&c->current_job_lock);
 
     c->current_job = avctx->thread_count;
@@ -192,6 +235,15 @@ int ff_slice_thread_init(AVCodecContext *avctx)
     if (!c)
         return -1;
 
+    if (avpriv_slice_pool_enabled() &&
+        !(avctx->codec->caps_internal & FF_CODEC_CAP_SLICE_THREAD_SYNC)) {
+        c->shared = 1;
+        avctx->internal->thread_ctx = c;
+        avctx->execute  = thread_execute;
+        avctx->execute2 = thread_execute2;
+        return 0;
+    }
+
     c->workers = av_mallocz(sizeof(pthread_t)*thread_count);
     if (!c->workers) {
         av_free(c);
@@ -505,6 +505,9 @@ av_cold int ff_rate_control_init(MpegEncContext *s)
 
         rcc->last_qscale_for[i] = FF_QP2LAMBDA * 5;
     }
+    rcc->lookahead_pred[0].decay =
+    rcc->lookahead_pred[1].decay = 0.4;
+
     rcc->buffer_index = s->avctx->rc_initial_buffer_occupancy;
 
     if (s->avctx->flags & AV_CODEC_FLAG_PASS2) {
@@ -700,6 +703,52 @@ static void update_predictor(Predictor *p, double q, double var, double size)
     p->coeff += new_coeff;
 }
 
+static int lookahead_cost(MpegEncContext *s)
+{
+    const Picture *pic = s->reordered_input_picture[0];
+
+    return s->pict_type == AV_PICTURE_TYPE_I ? pic->lookahead_intra_cost
+                                             : pic->lookahead_cost;
+}
+
+/**
+ * Raise q until the frame being coded and the frames the lookahead has seen
+ * after it are predicted to fit in the VBV buffer at the maximum rate.
+ */
+static double lookahead_vbv_qscale(MpegEncContext *s, double q, int qmax)
+{
+    RateControlContext *rcc = &s->rc_context;
+    const double fps        = 1 / av_q2d(s->avctx->time_base);
+    const double max_rate   = s->avctx->rc_max_rate / fps;
+    const int buffer_size   = s->avctx->rc_buffer_size;
+    int types[MAX_PICTURE_COUNT], costs[MAX_PICTURE_COUNT];
+    int i, n;
+
+    if (!rcc->lookahead_pred[1].count)
+        return q;
+
+    n = ff_mpv_lookahead_window(s, types, costs, MAX_PICTURE_COUNT);
+
+    for (; q < qmax; q = FFMIN(q * 1.05, qmax)) {
+        double buffer = rcc->buffer_index;
+
+        for (i = 0; i < n; i++) {
+            Predictor *p = &rcc->lookahead_pred[types[i] != AV_PICTURE_TYPE_I];
+
+            if (!p->count)
+                p = &rcc->lookahead_pred[1];
+            buffer -= predict_size(p, q, costs[i]);
+            if (buffer < 0)
+                break;
+            buffer += FFMIN(max_rate, buffer_size - buffer);
+        }
+        if (i == n)
+            break;
+    }
+
+    return q;
+}
+
 static void adaptive_quantization(MpegEncContext *s, double q)
 {
     int i;
@@ -858,6 +907,10 @@ float ff_rate_estimate_qscale(MpegEncContext *s, int dry_run)
         update_predictor(&rcc->pred[s->last_pict_type],
                          rcc->last_qscale,
                          sqrt(last_var), s->frame_bits);
+        if (s->b_frame_strategy == 3)
+            update_predictor(&rcc->lookahead_pred[s->last_pict_type != AV_PICTURE_TYPE_I],
+                             rcc->last_qscale,
+                             rcc->last_lookahead_cost, s->frame_bits);
     }
 
     if (s->avctx->flags & AV_CODEC_FLAG_PASS2) {
@@ -915,7 +968,8 @@ float ff_rate_estimate_qscale(MpegEncContext *s, int dry_run)
             rce->p_tex_bits = 0;
             rce->mv_bits    = 0;
         } else {
-            rce->i_count    = 0;    // FIXME we do know this approx
+            rce->i_count    = s->b_frame_strategy == 3 ?
+                              s->reordered_input_picture[0]->lookahead_intra_mbs : 0;
             rce->i_tex_bits = 0;
             rce->p_tex_bits = bits * 0.9;
             rce->mv_bits    = bits * 0.1;
@@ -950,6 +1004,9 @@ float ff_rate_estimate_qscale(MpegEncContext *s, int dry_run)
 
         q = modify_qscale(s, rce, q, picture_number);
 
+        if (s->b_frame_strategy == 3 && a->rc_buffer_size && a->rc_max_rate)
+            q = lookahead_vbv_qscale(s, q, qmax);
+
         rcc->pass1_wanted_bits += s->bit_rate / fps;
 
         assert(q > 0.0);
@@ -981,6 +1038,8 @@ float ff_rate_estimate_qscale(MpegEncContext *s, int dry_run)
         rcc->last_qscale        = q;
         rcc->last_mc_mb_var_sum = pic->mc_mb_var_sum;
         rcc->last_mb_var_sum    = pic->mb_var_sum;
+        if (s->b_frame_strategy == 3)
+            rcc->last_lookahead_cost = lookahead_cost(s);
     }
     return q;
 }
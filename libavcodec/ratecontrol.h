@@ -80,6 +80,10 @@ typedef struct RateControlContext{
     int frame_count[5];
     int last_non_b_pict_type;
     AVExpr * rc_eq_eval;
+
+    /* frame size predictors from the b_frame_strategy 3 lookahead costs */
+    Predictor lookahead_pred[2];  ///< for intra and inter frames
+    int last_lookahead_cost;
 }RateControlContext;
 
 struct MpegEncContext;
@@ -83,6 +83,7 @@ typedef struct UtvideoContext {
     ptrdiff_t slice_stride;
     uint8_t *slice_bits, *slice_buffer[4];
     int      slice_bits_size;
+    uint64_t (*slice_counts)[256];
 } UtvideoContext;
 
 typedef struct HuffEntry {
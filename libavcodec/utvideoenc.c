@@ -51,6 +51,7 @@ static av_cold int utvideo_encode_close(AVCodecContext *avctx)
     int i;
 
     av_freep(&c->slice_bits);
+    av_freep(&c->slice_counts);
     for (i = 0; i < 4; i++)
         av_freep(&c->slice_buffer[i]);
 
@@ -172,13 +173,16 @@ FF_ENABLE_DEPRECATION_WARNINGS
         return AVERROR(ENOMEM);
     }
 
-    for (i = 0; i < c->planes; i++) {
-        c->slice_buffer[i] = av_malloc(c->slice_stride * (avctx->height + 2) +
-                                       AV_INPUT_BUFFER_PADDING_SIZE);
-        if (!c->slice_buffer[i]) {
-            av_log(avctx, AV_LOG_ERROR, "Cannot allocate temporary buffer 1.\n");
-            utvideo_encode_close(avctx);
-            return AVERROR(ENOMEM);
+    /* Only RGB needs the planes to be mangled before prediction */
+    if (avctx->pix_fmt == AV_PIX_FMT_RGBA || avctx->pix_fmt == AV_PIX_FMT_RGB24) {
+        for (i = 0; i < c->planes; i++) {
+            c->slice_buffer[i] = av_malloc(c->slice_stride * (avctx->height + 2) +
+                                           AV_INPUT_BUFFER_PADDING_SIZE);
+            if (!c->slice_buffer[i]) {
+                av_log(avctx, AV_LOG_ERROR, "Cannot allocate temporary buffer 1.\n");
+                utvideo_encode_close(avctx);
+                return AVERROR(ENOMEM);
+            }
         }
     }
 
@@ -215,6 +219,12 @@ FF_ENABLE_DEPRECATION_WARNINGS
         c->slices = avctx->slices;
     }
 
+    c->slice_counts = av_malloc_array(c->slices, sizeof(*c->slice_counts));
+    if (!c->slice_counts) {
+        utvideo_encode_close(avctx);
+        return AVERROR(ENOMEM);
+    }
+
     /* Set compression mode */
     c->compression = COMP_HUFF;
 
@@ -387,55 +397,104 @@ static int write_huff_codes(uint8_t *src, uint8_t *dst, int dst_size,
     return count;
 }
 
-static int encode_plane(AVCodecContext *avctx, uint8_t *src,
-                        uint8_t *dst, ptrdiff_t stride,
-                        int width, int height, PutByteContext *pb)
-{
-    UtvideoContext *c        = avctx->priv_data;
-    uint8_t  lengths[256];
-    uint64_t counts[256]     = { 0 };
+/* Per-plane state shared by the slice jobs */
+typedef struct EncodePlaneContext {
+    uint8_t  *src, *dst;
+    ptrdiff_t stride;
+    int       width, height;
 
     HuffEntry he[256];
+    uint8_t  *slice_data;
+    uint32_t  slice_end[256];
+} EncodePlaneContext;
 
-    uint32_t offset = 0, slice_len = 0;
-    int      i, sstart, send = 0;
-    int      symbol;
+/* Predict one slice and count the usage of its values */
+static int predict_slice(AVCodecContext *avctx, void *arg,
+                         int jobnr, int threadnr)
+{
+    UtvideoContext     *c = avctx->priv_data;
+    EncodePlaneContext *p = arg;
+    int sstart = p->height *  jobnr      / c->slices;
+    int send   = p->height * (jobnr + 1) / c->slices;
+    uint8_t *src = p->src + sstart * p->stride;
+    uint8_t *dst = p->dst + sstart * p->width;
 
-    /* Do prediction / make planes */
     switch (c->frame_pred) {
     case PRED_NONE:
-        for (i = 0; i < c->slices; i++) {
-            sstart = send;
-            send   = height * (i + 1) / c->slices;
-            av_image_copy_plane(dst + sstart * width, width,
-                                src + sstart * stride, stride,
-                                width, send - sstart);
-        }
+        av_image_copy_plane(dst, p->width, src, p->stride,
+                            p->width, send - sstart);
         break;
     case PRED_LEFT:
-        for (i = 0; i < c->slices; i++) {
-            sstart = send;
-            send   = height * (i + 1) / c->slices;
-            left_predict(src + sstart * stride, dst + sstart * width,
-                         stride, width, send - sstart);
-        }
+        left_predict(src, dst, p->stride, p->width, send - sstart);
         break;
     case PRED_MEDIAN:
-        for (i = 0; i < c->slices; i++) {
-            sstart = send;
-            send   = height * (i + 1) / c->slices;
-            median_predict(c, src + sstart * stride, dst + sstart * width,
-                           stride, width, send - sstart);
-        }
+        median_predict(c, src, dst, p->stride, p->width, send - sstart);
         break;
-    default:
+    }
+
+    memset(c->slice_counts[jobnr], 0, sizeof(c->slice_counts[jobnr]));
+    count_usage(dst, p->width, send - sstart, c->slice_counts[jobnr]);
+
+    return 0;
+}
+
+/* Write the huffman codes of one slice to its place in the packet */
+static int encode_slice(AVCodecContext *avctx, void *arg,
+                        int jobnr, int threadnr)
+{
+    UtvideoContext     *c = avctx->priv_data;
+    EncodePlaneContext *p = arg;
+    int sstart     = p->height *  jobnr      / c->slices;
+    int send       = p->height * (jobnr + 1) / c->slices;
+    uint32_t start = jobnr ? p->slice_end[jobnr - 1] : 0;
+    uint32_t size  = p->slice_end[jobnr] - start;
+    uint8_t *dst   = p->slice_data + start;
+
+    write_huff_codes(p->dst + sstart * p->width, dst, size,
+                     p->width, send - sstart, p->he);
+
+    /* Byteswap the written huffman codes */
+    c->bdsp.bswap_buf((uint32_t *) dst, (uint32_t *) dst, size >> 2);
+
+    return 0;
+}
+
+static int encode_plane(AVCodecContext *avctx, uint8_t *src,
+                        uint8_t *dst, ptrdiff_t stride,
+                        int width, int height, PutByteContext *pb)
+{
+    UtvideoContext *c        = avctx->priv_data;
+    EncodePlaneContext p     = {
+        .src    = src,
+        .dst    = dst,
+        .stride = stride,
+        .width  = width,
+        .height = height,
+    };
+    uint8_t  lengths[256];
+    uint64_t counts[256]     = { 0 };
+
+    uint32_t offset = 0;
+    int      i, j;
+    int      symbol;
+
+    if (c->frame_pred != PRED_NONE && c->frame_pred != PRED_LEFT &&
+        c->frame_pred != PRED_MEDIAN) {
         av_log(avctx, AV_LOG_ERROR, "Unknown prediction mode: %d\n",
                c->frame_pred);
         return AVERROR_OPTION_NOT_FOUND;
     }
 
+    /*
+     * Do prediction / make planes, the slices are predicted independently
+     * so they can be processed in parallel.
+     */
+    avctx->execute2(avctx, predict_slice, &p, NULL, c->slices);
+
     /* Count the usage of values */
-    count_usage(dst, width, height, counts);
+    for (i = 0; i < c->slices; i++)
+        for (j = 0; j < 256; j++)
+            counts[j] += c->slice_counts[i][j];
 
     /* Check for a special case where only one symbol was used */
     for (symbol = 0; symbol < 256; symbol++) {
@@ -476,50 +535,39 @@ static int encode_plane(AVCodecContext *avctx, uint8_t *src,
     for (i = 0; i < 256; i++) {
         bytestream2_put_byte(pb, lengths[i]);
 
-        he[i].len = lengths[i];
-        he[i].sym = i;
+        p.he[i].len = lengths[i];
+        p.he[i].sym = i;
     }
 
     /* Calculate the huffman codes themselves */
-    calculate_codes(he);
+    calculate_codes(p.he);
 
-    send = 0;
+    /*
+     * The size of each slice is known from its counts, so all the slice
+     * offsets can be written before the slices are coded in parallel.
+     */
     for (i = 0; i < c->slices; i++) {
-        sstart  = send;
-        send    = height * (i + 1) / c->slices;
+        uint64_t bits = 0;
 
-        /*
-         * Write the huffman codes to a buffer,
-         * get the offset in bits and convert to bytes.
-         */
-        offset += write_huff_codes(dst + sstart * width, c->slice_bits,
-                                   width * (send - sstart), width,
-                                   send - sstart, he) >> 3;
+        for (j = 0; j < 256; j++)
+            bits += c->slice_counts[i][j] * lengths[j];
 
-        slice_len = offset - slice_len;
+        /* Slices are padded to a 32-bit boundary */
+        offset          += FFALIGN(bits, 32) >> 3;
+        p.slice_end[i]   = offset;
 
-        /* Byteswap the written huffman codes */
-        c->bdsp.bswap_buf((uint32_t *) c->slice_bits,
-                          (uint32_t *) c->slice_bits,
-                          slice_len >> 2);
-
-        /* Write the offset to the stream */
         bytestream2_put_le32(pb, offset);
+    }
 
-        /* Seek to the data part of the packet */
-        bytestream2_seek_p(pb, 4 * (c->slices - i - 1) +
-                           offset - slice_len, SEEK_CUR);
-
-        /* Write the slices' data into the output packet */
-        bytestream2_put_buffer(pb, c->slice_bits, slice_len);
-
-        /* Seek back to the slice offsets */
-        bytestream2_seek_p(pb, -4 * (c->slices - i - 1) - offset,
-                           SEEK_CUR);
-
-        slice_len = offset;
+    if (bytestream2_get_bytes_left_p(pb) < offset) {
+        av_log(avctx, AV_LOG_ERROR, "Output packet too small.\n");
+        return AVERROR_BUG;
     }
 
+    /* Write the slices' data into the output packet */
+    p.slice_data = pb->buffer;
+    avctx->execute2(avctx, encode_slice, &p, NULL, c->slices);
+
     /* And at the end seek to the end of written slice(s) */
     bytestream2_seek_p(pb, offset, SEEK_CUR);
 
@@ -573,7 +621,7 @@ static int utvideo_encode_frame(AVCodecContext *avctx, AVPacket *pkt,
     case AV_PIX_FMT_RGBA:
         for (i = 0; i < c->planes; i++) {
             ret = encode_plane(avctx, c->slice_buffer[i] + 2 * c->slice_stride,
-                               c->slice_buffer[i], c->slice_stride,
+                               c->slice_bits, c->slice_stride,
                                width, height, &pb);
 
             if (ret) {
@@ -584,7 +632,7 @@ static int utvideo_encode_frame(AVCodecContext *avctx, AVPacket *pkt,
         break;
     case AV_PIX_FMT_YUV422P:
         for (i = 0; i < c->planes; i++) {
-            ret = encode_plane(avctx, pic->data[i], c->slice_buffer[0],
+            ret = encode_plane(avctx, pic->data[i], c->slice_bits,
                                pic->linesize[i], width >> !!i, height, &pb);
 
             if (ret) {
@@ -595,7 +643,7 @@ static int utvideo_encode_frame(AVCodecContext *avctx, AVPacket *pkt,
         break;
     case AV_PIX_FMT_YUV420P:
         for (i = 0; i < c->planes; i++) {
-            ret = encode_plane(avctx, pic->data[i], c->slice_buffer[0],
+            ret = encode_plane(avctx, pic->data[i], c->slice_bits,
                                pic->linesize[i], width >> !!i, height >> !!i,
                                &pb);
 
@@ -668,6 +716,7 @@ AVCodec ff_utvideo_encoder = {
     .init           = utvideo_encode_init,
     .encode2        = utvideo_encode_frame,
     .close          = utvideo_encode_close,
+    .capabilities   = AV_CODEC_CAP_SLICE_THREADS,
     .pix_fmts       = (const enum AVPixelFormat[]) {
                           AV_PIX_FMT_RGB24, AV_PIX_FMT_RGBA, AV_PIX_FMT_YUV422P,
                           AV_PIX_FMT_YUV420P, AV_PIX_FMT_NONE
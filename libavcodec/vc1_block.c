@@ -30,6 +30,7 @@
 #include "mpegutils.h"
 #include "mpegvideo.h"
 #include "msmpeg4data.h"
+#include "thread.h"
 #include "unary_legacy.h"
 #include "vc1.h"
 #include "vc1_pred.h"
@@ -2573,6 +2574,43 @@ static int vc1_decode_b_mb_intfr(VC1Context *v)
     return 0;
 }
 
+/** Report the MB rows of a reference frame which are final.
+ * The overlap smoothing and the loop filter run up to two rows behind the
+ * decoding loop, field pictures only report completion in ff_mpv_frame_end().
+ */
+static void vc1_report_progress(VC1Context *v, int mb_y)
+{
+    MpegEncContext *s = &v->s;
+
+    if (!v->field_mode && s->pict_type != AV_PICTURE_TYPE_B &&
+        !s->er.error_occurred)
+        ff_thread_report_progress(&s->current_picture_ptr->tf, mb_y, 0);
+}
+
+/** Wait for the rows of the reference frames the current MB row can be
+ * predicted from.
+ */
+static void vc1_await_references(VC1Context *v)
+{
+    MpegEncContext *s = &v->s;
+    int mb_y = INT_MAX;
+
+    if (!(s->avctx->active_thread_type & FF_THREAD_FRAME))
+        return;
+
+    /* range_y is in quarter pels, plus the bicubic filter taps below
+     * the block; interlaced MVs are in field lines, wait for everything */
+    if (v->fcm == PROGRESSIVE)
+        mb_y = FFMIN(s->mb_y + ((v->range_y >> 2) + 15 + 3 >> 4),
+                     s->mb_height - 1);
+
+    if (s->last_picture_ptr && s->last_picture_ptr->f->buf[0])
+        ff_thread_await_progress(&s->last_picture_ptr->tf, mb_y, 0);
+    if (s->pict_type == AV_PICTURE_TYPE_B &&
+        s->next_picture_ptr && s->next_picture_ptr->f->buf[0])
+        ff_thread_await_progress(&s->next_picture_ptr->tf, mb_y, 0);
+}
+
 /** Decode blocks of I-frame
  */
 static void vc1_decode_i_blocks(VC1Context *v)
@@ -2707,11 +2745,13 @@ static void vc1_decode_i_blocks(VC1Context *v)
             ff_mpeg_draw_horiz_band(s, s->mb_y * 16, 16);
         else if (s->mb_y)
             ff_mpeg_draw_horiz_band(s, (s->mb_y - 1) * 16, 16);
+        vc1_report_progress(v, s->mb_y - 2);
 
         s->first_slice_line = 0;
     }
     if (v->s.loop_filter)
         ff_mpeg_draw_horiz_band(s, (s->end_mb_y - 1) * 16, 16);
+    vc1_report_progress(v, s->end_mb_y - 1);
 
     /* This is intentionally mb_height and not end_mb_y - unlike in advanced
      * profile, these only differ are when decoding MSS2 rectangles. */
@@ -2836,6 +2876,7 @@ static void vc1_decode_i_blocks_adv(VC1Context *v)
             ff_mpeg_draw_horiz_band(s, s->mb_y * 16, 16);
         else if (s->mb_y)
             ff_mpeg_draw_horiz_band(s, (s->mb_y-1) * 16, 16);
+        vc1_report_progress(v, s->mb_y - 2);
         s->first_slice_line = 0;
     }
 
@@ -2851,6 +2892,7 @@ static void vc1_decode_i_blocks_adv(VC1Context *v)
     }
     if (v->s.loop_filter)
         ff_mpeg_draw_horiz_band(s, (s->end_mb_y-1)*16, 16);
+    vc1_report_progress(v, s->end_mb_y - 1);
     ff_er_add_slice(&s->er, 0, s->start_mb_y << v->field_mode, s->mb_width - 1,
                     (s->end_mb_y << v->field_mode) - 1, ER_MB_END);
 }
@@ -2892,6 +2934,7 @@ static void vc1_decode_p_blocks(VC1Context *v)
     for (s->mb_y = s->start_mb_y; s->mb_y < s->end_mb_y; s->mb_y++) {
         s->mb_x = 0;
         init_block_index(v);
+        vc1_await_references(v);
         for (; s->mb_x < s->mb_width; s->mb_x++) {
             ff_update_block_index(s);
 
@@ -2915,6 +2958,7 @@ static void vc1_decode_p_blocks(VC1Context *v)
         memmove(v->is_intra_base, v->is_intra, sizeof(v->is_intra_base[0]) * s->mb_stride);
         memmove(v->luma_mv_base,  v->luma_mv,  sizeof(v->luma_mv_base[0])  * s->mb_stride);
         if (s->mb_y != s->start_mb_y) ff_mpeg_draw_horiz_band(s, (s->mb_y - 1) * 16, 16);
+        vc1_report_progress(v, s->mb_y - 2);
         s->first_slice_line = 0;
     }
     if (apply_loop_filter) {
@@ -2927,6 +2971,7 @@ static void vc1_decode_p_blocks(VC1Context *v)
     }
     if (s->end_mb_y >= s->start_mb_y)
         ff_mpeg_draw_horiz_band(s, (s->end_mb_y - 1) * 16, 16);
+    vc1_report_progress(v, s->end_mb_y - 1);
     ff_er_add_slice(&s->er, 0, s->start_mb_y << v->field_mode, s->mb_width - 1,
                     (s->end_mb_y << v->field_mode) - 1, ER_MB_END);
 }
@@ -2964,6 +3009,7 @@ static void vc1_decode_b_blocks(VC1Context *v)
     for (s->mb_y = s->start_mb_y; s->mb_y < s->end_mb_y; s->mb_y++) {
         s->mb_x = 0;
         init_block_index(v);
+        vc1_await_references(v);
         for (; s->mb_x < s->mb_width; s->mb_x++) {
             ff_update_block_index(s);
 
@@ -3008,10 +3054,12 @@ static void vc1_decode_skip_blocks(VC1Context *v)
         s->mb_x = 0;
         init_block_index(v);
         ff_update_block_index(s);
+        vc1_await_references(v);
         memcpy(s->dest[0], s->last_picture.f->data[0] + s->mb_y * 16 * s->linesize,   s->linesize   * 16);
         memcpy(s->dest[1], s->last_picture.f->data[1] + s->mb_y *  8 * s->uvlinesize, s->uvlinesize *  8);
         memcpy(s->dest[2], s->last_picture.f->data[2] + s->mb_y *  8 * s->uvlinesize, s->uvlinesize *  8);
         ff_mpeg_draw_horiz_band(s, s->mb_y * 16, 16);
+        vc1_report_progress(v, s->mb_y);
         s->first_slice_line = 0;
     }
     s->pict_type = AV_PICTURE_TYPE_P;
@@ -36,6 +36,7 @@
 #include "msmpeg4.h"
 #include "msmpeg4data.h"
 #include "profiles.h"
+#include "thread.h"
 #include "vc1.h"
 #include "vc1data.h"
 
@@ -513,6 +514,7 @@ static av_cold int vc1_decode_init(AVCodecContext *avctx)
         avctx->level = v->level;
 
     avctx->has_b_frames = !!avctx->max_b_frames;
+    avctx->internal->allocate_progress = 1;
 
     if (v->color_prim == 1 || v->color_prim == 5 || v->color_prim == 6)
         avctx->color_primaries = v->color_prim;
@@ -583,6 +585,92 @@ av_cold int ff_vc1_decode_end(AVCodecContext *avctx)
 }
 
 
+#if HAVE_THREADS
+static av_cold int vc1_decode_init_thread_copy(AVCodecContext *avctx)
+{
+    VC1Context *v = avctx->priv_data;
+
+    v->s.avctx = avctx;
+
+    /* everything else is allocated along with the MpegEncContext */
+    v->sprite_output_frame = av_frame_alloc();
+    if (!v->sprite_output_frame)
+        return AVERROR(ENOMEM);
+
+    return 0;
+}
+
+static int vc1_update_thread_context(AVCodecContext *dst,
+                                     const AVCodecContext *src)
+{
+    VC1Context *v = dst->priv_data, *v1 = src->priv_data;
+    MpegEncContext *s = &v->s, *s1 = &v1->s;
+    int i, ret;
+
+    if (dst == src || !s1->context_initialized)
+        return 0;
+
+    /* same as the reinit on a coded size change in vc1_decode_frame() */
+    if (s->context_initialized &&
+        (s->width != s1->width || s->height != s1->height)) {
+        ff_vc1_decode_end(dst);
+        v->sprite_output_frame = av_frame_alloc();
+        if (!v->sprite_output_frame)
+            return AVERROR(ENOMEM);
+    }
+
+    if ((ret = ff_mpeg_update_thread_context(dst, src)) < 0)
+        return ret;
+    if (!v->mv_type_mb_plane &&
+        (ret = ff_vc1_decode_init_alloc_tables(v)) < 0)
+        return ret;
+
+    /* entry point */
+    v->broken_link      = v1->broken_link;
+    v->closed_entry     = v1->closed_entry;
+    v->panscanflag      = v1->panscanflag;
+    v->refdist_flag     = v1->refdist_flag;
+    s->loop_filter      = s1->loop_filter;
+    v->fastuvmc         = v1->fastuvmc;
+    v->extended_mv      = v1->extended_mv;
+    v->extended_dmv     = v1->extended_dmv;
+    v->dquant           = v1->dquant;
+    v->vstransform      = v1->vstransform;
+    v->overlap          = v1->overlap;
+    v->quantizer_mode   = v1->quantizer_mode;
+    v->range_mapy_flag  = v1->range_mapy_flag;
+    v->range_mapy       = v1->range_mapy;
+    v->range_mapuv_flag = v1->range_mapuv_flag;
+    v->range_mapuv      = v1->range_mapuv;
+
+    /* state carried over from the previous anchor picture */
+    v->refdist     = v1->refdist;
+    v->rnd         = v1->rnd;
+    v->qs_last     = v1->qs_last;
+    v->last_use_ic = v1->last_use_ic;
+    v->next_use_ic = v1->next_use_ic;
+    v->aux_use_ic  = v1->aux_use_ic;
+    memcpy(v->last_luty,  v1->last_luty,  sizeof(v->last_luty));
+    memcpy(v->last_lutuv, v1->last_lutuv, sizeof(v->last_lutuv));
+    memcpy(v->next_luty,  v1->next_luty,  sizeof(v->next_luty));
+    memcpy(v->next_lutuv, v1->next_lutuv, sizeof(v->next_lutuv));
+    memcpy(v->aux_luty,   v1->aux_luty,   sizeof(v->aux_luty));
+    memcpy(v->aux_lutuv,  v1->aux_lutuv,  sizeof(v->aux_lutuv));
+
+    if (v->interlace) {
+        int mb_height = FFALIGN(s->mb_height, 2);
+        int size      = s->b8_stride * (mb_height * 2 + 1) +
+                        s->mb_stride * (mb_height + 1) * 2;
+
+        for (i = 0; i < 2; i++)
+            memcpy(v->mv_f_next[i] - s->b8_stride - 1,
+                   v1->mv_f_next[i] - s1->b8_stride - 1, size);
+    }
+
+    return 0;
+}
+#endif
+
 /** Decode a VC1/WMV3 frame
  * @todo TODO: Handle VC-1 IDUs (Transport level?)
  */
@@ -812,6 +900,11 @@ static int vc1_decode_frame(AVCodecContext *avctx, void *data,
     s->me.qpel_put = s->qdsp.put_qpel_pixels_tab;
     s->me.qpel_avg = s->qdsp.avg_qpel_pixels_tab;
 
+    /* the second field header and the field MV planes are only known
+     * once the whole field pair is decoded */
+    if (avctx->hwaccel || !v->field_mode)
+        ff_thread_finish_setup(avctx);
+
     if (avctx->hwaccel) {
         if (avctx->hwaccel->start_frame(avctx, buf, buf_size) < 0)
             goto err;
@@ -903,6 +996,7 @@ static int vc1_decode_frame(AVCodecContext *avctx, void *data,
                 FFSWAP(uint8_t *, v->mv_f_next[0], v->mv_f[0]);
                 FFSWAP(uint8_t *, v->mv_f_next[1], v->mv_f[1]);
             }
+            ff_thread_finish_setup(avctx);
         }
         ff_dlog(s->avctx, "Consumed %i/%i bits\n",
                 get_bits_count(&s->gb), s->gb.size_in_bits);
@@ -949,6 +1043,9 @@ end:
     return buf_size;
 
 err:
+    /* do not leave other threads waiting on a half-decoded reference */
+    if (s->current_picture_ptr)
+        ff_thread_report_progress(&s->current_picture_ptr->tf, INT_MAX, 0);
     av_free(buf2);
     for (i = 0; i < n_slices; i++)
         av_free(slices[i].buf);
@@ -976,70 +1073,76 @@ static const enum AVPixelFormat vc1_hwaccel_pixfmt_list_420[] = {
 };
 
 AVCodec ff_vc1_decoder = {
-    .name           = "vc1",
-    .long_name      = NULL_IF_CONFIG_SMALL("SMPTE VC-1"),
-    .type           = AVMEDIA_TYPE_VIDEO,
-    .id             = AV_CODEC_ID_VC1,
-    .priv_data_size = sizeof(VC1Context),
-    .init           = vc1_decode_init,
-    .close          = ff_vc1_decode_end,
-    .decode         = vc1_decode_frame,
-    .flush          = ff_mpeg_flush,
-    .capabilities   = AV_CODEC_CAP_DR1 | AV_CODEC_CAP_DELAY,
-    .pix_fmts       = vc1_hwaccel_pixfmt_list_420,
-    .hw_configs     = (const AVCodecHWConfigInternal*[]) {
+    .name                  = "vc1",
+    .long_name             = NULL_IF_CONFIG_SMALL("SMPTE VC-1"),
+    .type                  = AVMEDIA_TYPE_VIDEO,
+    .id                    = AV_CODEC_ID_VC1,
+    .priv_data_size        = sizeof(VC1Context),
+    .init                  = vc1_decode_init,
+    .close                 = ff_vc1_decode_end,
+    .decode                = vc1_decode_frame,
+    .flush                 = ff_mpeg_flush,
+    .init_thread_copy      = ONLY_IF_THREADS_ENABLED(vc1_decode_init_thread_copy),
+    .update_thread_context = ONLY_IF_THREADS_ENABLED(vc1_update_thread_context),
+    .capabilities          = AV_CODEC_CAP_DR1 | AV_CODEC_CAP_DELAY |
+                             AV_CODEC_CAP_FRAME_THREADS,
+    .pix_fmts              = vc1_hwaccel_pixfmt_list_420,
+    .hw_configs            = (const AVCodecHWConfigInternal*[]) {
 #if CONFIG_VC1_DXVA2_HWACCEL
-                        HWACCEL_DXVA2(vc1),
+                               HWACCEL_DXVA2(vc1),
 #endif
 #if CONFIG_VC1_D3D11VA_HWACCEL
-                        HWACCEL_D3D11VA(vc1),
+                               HWACCEL_D3D11VA(vc1),
 #endif
 #if CONFIG_VC1_D3D11VA2_HWACCEL
-                        HWACCEL_D3D11VA2(vc1),
+                               HWACCEL_D3D11VA2(vc1),
 #endif
 #if CONFIG_VC1_VAAPI_HWACCEL
-                        HWACCEL_VAAPI(vc1),
+                               HWACCEL_VAAPI(vc1),
 #endif
 #if CONFIG_VC1_VDPAU_HWACCEL
-                        HWACCEL_VDPAU(vc1),
+                               HWACCEL_VDPAU(vc1),
 #endif
-                        NULL
-                    },
-    .profiles       = NULL_IF_CONFIG_SMALL(ff_vc1_profiles)
+                               NULL
+                           },
+    .profiles              = NULL_IF_CONFIG_SMALL(ff_vc1_profiles)
 };
 
 #if CONFIG_WMV3_DECODER
 AVCodec ff_wmv3_decoder = {
-    .name           = "wmv3",
-    .long_name      = NULL_IF_CONFIG_SMALL("Windows Media Video 9"),
-    .type           = AVMEDIA_TYPE_VIDEO,
-    .id             = AV_CODEC_ID_WMV3,
-    .priv_data_size = sizeof(VC1Context),
-    .init           = vc1_decode_init,
-    .close          = ff_vc1_decode_end,
-    .decode         = vc1_decode_frame,
-    .flush          = ff_mpeg_flush,
-    .capabilities   = AV_CODEC_CAP_DR1 | AV_CODEC_CAP_DELAY,
-    .pix_fmts       = vc1_hwaccel_pixfmt_list_420,
-    .hw_configs     = (const AVCodecHWConfigInternal*[]) {
+    .name                  = "wmv3",
+    .long_name             = NULL_IF_CONFIG_SMALL("Windows Media Video 9"),
+    .type                  = AVMEDIA_TYPE_VIDEO,
+    .id                    = AV_CODEC_ID_WMV3,
+    .priv_data_size        = sizeof(VC1Context),
+    .init                  = vc1_decode_init,
+    .close                 = ff_vc1_decode_end,
+    .decode                = vc1_decode_frame,
+    .flush                 = ff_mpeg_flush,
+    .init_thread_copy      = ONLY_IF_THREADS_ENABLED(vc1_decode_init_thread_copy),
+    .update_thread_context = ONLY_IF_THREADS_ENABLED(vc1_update_thread_context),
+    .capabilities          = AV_CODEC_CAP_DR1 | AV_CODEC_CAP_DELAY |
+                             AV_CODEC_CAP_FRAME_THREADS,
+    .pix_fmts              = vc1_hwaccel_pixfmt_list_420,
+    .hw_configs            = (const AVCodecHWConfigInternal*[]) {
 #if CONFIG_WMV3_DXVA2_HWACCEL
-                        HWACCEL_DXVA2(wmv3),
+                               HWACCEL_DXVA2(wmv3),
 #endif
 #if CONFIG_WMV3_D3D11VA_HWACCEL
-                        HWACCEL_D3D11VA(wmv3),
+                               HWACCEL_D3D11VA(wmv3),
 #endif
 #if CONFIG_WMV3_D3D11VA2_HWACCEL
-                        HWACCEL_D3D11VA2(wmv3),
+                               HWACCEL_D3D11VA2(wmv3),
 #endif
 #if CONFIG_WMV3_VAAPI_HWACCEL
-                        HWACCEL_VAAPI(wmv3),
+                               HWACCEL_VAAPI(wmv3),
 #endif
 #if CONFIG_WMV3_VDPAU_HWACCEL
-                        HWACCEL_VDPAU(wmv3),
+                               HWACCEL_VDPAU(wmv3),
 #endif
-                        NULL
-                    },
-    .profiles       = NULL_IF_CONFIG_SMALL(ff_vc1_profiles)
+                               NULL
+                           },
+    .profiles              = NULL_IF_CONFIG_SMALL(ff_vc1_profiles)
 };
 #endif
 
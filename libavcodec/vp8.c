@@ -2861,6 +2861,7 @@ AVCodec ff_vp8_decoder = {
                                NULL
                            },
     .flush                 = vp8_decode_flush,
+    .caps_internal         = FF_CODEC_CAP_SLICE_THREAD_SYNC,
     .init_thread_copy      = ONLY_IF_THREADS_ENABLED(vp8_decode_init_thread_copy),
     .update_thread_context = ONLY_IF_THREADS_ENABLED(vp8_decode_update_thread_context),
 };
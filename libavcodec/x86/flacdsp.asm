@@ -0,0 +1,298 @@
+;******************************************************************************
+;* x86 optimized FLAC DSP functions
+;*
+;* This file is part of Libav.
+;*
+;* Libav is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* Libav is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with Libav; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;******************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION .text
+
+;-------------------------------------------------------------------------------
+; LPC reconstruction
+;
+; void ff_flac_lpc_<16|32>(int32_t *decoded, const int32_t *coeffs,
+;                          int order, int qlevel, int len)
+;
+; coeffs must be aligned and zero-padded up to a multiple of mmsize / 4
+; entries, the padding is multiplied with the samples following the one being
+; reconstructed. Each output sample is the dot product of the coefficients
+; with the order previous samples, so this is vectorized over the order.
+;-------------------------------------------------------------------------------
+
+; The 16-bit version accumulates in 32 bits, just like the C code.
+%macro LPC_16 0
+cglobal flac_lpc_16, 5, 6, 3, decoded, coeffs, order, qlevel, len, j
+    movd           xm2, qleveld
+    sub           lend, orderd
+    jle .end
+    movsxdifnidn orderq, orderd
+.loop_sample:
+    pxor            m0, m0
+    xor             jd, jd
+.loop_order:
+    movu            m1, [decodedq+jq*4]
+    pmulld          m1, [coeffsq+jq*4]
+    paddd           m0, m1
+    add             jd, mmsize / 4
+    cmp             jd, orderd
+    jl .loop_order
+%if mmsize == 32
+    vextracti128   xm1, m0, 1
+    paddd          xm0, xm1
+%endif
+    pshufd         xm1, xm0, q1032
+    paddd          xm0, xm1
+    pshufd         xm1, xm0, q0001
+    paddd          xm0, xm1
+    psrad          xm0, xm2
+    movd           xm1, [decodedq+orderq*4]
+    paddd          xm0, xm1
+    movd [decodedq+orderq*4], xm0
+    add       decodedq, 4
+    dec           lend
+    jg .loop_sample
+.end:
+    RET
+%endmacro
+
+; The 32-bit version accumulates in 64 bits. pmuldq only multiplies the even
+; dwords, the odd ones are shifted down and multiplied separately. The sum is
+; shifted logically, only its low 32 bits are used.
+%macro LPC_32 0
+cglobal flac_lpc_32, 5, 6, 6, decoded, coeffs, order, qlevel, len, j
+    movd           xm5, qleveld
+    sub           lend, orderd
+    jle .end
+    movsxdifnidn orderq, orderd
+.loop_sample:
+    pxor            m0, m0
+    xor             jd, jd
+.loop_order:
+    movu            m1, [decodedq+jq*4]
+    mova            m2, [coeffsq+jq*4]
+    pshufd          m3, m1, q3311
+    pshufd          m4, m2, q3311
+    pmuldq          m1, m2
+    pmuldq          m3, m4
+    paddq           m0, m1
+    paddq           m0, m3
+    add             jd, mmsize / 4
+    cmp             jd, orderd
+    jl .loop_order
+%if mmsize == 32
+    vextracti128   xm1, m0, 1
+    paddq          xm0, xm1
+%endif
+    punpckhqdq     xm1, xm0, xm0
+    paddq          xm0, xm1
+    psrlq          xm0, xm5
+    movd           xm1, [decodedq+orderq*4]
+    paddd          xm0, xm1
+    movd [decodedq+orderq*4], xm0
+    add       decodedq, 4
+    dec           lend
+    jg .loop_sample
+.end:
+    RET
+%endmacro
+
+INIT_XMM sse4
+LPC_16
+LPC_32
+
+%if HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+LPC_16
+LPC_32
+%endif
+
+;-------------------------------------------------------------------------------
+; Decorrelation
+;
+; void ff_flac_decorrelate_<mode>_<fmt>(uint8_t **out, int32_t **in,
+;                                       int channels, int len, int shift)
+;
+; The input and output are processed in blocks of mmsize / 4 samples, the
+; buffers are padded to a multiple of 32 samples by av_samples_get_buffer_size()
+; so len does not need to be a multiple of the block size.
+;-------------------------------------------------------------------------------
+
+; Stereo modes: take the two input channels in m0, m1 and leave the two output
+; channels (before the shift) in m0, m1.
+%macro DECORR_indep2 0
+%endmacro
+
+%macro DECORR_ls 0
+    psubd           m2, m0, m1
+    SWAP             1, 2
+%endmacro
+
+%macro DECORR_rs 0
+    paddd           m0, m1
+%endmacro
+
+%macro DECORR_ms 0
+    psrad           m2, m1, 1
+    psubd           m0, m2
+    paddd           m1, m0
+    SWAP             0, 1
+%endmacro
+
+; Store the two shifted output channels in m0, m1 at sample offset lenq.
+%macro STORE_16 0
+    punpckldq       m2, m0, m1
+    punpckhdq       m0, m1
+    packssdw        m2, m0
+    movu [out0q+lenq*4], m2
+%endmacro
+
+%macro STORE_32 0
+    punpckldq       m2, m0, m1
+    punpckhdq       m0, m1
+%if mmsize == 32
+    vperm2i128      m1, m2, m0, 0x20
+    vperm2i128      m2, m2, m0, 0x31
+    movu [out0q+lenq*8],      m1
+    movu [out0q+lenq*8+32],   m2
+%else
+    movu [out0q+lenq*8],      m2
+    movu [out0q+lenq*8+16],   m0
+%endif
+%endmacro
+
+%macro STORE_16p 0
+    packssdw        m0, m1
+%if mmsize == 32
+    vpermq          m0, m0, q3120
+    movu [out0q+lenq*2], xm0
+    vextracti128 [out1q+lenq*2], m0, 1
+%else
+    movq   [out0q+lenq*2], m0
+    movhps [out1q+lenq*2], m0
+%endif
+%endmacro
+
+%macro STORE_32p 0
+    movu [out0q+lenq*4], m0
+    movu [out1q+lenq*4], m1
+%endmacro
+
+; %1 = mode, %2 = output format, %3 = output bytes per sample and plane
+%macro DECORRELATE_STEREO 3
+cglobal flac_decorrelate_%1_%2, 2, 5, 4, out0, in0, in1, len, out1
+    movd           xm3, r4m
+%if ARCH_X86_32
+    mov           lend, lenm
+%endif
+    movsxdifnidn lenq, lend
+    mov           in1q, [in0q+gprsize]
+    mov           in0q, [in0q]
+%ifidn %2, 16p
+    mov          out1q, [out0q+gprsize]
+%elifidn %2, 32p
+    mov          out1q, [out0q+gprsize]
+%endif
+    mov          out0q, [out0q]
+    lea           in0q, [in0q+lenq*4]
+    lea           in1q, [in1q+lenq*4]
+    lea          out0q, [out0q+lenq*%3]
+%ifidn %2, 16p
+    lea          out1q, [out1q+lenq*%3]
+%elifidn %2, 32p
+    lea          out1q, [out1q+lenq*%3]
+%endif
+    neg           lenq
+.loop:
+    movu            m0, [in0q+lenq*4]
+    movu            m1, [in1q+lenq*4]
+    DECORR_%1
+    pslld           m0, xm3
+    pslld           m1, xm3
+    STORE_%2
+    add           lenq, mmsize / 4
+    jl .loop
+    RET
+%endmacro
+
+; Independent channels with planar output, also used for mono interleaved
+; output. Loops over all the channels.
+; %1 = output format, %2 = output bytes per sample
+%macro DECORRELATE_INDEP 2
+cglobal flac_decorrelate_indep_%1, 2, 7, 2, out, in, channels, len, i, dst, src
+    movd           xm1, r4m
+%if ARCH_X86_32
+    mov      channelsd, channelsm
+    mov           lend, lenm
+%endif
+    movsxdifnidn lenq, lend
+.loop_channel:
+    mov           srcq, [inq]
+    mov           dstq, [outq]
+    lea           srcq, [srcq+lenq*4]
+    lea           dstq, [dstq+lenq*%2]
+    mov             iq, lenq
+    neg             iq
+.loop:
+    movu            m0, [srcq+iq*4]
+    pslld           m0, xm1
+%if %2 == 2
+    packssdw        m0, m0
+%if mmsize == 32
+    vpermq          m0, m0, q3120
+    movu  [dstq+iq*2], xm0
+%else
+    movq  [dstq+iq*2], m0
+%endif
+%else
+    movu  [dstq+iq*4], m0
+%endif
+    add             iq, mmsize / 4
+    jl .loop
+    add            inq, gprsize
+    add           outq, gprsize
+    dec      channelsd
+    jg .loop_channel
+    RET
+%endmacro
+
+%macro DECORRELATE_FUNCS 0
+DECORRELATE_STEREO indep2, 16, 4
+DECORRELATE_STEREO ls,     16, 4
+DECORRELATE_STEREO rs,     16, 4
+DECORRELATE_STEREO ms,     16, 4
+DECORRELATE_STEREO indep2, 32, 8
+DECORRELATE_STEREO ls,     32, 8
+DECORRELATE_STEREO rs,     32, 8
+DECORRELATE_STEREO ms,     32, 8
+DECORRELATE_STEREO ls,    16p, 2
+DECORRELATE_STEREO rs,    16p, 2
+DECORRELATE_STEREO ms,    16p, 2
+DECORRELATE_STEREO ls,    32p, 4
+DECORRELATE_STEREO rs,    32p, 4
+DECORRELATE_STEREO ms,    32p, 4
+DECORRELATE_INDEP 16p, 2
+DECORRELATE_INDEP 32p, 4
+%endmacro
+
+INIT_XMM sse2
+DECORRELATE_FUNCS
+
+%if HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+DECORRELATE_FUNCS
+%endif
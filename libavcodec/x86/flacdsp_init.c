@@ -0,0 +1,130 @@
+/*
+ * This file is part of Libav.
+ *
+ * Libav is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * Libav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with Libav; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "config.h"
+#include "libavutil/attributes.h"
+#include "libavutil/cpu.h"
+#include "libavutil/internal.h"
+#include "libavutil/samplefmt.h"
+#include "libavutil/x86/cpu.h"
+#include "libavcodec/flacdsp.h"
+
+/* The asm needs the coefficients aligned and zero-padded to the vector
+ * length, the decoder only sets the first order ones. */
+#define LPC_FUNC(bits, opt)                                                   \
+void ff_flac_lpc_ ## bits ## _ ## opt(int32_t *decoded, const int32_t *coeffs, \
+                                      int order, int qlevel, int len);        \
+                                                                              \
+static void flac_lpc_ ## bits ## _ ## opt(int32_t *decoded,                   \
+                                          const int coeffs[32], int order,    \
+                                          int qlevel, int len)                \
+{                                                                             \
+    LOCAL_ALIGNED_32(int32_t, c, [32]);                                       \
+                                                                              \
+    memcpy(c, coeffs, order * sizeof(*c));                                    \
+    memset(c + order, 0, (32 - order) * sizeof(*c));                          \
+    ff_flac_lpc_ ## bits ## _ ## opt(decoded, c, order, qlevel, len);         \
+}
+
+#define DECORRELATE_FUNC(mode, fmt, opt)                                      \
+void ff_flac_decorrelate_ ## mode ## _ ## fmt ## _ ## opt(uint8_t **out,      \
+                                                          int32_t **in,       \
+                                                          int channels,       \
+                                                          int len, int shift);
+
+#define DECORRELATE_FUNCS(opt)                                                \
+    DECORRELATE_FUNC(indep2, 16,  opt)                                        \
+    DECORRELATE_FUNC(ls,     16,  opt)                                        \
+    DECORRELATE_FUNC(rs,     16,  opt)                                        \
+    DECORRELATE_FUNC(ms,     16,  opt)                                        \
+    DECORRELATE_FUNC(indep2, 32,  opt)                                        \
+    DECORRELATE_FUNC(ls,     32,  opt)                                        \
+    DECORRELATE_FUNC(rs,     32,  opt)                                        \
+    DECORRELATE_FUNC(ms,     32,  opt)                                        \
+    DECORRELATE_FUNC(indep,  16p, opt)                                        \
+    DECORRELATE_FUNC(ls,     16p, opt)                                        \
+    DECORRELATE_FUNC(rs,     16p, opt)                                        \
+    DECORRELATE_FUNC(ms,     16p, opt)                                        \
+    DECORRELATE_FUNC(indep,  32p, opt)                                        \
+    DECORRELATE_FUNC(ls,     32p, opt)                                        \
+    DECORRELATE_FUNC(rs,     32p, opt)                                        \
+    DECORRELATE_FUNC(ms,     32p, opt)
+
+LPC_FUNC(16, sse4)
+LPC_FUNC(32, sse4)
+LPC_FUNC(16, avx2)
+LPC_FUNC(32, avx2)
+
+DECORRELATE_FUNCS(sse2)
+DECORRELATE_FUNCS(avx2)
+
+/* Mono interleaved output is the same as planar, other channel counts are
+ * only handled by the stereo modes. */
+#define SET_DECORRELATE(opt)                                                  \
+    switch (fmt) {                                                            \
+    case AV_SAMPLE_FMT_S16:                                                   \
+        if (channels == 1)                                                    \
+            c->decorrelate[0] = ff_flac_decorrelate_indep_16p_  ## opt;       \
+        else if (channels == 2)                                               \
+            c->decorrelate[0] = ff_flac_decorrelate_indep2_16_  ## opt;       \
+        c->decorrelate[1]     = ff_flac_decorrelate_ls_16_      ## opt;       \
+        c->decorrelate[2]     = ff_flac_decorrelate_rs_16_      ## opt;       \
+        c->decorrelate[3]     = ff_flac_decorrelate_ms_16_      ## opt;       \
+        break;                                                                \
+    case AV_SAMPLE_FMT_S32:                                                   \
+        if (channels == 1)                                                    \
+            c->decorrelate[0] = ff_flac_decorrelate_indep_32p_  ## opt;       \
+        else if (channels == 2)                                               \
+            c->decorrelate[0] = ff_flac_decorrelate_indep2_32_  ## opt;       \
+        c->decorrelate[1]     = ff_flac_decorrelate_ls_32_      ## opt;       \
+        c->decorrelate[2]     = ff_flac_decorrelate_rs_32_      ## opt;       \
+        c->decorrelate[3]     = ff_flac_decorrelate_ms_32_      ## opt;       \
+        break;                                                                \
+    case AV_SAMPLE_FMT_S16P:                                                  \
+        c->decorrelate[0]     = ff_flac_decorrelate_indep_16p_  ## opt;       \
+        c->decorrelate[1]     = ff_flac_decorrelate_ls_16p_     ## opt;       \
+        c->decorrelate[2]     = ff_flac_decorrelate_rs_16p_     ## opt;       \
+        c->decorrelate[3]     = ff_flac_decorrelate_ms_16p_     ## opt;       \
+        break;                                                                \
+    case AV_SAMPLE_FMT_S32P:                                                  \
+        c->decorrelate[0]     = ff_flac_decorrelate_indep_32p_  ## opt;       \
+        c->decorrelate[1]     = ff_flac_decorrelate_ls_32p_     ## opt;       \
+        c->decorrelate[2]     = ff_flac_decorrelate_rs_32p_     ## opt;       \
+        c->decorrelate[3]     = ff_flac_decorrelate_ms_32p_     ## opt;       \
+        break;                                                                \
+    }
+
+av_cold void ff_flacdsp_init_x86(FLACDSPContext *c, enum AVSampleFormat fmt,
+                                 int channels, int bps)
+{
+    int cpu_flags = av_get_cpu_flags();
+
+    if (EXTERNAL_SSE2(cpu_flags)) {
+        SET_DECORRELATE(sse2)
+    }
+    if (EXTERNAL_SSE4(cpu_flags)) {
+        c->lpc = bps > 16 ? flac_lpc_32_sse4 : flac_lpc_16_sse4;
+    }
+    if (EXTERNAL_AVX2(cpu_flags)) {
+        SET_DECORRELATE(avx2)
+        c->lpc = bps > 16 ? flac_lpc_32_avx2 : flac_lpc_16_avx2;
+    }
+}
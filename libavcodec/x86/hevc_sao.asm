@@ -0,0 +1,298 @@
+;*****************************************************************************
+;* SIMD-optimized HEVC sample adaptive offset code
+;*****************************************************************************
+;* This file is part of Libav.
+;*
+;* Libav is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* Libav is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with Libav; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;******************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION_RODATA 32
+
+pw_pixel_max: times 16 dw ((1 << 10)-1)
+pw_0202:      times 16 dw 0x0202
+pw_0504:      times 16 dw 0x0504
+pb_80:        times 32 db 0x80
+pb_1f:        times 32 db 0x1f
+pb_2:         times 32 db 2
+
+; SaoOffsetVal index for edgeIdx 0..4, as byte and as word shuffles
+edge_shuf_8:  db 1, 2, 0, 3, 4, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+edge_shuf_10: db 2, 3, 4, 5, 0, 1, 6, 7, 8, 9, 0, 0, 0, 0, 0, 0
+
+; horizontal distance to the first neighbour for each eo_class, all classes
+; but SAO_EO_HORIZ take it from the row above
+eo_dx:        db -1, 0, -1, 1
+
+SECTION .text
+
+; Both filters work on whole vectors and may read up to mmsize - 1 bytes past
+; the end of each row of src, but never write past width.
+
+; %1 = splat width (b or w), %2 = dst register number, %3 = src gpr
+%macro SPLAT_GPR 3
+    movd           xm%2, %3d
+%if cpuflag(avx2)
+    vpbroadcast%1   m%2, xm%2
+%else
+%ifidn %1, b
+    punpcklbw       m%2, m%2
+%endif
+    pshuflw         m%2, m%2, 0
+    punpcklqdq      m%2, m%2
+%endif
+%endmacro
+
+; store the low %3 (< mmsize) bytes of m%4 to [%1 + %2]
+; %1 = dst, %2 = offset (updated), %3 = byte count, %4 = register number,
+; %5 = gpr scratch, %6 = bytes per pixel
+%macro STORE_PARTIAL 6
+%if mmsize == 32
+    test            %3d, 16
+    jz .store8
+    movu       [%1 + %2], xm%4
+    vextracti128   xm%4, m%4, 1
+    add              %2, 16
+.store8:
+%endif
+    test            %3d, 8
+    jz .store4
+    movq       [%1 + %2], xm%4
+    psrldq         xm%4, 8
+    add              %2, 8
+.store4:
+    test            %3d, 4
+    jz .store2
+    movd       [%1 + %2], xm%4
+    psrldq         xm%4, 4
+    add              %2, 4
+.store2:
+    movd            %5d, xm%4
+    test            %3d, 2
+    jz .store1
+    mov        [%1 + %2], %5w
+    shr             %5d, 16
+    add              %2, 2
+.store1:
+%if %6 == 1
+    test            %3d, 1
+    jz .next_row
+    mov        [%1 + %2], %5b
+%endif
+%endmacro
+
+; row/column loop shared by the filters; %1 computes m1 from the pixels at
+; [srcq + xq], %2 = bytes per pixel, %3 = gpr scratch, %4 = advance the
+; neighbour pointers aq and bq
+%macro SAO_LOOP 4
+%if %2 == 2
+    shl          widthd, 1
+%endif
+    movsxdifnidn widthq, widthd
+.loop_y:
+    xor              xq, xq
+.loop_x:
+    %1
+    mov            tmpq, widthq
+    sub            tmpq, xq
+    cmp            tmpq, mmsize
+    jl .tail
+    movu    [dstq + xq], m1
+    add              xq, mmsize
+    cmp              xq, widthq
+    jl .loop_x
+.next_row:
+    add            dstq, strideq
+    add            srcq, strideq
+%if %4
+    add              aq, strideq
+    add              bq, strideq
+%endif
+    dec         heightd
+    jg .loop_y
+    RET
+
+.tail:
+    STORE_PARTIAL   dstq, xq, tmp, 1, %3, %2
+    jmp .next_row
+%endmacro
+
+;-----------------------------------------------------------------------------
+; void ff_hevc_sao_band_filter_<depth>(uint8_t *dst, uint8_t *src,
+;                                      ptrdiff_t stride, const int *offset_val,
+;                                      int band_position, int width, int height)
+;-----------------------------------------------------------------------------
+%macro BAND_FILTER_8 0
+    movu             m1, [srcq + xq]
+    psrlw            m2, m1, 3
+    pand             m2, m9
+    pcmpeqb          m3, m2, m4
+    pand             m3, m10
+    pcmpeqb          m0, m2, m5
+    pand             m0, m11
+    por              m3, m0
+    pcmpeqb          m0, m2, m6
+    pand             m0, m12
+    por              m3, m0
+    pcmpeqb          m2, m7
+    pand             m2, m13
+    por              m3, m2
+    pxor             m1, m8
+    paddsb           m1, m3
+    pxor             m1, m8
+%endmacro
+
+%macro BAND_FILTER_10 0
+    movu             m1, [srcq + xq]
+    psrlw            m2, m1, 5
+    pcmpeqw          m3, m2, m4
+    pand             m3, m10
+    pcmpeqw          m0, m2, m5
+    pand             m0, m11
+    por              m3, m0
+    pcmpeqw          m0, m2, m6
+    pand             m0, m12
+    por              m3, m0
+    pcmpeqw          m2, m7
+    pand             m2, m13
+    por              m3, m2
+    paddw            m1, m3
+    CLIPW            m1, m9, m8
+%endmacro
+
+; splat the k-th band index (band_position + k) & 31 and its offset
+; %1 = splat width, %2 = k, %3 = band register, %4 = offset register
+%macro BAND_SETUP 4
+    lea            tmpd, [leftq + %2]
+    and            tmpd, 31
+    SPLAT_GPR        %1, %3, tmp
+    mov            tmpd, [offsetq + 4 * (%2 + 1)]
+    SPLAT_GPR        %1, %4, tmp
+%endmacro
+
+%macro SAO_BAND_FILTER 2 ; depth, splat width
+cglobal hevc_sao_band_filter_%1, 7, 9, 14, dst, src, stride, offset, left, width, height, x, tmp
+    BAND_SETUP       %2, 0, 4, 10
+    BAND_SETUP       %2, 1, 5, 11
+    BAND_SETUP       %2, 2, 6, 12
+    BAND_SETUP       %2, 3, 7, 13
+%if %1 == 8
+    mova             m8, [pb_80]
+    mova             m9, [pb_1f]
+%else
+    mova             m8, [pw_pixel_max]
+    pxor             m9, m9
+%endif
+    SAO_LOOP BAND_FILTER_%1, (%1 + 7) / 8, left, 0
+%endmacro
+
+;-----------------------------------------------------------------------------
+; void ff_hevc_sao_edge_filter_<depth>(uint8_t *dst, uint8_t *src,
+;                                      ptrdiff_t stride, const int *offset_val,
+;                                      int eo_class, int width, int height)
+;-----------------------------------------------------------------------------
+%macro EDGE_FILTER_8 0
+    movu             m1, [srcq + xq]
+    movu             m2, [aq + xq]
+    movu             m3, [bq + xq]
+    psubusb          m4, m1, m2
+    psubusb          m2, m1
+    pcmpeqb          m4, m7
+    pcmpeqb          m2, m7
+    psubb            m4, m2
+    psubusb          m5, m1, m3
+    psubusb          m3, m1
+    pcmpeqb          m5, m7
+    pcmpeqb          m3, m7
+    psubb            m5, m3
+    paddb            m4, m5
+    paddb            m4, [pb_2]
+    pshufb           m5, m0, m4
+    pxor             m1, m6
+    paddsb           m1, m5
+    pxor             m1, m6
+%endmacro
+
+%macro EDGE_FILTER_10 0
+    movu             m1, [srcq + xq]
+    movu             m2, [aq + xq]
+    movu             m3, [bq + xq]
+    pcmpgtw          m4, m1, m2
+    pcmpgtw          m2, m1
+    psubw            m2, m4
+    pcmpgtw          m4, m1, m3
+    pcmpgtw          m3, m1
+    psubw            m3, m4
+    paddw            m2, m3
+    pmullw           m2, [pw_0202]
+    paddw            m2, [pw_0504]
+    pshufb           m4, m0, m2
+    paddw            m1, m4
+    CLIPW            m1, m7, m6
+%endmacro
+
+%macro SAO_EDGE_FILTER 1 ; depth
+cglobal hevc_sao_edge_filter_%1, 7, 11, 8, dst, src, stride, offset, eo, width, height, a, b, x, tmp
+    movsxdifnidn    eoq, eod
+    lea            tmpq, [eo_dx]
+    movsx            aq, byte [tmpq + eoq]
+%if %1 > 8
+    add              aq, aq
+%endif
+    test            eod, eod
+    jz .horiz
+    sub              aq, strideq
+.horiz:
+    mov              bq, srcq
+    sub              bq, aq
+    add              aq, srcq
+
+    movu            xm0, [offsetq]
+    movd            xm1, [offsetq + 16]
+    packssdw        xm0, xm1
+%if %1 == 8
+    packsswb        xm0, xm0
+%endif
+    pshufb          xm0, [edge_shuf_%1]
+%if mmsize == 32
+    vinserti128      m0, m0, xm0, 1
+%endif
+    pxor             m7, m7
+%if %1 == 8
+    mova             m6, [pb_80]
+%else
+    mova             m6, [pw_pixel_max]
+%endif
+    SAO_LOOP EDGE_FILTER_%1, (%1 + 7) / 8, eo, 1
+%endmacro
+
+%if ARCH_X86_64
+INIT_XMM sse2
+SAO_BAND_FILTER  8, b
+SAO_BAND_FILTER 10, w
+
+INIT_XMM ssse3
+SAO_EDGE_FILTER  8
+SAO_EDGE_FILTER 10
+
+%if HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+SAO_BAND_FILTER  8, b
+SAO_BAND_FILTER 10, w
+SAO_EDGE_FILTER  8
+SAO_EDGE_FILTER 10
+%endif
+%endif
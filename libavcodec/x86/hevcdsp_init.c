@@ -37,14 +37,40 @@ void ff_hevc_ ## DIR ## _loop_filter_luma_ ## DEPTH ## _ ## OPT(uint8_t *pix, pt
     LFC_FUNC(v, depth, sse2)
 
 #define LFL_FUNCS(type, depth) \
+    LFL_FUNC(h, depth, sse2)   \
+    LFL_FUNC(v, depth, sse2)   \
     LFL_FUNC(h, depth, ssse3)  \
-    LFL_FUNC(v, depth, ssse3)
+    LFL_FUNC(v, depth, ssse3)  \
+    LFL_FUNC(h, depth, avx)    \
+    LFL_FUNC(v, depth, avx)
 
 LFC_FUNCS(uint8_t, 8)
 LFC_FUNCS(uint8_t, 10)
 LFL_FUNCS(uint8_t, 8)
 LFL_FUNCS(uint8_t, 10)
 
+#define SAO_BAND_FUNC(depth, opt)                                                   \
+void ff_hevc_sao_band_filter_ ## depth ## _ ## opt(uint8_t *dst, uint8_t *src,      \
+                                                   ptrdiff_t stride,                \
+                                                   const int *offset_val,           \
+                                                   int band_position,               \
+                                                   int width, int height);
+#define SAO_EDGE_FUNC(depth, opt)                                                   \
+void ff_hevc_sao_edge_filter_ ## depth ## _ ## opt(uint8_t *dst, uint8_t *src,      \
+                                                   ptrdiff_t stride,                \
+                                                   const int *offset_val,           \
+                                                   int eo_class,                    \
+                                                   int width, int height);
+
+SAO_BAND_FUNC(8,  sse2)
+SAO_BAND_FUNC(10, sse2)
+SAO_BAND_FUNC(8,  avx2)
+SAO_BAND_FUNC(10, avx2)
+SAO_EDGE_FUNC(8,  ssse3)
+SAO_EDGE_FUNC(10, ssse3)
+SAO_EDGE_FUNC(8,  avx2)
+SAO_EDGE_FUNC(10, avx2)
+
 #define idct_dc_proto(size, bitd, opt) \
                 void ff_hevc_idct_ ## size ## _dc_add_ ## bitd ## _ ## opt(uint8_t *dst, int16_t *coeffs, ptrdiff_t stride)
 
@@ -384,10 +410,17 @@ void ff_hevc_dsp_init_x86(HEVCDSPContext *c, const int bit_depth)
         if (EXTERNAL_SSE2(cpu_flags)) {
             c->idct[2] = ff_hevc_idct_16x16_8_sse2;
             c->idct[3] = ff_hevc_idct_32x32_8_sse2;
+
+            c->hevc_v_loop_filter_luma = ff_hevc_v_loop_filter_luma_8_sse2;
+            c->hevc_h_loop_filter_luma = ff_hevc_h_loop_filter_luma_8_sse2;
+
+            c->sao_band_filter = ff_hevc_sao_band_filter_8_sse2;
         }
         if (EXTERNAL_SSSE3(cpu_flags)) {
             c->hevc_v_loop_filter_luma = ff_hevc_v_loop_filter_luma_8_ssse3;
             c->hevc_h_loop_filter_luma = ff_hevc_h_loop_filter_luma_8_ssse3;
+
+            c->sao_edge_filter = ff_hevc_sao_edge_filter_8_ssse3;
         }
 
         if (EXTERNAL_SSE4(cpu_flags)) {
@@ -404,19 +437,32 @@ void ff_hevc_dsp_init_x86(HEVCDSPContext *c, const int bit_depth)
 #endif /* HAVE_AVX_EXTERNAL */
             c->idct[2] = ff_hevc_idct_16x16_8_avx;
             c->idct[3] = ff_hevc_idct_32x32_8_avx;
+
+            c->hevc_v_loop_filter_luma = ff_hevc_v_loop_filter_luma_8_avx;
+            c->hevc_h_loop_filter_luma = ff_hevc_h_loop_filter_luma_8_avx;
         }
         if (EXTERNAL_AVX2(cpu_flags)) {
             c->idct_dc[2] = ff_hevc_idct_16x16_dc_8_avx2;
             c->idct_dc[3] = ff_hevc_idct_32x32_dc_8_avx2;
+
+            c->sao_band_filter = ff_hevc_sao_band_filter_8_avx2;
+            c->sao_edge_filter = ff_hevc_sao_edge_filter_8_avx2;
         }
     } else if (bit_depth == 10) {
         if (EXTERNAL_SSE2(cpu_flags)) {
             c->idct[2] = ff_hevc_idct_16x16_10_sse2;
             c->idct[3] = ff_hevc_idct_32x32_10_sse2;
+
+            c->hevc_v_loop_filter_luma = ff_hevc_v_loop_filter_luma_10_sse2;
+            c->hevc_h_loop_filter_luma = ff_hevc_h_loop_filter_luma_10_sse2;
+
+            c->sao_band_filter = ff_hevc_sao_band_filter_10_sse2;
         }
         if (EXTERNAL_SSSE3(cpu_flags)) {
             c->hevc_v_loop_filter_luma = ff_hevc_v_loop_filter_luma_10_ssse3;
             c->hevc_h_loop_filter_luma = ff_hevc_h_loop_filter_luma_10_ssse3;
+
+            c->sao_edge_filter = ff_hevc_sao_edge_filter_10_ssse3;
         }
         if (EXTERNAL_SSE4(cpu_flags)) {
             SET_LUMA_FUNCS(weighted_pred,              ff_hevc_put_weighted_pred,     10, sse4);
@@ -435,10 +481,16 @@ void ff_hevc_dsp_init_x86(HEVCDSPContext *c, const int bit_depth)
 #endif /* HAVE_AVX_EXTERNAL */
             c->idct[2] = ff_hevc_idct_16x16_10_avx;
             c->idct[3] = ff_hevc_idct_32x32_10_avx;
+
+            c->hevc_v_loop_filter_luma = ff_hevc_v_loop_filter_luma_10_avx;
+            c->hevc_h_loop_filter_luma = ff_hevc_h_loop_filter_luma_10_avx;
         }
         if (EXTERNAL_AVX2(cpu_flags)) {
             c->idct_dc[2] = ff_hevc_idct_16x16_dc_10_avx2;
             c->idct_dc[3] = ff_hevc_idct_32x32_dc_10_avx2;
+
+            c->sao_band_filter = ff_hevc_sao_band_filter_10_avx2;
+            c->sao_edge_filter = ff_hevc_sao_edge_filter_10_avx2;
         }
     }
 #endif /* ARCH_X86_64 */
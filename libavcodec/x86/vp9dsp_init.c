@@ -241,6 +241,67 @@ lpf_funcs(88, 16, avx);
 
 #undef lpf_funcs
 
+#define itxfm_func(typea, typeb, size, opt) \
+void ff_vp9_##typea##_##typeb##_##size##x##size##_add_##opt(uint8_t *dst, ptrdiff_t stride, \
+                                                          int16_t *block, int eob)
+#define itxfm_funcs(size, opt)               \
+    itxfm_func(idct,  idct,  size, opt);     \
+    itxfm_func(iadst, idct,  size, opt);     \
+    itxfm_func(idct,  iadst, size, opt);     \
+    itxfm_func(iadst, iadst, size, opt)
+
+itxfm_funcs(4, sse2);
+itxfm_funcs(4, ssse3);
+itxfm_func(iwht, iwht, 4, sse2);
+itxfm_funcs(8, sse2);
+itxfm_funcs(8, ssse3);
+itxfm_funcs(16, sse2);
+itxfm_funcs(16, ssse3);
+itxfm_funcs(16, avx2);
+itxfm_func(idct, idct, 32, sse2);
+itxfm_func(idct, idct, 32, ssse3);
+itxfm_func(idct, idct, 32, avx2);
+
+#undef itxfm_funcs
+#undef itxfm_func
+
+#define ipred_func(size, type, opt) \
+void ff_vp9_ipred_##type##_##size##x##size##_##opt(uint8_t *dst, ptrdiff_t stride, \
+                                                   const uint8_t *l, const uint8_t *a)
+#define ipred_funcs(type, opt)       \
+    ipred_func(4,  type, opt);       \
+    ipred_func(8,  type, opt);       \
+    ipred_func(16, type, opt);       \
+    ipred_func(32, type, opt)
+
+ipred_funcs(v,       sse2);
+ipred_funcs(dc_127,  sse2);
+ipred_funcs(dc_128,  sse2);
+ipred_funcs(dc_129,  sse2);
+ipred_funcs(h,       ssse3);
+ipred_funcs(dc,      ssse3);
+ipred_funcs(dc_left, ssse3);
+ipred_funcs(dc_top,  ssse3);
+ipred_funcs(tm,      ssse3);
+ipred_funcs(dl,      ssse3);
+ipred_funcs(dr,      ssse3);
+ipred_funcs(vl,      ssse3);
+ipred_funcs(vr,      ssse3);
+ipred_funcs(hd,      ssse3);
+ipred_funcs(hu,      ssse3);
+ipred_func(32, v,       avx2);
+ipred_func(32, h,       avx2);
+ipred_func(32, dc,      avx2);
+ipred_func(32, dc_left, avx2);
+ipred_func(32, dc_top,  avx2);
+ipred_func(32, dc_127,  avx2);
+ipred_func(32, dc_128,  avx2);
+ipred_func(32, dc_129,  avx2);
+ipred_func(32, tm,      avx2);
+
+#undef ipred_funcs
+#undef ipred_func
+
 #endif /* HAVE_X86ASM */
 
 av_cold void ff_vp9dsp_init_x86(VP9DSPContext *dsp)
@@ -291,6 +352,27 @@ av_cold void ff_vp9dsp_init_x86(VP9DSPContext *dsp)
     dsp->loop_filter_mix2[1][1][1] = ff_vp9_loop_filter_v_88_16_##opt; \
 } while (0)
 
+#define init_itxfm(tx, sz, opt)                                            \
+    dsp->itxfm_add[tx][DCT_DCT]   = ff_vp9_idct_idct_   ## sz ## _add_ ## opt; \
+    dsp->itxfm_add[tx][DCT_ADST]  = ff_vp9_iadst_idct_  ## sz ## _add_ ## opt; \
+    dsp->itxfm_add[tx][ADST_DCT]  = ff_vp9_idct_iadst_  ## sz ## _add_ ## opt; \
+    dsp->itxfm_add[tx][ADST_ADST] = ff_vp9_iadst_iadst_ ## sz ## _add_ ## opt
+
+#define init_idct(tx, nm, opt)                          \
+    dsp->itxfm_add[tx][DCT_DCT]   =                     \
+    dsp->itxfm_add[tx][ADST_DCT]  =                     \
+    dsp->itxfm_add[tx][DCT_ADST]  =                     \
+    dsp->itxfm_add[tx][ADST_ADST] = ff_vp9_ ## nm ## _add_ ## opt
+
+#define init_ipred(tx, sz, mode, type, opt) \
+    dsp->intra_pred[tx][mode ## _PRED] = ff_vp9_ipred_ ## type ## _ ## sz ## x ## sz ## _ ## opt
+
+#define init_ipred_all(mode, type, opt)        \
+    init_ipred(TX_4X4,    4, mode, type, opt); \
+    init_ipred(TX_8X8,    8, mode, type, opt); \
+    init_ipred(TX_16X16, 16, mode, type, opt); \
+    init_ipred(TX_32X32, 32, mode, type, opt)
+
     if (EXTERNAL_MMX(cpu_flags)) {
         init_fpel(4, 0,  4, put, mmx);
         init_fpel(3, 0,  8, put, mmx);
@@ -316,12 +398,40 @@ av_cold void ff_vp9dsp_init_x86(VP9DSPContext *dsp)
         init_fpel(1, 1, 32, avg, sse2);
         init_fpel(0, 1, 64, avg, sse2);
         init_lpf(sse2);
+        init_itxfm(TX_4X4, 4x4, sse2);
+        init_idct(4 /* lossless */, iwht_iwht_4x4, sse2);
+        init_ipred_all(VERT,   v,      sse2);
+        init_ipred_all(DC_127, dc_127, sse2);
+        init_ipred_all(DC_128, dc_128, sse2);
+        init_ipred_all(DC_129, dc_129, sse2);
+#if ARCH_X86_64
+        init_itxfm(TX_8X8, 8x8, sse2);
+        init_itxfm(TX_16X16, 16x16, sse2);
+        init_idct(TX_32X32, idct_idct_32x32, sse2);
+#endif
     }
 
     if (EXTERNAL_SSSE3(cpu_flags)) {
         init_subpel3(0, put, ssse3);
         init_subpel3(1, avg, ssse3);
         init_lpf(ssse3);
+        init_itxfm(TX_4X4, 4x4, ssse3);
+        init_ipred_all(HOR,             h,       ssse3);
+        init_ipred_all(DC,              dc,      ssse3);
+        init_ipred_all(LEFT_DC,         dc_left, ssse3);
+        init_ipred_all(TOP_DC,          dc_top,  ssse3);
+        init_ipred_all(TM_VP8,          tm,      ssse3);
+        init_ipred_all(DIAG_DOWN_LEFT,  dl,      ssse3);
+        init_ipred_all(DIAG_DOWN_RIGHT, dr,      ssse3);
+        init_ipred_all(VERT_LEFT,       vl,      ssse3);
+        init_ipred_all(VERT_RIGHT,      vr,      ssse3);
+        init_ipred_all(HOR_DOWN,        hd,      ssse3);
+        init_ipred_all(HOR_UP,          hu,      ssse3);
+#if ARCH_X86_64
+        init_itxfm(TX_8X8, 8x8, ssse3);
+        init_itxfm(TX_16X16, 16x16, ssse3);
+        init_idct(TX_32X32, idct_idct_32x32, ssse3);
+#endif
     }
 
     if (EXTERNAL_AVX(cpu_flags)) {
@@ -333,14 +443,29 @@ av_cold void ff_vp9dsp_init_x86(VP9DSPContext *dsp)
     if (EXTERNAL_AVX2(cpu_flags)) {
         init_fpel(1, 1, 32, avg, avx2);
         init_fpel(0, 1, 64, avg, avx2);
+        init_ipred(TX_32X32, 32, VERT,    v,       avx2);
+        init_ipred(TX_32X32, 32, HOR,     h,       avx2);
+        init_ipred(TX_32X32, 32, DC,      dc,      avx2);
+        init_ipred(TX_32X32, 32, LEFT_DC, dc_left, avx2);
+        init_ipred(TX_32X32, 32, TOP_DC,  dc_top,  avx2);
+        init_ipred(TX_32X32, 32, DC_127,  dc_127,  avx2);
+        init_ipred(TX_32X32, 32, DC_128,  dc_128,  avx2);
+        init_ipred(TX_32X32, 32, DC_129,  dc_129,  avx2);
+        init_ipred(TX_32X32, 32, TM_VP8,  tm,      avx2);
 
 #if ARCH_X86_64 && HAVE_AVX2_EXTERNAL
         init_subpel3_32_64(0, put, avx2);
         init_subpel3_32_64(1, avg, avx2);
+        init_itxfm(TX_16X16, 16x16, avx2);
+        init_idct(TX_32X32, idct_idct_32x32, avx2);
 #endif /* ARCH_X86_64 && HAVE_AVX2_EXTERNAL */
     }
 
 #undef init_fpel
+#undef init_itxfm
+#undef init_idct
+#undef init_ipred
+#undef init_ipred_all
 #undef init_subpel1
 #undef init_subpel2
 #undef init_subpel3
@@ -0,0 +1,1108 @@
+;******************************************************************************
+;* VP9 intra prediction SIMD optimizations
+;*
+;* This file is part of Libav.
+;*
+;* Libav is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* Libav is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with Libav; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;******************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION_RODATA 32
+
+pw_m256:    times 16 dw -256
+pw_1:       times 16 dw 1
+pb_7f:      times 32 db 0x7f
+pb_80:      times 32 db 0x80
+pb_81:      times 32 db 0x81
+
+pw_512:     times  8 dw 512
+pw_1024:    times  8 dw 1024
+pw_2048:    times  8 dw 2048
+pw_4096:    times  8 dw 4096
+pw_8192:    times  8 dw 8192
+
+pb_2:       times 16 db 2
+pb_15:      times 16 db 15
+pb_reverse: db 15, 14, 13, 12, 11, 10,  9,  8,  7,  6,  5,  4,  3,  2,  1,  0
+
+; gather [left[n-1..0], topleft, top[]] from left[0..n-1] in the low and
+; top[-1..] in the high quadword
+pb_lr4:     db  3,  2,  1,  0,  8,  9, 10, 11, 12, 13, 14, 15, -1, -1, -1, -1
+pb_lr8:     db  7,  6,  5,  4,  3,  2,  1,  0,  8,  9, 10, 11, 12, 13, 14, 15
+
+; edge pixels shifted by 0, 1 and 2, with the last one replicated
+pb_0to3_3:  db  0,  1,  2,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3
+pb_1to3_3:  db  1,  2,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3
+pb_2to3_3:  db  2,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3
+pb_0to7_7:  db  0,  1,  2,  3,  4,  5,  6,  7,  7,  7,  7,  7,  7,  7,  7,  7
+pb_1to7_7:  db  1,  2,  3,  4,  5,  6,  7,  7,  7,  7,  7,  7,  7,  7,  7,  7
+pb_2to7_7:  db  2,  3,  4,  5,  6,  7,  7,  7,  7,  7,  7,  7,  7,  7,  7,  7
+; the bottom-right pixel of 4x4 diag_downleft is top[7] itself
+pb_dl4:     db  0,  1,  2,  3,  4,  5,  7,  7,  7,  7,  7,  7,  7,  7,  7,  7
+
+; vert_right: deinterleave the left edge filter output into the even and odd
+; row feeds, right-aligned so that they can be shifted in one byte at a time
+pb_vr8_e:   db -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,  2,  4,  6
+pb_vr8_o:   db -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,  1,  3,  5
+pb_vr16_e:  db -1, -1, -1, -1, -1, -1, -1, -1, -1,  2,  4,  6,  8, 10, 12, 14
+pb_vr16_o:  db -1, -1, -1, -1, -1, -1, -1, -1, -1,  1,  3,  5,  7,  9, 11, 13
+pb_vr32_e0: db -1,  2,  4,  6,  8, 10, 12, 14, -1, -1, -1, -1, -1, -1, -1, -1
+pb_vr32_e1: db -1, -1, -1, -1, -1, -1, -1, -1,  0,  2,  4,  6,  8, 10, 12, 14
+pb_vr32_o0: db -1,  1,  3,  5,  7,  9, 11, 13, 15, -1, -1, -1, -1, -1, -1, -1
+pb_vr32_o1: db -1, -1, -1, -1, -1, -1, -1, -1, -1,  1,  3,  5,  7,  9, 11, 13
+
+cextern pb_1
+cextern pb_3
+
+SECTION .text
+
+; m%1 = (m%2 + 2 * m%3 + m%4 + 2) >> 2, computed without unpacking as
+; avg(m%3, (m%2 + m%4) >> 1), which is exact; clobbers m%4
+%macro LOWPASS 4
+    pavgb               m%1, m%2, m%4
+    pxor                m%4, m%2
+    pand                m%4, [pb_1]
+    psubusb             m%1, m%4
+    pavgb               m%1, m%3
+%endmacro
+
+; store a row of a %1x%1 block from m%3 (and m%4 for the right half of a
+; 32-pixel row in xmm registers, defaulting to m%3)
+%macro STORE_ROW 3-4
+%if %1 == 4
+    movd               [%2], m%3
+%elif %1 == 8
+    movq               [%2], m%3
+%elif %1 == mmsize
+    mova               [%2], m%3
+%elif %0 == 4
+    mova               [%2], m%3
+    mova          [%2 + 16], m%4
+%else
+    mova               [%2], m%3
+    mova          [%2 + 16], m%3
+%endif
+%endmacro
+
+; store a row of a 4x4 or 8x8 block from m%3, then shift m%3 right by %4 bytes
+%macro SROW 3-4
+    STORE_ROW            %1, %2, %3
+%if %0 == 4
+    psrldq              m%3, %4
+%endif
+%endmacro
+
+; fill a %1x%1 block with m0 (and m1 for the right half of 32-pixel rows in
+; xmm registers); needs stride3 and cnt
+%macro FILL 1-2 0
+    lea            stride3q, [strideq*3]
+%if %1 > 4
+    mov                cntd, %1 / 4
+.loop:
+%endif
+    STORE_ROW            %1, dstq,             0, %2
+    STORE_ROW            %1, dstq + strideq,   0, %2
+    STORE_ROW            %1, dstq + strideq*2, 0, %2
+    STORE_ROW            %1, dstq + stride3q,  0, %2
+%if %1 > 4
+    lea                dstq, [dstq + strideq*4]
+    dec                cntd
+    jg .loop
+%endif
+    RET
+%endmacro
+
+; sum %1 pixels at each of the given addresses into the low word of xm0;
+; m1 must be zero, clobbers m2
+%macro SUM_PIXELS 2-3
+%if %1 == 4
+    movd                 m0, [%2]
+%if %0 == 3
+    movd                 m2, [%3]
+    punpckldq            m0, m2
+%endif
+    psadbw               m0, m1
+%elif %1 == 8
+    movq                 m0, [%2]
+%if %0 == 3
+    movhps               m0, [%3]
+%endif
+    psadbw               m0, m1
+%if %0 == 3
+    movhlps              m2, m0
+    paddw                m0, m2
+%endif
+%else
+    movu                 m0, [%2]
+    psadbw               m0, m1
+%if %1 > mmsize
+    movu                 m2, [%2 + mmsize]
+    psadbw               m2, m1
+    paddw                m0, m2
+%endif
+%if %0 == 3
+    movu                 m2, [%3]
+    psadbw               m2, m1
+    paddw                m0, m2
+%if %1 > mmsize
+    movu                 m2, [%3 + mmsize]
+    psadbw               m2, m1
+    paddw                m0, m2
+%endif
+%endif
+%if mmsize == 32
+    vextracti128        xm2, m0, 1
+    paddw               xm0, xm2
+%endif
+    movhlps             xm2, xm0
+    paddw               xm0, xm2
+%endif
+%endmacro
+
+; xm0 = (xm0 + (1 << (%1 - 1))) >> %1
+%macro ROUND_SHIFT 1
+%if %1 == 2
+    pmulhrsw            xm0, [pw_8192]
+%elif %1 == 3
+    pmulhrsw            xm0, [pw_4096]
+%elif %1 == 4
+    pmulhrsw            xm0, [pw_2048]
+%elif %1 == 5
+    pmulhrsw            xm0, [pw_1024]
+%else
+    pmulhrsw            xm0, [pw_512]
+%endif
+%endmacro
+
+; broadcast the low byte of xm0 to all of m0 (and m1); m1 must be zero
+%macro SPLAT_DC 1
+%if cpuflag(avx2)
+    vpbroadcastb         m0, xm0
+%else
+    pshufb               m0, m1
+%if %1 > mmsize
+    mova                 m1, m0
+%endif
+%endif
+%endmacro
+
+; %1 = block size, %2 = log2(%1)
+%macro DC_FUNCS 2
+cglobal vp9_ipred_dc_%1x%1, 4, 4, 3, dst, stride, l, a
+    pxor                 m1, m1
+    SUM_PIXELS           %1, lq, aq
+    ROUND_SHIFT          %2 + 1
+    SPLAT_DC             %1
+    DEFINE_ARGS dst, stride, stride3, cnt
+    FILL                 %1, 1
+
+cglobal vp9_ipred_dc_left_%1x%1, 3, 5, 3, dst, stride, l, stride3, cnt
+    pxor                 m1, m1
+    SUM_PIXELS           %1, lq
+    ROUND_SHIFT          %2
+    SPLAT_DC             %1
+    FILL                 %1, 1
+
+cglobal vp9_ipred_dc_top_%1x%1, 4, 4, 3, dst, stride, l, a
+    pxor                 m1, m1
+    SUM_PIXELS           %1, aq
+    ROUND_SHIFT          %2
+    SPLAT_DC             %1
+    DEFINE_ARGS dst, stride, stride3, cnt
+    FILL                 %1, 1
+%endmacro
+
+%macro DC_FIXED_FUNC 2 ; size, value
+cglobal vp9_ipred_dc_%2_%1x%1, 2, 4, 1, dst, stride, stride3, cnt
+%if %2 == 127
+    mova                 m0, [pb_7f]
+%elif %2 == 128
+    mova                 m0, [pb_80]
+%else
+    mova                 m0, [pb_81]
+%endif
+    FILL                 %1
+%endmacro
+
+%macro DC_FIXED_FUNCS 1
+    DC_FIXED_FUNC        %1, 127
+    DC_FIXED_FUNC        %1, 128
+    DC_FIXED_FUNC        %1, 129
+%endmacro
+
+%macro V_FUNC 1
+cglobal vp9_ipred_v_%1x%1, 4, 4, 2, dst, stride, l, a
+%if %1 == 4
+    movd                 m0, [aq]
+%elif %1 == 8
+    movq                 m0, [aq]
+%else
+    movu                 m0, [aq]
+%if %1 > mmsize
+    movu                 m1, [aq + 16]
+%endif
+%endif
+    DEFINE_ARGS dst, stride, stride3, cnt
+    FILL                 %1, 1
+%endmacro
+
+%macro H_FUNC 1
+cglobal vp9_ipred_h_%1x%1, 3, 5, 4, dst, stride, l, stride3, cnt
+    lea            stride3q, [strideq*3]
+%if notcpuflag(avx2)
+    pxor                 m3, m3
+%endif
+%if %1 > 4
+    mov                cntd, %1 / 4
+.loop:
+%endif
+%if cpuflag(avx2)
+    vpbroadcastb         m0, [lq + 0]
+    vpbroadcastb         m1, [lq + 1]
+    vpbroadcastb         m2, [lq + 2]
+    vpbroadcastb         m3, [lq + 3]
+    mova             [dstq], m0
+    mova   [dstq + strideq], m1
+    mova [dstq + strideq*2], m2
+    mova [dstq + stride3q ], m3
+%else
+    movd                 m0, [lq]
+    pshufb               m1, m0, m3
+    pshufb               m2, m0, [pb_1]
+    STORE_ROW            %1, dstq,             1
+    STORE_ROW            %1, dstq + strideq,   2
+    pshufb               m1, m0, [pb_2]
+    pshufb               m0, [pb_3]
+    STORE_ROW            %1, dstq + strideq*2, 1
+    STORE_ROW            %1, dstq + stride3q,  0
+%endif
+%if %1 > 4
+    add                  lq, 4
+    lea                dstq, [dstq + strideq*4]
+    dec                cntd
+    jg .loop
+%endif
+    RET
+%endmacro
+
+; top - topleft is kept in words; each row adds left[y] (broadcast with a
+; pshufb mask whose index is advanced by one per row) and packs with
+; unsigned saturation, which is the clip in the C version
+%macro TM_FUNC 1
+%if %1 <= 8
+cglobal vp9_ipred_tm_%1x%1, 4, 5, 6, dst, stride, l, a, cnt
+    pxor                 m1, m1
+%if %1 == 4
+    movd                 m0, [aq]
+    movd                 m3, [lq]
+%else
+    movq                 m0, [aq]
+    movq                 m3, [lq]
+%endif
+    movd                 m2, [aq - 1]
+    punpcklbw            m0, m1
+    pshufb               m2, [pw_m256]
+    psubw                m0, m2
+    mova                 m4, [pw_m256]
+    mov                cntd, %1
+.loop:
+    pshufb               m2, m3, m4
+    paddw                m2, m0
+    packuswb             m2, m2
+    STORE_ROW            %1, dstq, 2
+    paddw                m4, [pw_1]
+    add                dstq, strideq
+    dec                cntd
+    jg .loop
+    RET
+%elif %1 == 16
+cglobal vp9_ipred_tm_16x16, 4, 5, 6, dst, stride, l, a, cnt
+    pxor                 m5, m5
+    movu                 m0, [aq]
+    movd                 m2, [aq - 1]
+    pshufb               m2, [pw_m256]
+    punpckhbw            m1, m0, m5
+    punpcklbw            m0, m5
+    psubw                m0, m2
+    psubw                m1, m2
+    movu                 m3, [lq]
+    mova                 m4, [pw_m256]
+    mov                cntd, 16
+.loop:
+    pshufb               m2, m3, m4
+    paddw                m5, m2, m1
+    paddw                m2, m0
+    packuswb             m2, m5
+    mova             [dstq], m2
+    paddw                m4, [pw_1]
+    add                dstq, strideq
+    dec                cntd
+    jg .loop
+    RET
+%elif mmsize == 32
+cglobal vp9_ipred_tm_32x32, 4, 6, 7, dst, stride, l, a, cnt, cnt2
+    ; words of pixels 0-7|16-23 and 8-15|24-31, so that packuswb puts
+    ; them back in order without a cross-lane permute
+    pxor                 m3, m3
+    movu                 m0, [aq]
+    vpbroadcastb         m2, [aq - 1]
+    punpckhbw            m1, m0, m3
+    punpcklbw            m0, m3
+    punpcklbw            m2, m3
+    psubw                m0, m2
+    psubw                m1, m2
+    mov                cntd, 2
+.loop_half:
+    vbroadcasti128       m4, [lq]
+    mova                 m5, [pw_m256]
+    mov               cnt2d, 16
+.loop:
+    pshufb               m2, m4, m5
+    paddw                m6, m2, m1
+    paddw                m2, m0
+    packuswb             m2, m6
+    mova             [dstq], m2
+    paddw                m5, [pw_1]
+    add                dstq, strideq
+    dec               cnt2d
+    jg .loop
+    add                  lq, 16
+    dec                cntd
+    jg .loop_half
+    RET
+%else
+cglobal vp9_ipred_tm_32x32, 4, 6, 8, dst, stride, l, a, cnt, cnt2
+    pxor                 m7, m7
+    movu                 m0, [aq]
+    movu                 m2, [aq + 16]
+    movd                 m6, [aq - 1]
+    pshufb               m6, [pw_m256]
+    punpckhbw            m1, m0, m7
+    punpcklbw            m0, m7
+    punpckhbw            m3, m2, m7
+    punpcklbw            m2, m7
+    psubw                m0, m6
+    psubw                m1, m6
+    psubw                m2, m6
+    psubw                m3, m6
+    mov                cntd, 2
+.loop_half:
+    movu                 m4, [lq]
+    mova                 m5, [pw_m256]
+    mov               cnt2d, 16
+.loop:
+    pshufb               m6, m4, m5
+    paddw                m7, m6, m0
+    paddw                m6, m1
+    packuswb             m7, m6
+    mova             [dstq], m7
+    pshufb               m6, m4, m5
+    paddw                m7, m6, m2
+    paddw                m6, m3
+    packuswb             m7, m6
+    mova        [dstq + 16], m7
+    paddw                m5, [pw_1]
+    add                dstq, strideq
+    dec               cnt2d
+    jg .loop
+    add                  lq, 16
+    dec                cntd
+    jg .loop_half
+    RET
+%endif
+%endmacro
+
+; The directional predictors below build the edge
+;     E = [left[n-1..0], topleft, top[0..n-1]]
+; (or just top[] / left[] for the modes that only use one of them) in
+; registers, filter it with LOWPASS / pavgb and then produce each row by
+; shifting a chain of registers by one (or two) bytes per row.
+
+; m0 = [left[3..0], topleft, top[0..6]]
+%macro EDGE_4x4 0
+    movd                 m0, [lq]
+    movq                 m1, [aq - 1]
+    punpcklqdq           m0, m1
+    pshufb               m0, [pb_lr4]
+%endmacro
+
+; m0 = [left[7..0], topleft, top[0..6]]
+%macro EDGE_8x8 0
+    movq                 m0, [lq]
+    movq                 m1, [aq - 1]
+    punpcklqdq           m0, m1
+    pshufb               m0, [pb_lr8]
+%endmacro
+
+INIT_XMM sse2
+V_FUNC                   4
+V_FUNC                   8
+V_FUNC                  16
+V_FUNC                  32
+DC_FIXED_FUNCS           4
+DC_FIXED_FUNCS           8
+DC_FIXED_FUNCS          16
+DC_FIXED_FUNCS          32
+
+INIT_XMM ssse3
+DC_FUNCS                 4, 2
+DC_FUNCS                 8, 3
+DC_FUNCS                16, 4
+DC_FUNCS                32, 5
+H_FUNC                   4
+H_FUNC                   8
+H_FUNC                  16
+H_FUNC                  32
+TM_FUNC                  4
+TM_FUNC                  8
+TM_FUNC                 16
+TM_FUNC                 32
+
+; diag_downleft
+
+cglobal vp9_ipred_dl_4x4, 4, 4, 4, dst, stride, l, a
+    movq                 m1, [aq]
+    pshufb               m0, m1, [pb_dl4]
+    pshufb               m2, m1, [pb_2to7_7]
+    pshufb               m1, [pb_1to7_7]
+    LOWPASS               3, 0, 1, 2
+    DEFINE_ARGS dst, stride, stride3
+    lea            stride3q, [strideq*3]
+    SROW                  4, dstq,             3, 1
+    SROW                  4, dstq + strideq,   3, 1
+    SROW                  4, dstq + strideq*2, 3, 1
+    SROW                  4, dstq + stride3q,  3
+    RET
+
+cglobal vp9_ipred_dl_8x8, 4, 4, 4, dst, stride, l, a
+    movq                 m1, [aq]
+    pshufb               m0, m1, [pb_0to7_7]
+    pshufb               m2, m1, [pb_2to7_7]
+    pshufb               m1, [pb_1to7_7]
+    LOWPASS               3, 0, 1, 2
+    DEFINE_ARGS dst, stride, stride3
+    lea            stride3q, [strideq*3]
+    SROW                  8, dstq,             3, 1
+    SROW                  8, dstq + strideq,   3, 1
+    SROW                  8, dstq + strideq*2, 3, 1
+    SROW                  8, dstq + stride3q,  3, 1
+    lea                dstq, [dstq + strideq*4]
+    SROW                  8, dstq,             3, 1
+    SROW                  8, dstq + strideq,   3, 1
+    SROW                  8, dstq + strideq*2, 3, 1
+    SROW                  8, dstq + stride3q,  3
+    RET
+
+cglobal vp9_ipred_dl_16x16, 4, 4, 6, dst, stride, l, a
+    movu                 m0, [aq]
+    pshufb               m5, m0, [pb_15]
+    palignr              m1, m5, m0, 1
+    palignr              m2, m5, m0, 2
+    LOWPASS               3, 0, 1, 2
+    DEFINE_ARGS dst, stride, cnt
+    mov                cntd, 8
+.loop:
+    mova             [dstq], m3
+    palignr              m4, m5, m3, 1
+    mova   [dstq + strideq], m4
+    palignr              m3, m5, m4, 1
+    lea                dstq, [dstq + strideq*2]
+    dec                cntd
+    jg .loop
+    RET
+
+cglobal vp9_ipred_dl_32x32, 4, 4, 8, dst, stride, l, a
+    movu                 m0, [aq]
+    movu                 m1, [aq + 16]
+    pshufb               m7, m1, [pb_15]
+    palignr              m2, m1, m0, 1
+    palignr              m3, m1, m0, 2
+    LOWPASS               4, 0, 2, 3
+    palignr              m2, m7, m1, 1
+    palignr              m3, m7, m1, 2
+    LOWPASS               5, 1, 2, 3
+    DEFINE_ARGS dst, stride, cnt
+    mov                cntd, 16
+.loop:
+    mova             [dstq], m4
+    mova        [dstq + 16], m5
+    palignr              m0, m5, m4, 1
+    palignr              m1, m7, m5, 1
+    mova   [dstq + strideq], m0
+    mova [dstq + strideq + 16], m1
+    palignr              m4, m1, m0, 1
+    palignr              m5, m7, m1, 1
+    lea                dstq, [dstq + strideq*2]
+    dec                cntd
+    jg .loop
+    RET
+
+; diag_downright: v[i] = LOWPASS(E[i], E[i + 1], E[i + 2]), row y = v[n - 1 - y]
+
+cglobal vp9_ipred_dr_4x4, 4, 4, 4, dst, stride, l, a
+    EDGE_4x4
+    psrldq               m1, m0, 1
+    psrldq               m2, m0, 2
+    LOWPASS               3, 0, 1, 2
+    DEFINE_ARGS dst, stride, stride3
+    lea            stride3q, [strideq*3]
+    SROW                  4, dstq + stride3q,  3, 1
+    SROW                  4, dstq + strideq*2, 3, 1
+    SROW                  4, dstq + strideq,   3, 1
+    SROW                  4, dstq,             3
+    RET
+
+cglobal vp9_ipred_dr_8x8, 4, 4, 4, dst, stride, l, a
+    EDGE_8x8
+    movq                 m1, [aq]
+    psrldq               m1, 7
+    palignr              m2, m1, m0, 2
+    palignr              m1, m0, 1
+    LOWPASS               3, 0, 1, 2
+    DEFINE_ARGS dst, stride, stride3, dst4
+    lea            stride3q, [strideq*3]
+    lea               dst4q, [dstq + strideq*4]
+    SROW                  8, dst4q + stride3q,  3, 1
+    SROW                  8, dst4q + strideq*2, 3, 1
+    SROW                  8, dst4q + strideq,   3, 1
+    SROW                  8, dst4q,             3, 1
+    SROW                  8, dstq + stride3q,   3, 1
+    SROW                  8, dstq + strideq*2,  3, 1
+    SROW                  8, dstq + strideq,    3, 1
+    SROW                  8, dstq,              3
+    RET
+
+cglobal vp9_ipred_dr_16x16, 4, 4, 6, dst, stride, l, a
+    movu                 m0, [lq]
+    pshufb               m0, [pb_reverse]
+    movu                 m1, [aq - 1]
+    palignr              m2, m1, m0, 1
+    palignr              m3, m1, m0, 2
+    LOWPASS               4, 0, 2, 3
+    movu                 m0, [aq]
+    psrldq               m2, m0, 1
+    LOWPASS               5, 1, 0, 2
+    DEFINE_ARGS dst, stride, stride3, cnt
+    lea            stride3q, [strideq*3]
+    mov                cntd, 4
+.loop:
+    palignr              m5, m4, 15
+    pslldq               m4, 1
+    mova             [dstq], m5
+    palignr              m5, m4, 15
+    pslldq               m4, 1
+    mova   [dstq + strideq], m5
+    palignr              m5, m4, 15
+    pslldq               m4, 1
+    mova [dstq + strideq*2], m5
+    palignr              m5, m4, 15
+    pslldq               m4, 1
+    mova [dstq + stride3q ], m5
+    lea                dstq, [dstq + strideq*4]
+    dec                cntd
+    jg .loop
+    RET
+
+cglobal vp9_ipred_dr_32x32, 4, 4, 8, dst, stride, l, a
+    movu                 m0, [lq + 16]
+    movu                 m1, [lq]
+    pshufb               m0, [pb_reverse]
+    pshufb               m1, [pb_reverse]
+    palignr              m2, m1, m0, 1
+    palignr              m3, m1, m0, 2
+    LOWPASS               4, 0, 2, 3
+    movu                 m0, [aq - 1]
+    palignr              m2, m0, m1, 1
+    palignr              m3, m0, m1, 2
+    LOWPASS               5, 1, 2, 3
+    movu                 m1, [aq]
+    movu                 m2, [aq + 1]
+    LOWPASS               6, 0, 1, 2
+    movu                 m0, [aq + 15]
+    movu                 m1, [aq + 16]
+    psrldq               m2, m1, 1
+    LOWPASS               7, 0, 1, 2
+    DEFINE_ARGS dst, stride, cnt
+    mov                cntd, 32
+.loop:
+    palignr              m7, m6, 15
+    palignr              m6, m5, 15
+    palignr              m5, m4, 15
+    pslldq               m4, 1
+    mova             [dstq], m6
+    mova        [dstq + 16], m7
+    add                dstq, strideq
+    dec                cntd
+    jg .loop
+    RET
+
+; vert_left
+
+cglobal vp9_ipred_vl_4x4, 4, 4, 5, dst, stride, l, a
+    movq                 m0, [aq]
+    psrldq               m1, m0, 1
+    psrldq               m2, m0, 2
+    pavgb                m3, m0, m1
+    LOWPASS               4, 0, 1, 2
+    DEFINE_ARGS dst, stride, stride3
+    lea            stride3q, [strideq*3]
+    SROW                  4, dstq,             3, 1
+    SROW                  4, dstq + strideq,   4, 1
+    SROW                  4, dstq + strideq*2, 3
+    SROW                  4, dstq + stride3q,  4
+    RET
+
+cglobal vp9_ipred_vl_8x8, 4, 4, 5, dst, stride, l, a
+    movq                 m1, [aq]
+    pshufb               m0, m1, [pb_0to7_7]
+    pshufb               m2, m1, [pb_2to7_7]
+    pshufb               m1, [pb_1to7_7]
+    pavgb                m3, m0, m1
+    LOWPASS               4, 0, 1, 2
+    DEFINE_ARGS dst, stride, stride3
+    lea            stride3q, [strideq*3]
+    SROW                  8, dstq,             3, 1
+    SROW                  8, dstq + strideq,   4, 1
+    SROW                  8, dstq + strideq*2, 3, 1
+    SROW                  8, dstq + stride3q,  4, 1
+    lea                dstq, [dstq + strideq*4]
+    SROW                  8, dstq,             3, 1
+    SROW                  8, dstq + strideq,   4, 1
+    SROW                  8, dstq + strideq*2, 3
+    SROW                  8, dstq + stride3q,  4
+    RET
+
+cglobal vp9_ipred_vl_16x16, 4, 4, 7, dst, stride, l, a
+    movu                 m0, [aq]
+    pshufb               m6, m0, [pb_15]
+    palignr              m1, m6, m0, 1
+    palignr              m2, m6, m0, 2
+    pavgb                m3, m0, m1
+    LOWPASS               4, 0, 1, 2
+    DEFINE_ARGS dst, stride, stride3, cnt
+    lea            stride3q, [strideq*3]
+    mov                cntd, 4
+.loop:
+    mova             [dstq], m3
+    mova   [dstq + strideq], m4
+    palignr              m0, m6, m3, 1
+    palignr              m1, m6, m4, 1
+    mova [dstq + strideq*2], m0
+    mova [dstq + stride3q ], m1
+    palignr              m3, m6, m0, 1
+    palignr              m4, m6, m1, 1
+    lea                dstq, [dstq + strideq*4]
+    dec                cntd
+    jg .loop
+    RET
+
+; the replicated top[31] is kept on the stack so that both the current and
+; next rows fit in 8 registers
+cglobal vp9_ipred_vl_32x32, 4, 4, 8, mmsize, dst, stride, l, a
+    movu                 m0, [aq]
+    movu                 m1, [aq + 16]
+    pshufb               m2, m1, [pb_15]
+    mova             [rsp], m2
+    palignr              m3, m1, m0, 1
+    palignr              m4, m1, m0, 2
+    pavgb                m5, m0, m3
+    LOWPASS               6, 0, 3, 4
+    palignr              m3, m2, m1, 1
+    palignr              m4, m2, m1, 2
+    pavgb                m7, m1, m3
+    LOWPASS               0, 1, 3, 4
+    DEFINE_ARGS dst, stride, stride3, cnt
+    lea            stride3q, [strideq*3]
+    mov                cntd, 8
+.loop:
+    mova             [dstq], m5
+    mova        [dstq + 16], m7
+    mova   [dstq + strideq], m6
+    mova [dstq + strideq + 16], m0
+    palignr              m1, m7, m5, 1
+    mova                 m2, [rsp]
+    palignr              m2, m7, 1
+    palignr              m3, m0, m6, 1
+    mova                 m4, [rsp]
+    palignr              m4, m0, 1
+    mova [dstq + strideq*2], m1
+    mova [dstq + strideq*2 + 16], m2
+    mova [dstq + stride3q ], m3
+    mova [dstq + stride3q + 16], m4
+    palignr              m5, m2, m1, 1
+    mova                 m7, [rsp]
+    palignr              m7, m2, 1
+    palignr              m6, m4, m3, 1
+    mova                 m0, [rsp]
+    palignr              m0, m4, 1
+    lea                dstq, [dstq + strideq*4]
+    dec                cntd
+    jg .loop
+    RET
+
+; vert_right: even rows are pavgb(E[i], E[i + 1]) and odd rows are
+; LOWPASS(E[i - 1], E[i], E[i + 1]) of topleft/top[]; each pair of rows is
+; shifted right by one, pulling in alternating LOWPASS outputs of left[]
+
+cglobal vp9_ipred_vr_4x4, 4, 4, 5, dst, stride, l, a
+    EDGE_4x4
+    psrldq               m1, m0, 1
+    psrldq               m2, m0, 2
+    pavgb                m3, m0, m1
+    LOWPASS               4, 0, 1, 2
+    pslldq               m0, m4, 13
+    pslldq               m1, m4, 14
+    psrldq               m3, 4
+    psrldq               m4, 3
+    palignr              m3, m0, 15
+    palignr              m4, m1, 15
+    DEFINE_ARGS dst, stride, stride3
+    lea            stride3q, [strideq*3]
+    SROW                  4, dstq + strideq*2, 3, 1
+    SROW                  4, dstq + stride3q,  4, 1
+    SROW                  4, dstq,             3
+    SROW                  4, dstq + strideq,   4
+    RET
+
+%macro VR_8x8_ROWS 2 ; even row, odd row
+    SROW                  8, %1, 3
+    SROW                  8, %2, 6
+    palignr              m3, m0, 15
+    pslldq               m0, 1
+    palignr              m6, m4, 15
+    pslldq               m4, 1
+%endmacro
+
+cglobal vp9_ipred_vr_8x8, 4, 4, 7, dst, stride, l, a
+    EDGE_8x8
+    movq                 m5, [aq]
+    movq                 m3, [aq - 1]
+    psrldq               m1, m0, 7
+    psrldq               m2, m0, 8
+    pavgb                m3, m5
+    LOWPASS               6, 1, 2, 5
+    psrldq               m1, m0, 1
+    psrldq               m2, m0, 2
+    LOWPASS               4, 0, 1, 2
+    pshufb               m0, m4, [pb_vr8_e]
+    pshufb               m4, [pb_vr8_o]
+    DEFINE_ARGS dst, stride, stride3
+    lea            stride3q, [strideq*3]
+    VR_8x8_ROWS          dstq,             dstq + strideq
+    VR_8x8_ROWS          dstq + strideq*2, dstq + stride3q
+    lea                dstq, [dstq + strideq*4]
+    VR_8x8_ROWS          dstq,             dstq + strideq
+    VR_8x8_ROWS          dstq + strideq*2, dstq + stride3q
+    RET
+
+cglobal vp9_ipred_vr_16x16, 4, 4, 6, dst, stride, l, a
+    movu                 m0, [lq]
+    pshufb               m0, [pb_reverse]
+    movu                 m1, [aq - 1]
+    movu                 m2, [aq]
+    palignr              m3, m1, m0, 15
+    pavgb                m5, m1, m2
+    LOWPASS               4, 3, 1, 2
+    palignr              m2, m1, m0, 1
+    palignr              m3, m1, m0, 2
+    LOWPASS               1, 0, 2, 3
+    pshufb               m0, m1, [pb_vr16_e]
+    pshufb               m1, [pb_vr16_o]
+    DEFINE_ARGS dst, stride, stride3, cnt
+    lea            stride3q, [strideq*3]
+    mov                cntd, 4
+.loop:
+    mova             [dstq], m5
+    mova   [dstq + strideq], m4
+    palignr              m5, m0, 15
+    pslldq               m0, 1
+    palignr              m4, m1, 15
+    pslldq               m1, 1
+    mova [dstq + strideq*2], m5
+    mova [dstq + stride3q ], m4
+    palignr              m5, m0, 15
+    pslldq               m0, 1
+    palignr              m4, m1, 15
+    pslldq               m1, 1
+    lea                dstq, [dstq + strideq*4]
+    dec                cntd
+    jg .loop
+    RET
+
+cglobal vp9_ipred_vr_32x32, 4, 4, 8, dst, stride, l, a
+    movu                 m0, [lq + 16]
+    movu                 m1, [lq]
+    pshufb               m0, [pb_reverse]
+    pshufb               m1, [pb_reverse]
+    palignr              m2, m1, m0, 1
+    palignr              m3, m1, m0, 2
+    LOWPASS               4, 0, 2, 3
+    movu                 m0, [aq - 1]
+    palignr              m2, m0, m1, 1
+    palignr              m3, m0, m1, 2
+    LOWPASS               5, 1, 2, 3
+    palignr              m6, m0, m1, 15
+    pshufb               m2, m4, [pb_vr32_e0]
+    pshufb               m3, m5, [pb_vr32_e1]
+    por                  m2, m3
+    pshufb               m4, [pb_vr32_o0]
+    pshufb               m5, [pb_vr32_o1]
+    por                  m4, m5
+    movu                 m1, [aq]
+    pavgb                m3, m0, m1
+    LOWPASS               5, 6, 0, 1
+    movu                 m0, [aq + 15]
+    movu                 m1, [aq + 16]
+    movu                 m7, [aq + 14]
+    LOWPASS               6, 7, 0, 1
+    movu                 m1, [aq + 16]
+    pavgb                m0, m1
+    DEFINE_ARGS dst, stride, cnt
+    mov                cntd, 16
+.loop:
+    mova             [dstq], m3
+    mova        [dstq + 16], m0
+    mova   [dstq + strideq], m5
+    mova [dstq + strideq + 16], m6
+    palignr              m0, m3, 15
+    palignr              m3, m2, 15
+    pslldq               m2, 1
+    palignr              m6, m5, 15
+    palignr              m5, m4, 15
+    pslldq               m4, 1
+    lea                dstq, [dstq + strideq*2]
+    dec                cntd
+    jg .loop
+    RET
+
+; hor_down: v[] interleaves pavgb(E[i], E[i + 1]) and
+; LOWPASS(E[i], E[i + 1], E[i + 2]) over left[]/topleft, followed by
+; LOWPASS of top[]; row y = v[2 * (n - 1 - y)]
+
+cglobal vp9_ipred_hd_4x4, 4, 4, 5, dst, stride, l, a
+    EDGE_4x4
+    psrldq               m1, m0, 1
+    psrldq               m2, m0, 2
+    pavgb                m3, m0, m1
+    LOWPASS               4, 0, 1, 2
+    punpcklbw            m3, m4
+    psrldq               m4, 4
+    punpcklqdq           m3, m4
+    DEFINE_ARGS dst, stride, stride3
+    lea            stride3q, [strideq*3]
+    SROW                  4, dstq + stride3q,  3, 2
+    SROW                  4, dstq + strideq*2, 3, 2
+    SROW                  4, dstq + strideq,   3, 2
+    SROW                  4, dstq,             3
+    RET
+
+cglobal vp9_ipred_hd_8x8, 4, 4, 5, dst, stride, l, a
+    EDGE_8x8
+    psrldq               m1, m0, 1
+    psrldq               m2, m0, 2
+    pavgb                m3, m0, m1
+    LOWPASS               4, 0, 1, 2
+    punpcklbw            m3, m4
+    psrldq               m4, 8
+    palignr              m4, m3, 8
+    DEFINE_ARGS dst, stride, stride3, dst4
+    lea            stride3q, [strideq*3]
+    lea               dst4q, [dstq + strideq*4]
+    SROW                  8, dst4q + stride3q,  3, 2
+    SROW                  8, dst4q + strideq*2, 3, 2
+    SROW                  8, dst4q + strideq,   3, 2
+    SROW                  8, dst4q,             3
+    SROW                  8, dstq + stride3q,   4, 2
+    SROW                  8, dstq + strideq*2,  4, 2
+    SROW                  8, dstq + strideq,    4, 2
+    SROW                  8, dstq,              4
+    RET
+
+cglobal vp9_ipred_hd_16x16, 4, 4, 6, dst, stride, l, a
+    movu                 m0, [lq]
+    pshufb               m0, [pb_reverse]
+    movu                 m1, [aq - 1]
+    palignr              m2, m1, m0, 1
+    palignr              m3, m1, m0, 2
+    pavgb                m4, m0, m2
+    LOWPASS               5, 0, 2, 3
+    punpckhbw            m2, m4, m5
+    punpcklbw            m4, m5
+    movu                 m0, [aq]
+    psrldq               m3, m0, 1
+    LOWPASS               5, 1, 0, 3
+    DEFINE_ARGS dst, stride, cnt
+    mov                cntd, 16
+.loop:
+    palignr              m5, m2, 14
+    palignr              m2, m4, 14
+    pslldq               m4, 2
+    mova             [dstq], m5
+    add                dstq, strideq
+    dec                cntd
+    jg .loop
+    RET
+
+cglobal vp9_ipred_hd_32x32, 4, 4, 8, dst, stride, l, a
+    movu                 m0, [aq - 1]
+    movu                 m1, [aq]
+    movu                 m2, [aq + 1]
+    LOWPASS               6, 0, 1, 2
+    movu                 m0, [aq + 15]
+    movu                 m1, [aq + 16]
+    psrldq               m2, m1, 1
+    LOWPASS               7, 0, 1, 2
+    movu                 m0, [lq + 16]
+    movu                 m1, [lq]
+    pshufb               m0, [pb_reverse]
+    pshufb               m1, [pb_reverse]
+    palignr              m2, m1, m0, 1
+    palignr              m3, m1, m0, 2
+    pavgb                m4, m0, m2
+    LOWPASS               5, 0, 2, 3
+    punpckhbw            m0, m4, m5
+    punpcklbw            m4, m5
+    movu                 m2, [aq - 1]
+    palignr              m3, m2, m1, 1
+    palignr              m2, m1, 2
+    LOWPASS               5, 1, 3, 2
+    pavgb                m1, m3
+    punpckhbw            m2, m1, m5
+    punpcklbw            m1, m5
+    DEFINE_ARGS dst, stride, cnt
+    mov                cntd, 32
+.loop:
+    palignr              m7, m6, 14
+    palignr              m6, m2, 14
+    palignr              m2, m1, 14
+    palignr              m1, m0, 14
+    palignr              m0, m4, 14
+    pslldq               m4, 2
+    mova             [dstq], m6
+    mova        [dstq + 16], m7
+    add                dstq, strideq
+    dec                cntd
+    jg .loop
+    RET
+
+; hor_up: v[] interleaves pavgb and LOWPASS of left[] with left[n - 1]
+; replicated, row y = v[2 * y]
+
+cglobal vp9_ipred_hu_4x4, 3, 4, 5, dst, stride, l, stride3
+    movd                 m1, [lq]
+    pshufb               m0, m1, [pb_0to3_3]
+    pshufb               m2, m1, [pb_2to3_3]
+    pshufb               m1, [pb_1to3_3]
+    pavgb                m3, m0, m1
+    LOWPASS               4, 0, 1, 2
+    punpcklbw            m3, m4
+    lea            stride3q, [strideq*3]
+    SROW                  4, dstq,             3, 2
+    SROW                  4, dstq + strideq,   3, 2
+    SROW                  4, dstq + strideq*2, 3, 2
+    SROW                  4, dstq + stride3q,  3
+    RET
+
+cglobal vp9_ipred_hu_8x8, 3, 4, 5, dst, stride, l, stride3
+    movq                 m1, [lq]
+    pshufb               m0, m1, [pb_0to7_7]
+    pshufb               m2, m1, [pb_2to7_7]
+    pshufb               m1, [pb_1to7_7]
+    pavgb                m3, m0, m1
+    LOWPASS               4, 0, 1, 2
+    punpckhbw            m0, m3, m4
+    punpcklbw            m3, m4
+    palignr              m0, m3, 8
+    lea            stride3q, [strideq*3]
+    SROW                  8, dstq,             3, 2
+    SROW                  8, dstq + strideq,   3, 2
+    SROW                  8, dstq + strideq*2, 3, 2
+    SROW                  8, dstq + stride3q,  3
+    lea                dstq, [dstq + strideq*4]
+    SROW                  8, dstq,             0, 2
+    SROW                  8, dstq + strideq,   0, 2
+    SROW                  8, dstq + strideq*2, 0, 2
+    SROW                  8, dstq + stride3q,  0
+    RET
+
+cglobal vp9_ipred_hu_16x16, 3, 4, 7, dst, stride, l, cnt
+    movu                 m0, [lq]
+    pshufb               m6, m0, [pb_15]
+    palignr              m1, m6, m0, 1
+    palignr              m2, m6, m0, 2
+    pavgb                m3, m0, m1
+    LOWPASS               4, 0, 1, 2
+    punpckhbw            m1, m3, m4
+    punpcklbw            m3, m4
+    mov                cntd, 8
+.loop:
+    mova             [dstq], m3
+    palignr              m0, m1, m3, 2
+    palignr              m2, m6, m1, 2
+    mova   [dstq + strideq], m0
+    palignr              m3, m2, m0, 2
+    palignr              m1, m6, m2, 2
+    lea                dstq, [dstq + strideq*2]
+    dec                cntd
+    jg .loop
+    RET
+
+cglobal vp9_ipred_hu_32x32, 3, 4, 8, mmsize, dst, stride, l, cnt
+    movu                 m0, [lq]
+    movu                 m1, [lq + 16]
+    pshufb               m2, m1, [pb_15]
+    mova             [rsp], m2
+    palignr              m3, m1, m0, 1
+    palignr              m4, m1, m0, 2
+    pavgb                m5, m0, m3
+    LOWPASS               6, 0, 3, 4
+    punpckhbw            m7, m5, m6
+    punpcklbw            m5, m6
+    palignr              m3, m2, m1, 1
+    palignr              m4, m2, m1, 2
+    pavgb                m0, m1, m3
+    LOWPASS               6, 1, 3, 4
+    punpckhbw            m1, m0, m6
+    punpcklbw            m0, m6
+    mov                cntd, 16
+.loop:
+    mova             [dstq], m5
+    mova        [dstq + 16], m7
+    palignr              m2, m7, m5, 2
+    palignr              m3, m0, m7, 2
+    palignr              m4, m1, m0, 2
+    mova                 m6, [rsp]
+    palignr              m6, m1, 2
+    mova   [dstq + strideq], m2
+    mova [dstq + strideq + 16], m3
+    palignr              m5, m3, m2, 2
+    palignr              m7, m4, m3, 2
+    palignr              m0, m6, m4, 2
+    mova                 m1, [rsp]
+    palignr              m1, m6, 2
+    lea                dstq, [dstq + strideq*2]
+    dec                cntd
+    jg .loop
+    RET
+
+%if HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+DC_FUNCS                32, 5
+DC_FIXED_FUNCS          32
+V_FUNC                  32
+H_FUNC                  32
+TM_FUNC                 32
+%endif
@@ -0,0 +1,1105 @@
+;******************************************************************************
+;* VP9 inverse transform x86 SIMD optimizations
+;*
+;* This file is part of Libav.
+;*
+;* Libav is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* Libav is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with Libav; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;******************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION_RODATA 32
+
+pd_8192:            times 8 dd 8192
+pw_1:               times 16 dw 1
+pw_512:             times 16 dw 512
+pw_1024:            times 16 dw 1024
+pw_2048:            times 16 dw 2048
+
+; interleaved coefficient pairs for pmaddwd, named after their (even, odd)
+; word contents, so that pmaddwd(unpack(a, b), pw_X_Y) = a * X + b * Y
+%macro COEF_PAIR 2-3
+%if %0 == 3
+pw_%3:              times 8 dw %1, %2
+%else
+pw_%1_%2:           times 8 dw %1, %2
+%endif
+%endmacro
+
+COEF_PAIR  11585,  11585
+COEF_PAIR  11585, -11585, 11585_m11585
+COEF_PAIR -11585, -11585, m11585_m11585
+COEF_PAIR   6270,  15137
+COEF_PAIR  15137,   6270
+COEF_PAIR   6270, -15137, 6270_m15137
+COEF_PAIR  15137,  -6270, 15137_m6270
+COEF_PAIR -15137,  -6270, m15137_m6270
+COEF_PAIR   3196,  16069
+COEF_PAIR  16069,   3196
+COEF_PAIR   3196, -16069, 3196_m16069
+COEF_PAIR  16069,  -3196, 16069_m3196
+COEF_PAIR -16069,  -3196, m16069_m3196
+COEF_PAIR   9102,  13623
+COEF_PAIR  13623,   9102
+COEF_PAIR  13623,  -9102, 13623_m9102
+COEF_PAIR   9102, -13623, 9102_m13623
+COEF_PAIR  -9102, -13623, m9102_m13623
+
+; idct16/32 and iadst8/16 rotations
+COEF_PAIR   1606,  -16305, 1606_m16305
+COEF_PAIR  16305,   1606
+COEF_PAIR  12665,  -10394, 12665_m10394
+COEF_PAIR  10394,  12665
+COEF_PAIR   7723, -14449, 7723_m14449
+COEF_PAIR  14449,   7723
+COEF_PAIR  15679,  -4756, 15679_m4756
+COEF_PAIR   4756,  15679
+COEF_PAIR    804, -16364, 804_m16364
+COEF_PAIR  16364,    804
+COEF_PAIR  12140, -11003, 12140_m11003
+COEF_PAIR  11003,  12140
+COEF_PAIR   7005, -14811, 7005_m14811
+COEF_PAIR  14811,   7005
+COEF_PAIR  15426,  -5520, 15426_m5520
+COEF_PAIR   5520,  15426
+COEF_PAIR   3981, -15893, 3981_m15893
+COEF_PAIR  15893,   3981
+COEF_PAIR  14053,  -8423, 14053_m8423
+COEF_PAIR   8423,  14053
+COEF_PAIR   9760, -13160, 9760_m13160
+COEF_PAIR  13160,   9760
+COEF_PAIR  16207,  -2404, 16207_m2404
+COEF_PAIR   2404,  16207
+
+; iadst4
+COEF_PAIR   5283,  15212
+COEF_PAIR   9929,  13377
+COEF_PAIR   9929,  -5283, 9929_m5283
+COEF_PAIR -15212,  13377, m15212_13377
+COEF_PAIR  13377, -13377, 13377_m13377
+COEF_PAIR  13377,      0
+COEF_PAIR  15212,   9929
+COEF_PAIR  -5283, -13377, m5283_m13377
+
+SECTION .text
+
+; (a * X + b * Y + (1 << 13)) >> 14 for the interleaved coefficient pairs
+; %3 (result in %1) and %4 (result in %2), on full registers
+%macro VP9_MULSUB_2W 6 ; src/dst1, src/dst2, coef1, coef2, tmp1, tmp2
+    punpckhwd          m%5, m%1, m%2
+    punpcklwd          m%1, m%2
+    pmaddwd            m%2, m%1, [pw_%4]
+    pmaddwd            m%6, m%5, [pw_%4]
+    pmaddwd            m%1, [pw_%3]
+    pmaddwd            m%5, [pw_%3]
+    VP9_RND_SH_D       %1, %5, %2, %6
+    packssdw           m%1, m%5
+    packssdw           m%2, m%6
+%endmacro
+
+; same, but only on the low four words of each register
+%macro VP9_MULSUB_2W_4X 4 ; src/dst1, src/dst2, coef1, coef2
+    punpcklwd          m%1, m%2
+    pmaddwd            m%2, m%1, [pw_%4]
+    pmaddwd            m%1, [pw_%3]
+    VP9_RND_SH_D       %1, %2
+    packssdw           m%1, m%1
+    packssdw           m%2, m%2
+%endmacro
+
+%macro VP9_RND_SH_D 1-*
+%rep %0
+    paddd              m%1, [pd_8192]
+    psrad              m%1, 14
+%rotate 1
+%endrep
+%endmacro
+
+; %1 = (%1 - %2 + (1 << 13)) >> 14, %2 = (%1 + %2 + (1 << 13)) >> 14, on dwords
+%macro VP9_RND_SH_SUMSUB_D 2
+    paddd              m%1, [pd_8192]
+    psubd              m%1, m%2
+    paddd              m%2, m%2
+    paddd              m%2, m%1
+    psrad              m%1, 14
+    psrad              m%2, 14
+%endmacro
+
+; two rotations whose unrounded 32-bit products are summed/subtracted before
+; rounding, as in the first stages of the adst:
+; x1 = (a1, b1) * coef_x1, y1 = (a1, b1) * coef_y1 (same for x2 and y2), then
+; %4 = y1 + y2, %2 = y1 - y2, %3 = x1 + x2, %1 = x1 - x2
+%macro VP9_MULSUB_SUMSUB_2X 12 ; a1, b1, a2, b2, coef_x1, coef_y1, coef_x2, coef_y2, tmp1-4
+    punpckhwd          m%9,  m%1, m%2
+    punpcklwd          m%1,  m%2
+    punpckhwd          m%10, m%3, m%4
+    punpcklwd          m%3,  m%4
+    pmaddwd            m%2,  m%1,  [pw_%6]
+    pmaddwd            m%11, m%9,  [pw_%6]
+    pmaddwd            m%1,  [pw_%5]
+    pmaddwd            m%9,  [pw_%5]
+    pmaddwd            m%4,  m%3,  [pw_%8]
+    pmaddwd            m%12, m%10, [pw_%8]
+    pmaddwd            m%3,  [pw_%7]
+    pmaddwd            m%10, [pw_%7]
+    VP9_RND_SH_SUMSUB_D %2,  %4
+    VP9_RND_SH_SUMSUB_D %11, %12
+    VP9_RND_SH_SUMSUB_D %1,  %3
+    VP9_RND_SH_SUMSUB_D %9,  %10
+    packssdw           m%4, m%12
+    packssdw           m%2, m%11
+    packssdw           m%3, m%10
+    packssdw           m%1, m%9
+%endmacro
+
+; %1 = %1 + %2, %2 = %1 - %2
+%macro VP9_SUMSUB 3 ; src/dst1, src/dst2, tmp
+    psubw              m%3, m%1, m%2
+    paddw              m%1, m%2
+    SWAP               %2, %3
+%endmacro
+
+; %1 = -%1
+%macro VP9_NEG 2 ; src/dst, tmp
+    pxor               m%2, m%2
+    psubw              m%2, m%1
+    SWAP               %1, %2
+%endmacro
+
+; scratch slots on the stack, one register wide each
+%define SLOT(x) [rsp + (x) * mmsize]
+
+; %1 = %1 + SLOT(%2), SLOT(%2) = %1 - SLOT(%2)
+%macro VP9_SUMSUB_SLOT 4 ; src/dst, slot, tmp1, tmp2
+    mova               m%3, SLOT(%2)
+    psubw              m%4, m%1, m%3
+    paddw              m%1, m%3
+    mova          SLOT(%2), m%4
+%endmacro
+
+; SLOT(%2) = SLOT(%2) + %1, %1 = SLOT(%2) - %1
+%macro VP9_SLOT_SUMSUB 4 ; src/dst, slot, tmp1, tmp2
+    mova               m%3, SLOT(%2)
+    psubw              m%4, m%3, m%1
+    paddw              m%1, m%3
+    mova          SLOT(%2), m%1
+    SWAP               %1, %4
+%endmacro
+
+; (x + (1 << (bits - 1))) >> bits
+%macro VP9_ROUND 2 ; reg, bits
+%if cpuflag(ssse3)
+%if %2 == 4
+    pmulhrsw           m%1, [pw_2048]
+%elif %2 == 5
+    pmulhrsw           m%1, [pw_1024]
+%else
+    pmulhrsw           m%1, [pw_512]
+%endif
+%else
+    psraw              m%1, %2 - 1
+    paddw              m%1, [pw_1]
+    psraw              m%1, 1
+%endif
+%endmacro
+
+;-------------------------------------------------------------------------------
+; 1D transforms
+;-------------------------------------------------------------------------------
+
+; in/out: m0-3 (low 4 words), tmp: m4
+%macro VP9_IDCT4_1D 0
+    VP9_MULSUB_2W_4X    0, 2, 11585_m11585, 11585_11585 ; m0=t1, m2=t0
+    VP9_MULSUB_2W_4X    1, 3, 6270_m15137, 15137_6270   ; m1=t2, m3=t3
+    VP9_SUMSUB          2, 3, 4                         ; m2=out0, m3=out3
+    VP9_SUMSUB          0, 1, 4                         ; m0=out1, m1=out2
+    SWAP                0, 2
+    SWAP                1, 2
+%endmacro
+
+; in/out: m0-3 (low 4 words), tmp: m4-7
+%macro VP9_IADST4_1D 0
+    punpcklwd           m0, m2
+    punpcklwd           m3, m1
+    pmaddwd             m4, m0, [pw_5283_15212]
+    pmaddwd             m5, m3, [pw_9929_13377]
+    pmaddwd             m6, m0, [pw_9929_m5283]
+    pmaddwd             m7, m3, [pw_m15212_13377]
+    paddd               m4, m5                          ; out0
+    paddd               m6, m7                          ; out1
+    pmaddwd             m5, m0, [pw_13377_m13377]
+    pmaddwd             m7, m3, [pw_13377_0]
+    pmaddwd             m0, [pw_15212_9929]
+    pmaddwd             m3, [pw_m5283_m13377]
+    paddd               m5, m7                          ; out2
+    paddd               m3, m0                          ; out3
+    VP9_RND_SH_D        4, 6, 5, 3
+    packssdw            m4, m4
+    packssdw            m6, m6
+    packssdw            m5, m5
+    packssdw            m3, m3
+    SWAP                0, 4
+    SWAP                1, 6
+    SWAP                2, 5
+%endmacro
+
+; in/out: m0-3 (low 4 words), tmp: m4-5
+%macro VP9_IWHT4_1D 0
+    paddw               m0, m1                          ; t0
+    psubw               m2, m3                          ; t3
+    psubw               m4, m0, m2
+    psraw               m4, 1                           ; t4
+    psubw               m5, m4, m3                      ; t1
+    psubw               m4, m1                          ; t2
+    psubw               m0, m5
+    paddw               m2, m4
+    SWAP                1, 5
+    SWAP                2, 4
+    SWAP                3, 4
+%endmacro
+
+; in/out: m0-7, tmp: m8-9
+%macro VP9_IDCT8_1D 0
+    VP9_MULSUB_2W       0, 4, 11585_m11585, 11585_11585, 8, 9 ; m0=t1a, m4=t0a
+    VP9_MULSUB_2W       2, 6, 6270_m15137, 15137_6270, 8, 9   ; m2=t2a, m6=t3a
+    VP9_MULSUB_2W       1, 7, 3196_m16069, 16069_3196, 8, 9   ; m1=t4a, m7=t7a
+    VP9_MULSUB_2W       5, 3, 13623_m9102, 9102_13623, 8, 9   ; m5=t5a, m3=t6a
+    VP9_SUMSUB          4, 6, 8                               ; m4=t0, m6=t3
+    VP9_SUMSUB          0, 2, 8                               ; m0=t1, m2=t2
+    VP9_SUMSUB          1, 5, 8                               ; m1=t4, m5=t5a
+    VP9_SUMSUB          7, 3, 8                               ; m7=t7, m3=t6a
+    VP9_MULSUB_2W       3, 5, 11585_m11585, 11585_11585, 8, 9 ; m3=t5, m5=t6
+    VP9_SUMSUB          4, 7, 8                               ; m4=out0, m7=out7
+    VP9_SUMSUB          0, 5, 8                               ; m0=out1, m5=out6
+    VP9_SUMSUB          2, 3, 8                               ; m2=out2, m3=out5
+    VP9_SUMSUB          6, 1, 8                               ; m6=out3, m1=out4
+    SWAP                0, 4
+    SWAP                1, 4
+    SWAP                3, 6
+    SWAP                5, 6
+%endmacro
+
+; in/out: m0-7, tmp: m8-11
+%macro VP9_IADST8_1D 0
+    VP9_MULSUB_SUMSUB_2X 7, 0, 3, 4, 1606_m16305, 16305_1606, \
+                         12665_m10394, 10394_12665, 8, 9, 10, 11 ; m4=t0, m0=t4, m3=t1, m7=t5
+    VP9_MULSUB_SUMSUB_2X 5, 2, 1, 6, 7723_m14449, 14449_7723, \
+                         15679_m4756, 4756_15679, 8, 9, 10, 11   ; m6=t2, m2=t6, m1=t3, m5=t7
+    VP9_MULSUB_SUMSUB_2X 0, 7, 5, 2, 6270_m15137, 15137_6270, \
+                         6270_15137, 15137_m6270, 8, 9, 10, 11   ; m2=-out1, m7=t6, m5=out6, m0=t7
+    VP9_SUMSUB          4, 6, 8                                  ; m4=out0, m6=t2
+    VP9_SUMSUB          3, 1, 8                                  ; m3=-out7, m1=t3
+    VP9_MULSUB_2W       6, 1, 11585_m11585, 11585_11585, 8, 9    ; m6=out4, m1=-out3
+    VP9_MULSUB_2W       7, 0, 11585_m11585, 11585_11585, 8, 9    ; m7=-out5, m0=out2
+    VP9_NEG             2, 8
+    VP9_NEG             3, 8
+    VP9_NEG             1, 8
+    VP9_NEG             7, 8
+    SWAP                0, 4
+    SWAP                1, 2
+    SWAP                2, 4
+    SWAP                3, 4
+    SWAP                4, 6
+    SWAP                5, 7
+    SWAP                6, 7
+%endmacro
+
+; in: 16 rows at %1 + n * %2
+; out: out0-7 in m0-7, out8-15 in SLOT(8-15)
+%macro VP9_IDCT16_1D 2 ; src, stride
+    mova                m0, [%1 +  1 * %2]
+    mova                m1, [%1 + 15 * %2]
+    mova                m2, [%1 +  9 * %2]
+    mova                m3, [%1 +  7 * %2]
+    mova                m4, [%1 +  5 * %2]
+    mova                m5, [%1 + 11 * %2]
+    mova                m6, [%1 + 13 * %2]
+    mova                m7, [%1 +  3 * %2]
+    VP9_MULSUB_2W       0, 1, 1606_m16305, 16305_1606, 8, 9     ; m0=t8a, m1=t15a
+    VP9_MULSUB_2W       2, 3, 12665_m10394, 10394_12665, 8, 9   ; m2=t9a, m3=t14a
+    VP9_MULSUB_2W       4, 5, 7723_m14449, 14449_7723, 8, 9     ; m4=t10a, m5=t13a
+    VP9_MULSUB_2W       6, 7, 15679_m4756, 4756_15679, 8, 9     ; m6=t11a, m7=t12a
+    VP9_SUMSUB          0, 2, 8                                 ; m0=t8, m2=t9
+    VP9_SUMSUB          6, 4, 8                                 ; m6=t11, m4=t10
+    VP9_SUMSUB          7, 5, 8                                 ; m7=t12, m5=t13
+    VP9_SUMSUB          1, 3, 8                                 ; m1=t15, m3=t14
+    VP9_MULSUB_2W       3, 2, 6270_m15137, 15137_6270, 8, 9     ; m3=t9a, m2=t14a
+    VP9_MULSUB_2W       5, 4, m15137_m6270, 6270_m15137, 8, 9   ; m5=t10a, m4=t13a
+    VP9_SUMSUB          0, 6, 8                                 ; m0=t8a, m6=t11a
+    VP9_SUMSUB          3, 5, 8                                 ; m3=t9, m5=t10
+    VP9_SUMSUB          2, 4, 8                                 ; m2=t14, m4=t13
+    VP9_SUMSUB          1, 7, 8                                 ; m1=t15a, m7=t12a
+    VP9_MULSUB_2W       4, 5, 11585_m11585, 11585_11585, 8, 9   ; m4=t10a, m5=t13a
+    VP9_MULSUB_2W       7, 6, 11585_m11585, 11585_11585, 8, 9   ; m7=t11, m6=t12
+    mova          SLOT(8), m0
+    mova          SLOT(9), m3
+    mova         SLOT(10), m4
+    mova         SLOT(11), m7
+    mova         SLOT(12), m6
+    mova         SLOT(13), m5
+    mova         SLOT(14), m2
+    mova         SLOT(15), m1
+
+    mova                m0, [%1 +  0 * %2]
+    mova                m1, [%1 +  2 * %2]
+    mova                m2, [%1 +  4 * %2]
+    mova                m3, [%1 +  6 * %2]
+    mova                m4, [%1 +  8 * %2]
+    mova                m5, [%1 + 10 * %2]
+    mova                m6, [%1 + 12 * %2]
+    mova                m7, [%1 + 14 * %2]
+    VP9_IDCT8_1D
+    VP9_SUMSUB_SLOT     0, 15, 8, 9
+    VP9_SUMSUB_SLOT     1, 14, 8, 9
+    VP9_SUMSUB_SLOT     2, 13, 8, 9
+    VP9_SUMSUB_SLOT     3, 12, 8, 9
+    VP9_SUMSUB_SLOT     4, 11, 8, 9
+    VP9_SUMSUB_SLOT     5, 10, 8, 9
+    VP9_SUMSUB_SLOT     6,  9, 8, 9
+    VP9_SUMSUB_SLOT     7,  8, 8, 9
+%endmacro
+
+; in: 16 rows at %1 + n * %2
+; out: out0-7 in m0-7, out8-15 in SLOT(8-15), uses SLOT(0-7) as scratch
+%macro VP9_IADST16_1D 2 ; src, stride
+    mova                m0, [%1 + 15 * %2]
+    mova                m1, [%1 +  0 * %2]
+    mova                m2, [%1 +  7 * %2]
+    mova                m3, [%1 +  8 * %2]
+    VP9_MULSUB_SUMSUB_2X 0, 1, 2, 3, 804_m16364, 16364_804, \
+                         12140_m11003, 11003_12140, 4, 5, 6, 7  ; m3=t0a, m1=t8a, m2=t1a, m0=t9a
+    mova          SLOT(0), m3
+    mova          SLOT(1), m2
+    SWAP                1, 8
+    SWAP                0, 9
+
+    mova                m0, [%1 + 13 * %2]
+    mova                m1, [%1 +  2 * %2]
+    mova                m2, [%1 +  5 * %2]
+    mova                m3, [%1 + 10 * %2]
+    VP9_MULSUB_SUMSUB_2X 0, 1, 2, 3, 3981_m15893, 15893_3981, \
+                         14053_m8423, 8423_14053, 4, 5, 6, 7    ; m3=t2a, m1=t10a, m2=t3a, m0=t11a
+    mova          SLOT(2), m3
+    mova          SLOT(3), m2
+    SWAP                1, 10
+    SWAP                0, 11
+
+    mova                m0, [%1 + 11 * %2]
+    mova                m1, [%1 +  4 * %2]
+    mova                m2, [%1 +  3 * %2]
+    mova                m3, [%1 + 12 * %2]
+    VP9_MULSUB_SUMSUB_2X 0, 1, 2, 3, 7005_m14811, 14811_7005, \
+                         15426_m5520, 5520_15426, 4, 5, 6, 7    ; m3=t4a, m1=t12a, m2=t5a, m0=t13a
+    mova          SLOT(4), m3
+    mova          SLOT(5), m2
+    SWAP                1, 12
+    SWAP                0, 13
+
+    mova                m0, [%1 +  9 * %2]
+    mova                m1, [%1 +  6 * %2]
+    mova                m2, [%1 +  1 * %2]
+    mova                m3, [%1 + 14 * %2]
+    VP9_MULSUB_SUMSUB_2X 0, 1, 2, 3, 9760_m13160, 13160_9760, \
+                         16207_m2404, 2404_16207, 4, 5, 6, 7    ; m3=t6a, m1=t14a, m2=t7a, m0=t15a
+    mova          SLOT(6), m3
+    mova          SLOT(7), m2
+    SWAP                1, 14
+    SWAP                0, 15
+
+    VP9_MULSUB_SUMSUB_2X 8, 9, 13, 12, 3196_m16069, 16069_3196, \
+                         3196_16069, 16069_m3196, 0, 1, 2, 3    ; m12=t8a, m9=t12a, m13=t9a, m8=t13a
+    VP9_MULSUB_SUMSUB_2X 10, 11, 15, 14, 13623_m9102, 9102_13623, \
+                         13623_9102, 9102_m13623, 0, 1, 2, 3    ; m14=t10a, m11=t14a, m15=t11a, m10=t15a
+    VP9_MULSUB_SUMSUB_2X 9, 8, 10, 11, 6270_m15137, 15137_6270, \
+                         6270_15137, 15137_m6270, 0, 1, 2, 3    ; m11=out2, m8=t14a, m10=-out13, m9=t15a
+    VP9_SUMSUB          12, 14, 0                               ; m12=-out1, m14=t10
+    VP9_SUMSUB          13, 15, 0                               ; m13=out14, m15=t11
+    VP9_MULSUB_2W       15, 14, 11585_m11585, 11585_11585, 0, 1 ; m15=out9, m14=out6
+    VP9_MULSUB_2W       8, 9, 11585_m11585, m11585_m11585, 0, 1 ; m8=out10, m9=out5
+    VP9_NEG             12, 0
+    VP9_NEG             10, 0
+    mova          SLOT(9), m15
+    mova         SLOT(10), m8
+    mova         SLOT(13), m10
+    mova         SLOT(14), m13
+    SWAP                12, 15                                  ; m15=out1
+    SWAP                11, 14                                  ; m14=out2, m11=out6
+    SWAP                9, 13                                   ; m13=out5
+    SWAP                11, 12                                  ; m12=out6
+
+    mova                m0, SLOT(0)
+    mova                m1, SLOT(1)
+    mova                m2, SLOT(2)
+    mova                m3, SLOT(3)
+    mova                m4, SLOT(4)
+    mova                m5, SLOT(5)
+    mova                m6, SLOT(6)
+    mova                m7, SLOT(7)
+    VP9_SUMSUB          0, 4, 8                                 ; m0=t0, m4=t4
+    VP9_SUMSUB          1, 5, 8                                 ; m1=t1, m5=t5
+    VP9_SUMSUB          2, 6, 8                                 ; m2=t2, m6=t6
+    VP9_SUMSUB          3, 7, 8                                 ; m3=t3, m7=t7
+    VP9_MULSUB_SUMSUB_2X 4, 5, 7, 6, 6270_m15137, 15137_6270, \
+                         6270_15137, 15137_m6270, 8, 9, 10, 11  ; m6=-out3, m5=t6, m7=out12, m4=t7
+    VP9_SUMSUB          0, 2, 8                                 ; m0=out0, m2=t2a
+    VP9_SUMSUB          1, 3, 8                                 ; m1=-out15, m3=t3a
+    VP9_MULSUB_2W       2, 3, 11585_m11585, m11585_m11585, 8, 9 ; m2=out8, m3=out7
+    VP9_MULSUB_2W       4, 5, 11585_m11585, 11585_11585, 8, 9   ; m4=out11, m5=out4
+    VP9_NEG             6, 8
+    VP9_NEG             1, 8
+    mova          SLOT(8), m2
+    mova         SLOT(11), m4
+    mova         SLOT(12), m7
+    mova         SLOT(15), m1
+    SWAP                1, 15                                   ; m1=out1
+    SWAP                2, 14                                   ; m2=out2
+    SWAP                4, 5                                    ; m4=out4
+    SWAP                5, 13                                   ; m5=out5
+    SWAP                7, 3                                    ; m7=out7
+    SWAP                3, 6                                    ; m3=out3
+    SWAP                6, 12                                   ; m6=out6
+%endmacro
+
+; in: 32 rows at %1 + n * %2
+; out: SLOT(0-31)
+%macro VP9_IDCT32_1D 2 ; src, stride
+    mova                m0, [%1 +  1 * %2]
+    mova                m1, [%1 + 31 * %2]
+    mova                m2, [%1 + 17 * %2]
+    mova                m3, [%1 + 15 * %2]
+    mova                m4, [%1 +  9 * %2]
+    mova                m5, [%1 + 23 * %2]
+    mova                m6, [%1 + 25 * %2]
+    mova                m7, [%1 +  7 * %2]
+    VP9_MULSUB_2W       0, 1, 804_m16364, 16364_804, 8, 9       ; m0=t16a, m1=t31a
+    VP9_MULSUB_2W       2, 3, 12140_m11003, 11003_12140, 8, 9   ; m2=t17a, m3=t30a
+    VP9_MULSUB_2W       4, 5, 7005_m14811, 14811_7005, 8, 9     ; m4=t18a, m5=t29a
+    VP9_MULSUB_2W       6, 7, 15426_m5520, 5520_15426, 8, 9     ; m6=t19a, m7=t28a
+    VP9_SUMSUB          0, 2, 8                                 ; m0=t16, m2=t17
+    VP9_SUMSUB          6, 4, 8                                 ; m6=t19, m4=t18
+    VP9_SUMSUB          7, 5, 8                                 ; m7=t28, m5=t29
+    VP9_SUMSUB          1, 3, 8                                 ; m1=t31, m3=t30
+    VP9_MULSUB_2W       3, 2, 3196_m16069, 16069_3196, 8, 9     ; m3=t17a, m2=t30a
+    VP9_MULSUB_2W       5, 4, m16069_m3196, 3196_m16069, 8, 9   ; m5=t18a, m4=t29a
+    VP9_SUMSUB          0, 6, 8                                 ; m0=t16a, m6=t19a
+    VP9_SUMSUB          3, 5, 8                                 ; m3=t17, m5=t18
+    VP9_SUMSUB          2, 4, 8                                 ; m2=t30, m4=t29
+    VP9_SUMSUB          1, 7, 8                                 ; m1=t31a, m7=t28a
+    VP9_MULSUB_2W       4, 5, 6270_m15137, 15137_6270, 8, 9     ; m4=t18a, m5=t29a
+    VP9_MULSUB_2W       7, 6, 6270_m15137, 15137_6270, 8, 9     ; m7=t19, m6=t28
+    mova         SLOT(16), m0
+    mova         SLOT(17), m3
+    mova         SLOT(18), m4
+    mova         SLOT(19), m7
+    mova         SLOT(28), m6
+    mova         SLOT(29), m5
+    mova         SLOT(30), m2
+    mova         SLOT(31), m1
+
+    mova                m0, [%1 +  5 * %2]
+    mova                m1, [%1 + 27 * %2]
+    mova                m2, [%1 + 21 * %2]
+    mova                m3, [%1 + 11 * %2]
+    mova                m4, [%1 + 13 * %2]
+    mova                m5, [%1 + 19 * %2]
+    mova                m6, [%1 + 29 * %2]
+    mova                m7, [%1 +  3 * %2]
+    VP9_MULSUB_2W       0, 1, 3981_m15893, 15893_3981, 8, 9     ; m0=t20a, m1=t27a
+    VP9_MULSUB_2W       2, 3, 14053_m8423, 8423_14053, 8, 9     ; m2=t21a, m3=t26a
+    VP9_MULSUB_2W       4, 5, 9760_m13160, 13160_9760, 8, 9     ; m4=t22a, m5=t25a
+    VP9_MULSUB_2W       6, 7, 16207_m2404, 2404_16207, 8, 9     ; m6=t23a, m7=t24a
+    VP9_SUMSUB          0, 2, 8                                 ; m0=t20, m2=t21
+    VP9_SUMSUB          6, 4, 8                                 ; m6=t23, m4=t22
+    VP9_SUMSUB          7, 5, 8                                 ; m7=t24, m5=t25
+    VP9_SUMSUB          1, 3, 8                                 ; m1=t27, m3=t26
+    VP9_MULSUB_2W       3, 2, 13623_m9102, 9102_13623, 8, 9     ; m3=t21a, m2=t26a
+    VP9_MULSUB_2W       5, 4, m9102_m13623, 13623_m9102, 8, 9   ; m5=t22a, m4=t25a
+    VP9_SUMSUB          6, 0, 8                                 ; m6=t23a, m0=t20a
+    VP9_SUMSUB          5, 3, 8                                 ; m5=t22, m3=t21
+    VP9_SUMSUB          7, 1, 8                                 ; m7=t24a, m1=t27a
+    VP9_SUMSUB          4, 2, 8                                 ; m4=t25, m2=t26
+    VP9_MULSUB_2W       1, 0, m15137_m6270, 6270_m15137, 8, 9   ; m1=t20, m0=t27
+    VP9_MULSUB_2W       2, 3, m15137_m6270, 6270_m15137, 8, 9   ; m2=t21a, m3=t26a
+
+    VP9_SLOT_SUMSUB     6, 16, 8, 9                             ; SLOT16=t16,  m6=t23
+    VP9_SLOT_SUMSUB     5, 17, 8, 9                             ; SLOT17=t17a, m5=t22a
+    VP9_SLOT_SUMSUB     2, 18, 8, 9                             ; SLOT18=t18,  m2=t21
+    VP9_SLOT_SUMSUB     1, 19, 8, 9                             ; SLOT19=t19a, m1=t20a
+    VP9_SLOT_SUMSUB     7, 31, 8, 9                             ; SLOT31=t31,  m7=t24
+    VP9_SLOT_SUMSUB     4, 30, 8, 9                             ; SLOT30=t30a, m4=t25a
+    VP9_SLOT_SUMSUB     3, 29, 8, 9                             ; SLOT29=t29,  m3=t26
+    VP9_SLOT_SUMSUB     0, 28, 8, 9                             ; SLOT28=t28a, m0=t27a
+    VP9_MULSUB_2W       0, 1, 11585_m11585, 11585_11585, 8, 9   ; m0=t20, m1=t27
+    VP9_MULSUB_2W       3, 2, 11585_m11585, 11585_11585, 8, 9   ; m3=t21a, m2=t26a
+    VP9_MULSUB_2W       4, 5, 11585_m11585, 11585_11585, 8, 9   ; m4=t22, m5=t25
+    VP9_MULSUB_2W       7, 6, 11585_m11585, 11585_11585, 8, 9   ; m7=t23a, m6=t24a
+    mova         SLOT(20), m0
+    mova         SLOT(21), m3
+    mova         SLOT(22), m4
+    mova         SLOT(23), m7
+    mova         SLOT(24), m6
+    mova         SLOT(25), m5
+    mova         SLOT(26), m2
+    mova         SLOT(27), m1
+
+    VP9_IDCT16_1D       %1, 2 * %2
+    VP9_SUMSUB_SLOT     0, 31, 8, 9
+    VP9_SUMSUB_SLOT     1, 30, 8, 9
+    VP9_SUMSUB_SLOT     2, 29, 8, 9
+    VP9_SUMSUB_SLOT     3, 28, 8, 9
+    VP9_SUMSUB_SLOT     4, 27, 8, 9
+    VP9_SUMSUB_SLOT     5, 26, 8, 9
+    VP9_SUMSUB_SLOT     6, 25, 8, 9
+    VP9_SUMSUB_SLOT     7, 24, 8, 9
+    mova          SLOT(0), m0
+    mova          SLOT(1), m1
+    mova          SLOT(2), m2
+    mova          SLOT(3), m3
+    mova          SLOT(4), m4
+    mova          SLOT(5), m5
+    mova          SLOT(6), m6
+    mova          SLOT(7), m7
+%assign %%i 8
+%rep 8
+    mova                m0, SLOT(%%i)
+    VP9_SUMSUB_SLOT     0, 31 - %%i, 8, 9
+    mova         SLOT(%%i), m0
+%assign %%i %%i+1
+%endrep
+%endmacro
+
+%macro VP9_1D 2-4 ; type, size, [src, stride]
+%ifidn %1, idct
+%if %2 == 4
+    VP9_IDCT4_1D
+%elif %2 == 8
+    VP9_IDCT8_1D
+%else
+    VP9_IDCT16_1D       %3, %4
+%endif
+%else
+%if %2 == 4
+    VP9_IADST4_1D
+%elif %2 == 8
+    VP9_IADST8_1D
+%else
+    VP9_IADST16_1D      %3, %4
+%endif
+%endif
+%endmacro
+
+;-------------------------------------------------------------------------------
+; dc-only (eob == 1) inverse dct
+;-------------------------------------------------------------------------------
+
+; m0 = positive part of the dc offset, m1 = negative part, as bytes
+%macro VP9_IDCT_DC_LOAD 2 ; bits, tmp gpr
+    movsx              %2d, word [blockq]
+    imul               %2d, 11585
+    add                %2d, 8192
+    sar                %2d, 14
+    imul               %2d, 11585
+    add                %2d, 8192 + (1 << (13 + %1))
+    sar                %2d, 14 + %1
+    mov        word [blockq], 0
+    movd               xm0, %2d
+%if mmsize == 32
+    vpbroadcastw        m0, xm0
+%else
+    pshuflw             m0, m0, q0000
+    punpcklqdq          m0, m0
+%endif
+    pxor                m1, m1
+    psubw               m1, m0
+    packuswb            m0, m0
+    packuswb            m1, m1
+%endmacro
+
+;-------------------------------------------------------------------------------
+; void vp9_<type_a>_<type_b>_<sz>x<sz>_add_<opt>(uint8_t *dst, ptrdiff_t stride,
+;                                               int16_t *block, int eob);
+;-------------------------------------------------------------------------------
+
+%macro VP9_ITXFM_4x4 2 ; type_a, type_b
+cglobal vp9_%1_%2_4x4_add, 4, 5, 8, dst, stride, block, eob, cnt
+%ifidn %1_%2, idct_idct
+    cmp               eobd, 1
+    jg .full
+    VP9_IDCT_DC_LOAD    4, cnt
+    lea               cntq, [strideq * 3]
+    movd                m2, [dstq]
+    movd                m3, [dstq + strideq]
+    movd                m4, [dstq + strideq * 2]
+    movd                m5, [dstq + cntq]
+    punpckldq           m2, m3
+    punpckldq           m4, m5
+    punpcklqdq          m2, m4
+    paddusb             m2, m0
+    psubusb             m2, m1
+    movd            [dstq], m2
+    psrldq              m2, 4
+    movd  [dstq + strideq], m2
+    psrldq              m2, 4
+    movd [dstq + strideq * 2], m2
+    psrldq              m2, 4
+    movd     [dstq + cntq], m2
+    RET
+.full:
+%endif
+    movq                m0, [blockq +  0]
+    movq                m1, [blockq +  8]
+    movq                m2, [blockq + 16]
+    movq                m3, [blockq + 24]
+    VP9_1D              %1, 4
+    ; transpose
+    punpcklwd           m0, m1
+    punpcklwd           m2, m3
+    punpckhdq           m1, m0, m2
+    punpckldq           m0, m2
+    punpckhqdq          m3, m1, m1
+    punpckhqdq          m4, m0, m0
+    SWAP                1, 4
+    SWAP                2, 4
+    VP9_1D              %2, 4
+    VP9_ROUND           0, 4
+    VP9_ROUND           1, 4
+    VP9_ROUND           2, 4
+    VP9_ROUND           3, 4
+    pxor                m4, m4
+    mova  [blockq +  0], m4
+    mova  [blockq + 16], m4
+    VP9_ADD_4x4         4
+    RET
+%endmacro
+
+; add the low four words of m0-3 to a 4x4 block of pixels at dstq
+%macro VP9_ADD_4x4 1 ; zero reg
+    lea               cntq, [strideq * 3]
+    punpcklqdq          m0, m1
+    punpcklqdq          m2, m3
+    movd                m1, [dstq]
+    movd                m3, [dstq + strideq]
+    movd                m5, [dstq + strideq * 2]
+    movd                m6, [dstq + cntq]
+    punpckldq           m1, m3
+    punpckldq           m5, m6
+    punpcklbw           m1, m%1
+    punpcklbw           m5, m%1
+    paddw               m0, m1
+    paddw               m2, m5
+    packuswb            m0, m2
+    movd            [dstq], m0
+    psrldq              m0, 4
+    movd  [dstq + strideq], m0
+    psrldq              m0, 4
+    movd [dstq + strideq * 2], m0
+    psrldq              m0, 4
+    movd     [dstq + cntq], m0
+%endmacro
+
+%macro VP9_ITXFM_4x4_FUNCS 0
+VP9_ITXFM_4x4 idct,  idct
+VP9_ITXFM_4x4 iadst, idct
+VP9_ITXFM_4x4 idct,  iadst
+VP9_ITXFM_4x4 iadst, iadst
+%endmacro
+
+INIT_XMM sse2
+VP9_ITXFM_4x4_FUNCS
+INIT_XMM ssse3
+VP9_ITXFM_4x4_FUNCS
+
+INIT_XMM sse2
+cglobal vp9_iwht_iwht_4x4_add, 4, 5, 8, dst, stride, block, eob, cnt
+    movq                m0, [blockq +  0]
+    movq                m1, [blockq +  8]
+    movq                m2, [blockq + 16]
+    movq                m3, [blockq + 24]
+    psraw               m0, 2
+    psraw               m1, 2
+    psraw               m2, 2
+    psraw               m3, 2
+    VP9_IWHT4_1D
+    punpcklwd           m0, m1
+    punpcklwd           m2, m3
+    punpckhdq           m1, m0, m2
+    punpckldq           m0, m2
+    punpckhqdq          m3, m1, m1
+    punpckhqdq          m4, m0, m0
+    SWAP                1, 4
+    SWAP                2, 4
+    VP9_IWHT4_1D
+    pxor                m4, m4
+    mova  [blockq +  0], m4
+    mova  [blockq + 16], m4
+    VP9_ADD_4x4         4
+    RET
+
+%if ARCH_X86_64
+
+; add the full-width rows in m%1 to the pixels at ptrq, and advance ptrq
+%macro VP9_ADD_ROW 3 ; src, tmp, zero
+%if mmsize == 32
+    pmovzxbw           m%2, [ptrq]
+    paddw              m%1, m%2
+    vextracti128      xm%2, m%1, 1
+    packuswb          xm%1, xm%2
+    mova            [ptrq], xm%1
+%else
+    movh               m%2, [ptrq]
+    punpcklbw          m%2, m%3
+    paddw              m%1, m%2
+    packuswb           m%1, m%1
+    movh            [ptrq], m%1
+%endif
+    add               ptrq, strideq
+%endmacro
+
+; transpose m0-7 as 8x8 word blocks, and store the result at %1 with row
+; stride %2; for ymm, the high lane is stored 8 rows further down
+%macro VP9_TRANSPOSE_STORE 2 ; dst, stride
+    TRANSPOSE8x8W        0, 1, 2, 3, 4, 5, 6, 7, 8
+%if mmsize == 32
+    mova   [%1 + 0 * %2], xm0
+    mova   [%1 + 1 * %2], xm1
+    mova   [%1 + 2 * %2], xm2
+    mova   [%1 + 3 * %2], xm3
+    mova   [%1 + 4 * %2], xm4
+    mova   [%1 + 5 * %2], xm5
+    mova   [%1 + 6 * %2], xm6
+    mova   [%1 + 7 * %2], xm7
+    vextracti128  [%1 +  8 * %2], m0, 1
+    vextracti128  [%1 +  9 * %2], m1, 1
+    vextracti128  [%1 + 10 * %2], m2, 1
+    vextracti128  [%1 + 11 * %2], m3, 1
+    vextracti128  [%1 + 12 * %2], m4, 1
+    vextracti128  [%1 + 13 * %2], m5, 1
+    vextracti128  [%1 + 14 * %2], m6, 1
+    vextracti128  [%1 + 15 * %2], m7, 1
+%else
+    mova   [%1 + 0 * %2], m0
+    mova   [%1 + 1 * %2], m1
+    mova   [%1 + 2 * %2], m2
+    mova   [%1 + 3 * %2], m3
+    mova   [%1 + 4 * %2], m4
+    mova   [%1 + 5 * %2], m5
+    mova   [%1 + 6 * %2], m6
+    mova   [%1 + 7 * %2], m7
+%endif
+%endmacro
+
+%macro VP9_LOAD_SLOTS 1 ; first slot
+    mova                m0, SLOT(%1 + 0)
+    mova                m1, SLOT(%1 + 1)
+    mova                m2, SLOT(%1 + 2)
+    mova                m3, SLOT(%1 + 3)
+    mova                m4, SLOT(%1 + 4)
+    mova                m5, SLOT(%1 + 5)
+    mova                m6, SLOT(%1 + 6)
+    mova                m7, SLOT(%1 + 7)
+%endmacro
+
+%macro VP9_ITXFM_8x8 2 ; type_a, type_b
+cglobal vp9_%1_%2_8x8_add, 4, 6, 12, dst, stride, block, eob, cnt, ptr
+%ifidn %1_%2, idct_idct
+    cmp               eobd, 1
+    jg .full
+    VP9_IDCT_DC_LOAD    5, cnt
+    mov               cntd, 4
+.dc_loop:
+    movh                m2, [dstq]
+    movhps              m2, [dstq + strideq]
+    paddusb             m2, m0
+    psubusb             m2, m1
+    movh            [dstq], m2
+    movhps [dstq + strideq], m2
+    lea               dstq, [dstq + strideq * 2]
+    dec               cntd
+    jg .dc_loop
+    RET
+.full:
+%endif
+    mova                m0, [blockq +   0]
+    mova                m1, [blockq +  16]
+    mova                m2, [blockq +  32]
+    mova                m3, [blockq +  48]
+    mova                m4, [blockq +  64]
+    mova                m5, [blockq +  80]
+    mova                m6, [blockq +  96]
+    mova                m7, [blockq + 112]
+    VP9_1D              %1, 8
+    TRANSPOSE8x8W        0, 1, 2, 3, 4, 5, 6, 7, 8
+    VP9_1D              %2, 8
+    pxor               m10, m10
+%assign %%i 0
+%rep 8
+    mova [blockq + %%i * 16], m10
+%assign %%i %%i+1
+%endrep
+    VP9_ROUND           0, 5
+    VP9_ROUND           1, 5
+    VP9_ROUND           2, 5
+    VP9_ROUND           3, 5
+    VP9_ROUND           4, 5
+    VP9_ROUND           5, 5
+    VP9_ROUND           6, 5
+    VP9_ROUND           7, 5
+    mov               ptrq, dstq
+    VP9_ADD_ROW         0, 8, 10
+    VP9_ADD_ROW         1, 8, 10
+    VP9_ADD_ROW         2, 8, 10
+    VP9_ADD_ROW         3, 8, 10
+    VP9_ADD_ROW         4, 8, 10
+    VP9_ADD_ROW         5, 8, 10
+    VP9_ADD_ROW         6, 8, 10
+    VP9_ADD_ROW         7, 8, 10
+    RET
+%endmacro
+
+; The 16x16 and 32x32 transforms run each pass over strips of mmsize / 2
+; columns. The first pass transposes into a temporary buffer on the stack, so
+; that the second pass reads its input as rows and produces output rows. For
+; the dct, eob tells us how many leading columns of coefficients can be
+; non-zero (from the default scan order), so strips beyond that are skipped
+; in the first pass and the corresponding temporary rows are zeroed instead.
+
+; dc-only add for %1 rows of %2 pixels
+%macro VP9_IDCT_DC_ADD 2 ; rows, width
+    mov               cntd, %1
+.dc_loop:
+%if %2 == 16
+    mova               xm2, [dstq]
+    paddusb            xm2, xm0
+    psubusb            xm2, xm1
+    mova            [dstq], xm2
+%elif mmsize == 32
+    mova                m2, [dstq]
+    paddusb             m2, m0
+    psubusb             m2, m1
+    mova            [dstq], m2
+%else
+    mova                m2, [dstq]
+    mova                m3, [dstq + 16]
+    paddusb             m2, m0
+    paddusb             m3, m0
+    psubusb             m2, m1
+    psubusb             m3, m1
+    mova            [dstq], m2
+    mova       [dstq + 16], m3
+%endif
+    add               dstq, strideq
+    dec               cntd
+    jg .dc_loop
+%endmacro
+
+%macro VP9_ITXFM_16x16 2 ; type_a, type_b
+cglobal vp9_%1_%2_16x16_add, 4, 7, 16, 16 * mmsize + 16 * 32, \
+                             dst, stride, block, eob, cnt, ptr, tmp
+%ifidn %1_%2, idct_idct
+    cmp               eobd, 1
+    jg .full
+    VP9_IDCT_DC_LOAD    6, cnt
+    VP9_IDCT_DC_ADD     16, 16
+    RET
+.full:
+%endif
+    lea               tmpq, [rsp + 16 * mmsize]
+    mov               cntd, 32 / mmsize
+%if mmsize == 16
+%ifidn %1_%2, idct_idct
+    cmp               eobd, 38
+    jg .pass1_loop
+    mov               cntd, 1
+%endif
+%endif
+.pass1_loop:
+    VP9_1D              %1, 16, blockq, 32
+    pxor                m8, m8
+%assign %%i 0
+%rep 16
+    mova [blockq + %%i * 32], m8
+%assign %%i %%i+1
+%endrep
+    VP9_TRANSPOSE_STORE tmpq, 32
+    VP9_LOAD_SLOTS      8
+    VP9_TRANSPOSE_STORE tmpq + 16, 32
+    add             blockq, mmsize
+    add               tmpq, 16 * mmsize
+    RESET_MM_PERMUTATION
+    dec               cntd
+    jg .pass1_loop
+
+%if mmsize == 16
+%ifidn %1_%2, idct_idct
+    cmp               eobd, 38
+    jg .pass2
+    pxor                m0, m0
+%assign %%i 0
+%rep 16
+    mova [tmpq + %%i * 16], m0
+%assign %%i %%i+1
+%endrep
+.pass2:
+%endif
+%endif
+
+    lea               tmpq, [rsp + 16 * mmsize]
+    mov               cntd, 32 / mmsize
+.pass2_loop:
+    VP9_1D              %2, 16, tmpq, 32
+    mov               ptrq, dstq
+    pxor               m10, m10
+    VP9_ROUND           0, 6
+    VP9_ROUND           1, 6
+    VP9_ROUND           2, 6
+    VP9_ROUND           3, 6
+    VP9_ROUND           4, 6
+    VP9_ROUND           5, 6
+    VP9_ROUND           6, 6
+    VP9_ROUND           7, 6
+    VP9_ADD_ROW         0, 8, 10
+    VP9_ADD_ROW         1, 8, 10
+    VP9_ADD_ROW         2, 8, 10
+    VP9_ADD_ROW         3, 8, 10
+    VP9_ADD_ROW         4, 8, 10
+    VP9_ADD_ROW         5, 8, 10
+    VP9_ADD_ROW         6, 8, 10
+    VP9_ADD_ROW         7, 8, 10
+%assign %%i 8
+%rep 8
+    mova                m0, SLOT(%%i)
+    VP9_ROUND           0, 6
+    VP9_ADD_ROW         0, 8, 10
+%assign %%i %%i+1
+%endrep
+    add               dstq, mmsize / 2
+    add               tmpq, mmsize
+    RESET_MM_PERMUTATION
+    dec               cntd
+    jg .pass2_loop
+    RET
+%endmacro
+
+%macro VP9_ITXFM_32x32 0
+cglobal vp9_idct_idct_32x32_add, 4, 8, 16, 32 * mmsize + 32 * 64, \
+                                 dst, stride, block, eob, cnt, ptr, tmp, nstrips
+    cmp               eobd, 1
+    jg .full
+    VP9_IDCT_DC_LOAD    6, cnt
+    VP9_IDCT_DC_ADD     32, 32
+    RET
+.full:
+    ; number of non-zero strips of mmsize / 2 columns
+    mov           nstripsd, 64 / mmsize
+%if mmsize == 16
+    cmp               eobd, 336
+    jg .strips_done
+    mov           nstripsd, 3
+%endif
+    cmp               eobd, 135
+    jg .strips_done
+    mov           nstripsd, 32 / mmsize
+%if mmsize == 16
+    cmp               eobd, 34
+    jg .strips_done
+    mov           nstripsd, 1
+%endif
+.strips_done:
+    lea               tmpq, [rsp + 32 * mmsize]
+    mov               cntd, nstripsd
+.pass1_loop:
+    VP9_IDCT32_1D       blockq, 64
+    pxor                m8, m8
+%assign %%i 0
+%rep 32
+    mova [blockq + %%i * 64], m8
+%assign %%i %%i+1
+%endrep
+%assign %%i 0
+%rep 4
+    VP9_LOAD_SLOTS      %%i * 8
+    VP9_TRANSPOSE_STORE tmpq + %%i * 16, 64
+%assign %%i %%i+1
+%endrep
+    add             blockq, mmsize
+    add               tmpq, 32 * mmsize
+    RESET_MM_PERMUTATION
+    dec               cntd
+    jg .pass1_loop
+
+    ; zero the rows of the temporary buffer matching skipped strips
+    sub           nstripsd, 64 / mmsize
+    jge .pass2
+    pxor                m0, m0
+.zero_loop:
+%assign %%i 0
+%rep 32
+    mova [tmpq + %%i * mmsize], m0
+%assign %%i %%i+1
+%endrep
+    add               tmpq, 32 * mmsize
+    inc           nstripsd
+    jl .zero_loop
+
+.pass2:
+    lea               tmpq, [rsp + 32 * mmsize]
+    mov               cntd, 64 / mmsize
+.pass2_loop:
+    VP9_IDCT32_1D       tmpq, 64
+    mov               ptrq, dstq
+    pxor               m10, m10
+%assign %%i 0
+%rep 32
+    mova                m0, SLOT(%%i)
+    VP9_ROUND           0, 6
+    VP9_ADD_ROW         0, 8, 10
+%assign %%i %%i+1
+%endrep
+    add               dstq, mmsize / 2
+    add               tmpq, mmsize
+    RESET_MM_PERMUTATION
+    dec               cntd
+    jg .pass2_loop
+    RET
+%endmacro
+
+%macro VP9_ITXFM_8x8_FUNCS 0
+VP9_ITXFM_8x8   idct,  idct
+VP9_ITXFM_8x8   iadst, idct
+VP9_ITXFM_8x8   idct,  iadst
+VP9_ITXFM_8x8   iadst, iadst
+%endmacro
+
+%macro VP9_ITXFM_16_32_FUNCS 0
+VP9_ITXFM_16x16 idct,  idct
+VP9_ITXFM_16x16 iadst, idct
+VP9_ITXFM_16x16 idct,  iadst
+VP9_ITXFM_16x16 iadst, iadst
+VP9_ITXFM_32x32
+%endmacro
+
+INIT_XMM sse2
+VP9_ITXFM_8x8_FUNCS
+VP9_ITXFM_16_32_FUNCS
+INIT_XMM ssse3
+VP9_ITXFM_8x8_FUNCS
+VP9_ITXFM_16_32_FUNCS
+
+%if HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+VP9_ITXFM_16_32_FUNCS
+%endif
+
+%endif ; ARCH_X86_64
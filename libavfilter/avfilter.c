@@ -264,6 +264,8 @@ int ff_request_frame(AVFilterLink *link)
 {
     FF_DPRINTF_START(NULL, request_frame); ff_dlog_link(NULL, link, 1);
 
+    if (HAVE_THREADS && link->dst->internal->in_stage)
+        return ff_pipeline_request_frame(link);
     if (link->srcpad->request_frame)
         return link->srcpad->request_frame(link);
     else if (link->src->inputs[0])
@@ -276,6 +278,8 @@ int ff_poll_frame(AVFilterLink *link)
 {
     int i, min = INT_MAX;
 
+    if (HAVE_THREADS && link->dst->internal->in_stage)
+        return ff_pipeline_poll_frame(link);
     if (link->srcpad->poll_frame)
         return link->srcpad->poll_frame(link);
 
@@ -639,15 +643,23 @@ static int default_filter_frame(AVFilterLink *link, AVFrame *frame)
 }
 
 int ff_filter_frame(AVFilterLink *link, AVFrame *frame)
+{
+    FF_DPRINTF_START(NULL, filter_frame);
+    ff_dlog_link(NULL, link, 1);
+
+    if (HAVE_THREADS && link->dst->internal->in_stage)
+        return ff_pipeline_filter_frame(link, frame);
+
+    return ff_filter_frame_direct(link, frame);
+}
+
+int ff_filter_frame_direct(AVFilterLink *link, AVFrame *frame)
 {
     int (*filter_frame)(AVFilterLink *, AVFrame *);
     AVFilterPad *dst = link->dstpad;
     AVFrame *out = NULL;
     int ret;
 
-    FF_DPRINTF_START(NULL, filter_frame);
-    ff_dlog_link(NULL, link, 1);
-
     if (!(filter_frame = dst->filter_frame))
         filter_frame = default_filter_frame;
 
@@ -258,6 +258,19 @@ typedef struct AVFilter {
  */
 #define AVFILTER_THREAD_SLICE (1 << 0)
 
+/**
+ * Run parts of the filtergraph on separate threads, each working on a
+ * different frame. Only meaningful for AVFilterGraph.thread_type, where it is
+ * not set by default.
+ *
+ * When set, av_buffersink_get_frame() and similar may return AVERROR(EAGAIN)
+ * while the graph is still processing the frames it was sent through buffer
+ * sources, and only wait for the processing once those are closed or have
+ * enough frames queued. The AVFilterGraph.execute callback, if any, may be
+ * called from several threads at once.
+ */
+#define AVFILTER_THREAD_PIPELINE (1 << 1)
+
 typedef struct AVFilterInternal AVFilterInternal;
 
 /** An instance of a filter */
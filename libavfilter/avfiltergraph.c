@@ -42,7 +42,8 @@
 static const AVOption filtergraph_options[] = {
     { "thread_type", "Allowed thread types", OFFSET(thread_type), AV_OPT_TYPE_FLAGS,
         { .i64 = AVFILTER_THREAD_SLICE }, 0, INT_MAX, FLAGS, "thread_type" },
-        { "slice", NULL, 0, AV_OPT_TYPE_CONST, { .i64 = AVFILTER_THREAD_SLICE }, .flags = FLAGS, .unit = "thread_type" },
+        { "slice",    NULL, 0, AV_OPT_TYPE_CONST, { .i64 = AVFILTER_THREAD_SLICE },    .flags = FLAGS, .unit = "thread_type" },
+        { "pipeline", NULL, 0, AV_OPT_TYPE_CONST, { .i64 = AVFILTER_THREAD_PIPELINE }, .flags = FLAGS, .unit = "thread_type" },
     { "threads",     "Maximum number of threads", OFFSET(nb_threads),
         AV_OPT_TYPE_INT,   { .i64 = 0 }, 0, INT_MAX, FLAGS },
     { NULL },
@@ -66,6 +67,27 @@ int ff_graph_thread_init(AVFilterGraph *graph)
     graph->nb_threads  = 1;
     return 0;
 }
+
+int ff_pipeline_init(AVFilterGraph *graph)
+{
+    return 0;
+}
+
+void ff_pipeline_uninit(AVFilterGraph *graph)
+{
+}
+
+void ff_pipeline_lock(AVFilterContext *ctx)
+{
+}
+
+void ff_pipeline_unlock(AVFilterContext *ctx)
+{
+}
+
+void ff_pipeline_source_update(AVFilterContext *ctx, int queued, int eof)
+{
+}
 #endif
 
 AVFilterGraph *avfilter_graph_alloc(void)
@@ -104,6 +126,8 @@ void avfilter_graph_free(AVFilterGraph **graph)
     if (!*graph)
         return;
 
+    ff_pipeline_uninit(*graph);
+
     while ((*graph)->nb_filters)
         avfilter_free((*graph)->filters[0]);
 
@@ -797,6 +821,9 @@ int avfilter_graph_config(AVFilterGraph *graphctx, void *log_ctx)
         return ret;
     if ((ret = graph_config_links(graphctx, log_ctx)))
         return ret;
+    if (graphctx->thread_type & AVFILTER_THREAD_PIPELINE &&
+        (ret = ff_pipeline_init(graphctx)) < 0)
+        return ret;
 
     return 0;
 }
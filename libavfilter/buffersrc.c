@@ -149,8 +149,7 @@ int attribute_align_arg av_buffersrc_write_frame(AVFilterContext *ctx, const AVF
     return ret;
 }
 
-int attribute_align_arg av_buffersrc_add_frame(AVFilterContext *ctx,
-                                               AVFrame *frame)
+static int add_frame_internal(AVFilterContext *ctx, AVFrame *frame)
 {
     BufferSourceContext *s = ctx->priv;
     AVFrame *copy;
@@ -205,6 +204,21 @@ int attribute_align_arg av_buffersrc_add_frame(AVFilterContext *ctx,
     return 0;
 }
 
+int attribute_align_arg av_buffersrc_add_frame(AVFilterContext *ctx,
+                                               AVFrame *frame)
+{
+    BufferSourceContext *s = ctx->priv;
+    int ret;
+
+    ff_pipeline_lock(ctx);
+    ret = add_frame_internal(ctx, frame);
+    ff_pipeline_source_update(ctx, av_fifo_size(s->fifo) / sizeof(AVFrame*),
+                              s->eof);
+    ff_pipeline_unlock(ctx);
+
+    return ret;
+}
+
 static av_cold int init_video(AVFilterContext *ctx)
 {
     BufferSourceContext *c = ctx->priv;
@@ -389,12 +403,16 @@ static int request_frame(AVFilterLink *link)
     AVFrame *frame;
     int ret = 0;
 
+    ff_pipeline_lock(link->src);
     if (!av_fifo_size(c->fifo)) {
-        if (c->eof)
-            return AVERROR_EOF;
-        return AVERROR(EAGAIN);
+        ret = c->eof ? AVERROR_EOF : AVERROR(EAGAIN);
+        ff_pipeline_unlock(link->src);
+        return ret;
     }
     av_fifo_generic_read(c->fifo, &frame, sizeof(frame), NULL);
+    ff_pipeline_source_update(link->src, av_fifo_size(c->fifo) / sizeof(AVFrame*),
+                              c->eof);
+    ff_pipeline_unlock(link->src);
 
     ret = ff_filter_frame(link, frame);
 
@@ -404,10 +422,15 @@ static int request_frame(AVFilterLink *link)
 static int poll_frame(AVFilterLink *link)
 {
     BufferSourceContext *c = link->src->priv;
-    int size = av_fifo_size(c->fifo);
-    if (!size && c->eof)
-        return AVERROR_EOF;
-    return size/sizeof(AVFrame*);
+    int ret;
+
+    ff_pipeline_lock(link->src);
+    ret = av_fifo_size(c->fifo) / sizeof(AVFrame*);
+    if (!ret && c->eof)
+        ret = AVERROR_EOF;
+    ff_pipeline_unlock(link->src);
+
+    return ret;
 }
 
 static const AVFilterPad avfilter_vsrc_buffer_outputs[] = {
@@ -427,6 +450,7 @@ AVFilter ff_vsrc_buffer = {
     .priv_size = sizeof(BufferSourceContext),
     .priv_class = &buffer_class,
     .query_formats = query_formats,
+    .flags_internal = FF_FILTER_FLAG_EXTERNAL_SOURCE,
 
     .init      = init_video,
     .uninit    = uninit,
@@ -452,6 +476,7 @@ AVFilter ff_asrc_abuffer = {
     .priv_size     = sizeof(BufferSourceContext),
     .priv_class    = &abuffer_class,
     .query_formats = query_formats,
+    .flags_internal = FF_FILTER_FLAG_EXTERNAL_SOURCE,
 
     .init      = init_audio,
     .uninit    = uninit,
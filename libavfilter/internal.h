@@ -129,10 +129,16 @@ struct AVFilterPad {
 struct AVFilterGraphInternal {
     void *thread;
     avfilter_execute_func *thread_execute;
+    void *pipeline;
 };
 
 struct AVFilterInternal {
     avfilter_execute_func *execute;
+
+    /* pipelined graphs, see pipeline.c */
+    struct PipelineStage  *stage;     ///< stage running this filter, NULL for the caller's thread
+    struct PipelineStage  *in_stage;  ///< stage feeding the only input over a frame queue
+    struct PipelineSource *source;    ///< state of this external source seen by the stages
 };
 
 /** Tell is a format is contained in the provided list terminated by -1. */
@@ -205,6 +211,12 @@ int ff_request_frame(AVFilterLink *link);
  */
 int ff_filter_frame(AVFilterLink *link, AVFrame *frame);
 
+/**
+ * Send a frame of data to the next filter on the calling thread, without
+ * going through the frame queue of a pipelined graph.
+ */
+int ff_filter_frame_direct(AVFilterLink *link, AVFrame *frame);
+
 /**
  * Allocate a new filter context and return it.
  *
@@ -226,4 +238,10 @@ void ff_filter_graph_remove_filter(AVFilterGraph *graph, AVFilterContext *filter
  */
 #define FF_FILTER_FLAG_HWFRAME_AWARE (1 << 0)
 
+/**
+ * Frames are sent to the filter from outside of the graph by the caller, it
+ * has to report the number of frames it holds with ff_pipeline_source_update().
+ */
+#define FF_FILTER_FLAG_EXTERNAL_SOURCE (1 << 1)
+
 #endif /* AVFILTER_INTERNAL_H */
@@ -0,0 +1,534 @@
+/*
+ * This file is part of Libav.
+ *
+ * Libav is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * Libav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with Libav; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * Pipelined execution of filter graphs
+ *
+ * The graph is cut into segments at links going from a filter with a single
+ * output to a filter with a single input. Every segment except the one(s)
+ * containing the sinks gets its own thread (a stage), which keeps requesting
+ * frames from the last filter of the segment and stores them in a queue on the
+ * outgoing link. Requesting a frame on that link from the downstream segment
+ * takes a frame from the queue instead of running the upstream filters, so
+ * that all segments work on different frames at the same time.
+ */
+
+#include "config.h"
+
+#include "libavutil/common.h"
+#include "libavutil/fifo.h"
+#include "libavutil/frame.h"
+#include "libavutil/mem.h"
+
+#include "avfilter.h"
+#include "internal.h"
+#include "thread.h"
+
+#if HAVE_PTHREADS
+#include <pthread.h>
+#elif HAVE_W32THREADS
+#include "compat/w32pthreads.h"
+#endif
+
+/* number of frames a stage may produce ahead of its consumer, this is also
+ * the amount of input queued in the sources before a consumer waits for the
+ * stage instead of asking for more input */
+#define QUEUE_SIZE 4
+
+typedef struct PipelineSource {
+    int queued;                 ///< number of frames buffered in the source
+    int eof;                    ///< no more frames will be added to the source
+} PipelineSource;
+
+typedef struct PipelineStage {
+    struct PipelineContext *pipe;
+    struct PipelineStage   *next; ///< stage consuming the queue, NULL for the caller
+
+    AVFilterLink *link;         ///< link leaving the segment run by this stage
+    AVFifoBuffer *queue;        ///< frames sent over link, not consumed yet
+    pthread_t thread;
+
+    int status;                 ///< error returned by the segment, e.g. EOF
+    int starved;                ///< the segment needs more input to produce a frame
+    int wake;                   ///< input arrived since the segment was last run
+
+    /* sources fed from outside of the graph upstream of link */
+    PipelineSource **sources;
+    int           nb_sources;
+} PipelineStage;
+
+typedef struct PipelineContext {
+    pthread_mutex_t lock;
+    pthread_cond_t  cond;
+    int done;
+
+    PipelineStage *stages;
+    int         nb_stages;
+    int         nb_running;
+
+    PipelineSource *sources;
+    int          nb_sources;
+} PipelineContext;
+
+/* signal a new frame or the final status on the link of s, lock held */
+static void stage_update(PipelineStage *s)
+{
+    if (s->next)
+        s->next->wake = 1;
+    pthread_cond_broadcast(&s->pipe->cond);
+}
+
+static int sources_open(PipelineStage *s)
+{
+    int i;
+
+    for (i = 0; i < s->nb_sources; i++)
+        if (!s->sources[i]->eof)
+            return 1;
+    return 0;
+}
+
+static int request_upstream(AVFilterLink *link)
+{
+    if (link->srcpad->request_frame)
+        return link->srcpad->request_frame(link);
+    return ff_request_frame(link->src->inputs[0]);
+}
+
+static void* attribute_align_arg worker(void *arg)
+{
+    PipelineStage   *s = arg;
+    PipelineContext *p = s->pipe;
+    int ret;
+
+    pthread_mutex_lock(&p->lock);
+    while (!p->done) {
+        if (s->status || (s->starved && !s->wake) ||
+            av_fifo_size(s->queue) >= QUEUE_SIZE * sizeof(AVFrame*)) {
+            pthread_cond_wait(&p->cond, &p->lock);
+            continue;
+        }
+        s->starved = 0;
+        s->wake    = 0;
+        pthread_mutex_unlock(&p->lock);
+
+        ret = request_upstream(s->link);
+
+        pthread_mutex_lock(&p->lock);
+        /* without open sources, EAGAIN only means that a filter wants to be
+         * called again */
+        if (ret == AVERROR(EAGAIN) && sources_open(s)) {
+            s->starved = 1;
+            pthread_cond_broadcast(&p->cond);
+        } else if (ret < 0 && ret != AVERROR(EAGAIN)) {
+            s->status = ret;
+            stage_update(s);
+        }
+    }
+    pthread_mutex_unlock(&p->lock);
+
+    return NULL;
+}
+
+/*
+ * Whether a consumer of s should return EAGAIN to its caller instead of
+ * waiting for s: this is the case while some source upstream of s is still
+ * open and s either cannot progress without more input, or does not have
+ * much input left to work on.
+ */
+static int need_input(PipelineStage *s)
+{
+    int i, queued = 0;
+
+    for (i = 0; i < s->nb_sources; i++)
+        queued += s->sources[i]->queued;
+
+    return sources_open(s) && ((s->starved && !s->wake) || queued < QUEUE_SIZE);
+}
+
+int ff_pipeline_request_frame(AVFilterLink *link)
+{
+    PipelineStage   *s = link->dst->internal->in_stage;
+    PipelineContext *p = s->pipe;
+    AVFrame *frame;
+    int ret;
+
+    pthread_mutex_lock(&p->lock);
+    for (;;) {
+        if (av_fifo_size(s->queue)) {
+            av_fifo_generic_read(s->queue, &frame, sizeof(frame), NULL);
+            pthread_cond_broadcast(&p->cond);
+            pthread_mutex_unlock(&p->lock);
+            return ff_filter_frame_direct(link, frame);
+        }
+        if (s->status || p->done) {
+            ret = p->done ? AVERROR_EXIT : s->status;
+            break;
+        }
+        if (need_input(s)) {
+            ret = AVERROR(EAGAIN);
+            break;
+        }
+        pthread_cond_wait(&p->cond, &p->lock);
+    }
+    pthread_mutex_unlock(&p->lock);
+
+    return ret;
+}
+
+int ff_pipeline_filter_frame(AVFilterLink *link, AVFrame *frame)
+{
+    PipelineStage   *s = link->dst->internal->in_stage;
+    PipelineContext *p = s->pipe;
+    int ret = 0;
+
+    pthread_mutex_lock(&p->lock);
+    /* a single request may output more than one frame, so the queue can grow
+     * past QUEUE_SIZE */
+    if (!av_fifo_space(s->queue))
+        ret = av_fifo_realloc2(s->queue, av_fifo_size(s->queue) + sizeof(frame));
+    if (ret >= 0) {
+        av_fifo_generic_write(s->queue, &frame, sizeof(frame), NULL);
+        stage_update(s);
+    }
+    pthread_mutex_unlock(&p->lock);
+
+    if (ret < 0)
+        av_frame_free(&frame);
+    return ret;
+}
+
+int ff_pipeline_poll_frame(AVFilterLink *link)
+{
+    PipelineStage   *s = link->dst->internal->in_stage;
+    PipelineContext *p = s->pipe;
+    int ret;
+
+    pthread_mutex_lock(&p->lock);
+    ret = av_fifo_size(s->queue) / sizeof(AVFrame*);
+    if (!ret && s->status)
+        ret = s->status;
+    pthread_mutex_unlock(&p->lock);
+
+    return ret;
+}
+
+void ff_pipeline_lock(AVFilterContext *ctx)
+{
+    if (ctx->internal->stage)
+        pthread_mutex_lock(&ctx->internal->stage->pipe->lock);
+}
+
+void ff_pipeline_unlock(AVFilterContext *ctx)
+{
+    if (ctx->internal->stage)
+        pthread_mutex_unlock(&ctx->internal->stage->pipe->lock);
+}
+
+void ff_pipeline_source_update(AVFilterContext *ctx, int queued, int eof)
+{
+    PipelineSource *src = ctx->internal->source;
+
+    if (!src)
+        return;
+
+    if (queued > src->queued || eof > src->eof)
+        ctx->internal->stage->wake = 1;
+    src->queued = queued;
+    src->eof    = eof;
+    pthread_cond_broadcast(&ctx->internal->stage->pipe->cond);
+}
+
+static int filter_index(AVFilterGraph *graph, AVFilterContext *f)
+{
+    int i;
+
+    for (i = 0; i < graph->nb_filters; i++)
+        if (graph->filters[i] == f)
+            break;
+    return i;
+}
+
+/* assign the same number to all filters connected by a link that is not cut */
+static void find_segments(AVFilterGraph *graph, const uint8_t *cut, int *seg)
+{
+    int i, j, changed;
+
+    for (i = 0; i < graph->nb_filters; i++)
+        seg[i] = i;
+
+    do {
+        changed = 0;
+        for (i = 0; i < graph->nb_filters; i++) {
+            AVFilterContext *f = graph->filters[i];
+
+            if (cut[i])
+                continue;
+            for (j = 0; j < f->nb_inputs; j++) {
+                int k = filter_index(graph, f->inputs[j]->src);
+                int s = FFMIN(seg[i], seg[k]);
+
+                if (seg[i] != s || seg[k] != s) {
+                    seg[i] = seg[k] = s;
+                    changed = 1;
+                }
+            }
+        }
+    } while (changed);
+}
+
+/*
+ * Choose the links to cut the graph at, cut[i] is set if the only input link
+ * of the i-th filter is cut. Every segment must either end with a single cut
+ * link or contain only sinks as ends, so that it is driven by exactly one
+ * thread. Returns the number of cuts.
+ */
+static int choose_cuts(AVFilterGraph *graph, uint8_t *cut, int *seg,
+                       int *nb_outs, int *nb_sinks, int max_cuts)
+{
+    int i, nb_cuts, changed;
+
+    for (i = 0; i < graph->nb_filters; i++) {
+        AVFilterContext *f = graph->filters[i];
+
+        cut[i] = f->nb_inputs == 1 && f->nb_outputs > 0 &&
+                 f->inputs[0]->src->nb_inputs  > 0 &&
+                 f->inputs[0]->src->nb_outputs == 1;
+    }
+
+    do {
+        changed = 0;
+        nb_cuts = 0;
+        find_segments(graph, cut, seg);
+
+        memset(nb_outs,  0, graph->nb_filters * sizeof(*nb_outs));
+        memset(nb_sinks, 0, graph->nb_filters * sizeof(*nb_sinks));
+        for (i = 0; i < graph->nb_filters; i++) {
+            AVFilterContext *f = graph->filters[i];
+
+            if (!f->nb_outputs)
+                nb_sinks[seg[i]]++;
+            if (cut[i])
+                nb_outs[seg[filter_index(graph, f->inputs[0]->src)]]++;
+        }
+
+        for (i = 0; i < graph->nb_filters; i++) {
+            int s;
+
+            if (!cut[i])
+                continue;
+            s = seg[filter_index(graph, graph->filters[i]->inputs[0]->src)];
+            if (nb_outs[s] > 1 || nb_sinks[s]) {
+                cut[i]  = 0;
+                changed = 1;
+            } else
+                nb_cuts++;
+        }
+
+        /* merging a valid segment into the next one keeps both valid */
+        for (i = graph->nb_filters - 1; !changed && nb_cuts > max_cuts; i--) {
+            if (cut[i]) {
+                cut[i] = 0;
+                nb_cuts--;
+                changed = nb_cuts <= max_cuts;
+            }
+        }
+    } while (changed);
+
+    return nb_cuts;
+}
+
+static int add_sources(PipelineStage *s, AVFilterGraph *graph,
+                       AVFilterContext *f, uint8_t *visited)
+{
+    int i, ret, idx = filter_index(graph, f);
+
+    if (visited[idx])
+        return 0;
+    visited[idx] = 1;
+
+    if (f->internal->source) {
+        ret = av_reallocp_array(&s->sources, s->nb_sources + 1,
+                                sizeof(*s->sources));
+        if (ret < 0) {
+            s->nb_sources = 0;
+            return ret;
+        }
+        s->sources[s->nb_sources++] = f->internal->source;
+    }
+
+    for (i = 0; i < f->nb_inputs; i++) {
+        ret = add_sources(s, graph, f->inputs[i]->src, visited);
+        if (ret < 0)
+            return ret;
+    }
+    return 0;
+}
+
+void ff_pipeline_uninit(AVFilterGraph *graph)
+{
+    PipelineContext *p = graph->internal->pipeline;
+    AVFrame *frame;
+    int i;
+
+    if (!p)
+        return;
+
+    pthread_mutex_lock(&p->lock);
+    p->done = 1;
+    pthread_cond_broadcast(&p->cond);
+    pthread_mutex_unlock(&p->lock);
+
+    for (i = 0; i < p->nb_running; i++)
+        pthread_join(p->stages[i].thread, NULL);
+
+    for (i = 0; i < p->nb_stages; i++) {
+        PipelineStage *s = &p->stages[i];
+
+        while (s->queue && av_fifo_size(s->queue)) {
+            av_fifo_generic_read(s->queue, &frame, sizeof(frame), NULL);
+            av_frame_free(&frame);
+        }
+        av_fifo_free(s->queue);
+        av_freep(&s->sources);
+    }
+
+    for (i = 0; i < graph->nb_filters; i++) {
+        AVFilterInternal *fi = graph->filters[i]->internal;
+
+        fi->stage    = NULL;
+        fi->in_stage = NULL;
+        fi->source   = NULL;
+    }
+
+    pthread_cond_destroy(&p->cond);
+    pthread_mutex_destroy(&p->lock);
+    av_freep(&p->stages);
+    av_freep(&p->sources);
+    av_freep(&graph->internal->pipeline);
+}
+
+int ff_pipeline_init(AVFilterGraph *graph)
+{
+    PipelineContext *p;
+    uint8_t *cut = NULL, *visited = NULL;
+    int *seg = NULL, *nb_outs = NULL, *nb_sinks = NULL;
+    int i, j, nb_cuts, ret = 0;
+
+    ff_pipeline_uninit(graph);
+
+    if (!graph->nb_filters)
+        return 0;
+
+    cut      = av_malloc_array(graph->nb_filters, sizeof(*cut));
+    visited  = av_malloc_array(graph->nb_filters, sizeof(*visited));
+    seg      = av_malloc_array(graph->nb_filters, sizeof(*seg));
+    nb_outs  = av_malloc_array(graph->nb_filters, sizeof(*nb_outs));
+    nb_sinks = av_malloc_array(graph->nb_filters, sizeof(*nb_sinks));
+    if (!cut || !visited || !seg || !nb_outs || !nb_sinks) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+
+    /* the caller's thread runs the segments containing the sinks */
+    nb_cuts = choose_cuts(graph, cut, seg, nb_outs, nb_sinks,
+                          FFMAX(graph->nb_threads - 1, 0));
+    if (!nb_cuts)
+        goto end;
+
+    p = av_mallocz(sizeof(*p));
+    if (!p) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+    pthread_mutex_init(&p->lock, NULL);
+    pthread_cond_init(&p->cond, NULL);
+    graph->internal->pipeline = p;
+
+    p->stages  = av_mallocz_array(nb_cuts, sizeof(*p->stages));
+    p->sources = av_mallocz_array(graph->nb_filters, sizeof(*p->sources));
+    if (!p->stages || !p->sources) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+
+    for (i = 0; i < graph->nb_filters; i++) {
+        PipelineStage *s;
+        AVFilterLink *link;
+        int src_seg;
+
+        if (!cut[i])
+            continue;
+        s       = &p->stages[p->nb_stages++];
+        link    = graph->filters[i]->inputs[0];
+        src_seg = seg[filter_index(graph, link->src)];
+
+        s->pipe  = p;
+        s->link  = link;
+        s->queue = av_fifo_alloc(QUEUE_SIZE * sizeof(AVFrame*));
+        if (!s->queue) {
+            ret = AVERROR(ENOMEM);
+            goto end;
+        }
+
+        link->dst->internal->in_stage = s;
+        for (j = 0; j < graph->nb_filters; j++)
+            if (seg[j] == src_seg)
+                graph->filters[j]->internal->stage = s;
+    }
+
+    for (i = 0; i < graph->nb_filters; i++) {
+        AVFilterContext *f = graph->filters[i];
+
+        if (f->internal->in_stage)
+            f->internal->in_stage->next = f->internal->stage;
+        if (f->internal->stage &&
+            f->filter->flags_internal & FF_FILTER_FLAG_EXTERNAL_SOURCE)
+            f->internal->source = &p->sources[p->nb_sources++];
+    }
+
+    for (i = 0; i < p->nb_stages; i++) {
+        memset(visited, 0, graph->nb_filters * sizeof(*visited));
+        ret = add_sources(&p->stages[i], graph, p->stages[i].link->src, visited);
+        if (ret < 0)
+            goto end;
+    }
+
+    for (i = 0; i < p->nb_stages; i++) {
+        ret = pthread_create(&p->stages[i].thread, NULL, worker, &p->stages[i]);
+        if (ret) {
+            ret = AVERROR(ret);
+            goto end;
+        }
+        p->nb_running++;
+    }
+
+    av_log(graph, AV_LOG_VERBOSE, "Running the graph in %d pipeline stages.\n",
+           p->nb_stages + 1);
+
+end:
+    if (ret < 0)
+        ff_pipeline_uninit(graph);
+    av_freep(&cut);
+    av_freep(&visited);
+    av_freep(&seg);
+    av_freep(&nb_outs);
+    av_freep(&nb_sinks);
+    return ret;
+}
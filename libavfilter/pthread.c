@@ -26,6 +26,7 @@
 #include "libavutil/common.h"
 #include "libavutil/cpu.h"
 #include "libavutil/mem.h"
+#include "libavutil/slicepool_internal.h"
 
 #include "avfilter.h"
 #include "internal.h"
@@ -57,8 +58,32 @@ typedef struct ThreadContext {
     int current_job;
     unsigned int current_execute;
     int done;
+
+    /* pipelined graphs may run filters on several threads at once */
+    pthread_mutex_t execute_lock;
+
+    int shared;                 ///< the jobs run on the shared slice thread pool
 } ThreadContext;
 
+/**
+ * Parameters of one execute() call on the shared slice thread pool.
+ */
+typedef struct SharedExecute {
+    AVFilterContext *ctx;
+    avfilter_action_func *func;
+    void *arg;
+    int  *rets;
+    int nb_rets;
+    int nb_jobs;
+} SharedExecute;
+
+static void shared_worker(void *v, int jobnr, int threadnr)
+{
+    SharedExecute *e = v;
+
+    e->rets[jobnr % e->nb_rets] = e->func(e->ctx, e->arg, jobnr, e->nb_jobs);
+}
+
 static void* attribute_align_arg worker(void *v)
 {
     ThreadContext *c = v;
@@ -97,6 +122,9 @@ static void slice_thread_uninit(ThreadContext *c)
 {
     int i;
 
+    if (c->shared)
+        return;
+
     pthread_mutex_lock(&c->current_job_lock);
     c->done = 1;
     pthread_cond_broadcast(&c->current_job_cond);
@@ -106,6 +134,7 @@ static void slice_thread_uninit(ThreadContext *c)
          pthread_join(c->workers[i], NULL);
 
     pthread_mutex_destroy(&c->current_job_lock);
+    pthread_mutex_destroy(&c->execute_lock);
     pthread_cond_destroy(&c->current_job_cond);
     pthread_cond_destroy(&c->last_job_cond);
     av_freep(&c->workers);
@@ -127,6 +156,21 @@ static int thread_execute(AVFilterContext *ctx, avfilter_action_func *func,
     if (nb_jobs <= 0)
         return 0;
 
+    /* each call has its own parameters, so calls need not be serialized */
+    if (c->shared) {
+        SharedExecute e = {
+            .ctx     = ctx,
+            .func    = func,
+            .arg     = arg,
+            .rets    = ret ? ret : &dummy_ret,
+            .nb_rets = ret ? nb_jobs : 1,
+            .nb_jobs = nb_jobs,
+        };
+        avpriv_slice_pool_execute(shared_worker, &e, nb_jobs, c->nb_threads);
+        return 0;
+    }
+
+    pthread_mutex_lock(&c->execute_lock);
     pthread_mutex_lock(&c->current_job_lock);
 
     c->current_job = c->nb_threads;
@@ -146,6 +190,7 @@ static int thread_execute(AVFilterContext *ctx, avfilter_action_func *func,
     pthread_cond_broadcast(&c->current_job_cond);
 
     slice_thread_park_workers(c);
+    pthread_mutex_unlock(&c->execute_lock);
 
     return 0;
 }
@@ -168,6 +213,12 @@ static int thread_init_internal(ThreadContext *c, int nb_threads)
         return 1;
 
     c->nb_threads = nb_threads;
+
+    if (avpriv_slice_pool_enabled()) {
+        c->shared = 1;
+        return c->nb_threads;
+    }
+
     c->workers = av_mallocz(sizeof(*c->workers) * nb_threads);
     if (!c->workers)
         return AVERROR(ENOMEM);
@@ -179,6 +230,7 @@ static int thread_init_internal(ThreadContext *c, int nb_threads)
     pthread_cond_init(&c->current_job_cond, NULL);
     pthread_cond_init(&c->last_job_cond,    NULL);
 
+    pthread_mutex_init(&c->execute_lock, NULL);
     pthread_mutex_init(&c->current_job_lock, NULL);
     pthread_mutex_lock(&c->current_job_lock);
     for (i = 0; i < nb_threads; i++) {
@@ -25,4 +25,39 @@ int ff_graph_thread_init(AVFilterGraph *graph);
 
 void ff_graph_thread_free(AVFilterGraph *graph);
 
+/**
+ * Start running the segments of a configured graph on separate threads, if
+ * it can be split.
+ */
+int ff_pipeline_init(AVFilterGraph *graph);
+
+void ff_pipeline_uninit(AVFilterGraph *graph);
+
+/**
+ * Request a frame on a link fed by a pipeline stage. Return a queued frame,
+ * or AVERROR(EAGAIN) if the stage needs input from the caller.
+ */
+int ff_pipeline_request_frame(AVFilterLink *link);
+
+/**
+ * Queue a frame on a link leaving a pipeline stage.
+ */
+int ff_pipeline_filter_frame(AVFilterLink *link, AVFrame *frame);
+
+int ff_pipeline_poll_frame(AVFilterLink *link);
+
+/**
+ * Lock the state an external source shares with the stage running it.
+ * No-op if the source is run by the caller's thread.
+ */
+void ff_pipeline_lock(AVFilterContext *ctx);
+
+void ff_pipeline_unlock(AVFilterContext *ctx);
+
+/**
+ * Report the number of frames held by an external source and whether it
+ * reached EOF, must be called under ff_pipeline_lock().
+ */
+void ff_pipeline_source_update(AVFilterContext *ctx, int queued, int eof);
+
 #endif /* AVFILTER_THREAD_H */
@@ -72,7 +72,9 @@ typedef struct BoxBlurContext {
     int hsub, vsub;
     int radius[4];
     int power[4];
-    uint8_t *temp[2]; ///< temporary buffer used in blur_power()
+    uint8_t *temp[2]; ///< temporary buffers used in blur_power(), one line per thread
+    int temp_size;    ///< size of a line in the temporary buffers
+    int nb_threads;
 } BoxBlurContext;
 
 #define Y 0
@@ -139,11 +141,14 @@ static int config_input(AVFilterLink *inlink)
     char *expr;
     int ret;
 
+    s->nb_threads = FFMAX(ctx->graph->nb_threads, 1);
+    s->temp_size  = FFMAX(w, h);
+
     av_freep(&s->temp[0]);
     av_freep(&s->temp[1]);
-    if (!(s->temp[0] = av_malloc(FFMAX(w, h))))
+    if (!(s->temp[0] = av_malloc(s->temp_size * s->nb_threads)))
        return AVERROR(ENOMEM);
-    if (!(s->temp[1] = av_malloc(FFMAX(w, h)))) {
+    if (!(s->temp[1] = av_malloc(s->temp_size * s->nb_threads))) {
         av_freep(&s->temp[0]);
         return AVERROR(ENOMEM);
     }
@@ -273,41 +278,86 @@ static inline void blur_power(uint8_t *dst, int dst_step, const uint8_t *src, in
 }
 
 static void hblur(uint8_t *dst, int dst_linesize, const uint8_t *src, int src_linesize,
-                  int w, int h, int radius, int power, uint8_t *temp[2])
+                  int w, int slice_start, int slice_end, int radius, int power,
+                  uint8_t *temp[2])
 {
     int y;
 
     if (radius == 0 && dst == src)
         return;
 
-    for (y = 0; y < h; y++)
+    for (y = slice_start; y < slice_end; y++)
         blur_power(dst + y*dst_linesize, 1, src + y*src_linesize, 1,
                    w, radius, power, temp);
 }
 
 static void vblur(uint8_t *dst, int dst_linesize, const uint8_t *src, int src_linesize,
-                  int w, int h, int radius, int power, uint8_t *temp[2])
+                  int h, int slice_start, int slice_end, int radius, int power,
+                  uint8_t *temp[2])
 {
     int x;
 
     if (radius == 0 && dst == src)
         return;
 
-    for (x = 0; x < w; x++)
+    for (x = slice_start; x < slice_end; x++)
         blur_power(dst + x, dst_linesize, src + x, src_linesize,
                    h, radius, power, temp);
 }
 
+typedef struct ThreadData {
+    AVFrame *in, *out;
+    int w[4], h[4];
+} ThreadData;
+
+/* horizontal pass on a range of rows of every plane */
+static int hblur_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    BoxBlurContext *s = ctx->priv;
+    ThreadData *td = arg;
+    uint8_t *temp[2] = { s->temp[0] + jobnr * s->temp_size,
+                         s->temp[1] + jobnr * s->temp_size };
+    int plane;
+
+    for (plane = 0; td->in->data[plane] && plane < 4; plane++)
+        hblur(td->out->data[plane], td->out->linesize[plane],
+              td->in ->data[plane], td->in ->linesize[plane],
+              td->w[plane],
+              (td->h[plane] *  jobnr     ) / nb_jobs,
+              (td->h[plane] * (jobnr + 1)) / nb_jobs,
+              s->radius[plane], s->power[plane], temp);
+
+    return 0;
+}
+
+/* vertical pass on a range of columns of every plane */
+static int vblur_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    BoxBlurContext *s = ctx->priv;
+    ThreadData *td = arg;
+    uint8_t *temp[2] = { s->temp[0] + jobnr * s->temp_size,
+                         s->temp[1] + jobnr * s->temp_size };
+    int plane;
+
+    for (plane = 0; td->in->data[plane] && plane < 4; plane++)
+        vblur(td->out->data[plane], td->out->linesize[plane],
+              td->out->data[plane], td->out->linesize[plane],
+              td->h[plane],
+              (td->w[plane] *  jobnr     ) / nb_jobs,
+              (td->w[plane] * (jobnr + 1)) / nb_jobs,
+              s->radius[plane], s->power[plane], temp);
+
+    return 0;
+}
+
 static int filter_frame(AVFilterLink *inlink, AVFrame *in)
 {
     AVFilterContext *ctx = inlink->dst;
     BoxBlurContext *s = ctx->priv;
     AVFilterLink *outlink = inlink->dst->outputs[0];
     AVFrame *out;
-    int plane;
+    ThreadData td;
     int cw = inlink->w >> s->hsub, ch = in->height >> s->vsub;
-    int w[4] = { inlink->w, cw, cw, inlink->w };
-    int h[4] = { in->height, ch, ch, in->height };
 
     out = ff_get_video_buffer(outlink, outlink->w, outlink->h);
     if (!out) {
@@ -316,17 +366,17 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
     }
     av_frame_copy_props(out, in);
 
-    for (plane = 0; in->data[plane] && plane < 4; plane++)
-        hblur(out->data[plane], out->linesize[plane],
-              in ->data[plane], in ->linesize[plane],
-              w[plane], h[plane], s->radius[plane], s->power[plane],
-              s->temp);
+    td.in   = in;
+    td.out  = out;
+    td.w[0] = td.w[3] = inlink->w;
+    td.w[1] = td.w[2] = cw;
+    td.h[0] = td.h[3] = in->height;
+    td.h[1] = td.h[2] = ch;
 
-    for (plane = 0; in->data[plane] && plane < 4; plane++)
-        vblur(out->data[plane], out->linesize[plane],
-              out->data[plane], out->linesize[plane],
-              w[plane], h[plane], s->radius[plane], s->power[plane],
-              s->temp);
+    ctx->internal->execute(ctx, hblur_slice, &td, NULL,
+                           FFMIN(FFMIN(ch, in->height), s->nb_threads));
+    ctx->internal->execute(ctx, vblur_slice, &td, NULL,
+                           FFMIN(FFMIN(cw, inlink->w), s->nb_threads));
 
     av_frame_free(&in);
 
@@ -384,4 +434,5 @@ AVFilter ff_vf_boxblur = {
 
     .inputs    = avfilter_vf_boxblur_inputs,
     .outputs   = avfilter_vf_boxblur_outputs,
+    .flags     = AVFILTER_FLAG_SLICE_THREADS,
 };
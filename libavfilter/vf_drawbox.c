@@ -92,13 +92,19 @@ static int config_input(AVFilterLink *inlink)
     return 0;
 }
 
-static int filter_frame(AVFilterLink *inlink, AVFrame *frame)
+static int draw_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
 {
-    DrawBoxContext *s = inlink->dst->priv;
+    DrawBoxContext *s = ctx->priv;
+    AVFrame *frame = arg;
     int plane, x, y, xb = s->x, yb = s->y;
+    /* rows sharing a chroma row must be drawn by the same job */
+    int slice_h     = FFALIGN(frame->height / nb_jobs, 1 << s->vsub);
+    int slice_start = jobnr * slice_h;
+    int slice_end   = (jobnr == nb_jobs - 1) ? frame->height :
+                                               FFMIN((jobnr + 1) * slice_h, frame->height);
     unsigned char *row[4];
 
-    for (y = FFMAX(yb, 0); y < frame->height && y < (yb + s->h); y++) {
+    for (y = FFMAX3(yb, 0, slice_start); y < slice_end && y < (yb + s->h); y++) {
         row[0] = frame->data[0] + y * frame->linesize[0];
 
         for (plane = 1; plane < 3; plane++)
@@ -117,7 +123,17 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *frame)
         }
     }
 
-    return ff_filter_frame(inlink->dst->outputs[0], frame);
+    return 0;
+}
+
+static int filter_frame(AVFilterLink *inlink, AVFrame *frame)
+{
+    AVFilterContext *ctx = inlink->dst;
+
+    ctx->internal->execute(ctx, draw_slice, frame, NULL,
+                           FFMIN(frame->height, ctx->graph->nb_threads));
+
+    return ff_filter_frame(ctx->outputs[0], frame);
 }
 
 #define OFFSET(x) offsetof(DrawBoxContext, x)
@@ -168,4 +184,5 @@ AVFilter ff_vf_drawbox = {
     .query_formats   = query_formats,
     .inputs    = avfilter_vf_drawbox_inputs,
     .outputs   = avfilter_vf_drawbox_outputs,
+    .flags     = AVFILTER_FLAG_SLICE_THREADS,
 };
@@ -79,46 +79,91 @@ void ff_gradfun_blur_line_c(uint16_t *dc, uint16_t *buf, uint16_t *buf1, uint8_t
     }
 }
 
-static void filter(GradFunContext *ctx, uint8_t *dst, uint8_t *src, int width, int height, int dst_linesize, int src_linesize, int r)
+typedef struct ThreadData {
+    uint8_t *dst, *src;
+    int width, height;
+    int dst_linesize, src_linesize;
+    int r;
+} ThreadData;
+
+/* blur the block rows around the row pair starting at y into dc */
+static void blur_rows(GradFunContext *ctx, uint16_t *dc, uint16_t *buf,
+                      uint8_t *src, int width, int src_linesize,
+                      int bstride, int r, int y)
 {
-    int bstride = FFALIGN(width, 16) / 2;
-    int y;
     uint32_t dc_factor = (1 << 21) / (r * r);
-    uint16_t *dc = ctx->buf + 16;
-    uint16_t *buf = ctx->buf + bstride + 32;
+    int mod = ((y + r) / 2) % r;
+    uint16_t *buf0 = buf + mod * bstride;
+    uint16_t *buf1 = buf + (mod ? mod - 1 : r - 1) * bstride;
+    int x, v;
+
+    ctx->blur_line(dc, buf0, buf1, src + (y + r) * src_linesize, src_linesize, width / 2);
+    for (x = v = 0; x < r; x++)
+        v += dc[x];
+    for (; x < width / 2; x++) {
+        v += dc[x] - dc[x-r];
+        dc[x-r] = v * dc_factor >> 16;
+    }
+    for (; x < (width + r + 1) / 2; x++)
+        dc[x-r] = v * dc_factor >> 16;
+    for (x = -r / 2; x < 0; x++)
+        dc[x] = dc[0];
+}
+
+/**
+ * Filter a slice of the rows of a plane.
+ *
+ * Slices other than the first start on an even row past the first r rows.
+ * Each slice rebuilds the running sums of the r block rows above its first
+ * row in its own buffer, so the output does not depend on the slicing.
+ */
+static int filter_slice(AVFilterContext *avctx, void *arg, int jobnr, int nb_jobs)
+{
+    GradFunContext *ctx = avctx->priv;
+    ThreadData *td = arg;
+    uint8_t *dst = td->dst, *src = td->src;
+    int width  = td->width, height = td->height;
+    int dst_linesize = td->dst_linesize, src_linesize = td->src_linesize;
+    int r = td->r;
+    int bstride = FFALIGN(width, 16) / 2;
+    uint16_t *dc  = ctx->buf + jobnr * ctx->buf_size + 16;
+    uint16_t *buf = ctx->buf + jobnr * ctx->buf_size + bstride + 32;
     int thresh = ctx->thresh;
+    int y, y_end, y_blur, k, k_start;
+
+    y     = r + (((height - r) *  jobnr     / nb_jobs) & ~1);
+    y_end = jobnr < nb_jobs - 1 ?
+            r + (((height - r) * (jobnr + 1) / nb_jobs) & ~1) : height;
+    if (y >= y_end)
+        return 0;
+
+    /* the last rows are filtered with the sums of the last blurred pair */
+    y_blur  = FFMIN(y, (height - r - 1) & ~1);
+    k_start = (y_blur - r) / 2;
 
     memset(dc, 0, (bstride + 16) * sizeof(*buf));
-    for (y = 0; y < r; y++)
-        ctx->blur_line(dc, buf + y * bstride, buf + (y - 1) * bstride, src + 2 * y * src_linesize, src_linesize, width / 2);
+    for (k = k_start; k < k_start + r; k++)
+        ctx->blur_line(dc, buf + k % r * bstride,
+                       k == k_start ? buf - bstride : buf + (k - 1) % r * bstride,
+                       src + 2 * k * src_linesize, src_linesize, width / 2);
+    if (y_blur < y)
+        blur_rows(ctx, dc, buf, src, width, src_linesize, bstride, r, y_blur);
+
     for (;;) {
-        if (y < height - r) {
-            int mod = ((y + r) / 2) % r;
-            uint16_t *buf0 = buf + mod * bstride;
-            uint16_t *buf1 = buf + (mod ? mod - 1 : r - 1) * bstride;
-            int x, v;
-            ctx->blur_line(dc, buf0, buf1, src + (y + r) * src_linesize, src_linesize, width / 2);
-            for (x = v = 0; x < r; x++)
-                v += dc[x];
-            for (; x < width / 2; x++) {
-                v += dc[x] - dc[x-r];
-                dc[x-r] = v * dc_factor >> 16;
-            }
-            for (; x < (width + r + 1) / 2; x++)
-                dc[x-r] = v * dc_factor >> 16;
-            for (x = -r / 2; x < 0; x++)
-                dc[x] = dc[0];
-        }
+        if (y < height - r)
+            blur_rows(ctx, dc, buf, src, width, src_linesize, bstride, r, y);
         if (y == r) {
             for (y = 0; y < r; y++)
                 ctx->filter_line(dst + y * dst_linesize, src + y * src_linesize, dc - r / 2, width, thresh, dither[y & 7]);
         }
         ctx->filter_line(dst + y * dst_linesize, src + y * src_linesize, dc - r / 2, width, thresh, dither[y & 7]);
-        if (++y >= height) break;
+        if (++y >= y_end) break;
         ctx->filter_line(dst + y * dst_linesize, src + y * src_linesize, dc - r / 2, width, thresh, dither[y & 7]);
-        if (++y >= height) break;
+        if (++y >= y_end) break;
     }
     emms_c();
+
+    return 0;
 }
 
 static av_cold int init(AVFilterContext *ctx)
@@ -167,8 +212,11 @@ static int config_input(AVFilterLink *inlink)
     int hsub = desc->log2_chroma_w;
     int vsub = desc->log2_chroma_h;
 
+    s->nb_threads = FFMAX(inlink->dst->graph->nb_threads, 1);
+    s->buf_size   = FFALIGN(inlink->w, 16) * (s->radius + 1) / 2 + 32;
+
     av_freep(&s->buf);
-    s->buf = av_mallocz((FFALIGN(inlink->w, 16) * (s->radius + 1) / 2 + 32) * sizeof(uint16_t));
+    s->buf = av_mallocz_array(s->nb_threads, s->buf_size * sizeof(uint16_t));
     if (!s->buf)
         return AVERROR(ENOMEM);
 
@@ -181,12 +229,15 @@ static int config_input(AVFilterLink *inlink)
 
 static int filter_frame(AVFilterLink *inlink, AVFrame *in)
 {
-    GradFunContext *s = inlink->dst->priv;
+    AVFilterContext *ctx = inlink->dst;
+    GradFunContext *s = ctx->priv;
     AVFilterLink *outlink = inlink->dst->outputs[0];
     AVFrame *out;
     int p, direct;
 
-    if (av_frame_is_writable(in)) {
+    /* the slices read source rows around their own, so they cannot be
+     * filtered in place */
+    if (av_frame_is_writable(in) && s->nb_threads == 1) {
         direct = 1;
         out = in;
     } else {
@@ -212,9 +263,19 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
             r = s->chroma_r;
         }
 
-        if (FFMIN(w, h) > 2 * r)
-            filter(s, out->data[p], in->data[p], w, h, out->linesize[p], in->linesize[p], r);
-        else if (out->data[p] != in->data[p])
+        if (FFMIN(w, h) > 2 * r) {
+            ThreadData td = {
+                .dst          = out->data[p],
+                .src          = in->data[p],
+                .width        = w,
+                .height       = h,
+                .dst_linesize = out->linesize[p],
+                .src_linesize = in->linesize[p],
+                .r            = r,
+            };
+            ctx->internal->execute(ctx, filter_slice, &td, NULL,
+                                   FFMIN((h - r) / 2, s->nb_threads));
+        } else if (out->data[p] != in->data[p])
             av_image_copy_plane(out->data[p], out->linesize[p], in->data[p], in->linesize[p], w, h);
     }
 
@@ -268,4 +329,5 @@ AVFilter ff_vf_gradfun = {
 
     .inputs    = avfilter_vf_gradfun_inputs,
     .outputs   = avfilter_vf_gradfun_outputs,
+    .flags     = AVFILTER_FLAG_SLICE_THREADS,
 };
@@ -283,31 +283,31 @@ static int config_props(AVFilterLink *inlink)
     return 0;
 }
 
-static int filter_frame(AVFilterLink *inlink, AVFrame *in)
+typedef struct ThreadData {
+    AVFrame *in, *out;
+    int w, h;
+} ThreadData;
+
+static int lut_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
 {
-    AVFilterContext *ctx = inlink->dst;
     LutContext *s = ctx->priv;
-    AVFilterLink *outlink = ctx->outputs[0];
-    AVFrame *out;
+    ThreadData *td = arg;
+    AVFrame *in = td->in, *out = td->out;
     uint8_t *inrow, *outrow, *inrow0, *outrow0;
     int i, j, k, plane;
 
-    out = ff_get_video_buffer(outlink, outlink->w, outlink->h);
-    if (!out) {
-        av_frame_free(&in);
-        return AVERROR(ENOMEM);
-    }
-    av_frame_copy_props(out, in);
-
     if (s->is_rgb) {
         /* packed */
-        inrow0  = in ->data[0];
-        outrow0 = out->data[0];
+        int slice_start = (td->h *  jobnr     ) / nb_jobs;
+        int slice_end   = (td->h * (jobnr + 1)) / nb_jobs;
 
-        for (i = 0; i < in->height; i ++) {
+        inrow0  = in ->data[0] + slice_start * in ->linesize[0];
+        outrow0 = out->data[0] + slice_start * out->linesize[0];
+
+        for (i = slice_start; i < slice_end; i ++) {
             inrow  = inrow0;
             outrow = outrow0;
-            for (j = 0; j < inlink->w; j++) {
+            for (j = 0; j < td->w; j++) {
                 for (k = 0; k < s->step; k++)
                     outrow[k] = s->lut[s->rgba_map[k]][inrow[k]];
                 outrow += s->step;
@@ -321,12 +321,15 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
         for (plane = 0; plane < 4 && in->data[plane]; plane++) {
             int vsub = plane == 1 || plane == 2 ? s->vsub : 0;
             int hsub = plane == 1 || plane == 2 ? s->hsub : 0;
+            int h = td->h >> vsub;
+            int slice_start = (h *  jobnr     ) / nb_jobs;
+            int slice_end   = (h * (jobnr + 1)) / nb_jobs;
 
-            inrow  = in ->data[plane];
-            outrow = out->data[plane];
+            inrow  = in ->data[plane] + slice_start * in ->linesize[plane];
+            outrow = out->data[plane] + slice_start * out->linesize[plane];
 
-            for (i = 0; i < in->height >> vsub; i ++) {
-                for (j = 0; j < inlink->w>>hsub; j++)
+            for (i = slice_start; i < slice_end; i ++) {
+                for (j = 0; j < td->w>>hsub; j++)
                     outrow[j] = s->lut[plane][inrow[j]];
                 inrow  += in ->linesize[plane];
                 outrow += out->linesize[plane];
@@ -334,6 +337,30 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
         }
     }
 
+    return 0;
+}
+
+static int filter_frame(AVFilterLink *inlink, AVFrame *in)
+{
+    AVFilterContext *ctx = inlink->dst;
+    AVFilterLink *outlink = ctx->outputs[0];
+    AVFrame *out;
+    ThreadData td;
+
+    out = ff_get_video_buffer(outlink, outlink->w, outlink->h);
+    if (!out) {
+        av_frame_free(&in);
+        return AVERROR(ENOMEM);
+    }
+    av_frame_copy_props(out, in);
+
+    td.in  = in;
+    td.out = out;
+    td.w   = inlink->w;
+    td.h   = in->height;
+    ctx->internal->execute(ctx, lut_slice, &td, NULL,
+                           FFMIN(in->height, ctx->graph->nb_threads));
+
     av_frame_free(&in);
     return ff_filter_frame(outlink, out);
 }
@@ -370,6 +397,7 @@ static const AVFilterPad outputs[] = {
                                                                         \
         .inputs        = inputs,                                        \
         .outputs       = outputs,                                       \
+        .flags         = AVFILTER_FLAG_SLICE_THREADS,                   \
     }
 
 #if CONFIG_LUT_FILTER
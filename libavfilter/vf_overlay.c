@@ -195,29 +195,33 @@ static int config_output(AVFilterLink *outlink)
     return 0;
 }
 
-static void blend_frame(AVFilterContext *ctx,
-                        AVFrame *dst, AVFrame *src,
-                        int x, int y)
+typedef struct ThreadData {
+    AVFrame *dst, *src;
+    int x, y;
+    int start_y, width, height;
+} ThreadData;
+
+static int blend_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
 {
     OverlayContext *s = ctx->priv;
+    ThreadData *td = arg;
+    AVFrame *dst = td->dst, *src = td->src;
+    int x = td->x, y = td->y;
+    int start_y = td->start_y;
+    int width = td->width, height = td->height;
     int i, j, k;
-    int width, height;
-    int overlay_end_y = y + src->height;
-    int end_y, start_y;
-
-    width = FFMIN(dst->width - x, src->width);
-    end_y = FFMIN(dst->height, overlay_end_y);
-    start_y = FFMAX(y, 0);
-    height = end_y - start_y;
 
     if (dst->format == AV_PIX_FMT_BGR24 || dst->format == AV_PIX_FMT_RGB24) {
-        uint8_t *dp = dst->data[0] + x * 3 + start_y * dst->linesize[0];
-        uint8_t *sp = src->data[0];
+        int slice_start = (height *  jobnr     ) / nb_jobs;
+        int slice_end   = (height * (jobnr + 1)) / nb_jobs;
+        uint8_t *dp = dst->data[0] + x * 3 +
+                      (start_y + slice_start) * dst->linesize[0];
+        uint8_t *sp = src->data[0] + slice_start * src->linesize[0];
         int b = dst->format == AV_PIX_FMT_BGR24 ? 2 : 0;
         int r = dst->format == AV_PIX_FMT_BGR24 ? 0 : 2;
         if (y < 0)
             sp += -y * src->linesize[0];
-        for (i = 0; i < height; i++) {
+        for (i = slice_start; i < slice_end; i++) {
             uint8_t *d = dp, *s = sp;
             for (j = 0; j < width; j++) {
                 d[r] = (d[r] * (0xff - s[3]) + s[0] * s[3] + 128) >> 8;
@@ -233,17 +237,20 @@ static void blend_frame(AVFilterContext *ctx,
         for (i = 0; i < 3; i++) {
             int hsub = i ? s->hsub : 0;
             int vsub = i ? s->vsub : 0;
-            uint8_t *dp = dst->data[i] + (x >> hsub) +
-                (start_y >> vsub) * dst->linesize[i];
-            uint8_t *sp = src->data[i];
-            uint8_t *ap = src->data[3];
             int wp = FFALIGN(width, 1<<hsub) >> hsub;
             int hp = FFALIGN(height, 1<<vsub) >> vsub;
+            int slice_start = (hp *  jobnr     ) / nb_jobs;
+            int slice_end   = (hp * (jobnr + 1)) / nb_jobs;
+            uint8_t *dp = dst->data[i] + (x >> hsub) +
+                ((start_y >> vsub) + slice_start) * dst->linesize[i];
+            uint8_t *sp = src->data[i] + slice_start * src->linesize[i];
+            uint8_t *ap = src->data[3] +
+                ((slice_start << vsub) * src->linesize[3]);
             if (y < 0) {
                 sp += ((-y) >> vsub) * src->linesize[i];
                 ap += -y * src->linesize[3];
             }
-            for (j = 0; j < hp; j++) {
+            for (j = slice_start; j < slice_end; j++) {
                 uint8_t *d = dp, *s = sp, *a = ap;
                 for (k = 0; k < wp; k++) {
                     // average alpha for color components, improve quality
@@ -269,6 +276,32 @@ static void blend_frame(AVFilterContext *ctx,
             }
         }
     }
+
+    return 0;
+}
+
+static void blend_frame(AVFilterContext *ctx,
+                        AVFrame *dst, AVFrame *src,
+                        int x, int y)
+{
+    ThreadData td;
+    int overlay_end_y = y + src->height;
+    int end_y;
+
+    td.dst     = dst;
+    td.src     = src;
+    td.x       = x;
+    td.y       = y;
+    td.width   = FFMIN(dst->width - x, src->width);
+    end_y      = FFMIN(dst->height, overlay_end_y);
+    td.start_y = FFMAX(y, 0);
+    td.height  = end_y - td.start_y;
+
+    if (td.width <= 0 || td.height <= 0)
+        return;
+
+    ctx->internal->execute(ctx, blend_slice, &td, NULL,
+                           FFMIN(td.height, ctx->graph->nb_threads));
 }
 
 static int filter_frame_main(AVFilterLink *inlink, AVFrame *frame)
@@ -428,4 +461,5 @@ AVFilter ff_vf_overlay = {
 
     .inputs    = avfilter_vf_overlay_inputs,
     .outputs   = avfilter_vf_overlay_outputs,
+    .flags     = AVFILTER_FLAG_SLICE_THREADS,
 };
@@ -80,6 +80,7 @@ typedef struct ScaleContext {
     int w, h;
     unsigned int flags;         ///sws flags
     double param[2];            // sws params
+    int nb_threads;             ///< sws threads, 0 to follow the filter graph
 
     int hsub, vsub;             ///< chroma subsampling
     int slice_y;                ///< top of current output slice
@@ -237,11 +238,33 @@ static int config_props(AVFilterLink *outlink)
         inlink->format == outlink->format)
         scale->sws = NULL;
     else {
-        scale->sws = sws_getContext(inlink ->w, inlink ->h, inlink ->format,
-                                    outlink->w, outlink->h, outlink->format,
-                                    scale->flags, NULL, NULL, scale->param);
+        int nb_threads = scale->nb_threads;
+
+        if (!nb_threads)
+            nb_threads = ctx->graph->thread_type & AVFILTER_THREAD_SLICE ?
+                         ctx->graph->nb_threads : 1;
+
+        scale->sws = sws_alloc_context();
         if (!scale->sws)
-            return AVERROR(EINVAL);
+            return AVERROR(ENOMEM);
+
+        av_opt_set_int(scale->sws, "srcw",       inlink ->w,      0);
+        av_opt_set_int(scale->sws, "srch",       inlink ->h,      0);
+        av_opt_set_int(scale->sws, "src_format", inlink ->format, 0);
+        av_opt_set_int(scale->sws, "dstw",       outlink->w,      0);
+        av_opt_set_int(scale->sws, "dsth",       outlink->h,      0);
+        av_opt_set_int(scale->sws, "dst_format", outlink->format, 0);
+        av_opt_set_int(scale->sws, "sws_flags",  scale->flags,    0);
+        av_opt_set_int(scale->sws, "threads",    nb_threads,      0);
+        av_opt_set_double(scale->sws, "param0",  scale->param[0], 0);
+        av_opt_set_double(scale->sws, "param1",  scale->param[1], 0);
+
+        ret = sws_init_context(scale->sws, NULL, NULL);
+        if (ret < 0) {
+            sws_freeContext(scale->sws);
+            scale->sws = NULL;
+            return ret;
+        }
     }
 
 
@@ -303,6 +326,7 @@ static const AVOption options[] = {
     { "flags", "Flags to pass to libswscale", OFFSET(flags_str), AV_OPT_TYPE_STRING, { .str = "bilinear" }, .flags = FLAGS },
     { "param0", "Scaler param 0",             OFFSET(param[0]),  AV_OPT_TYPE_DOUBLE, { .dbl = SWS_PARAM_DEFAULT  }, INT_MIN, INT_MAX, FLAGS },
     { "param1", "Scaler param 1",             OFFSET(param[1]),  AV_OPT_TYPE_DOUBLE, { .dbl = SWS_PARAM_DEFAULT  }, INT_MIN, INT_MAX, FLAGS },
+    { "threads", "Number of scaling threads, 0 to use the filter graph threads", OFFSET(nb_threads), AV_OPT_TYPE_INT, { .i64 = 0 }, 0, INT_MAX, FLAGS },
     { NULL },
 };
 
@@ -56,7 +56,8 @@ typedef struct FilterParam {
     int steps_y;                             ///< vertical step count
     int scalebits;                           ///< bits to shift pixel
     int32_t halfscale;                       ///< amount to add to pixel
-    uint32_t *sc[(MAX_SIZE * MAX_SIZE) - 1]; ///< finite state machine storage
+    uint32_t **sc;                           ///< finite state machine storage, 2 * steps_y rows per thread
+    int nb_sc;                               ///< number of allocated state rows
 } FilterParam;
 
 typedef struct UnsharpContext {
@@ -66,13 +67,17 @@ typedef struct UnsharpContext {
     FilterParam luma;   ///< luma parameters (width, height, amount)
     FilterParam chroma; ///< chroma parameters (width, height, amount)
     int hsub, vsub;
+    int nb_threads;     ///< number of state machine sets in each FilterParam
 } UnsharpContext;
 
+/* Filter the rows [slice_start, slice_end) of a plane. The state machine
+ * only remembers the last 2 * steps_y rows, so it is primed by running it
+ * from steps_y rows above the slice. */
 static void apply_unsharp(      uint8_t *dst, int dst_stride,
                           const uint8_t *src, int src_stride,
-                          int width, int height, FilterParam *fp)
+                          int width, int height, int slice_start, int slice_end,
+                          FilterParam *fp, uint32_t **sc)
 {
-    uint32_t **sc = fp->sc;
     uint32_t sr[(MAX_SIZE * MAX_SIZE) - 1], tmp1, tmp2;
 
     int32_t res;
@@ -80,20 +85,18 @@ static void apply_unsharp(      uint8_t *dst, int dst_stride,
     const uint8_t *src2;
 
     if (!fp->amount) {
-        if (dst_stride == src_stride)
-            memcpy(dst, src, src_stride * height);
-        else
-            for (y = 0; y < height; y++, dst += dst_stride, src += src_stride)
-                memcpy(dst, src, width);
+        src += slice_start * src_stride;
+        dst += slice_start * dst_stride;
+        for (y = slice_start; y < slice_end; y++, dst += dst_stride, src += src_stride)
+            memcpy(dst, src, width);
         return;
     }
 
     for (y = 0; y < 2 * fp->steps_y; y++)
         memset(sc[y], 0, sizeof(sc[y][0]) * (width + 2 * fp->steps_x));
 
-    for (y = -fp->steps_y; y < height + fp->steps_y; y++) {
-        if (y < height)
-            src2 = src;
+    for (y = slice_start - fp->steps_y; y < slice_end + fp->steps_y; y++) {
+        src2 = src + av_clip(y, 0, height - 1) * src_stride;
 
         memset(sr, 0, sizeof(sr[0]) * (2 * fp->steps_x - 1));
         for (x = -fp->steps_x; x < width + fp->steps_x; x++) {
@@ -106,18 +109,14 @@ static void apply_unsharp(      uint8_t *dst, int dst_stride,
                 tmp2 = sc[z + 0][x + fp->steps_x] + tmp1; sc[z + 0][x + fp->steps_x] = tmp1;
                 tmp1 = sc[z + 1][x + fp->steps_x] + tmp2; sc[z + 1][x + fp->steps_x] = tmp2;
             }
-            if (x >= fp->steps_x && y >= fp->steps_y) {
-                const uint8_t *srx = src - fp->steps_y * src_stride + x - fp->steps_x;
-                uint8_t *dsx       = dst - fp->steps_y * dst_stride + x - fp->steps_x;
+            if (x >= fp->steps_x && y >= slice_start + fp->steps_y) {
+                const uint8_t *srx = src + (y - fp->steps_y) * src_stride + x - fp->steps_x;
+                uint8_t *dsx       = dst + (y - fp->steps_y) * dst_stride + x - fp->steps_x;
 
                 res = (int32_t)*srx + ((((int32_t) * srx - (int32_t)((tmp1 + fp->halfscale) >> fp->scalebits)) * fp->amount) >> 16);
                 *dsx = av_clip_uint8(res);
             }
         }
-        if (y >= 0) {
-            dst += dst_stride;
-            src += src_stride;
-        }
     }
 }
 
@@ -156,8 +155,20 @@ static int query_formats(AVFilterContext *ctx)
     return 0;
 }
 
-static void init_filter_param(AVFilterContext *ctx, FilterParam *fp, const char *effect_type, int width)
+static void free_filter_param(FilterParam *fp)
+{
+    int z;
+
+    if (fp->sc)
+        for (z = 0; z < fp->nb_sc; z++)
+            av_free(fp->sc[z]);
+    av_freep(&fp->sc);
+    fp->nb_sc = 0;
+}
+
+static int init_filter_param(AVFilterContext *ctx, FilterParam *fp, const char *effect_type, int width)
 {
+    UnsharpContext *unsharp = ctx->priv;
     int z;
     const char *effect;
 
@@ -166,30 +177,38 @@ static void init_filter_param(AVFilterContext *ctx, FilterParam *fp, const char
     av_log(ctx, AV_LOG_VERBOSE, "effect:%s type:%s msize_x:%d msize_y:%d amount:%0.2f\n",
            effect, effect_type, fp->msize_x, fp->msize_y, fp->amount / 65535.0);
 
-    for (z = 0; z < 2 * fp->steps_y; z++)
+    fp->sc = av_mallocz(sizeof(*fp->sc) * 2 * fp->steps_y * unsharp->nb_threads);
+    if (!fp->sc)
+        return AVERROR(ENOMEM);
+    fp->nb_sc = 2 * fp->steps_y * unsharp->nb_threads;
+
+    for (z = 0; z < fp->nb_sc; z++) {
         fp->sc[z] = av_malloc(sizeof(*(fp->sc[z])) * (width + 2 * fp->steps_x));
+        if (!fp->sc[z])
+            return AVERROR(ENOMEM);
+    }
+
+    return 0;
 }
 
 static int config_props(AVFilterLink *link)
 {
     UnsharpContext *unsharp = link->dst->priv;
     const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(link->format);
+    int ret;
 
     unsharp->hsub = desc->log2_chroma_w;
     unsharp->vsub = desc->log2_chroma_h;
 
-    init_filter_param(link->dst, &unsharp->luma,   "luma",   link->w);
-    init_filter_param(link->dst, &unsharp->chroma, "chroma", AV_CEIL_RSHIFT(link->w, unsharp->hsub));
-
-    return 0;
-}
+    free_filter_param(&unsharp->luma);
+    free_filter_param(&unsharp->chroma);
 
-static void free_filter_param(FilterParam *fp)
-{
-    int z;
+    unsharp->nb_threads = FFMAX(link->dst->graph->nb_threads, 1);
 
-    for (z = 0; z < 2 * fp->steps_y; z++)
-        av_free(fp->sc[z]);
+    ret = init_filter_param(link->dst, &unsharp->luma,   "luma",   link->w);
+    if (ret < 0)
+        return ret;
+    return init_filter_param(link->dst, &unsharp->chroma, "chroma", AV_CEIL_RSHIFT(link->w, unsharp->hsub));
 }
 
 static av_cold void uninit(AVFilterContext *ctx)
@@ -200,13 +219,42 @@ static av_cold void uninit(AVFilterContext *ctx)
     free_filter_param(&unsharp->chroma);
 }
 
+typedef struct ThreadData {
+    AVFrame *in, *out;
+} ThreadData;
+
+static int unsharp_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    UnsharpContext *unsharp = ctx->priv;
+    AVFilterLink *link      = ctx->inputs[0];
+    ThreadData *td = arg;
+    AVFrame *in  = td->in;
+    AVFrame *out = td->out;
+    int plane;
+
+    for (plane = 0; plane < 3; plane++) {
+        FilterParam *fp = plane ? &unsharp->chroma : &unsharp->luma;
+        int w = plane ? AV_CEIL_RSHIFT(link->w, unsharp->hsub) : link->w;
+        int h = plane ? AV_CEIL_RSHIFT(link->h, unsharp->vsub) : link->h;
+        int slice_start = (h *  jobnr     ) / nb_jobs;
+        int slice_end   = (h * (jobnr + 1)) / nb_jobs;
+
+        apply_unsharp(out->data[plane], out->linesize[plane],
+                      in->data[plane],  in->linesize[plane],
+                      w, h, slice_start, slice_end,
+                      fp, fp->sc + jobnr * 2 * fp->steps_y);
+    }
+
+    return 0;
+}
+
 static int filter_frame(AVFilterLink *link, AVFrame *in)
 {
-    UnsharpContext *unsharp = link->dst->priv;
-    AVFilterLink *outlink   = link->dst->outputs[0];
+    AVFilterContext *ctx    = link->dst;
+    UnsharpContext *unsharp = ctx->priv;
+    AVFilterLink *outlink   = ctx->outputs[0];
     AVFrame *out;
-    int cw = AV_CEIL_RSHIFT(link->w, unsharp->hsub);
-    int ch = AV_CEIL_RSHIFT(link->h, unsharp->vsub);
+    ThreadData td;
 
     out = ff_get_video_buffer(outlink, outlink->w, outlink->h);
     if (!out) {
@@ -215,9 +263,11 @@ static int filter_frame(AVFilterLink *link, AVFrame *in)
     }
     av_frame_copy_props(out, in);
 
-    apply_unsharp(out->data[0], out->linesize[0], in->data[0], in->linesize[0], link->w, link->h, &unsharp->luma);
-    apply_unsharp(out->data[1], out->linesize[1], in->data[1], in->linesize[1], cw,      ch,      &unsharp->chroma);
-    apply_unsharp(out->data[2], out->linesize[2], in->data[2], in->linesize[2], cw,      ch,      &unsharp->chroma);
+    td.in  = in;
+    td.out = out;
+    ctx->internal->execute(ctx, unsharp_slice, &td, NULL,
+                           FFMIN(AV_CEIL_RSHIFT(link->h, unsharp->vsub),
+                                 unsharp->nb_threads));
 
     av_frame_free(&in);
     return ff_filter_frame(outlink, out);
@@ -274,4 +324,6 @@ AVFilter ff_vf_unsharp = {
     .inputs    = avfilter_vf_unsharp_inputs,
 
     .outputs   = avfilter_vf_unsharp_outputs,
+
+    .flags     = AVFILTER_FLAG_SLICE_THREADS,
 };
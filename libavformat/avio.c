@@ -247,6 +247,15 @@ int ffurl_read(URLContext *h, unsigned char *buf, int size)
     return retry_transfer_wrapper(h, buf, size, 1, h->prot->url_read);
 }
 
+int ffurl_read_ref(URLContext *h, int64_t offset, int size, AVBufferRef **buf)
+{
+    if (!(h->flags & AVIO_FLAG_READ))
+        return AVERROR(EIO);
+    if (!h->prot->url_read_ref)
+        return AVERROR(ENOSYS);
+    return h->prot->url_read_ref(h, offset, size, buf);
+}
+
 int ffurl_read_complete(URLContext *h, unsigned char *buf, int size)
 {
     if (!(h->flags & AVIO_FLAG_READ))
@@ -267,6 +276,61 @@ int ffurl_write(URLContext *h, const unsigned char *buf, int size)
                                   h->prot->url_write);
 }
 
+int ffurl_write_vec(URLContext *h, const uint8_t * const *bufs,
+                    const int *sizes, int nb_bufs)
+{
+    int i, ret, done = 0;
+    int fast_retries = 5;
+    int64_t wait_since = 0;
+
+    if (!(h->flags & AVIO_FLAG_WRITE))
+        return AVERROR(EIO);
+    for (i = 0; i < nb_bufs; i++)
+        if (h->max_packet_size && sizes[i] > h->max_packet_size)
+            return AVERROR(EIO);
+
+    if (!h->prot->url_write_vec) {
+        for (i = 0; i < nb_bufs; i++) {
+            ret = ffurl_write(h, bufs[i], sizes[i]);
+            if (ret < 0)
+                return ret;
+        }
+        return nb_bufs;
+    }
+
+    /* same retry logic as retry_transfer_wrapper(), counted in buffers */
+    while (done < nb_bufs) {
+        ret = h->prot->url_write_vec(h, bufs + done, sizes + done,
+                                     nb_bufs - done);
+        if (ret == AVERROR(EINTR))
+            continue;
+        if (ret == AVERROR(EAGAIN) && !(h->flags & AVIO_FLAG_NONBLOCK)) {
+            ret = 0;
+            if (fast_retries) {
+                fast_retries--;
+            } else {
+                if (h->rw_timeout) {
+                    if (!wait_since)
+                        wait_since = av_gettime_relative();
+                    else if (av_gettime_relative() > wait_since + h->rw_timeout)
+                        return AVERROR(EIO);
+                }
+                av_usleep(1000);
+            }
+        } else if (ret < 0) {
+            return ret;
+        }
+        if (ret) {
+            fast_retries = FFMAX(fast_retries, 2);
+            wait_since = 0;
+        }
+        done += ret;
+        if (ff_check_interrupt(&h->interrupt_callback))
+            return AVERROR_EXIT;
+    }
+    return done;
+}
+
 int64_t ffurl_seek(URLContext *h, int64_t pos, int whence)
 {
     int64_t ret;
@@ -53,6 +53,24 @@ int ffio_init_context(AVIOContext *s,
  */
 int ffio_read_indirect(AVIOContext *s, unsigned char *buf, int size, const unsigned char **data);
 
+/**
+ * Read size bytes as a read-only reference to the data of the underlying
+ * protocol instead of a copy, when the protocol supports it.
+ * The reference is followed by AV_INPUT_BUFFER_PADDING_SIZE readable, but
+ * not necessarily zeroed, bytes.
+ *
+ * @return size on success, AVERROR(ENOSYS) if a reference cannot be made,
+ *         in which case nothing was read
+ */
+int ffio_read_ref(AVIOContext *s, int size, AVBufferRef **buf);
+
+/**
+ * End the current packet of a context with max_packet_size set, like
+ * avio_flush() does, but allow the protocol to queue it and send it
+ * together with the following packets on the next avio_flush().
+ */
+void ffio_end_packet(AVIOContext *s);
+
 void ffio_fill(AVIOContext *s, int b, int count);
 
 static av_always_inline void ffio_wfourcc(AVIOContext *pb, const uint8_t *s)
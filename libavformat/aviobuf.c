@@ -40,6 +40,12 @@
  */
 #define SHORT_SEEK_THRESHOLD 4096
 
+/**
+ * Number of packets queued for one url_write_vec() call on packetized
+ * output contexts whose protocol supports it.
+ */
+#define IO_WRITE_BATCH 32
+
 typedef struct AVIOInternal {
     const AVClass *class;
 
@@ -48,6 +54,12 @@ typedef struct AVIOInternal {
 
     URLContext *h;
     const URLProtocol **protocols;
+
+    /* packets waiting for the next avio_flush(), max_packet_size each */
+    uint8_t *batch_buf;
+    const uint8_t *batch[IO_WRITE_BATCH];
+    int batch_size[IO_WRITE_BATCH];
+    int nb_batched;
 } AVIOInternal;
 
 static void *io_priv_child_next(void *obj, void *prev)
@@ -105,6 +117,7 @@ const AVClass ff_avio_class = {
 
 static void fill_buffer(AVIOContext *s);
 static int url_resetbuf(AVIOContext *s, int flags);
+static void io_flush_batch(AVIOContext *s);
 
 int ffio_init_context(AVIOContext *s,
                   unsigned char *buffer,
@@ -245,9 +258,15 @@ void avio_write(AVIOContext *s, const unsigned char *buf, int size)
 void avio_flush(AVIOContext *s)
 {
     flush_buffer(s);
+    io_flush_batch(s);
     s->must_flush = 0;
 }
 
+void ffio_end_packet(AVIOContext *s)
+{
+    flush_buffer(s);
+}
+
 int64_t avio_seek(AVIOContext *s, int64_t offset, int whence)
 {
     int64_t offset1;
@@ -795,10 +814,54 @@ static int io_read_packet(void *opaque, uint8_t *buf, int buf_size)
     return ffurl_read(internal->h, buf, buf_size);
 }
 
+static int io_write_batch(AVIOInternal *internal)
+{
+    int ret = 0;
+
+    if (internal->nb_batched)
+        ret = ffurl_write_vec(internal->h, internal->batch,
+                              internal->batch_size, internal->nb_batched);
+    internal->nb_batched = 0;
+    return ret < 0 ? ret : 0;
+}
+
 static int io_write_packet(void *opaque, uint8_t *buf, int buf_size)
 {
     AVIOInternal *internal = opaque;
-    return ffurl_write(internal->h, buf, buf_size);
+    int ret;
+
+    if (!internal->batch_buf)
+        return ffurl_write(internal->h, buf, buf_size);
+
+    if (buf_size > internal->h->max_packet_size)
+        return AVERROR(EIO);
+    memcpy(internal->batch_buf +
+           internal->nb_batched * internal->h->max_packet_size, buf, buf_size);
+    internal->batch_size[internal->nb_batched++] = buf_size;
+
+    if (internal->nb_batched == IO_WRITE_BATCH) {
+        ret = io_write_batch(internal);
+        if (ret < 0)
+            return ret;
+    }
+    return buf_size;
+}
+
+static void io_flush_batch(AVIOContext *s)
+{
+    AVIOInternal *internal = s->opaque;
+    int ret;
+
+    if (s->write_packet != io_write_packet || !internal->nb_batched)
+        return;
+
+    if (s->error) {
+        internal->nb_batched = 0;
+        return;
+    }
+    ret = io_write_batch(internal);
+    if (ret < 0)
+        s->error = ret;
 }
 
 static int64_t io_seek(void *opaque, int64_t offset, int whence)
@@ -823,6 +886,28 @@ static int64_t io_read_seek(void *opaque, int stream_index, int64_t timestamp, i
     return internal->h->prot->url_read_seek(internal->h, stream_index, timestamp, flags);
 }
 
+int ffio_read_ref(AVIOContext *s, int size, AVBufferRef **buf)
+{
+    AVIOInternal *internal = s->opaque;
+    int ret;
+
+    /* data that is already buffered is cheap enough to copy */
+    if (s->read_packet != io_read_packet || s->write_flag ||
+        s->update_checksum || size <= s->buf_end - s->buf_ptr)
+        return AVERROR(ENOSYS);
+
+    ret = ffurl_read_ref(internal->h, avio_tell(s), size, buf);
+    if (ret < 0)
+        return ret;
+
+    if (avio_skip(s, size) < 0) {
+        av_buffer_unref(buf);
+        return AVERROR(EIO);
+    }
+
+    return size;
+}
+
 int ffio_fdopen(AVIOContext **s, URLContext *h)
 {
     AVIOInternal *internal = NULL;
@@ -846,6 +931,19 @@ int ffio_fdopen(AVIOContext **s, URLContext *h)
     internal->class = &io_priv_class;
     internal->h = h;
 
+    /* queue the packets and hand them to the protocol in one call on
+     * avio_flush(), instead of making one call per packet */
+    if (max_packet_size && (h->flags & AVIO_FLAG_WRITE) &&
+        h->prot->url_write_vec) {
+        int i;
+
+        internal->batch_buf = av_malloc(IO_WRITE_BATCH * max_packet_size);
+        if (!internal->batch_buf)
+            goto fail;
+        for (i = 0; i < IO_WRITE_BATCH; i++)
+            internal->batch[i] = internal->batch_buf + i * max_packet_size;
+    }
+
     av_opt_set_defaults(internal);
 
     *s = avio_alloc_context(buffer, buffer_size, h->flags & AVIO_FLAG_WRITE,
@@ -865,8 +963,10 @@ int ffio_fdopen(AVIOContext **s, URLContext *h)
     (*s)->av_class = &ff_avio_class;
     return 0;
 fail:
-    if (internal)
+    if (internal) {
         av_opt_free(internal);
+        av_freep(&internal->batch_buf);
+    }
     av_freep(&internal);
     av_freep(&buffer);
     return AVERROR(ENOMEM);
@@ -1010,6 +1110,7 @@ int avio_close(AVIOContext *s)
     av_opt_free(internal);
 
     av_freep(&internal->protocols);
+    av_freep(&internal->batch_buf);
     av_freep(&s->opaque);
     av_freep(&s->buffer);
 
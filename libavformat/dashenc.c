@@ -34,6 +34,7 @@
 #include "avc.h"
 #include "avformat.h"
 #include "avio_internal.h"
+#include "hlsplaylist.h"
 #include "internal.h"
 #include "isom.h"
 #include "os_support.h"
@@ -105,6 +106,8 @@ typedef struct DASHContext {
     const char *init_seg_name;
     const char *media_seg_name;
     const char *utc_timing_url;
+    int hls_playlist;
+    int http_persistent;
 } DASHContext;
 
 static struct codec_string {
@@ -677,6 +680,181 @@ end:
     return 0;
 }
 
+static void set_http_options(DASHContext *c, AVDictionary **options)
+{
+    if (c->http_persistent)
+        av_dict_set(options, "connection_pool", "1", 0);
+}
+
+/* Only local files can be written aside and renamed into place, remote
+ * ones are written directly. */
+static int use_temp_file(const char *filename)
+{
+    return !strstr(filename, "://") || av_strstart(filename, "file:", NULL);
+}
+
+/**
+ * Open filename for writing, through a temporary file if it is local.
+ * The name actually opened is returned in temp_filename.
+ */
+static int dash_open_write(AVFormatContext *s, AVIOContext **pb,
+                           const char *filename,
+                           char *temp_filename, int temp_size)
+{
+    DASHContext *c = s->priv_data;
+    AVDictionary *opts = NULL;
+    int ret;
+
+    snprintf(temp_filename, temp_size,
+             use_temp_file(filename) ? "%s.tmp" : "%s", filename);
+    set_http_options(c, &opts);
+    ret = s->io_open(s, pb, temp_filename, AVIO_FLAG_WRITE, &opts);
+    av_dict_free(&opts);
+    if (ret < 0)
+        av_log(s, AV_LOG_ERROR, "Unable to open %s for writing\n", temp_filename);
+    return ret;
+}
+
+static int dash_rename(const char *temp_filename, const char *filename)
+{
+    if (!strcmp(temp_filename, filename))
+        return 0;
+    return ff_rename(temp_filename, filename);
+}
+
+static int get_hls_playlist_name(char *name, int name_size,
+                                 const char *dirname, int id)
+{
+    int len;
+
+    if (id >= 0)
+        len = snprintf(name, name_size, "%smedia_%d.m3u8", dirname, id);
+    else
+        len = snprintf(name, name_size, "%smaster.m3u8", dirname);
+
+    return len < name_size ? 0 : AVERROR(ENAMETOOLONG);
+}
+
+static int write_hls_media_playlist(AVFormatContext *s, int id, int final)
+{
+    DASHContext *c = s->priv_data;
+    OutputStream *os = &c->streams[id];
+    AVStream *st = s->streams[id];
+    AVIOContext *out;
+    char filename[1024], temp_filename[1024];
+    int64_t target_duration = 0;
+    int ret, i, start_index = 0;
+
+    if (c->window_size)
+        start_index = FFMAX(os->nb_segments - c->window_size, 0);
+    for (i = start_index; i < os->nb_segments; i++)
+        target_duration = FFMAX(target_duration,
+                                av_rescale_q(os->segments[i]->duration,
+                                             st->time_base, AV_TIME_BASE_Q));
+
+    if ((ret = get_hls_playlist_name(filename, sizeof(filename), c->dirname, id)) < 0)
+        return ret;
+    ret = dash_open_write(s, &out, filename, temp_filename, sizeof(temp_filename));
+    if (ret < 0)
+        return ret;
+
+    ff_hls_write_playlist_header(out, 6, -1,
+                                 av_rescale_rnd(target_duration, 1, AV_TIME_BASE,
+                                                AV_ROUND_UP),
+                                 os->segment_index - os->nb_segments + start_index);
+    ff_hls_write_init_file(out, NULL, os->initfile,
+                           c->single_file ? os->init_range_length : 0,
+                           os->init_start_pos);
+    for (i = start_index; i < os->nb_segments; i++) {
+        Segment *seg = os->segments[i];
+        ff_hls_write_file_entry(out, 6, NULL,
+                                c->single_file ? os->initfile : seg->file,
+                                av_rescale_q(seg->duration, st->time_base,
+                                             AV_TIME_BASE_Q),
+                                c->single_file ? seg->range_length : 0,
+                                seg->start_pos);
+    }
+    if (final)
+        ff_hls_write_end_list(out);
+
+    ff_format_io_close(s, &out);
+    return dash_rename(temp_filename, filename);
+}
+
+static int write_hls_master_playlist(AVFormatContext *s)
+{
+    DASHContext *c = s->priv_data;
+    AVIOContext *out;
+    OutputStream *audio = NULL;
+    char filename[1024], temp_filename[1024], name[32];
+    int ret, i, audio_bit_rate = 0;
+
+    if ((ret = get_hls_playlist_name(filename, sizeof(filename), c->dirname, -1)) < 0)
+        return ret;
+    ret = dash_open_write(s, &out, filename, temp_filename, sizeof(temp_filename));
+    if (ret < 0)
+        return ret;
+
+    ff_hls_write_playlist_version(out, 6);
+
+    // Audio goes to a rendition group shared by all the video variants.
+    for (i = 0; i < s->nb_streams; i++) {
+        OutputStream *os = &c->streams[i];
+        if (strcmp(os->format_name, "mp4") ||
+            s->streams[i]->codecpar->codec_type != AVMEDIA_TYPE_AUDIO)
+            continue;
+        if (c->has_video) {
+            char rendition[32];
+            snprintf(rendition, sizeof(rendition), "audio_%d", i);
+            snprintf(name, sizeof(name), "media_%d.m3u8", i);
+            ff_hls_write_audio_rendition(out, "audio", rendition, name, !audio);
+        }
+        if (!audio)
+            audio = os;
+        audio_bit_rate = FFMAX(audio_bit_rate, os->bit_rate);
+    }
+
+    for (i = 0; i < s->nb_streams; i++) {
+        OutputStream *os = &c->streams[i];
+        enum AVMediaType type = s->streams[i]->codecpar->codec_type;
+        char codecs[sizeof(os->codec_str) * 2];
+
+        if (strcmp(os->format_name, "mp4") ||
+            (c->has_video && type != AVMEDIA_TYPE_VIDEO))
+            continue;
+
+        av_strlcpy(codecs, os->codec_str, sizeof(codecs));
+        if (type == AVMEDIA_TYPE_VIDEO && audio && audio->codec_str[0])
+            av_strlcatf(codecs, sizeof(codecs), ",%s", audio->codec_str);
+
+        snprintf(name, sizeof(name), "media_%d.m3u8", i);
+        ff_hls_write_stream_info(out,
+                                 os->bit_rate + (type == AVMEDIA_TYPE_VIDEO ?
+                                                 audio_bit_rate : 0),
+                                 codecs,
+                                 type == AVMEDIA_TYPE_VIDEO && audio ?
+                                 "audio" : NULL, name);
+    }
+
+    ff_format_io_close(s, &out);
+    return dash_rename(temp_filename, filename);
+}
+
+static int write_hls_playlists(AVFormatContext *s, int final)
+{
+    DASHContext *c = s->priv_data;
+    int ret, i;
+
+    for (i = 0; i < s->nb_streams; i++) {
+        if (strcmp(c->streams[i].format_name, "mp4"))
+            continue;
+        if ((ret = write_hls_media_playlist(s, i, final)) < 0)
+            return ret;
+    }
+
+    return write_hls_master_playlist(s);
+}
+
 static int write_manifest(AVFormatContext *s, int final)
 {
     DASHContext *c = s->priv_data;
@@ -685,12 +863,9 @@ static int write_manifest(AVFormatContext *s, int final)
     int ret, i;
     AVDictionaryEntry *title = av_dict_get(s->metadata, "title", NULL, 0);
 
-    snprintf(temp_filename, sizeof(temp_filename), "%s.tmp", s->filename);
-    ret = s->io_open(s, &out, temp_filename, AVIO_FLAG_WRITE, NULL);
-    if (ret < 0) {
-        av_log(s, AV_LOG_ERROR, "Unable to open %s for writing\n", temp_filename);
+    ret = dash_open_write(s, &out, s->filename, temp_filename, sizeof(temp_filename));
+    if (ret < 0)
         return ret;
-    }
     avio_printf(out, "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n");
     avio_printf(out, "<MPD xmlns:xsi=\"http://www.w3.org/2001/XMLSchema-instance\"\n"
                 "\txmlns=\"urn:mpeg:dash:schema:mpd:2011\"\n"
@@ -755,7 +930,11 @@ static int write_manifest(AVFormatContext *s, int final)
     avio_printf(out, "</MPD>\n");
     avio_flush(out);
     ff_format_io_close(s, &out);
-    return ff_rename(temp_filename, s->filename);
+    ret = dash_rename(temp_filename, s->filename);
+    if (ret < 0 || !c->hls_playlist)
+        return ret;
+
+    return write_hls_playlists(s, final);
 }
 
 static int dict_copy_entry(AVDictionary **dst, const AVDictionary *src, const char *key)
@@ -885,7 +1064,9 @@ static int dash_write_header(AVFormatContext *s)
             dash_fill_tmpl_params(os->initfile, sizeof(os->initfile), c->init_seg_name, i, 0, os->bit_rate, 0);
         }
         snprintf(filename, sizeof(filename), "%s%s", c->dirname, os->initfile);
-        ret = s->io_open(s, &os->out, filename, AVIO_FLAG_WRITE, NULL);
+        set_http_options(c, &opts);
+        ret = s->io_open(s, &os->out, filename, AVIO_FLAG_WRITE, &opts);
+        av_dict_free(&opts);
         if (ret < 0)
             goto fail;
         os->init_start_pos = 0;
@@ -1067,8 +1248,7 @@ static int dash_flush(AVFormatContext *s, int final, int stream)
         if (!c->single_file) {
             dash_fill_tmpl_params(filename, sizeof(filename), c->media_seg_name, i, os->segment_index, os->bit_rate, os->start_pts);
             snprintf(full_path, sizeof(full_path), "%s%s", c->dirname, filename);
-            snprintf(temp_path, sizeof(temp_path), "%s.tmp", full_path);
-            ret = s->io_open(s, &os->out, temp_path, AVIO_FLAG_WRITE, NULL);
+            ret = dash_open_write(s, &os->out, full_path, temp_path, sizeof(temp_path));
             if (ret < 0)
                 break;
             if (!strcmp(os->format_name, "mp4"))
@@ -1086,7 +1266,7 @@ static int dash_flush(AVFormatContext *s, int final, int stream)
             find_index_range(s, full_path, os->pos, &index_length);
         } else {
             ff_format_io_close(s, &os->out);
-            ret = ff_rename(temp_path, full_path);
+            ret = dash_rename(temp_path, full_path);
             if (ret < 0)
                 break;
         }
@@ -1233,7 +1413,13 @@ static int dash_write_trailer(AVFormatContext *s)
             OutputStream *os = &c->streams[i];
             snprintf(filename, sizeof(filename), "%s%s", c->dirname, os->initfile);
             unlink(filename);
+            if (c->hls_playlist &&
+                get_hls_playlist_name(filename, sizeof(filename), c->dirname, i) >= 0)
+                unlink(filename);
         }
+        if (c->hls_playlist &&
+            get_hls_playlist_name(filename, sizeof(filename), c->dirname, -1) >= 0)
+            unlink(filename);
         unlink(s->filename);
     }
 
@@ -1256,6 +1442,8 @@ static const AVOption options[] = {
     { "init_seg_name", "DASH-templated name to used for the initialization segment", OFFSET(init_seg_name), AV_OPT_TYPE_STRING, {.str = "init-stream$RepresentationID$.m4s"}, 0, 0, E },
     { "media_seg_name", "DASH-templated name to used for the media segments", OFFSET(media_seg_name), AV_OPT_TYPE_STRING, {.str = "chunk-stream$RepresentationID$-$Number%05d$.m4s"}, 0, 0, E },
     { "utc_timing_url", "URL of the page that will return the UTC timestamp in ISO format", OFFSET(utc_timing_url), AV_OPT_TYPE_STRING, { 0 }, 0, 0, AV_OPT_FLAG_ENCODING_PARAM },
+    { "hls_playlist", "Generate HLS playlists referencing the same segments", OFFSET(hls_playlist), AV_OPT_TYPE_INT, { .i64 = 0 }, 0, 1, E },
+    { "http_persistent", "Reuse HTTP connections from a process-wide pool", OFFSET(http_persistent), AV_OPT_TYPE_INT, { .i64 = 0 }, 0, 1, E },
     { NULL },
 };
 
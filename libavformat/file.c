@@ -20,6 +20,7 @@
  */
 
 #include "libavutil/avstring.h"
+#include "libavutil/buffer.h"
 #include "libavutil/internal.h"
 #include "libavutil/opt.h"
 #include "avformat.h"
@@ -30,6 +31,9 @@
 #if HAVE_UNISTD_H
 #include <unistd.h>
 #endif
+#if HAVE_MMAP
+#include <sys/mman.h>
+#endif
 #include <sys/stat.h>
 #include <stdlib.h>
 #include "os_support.h"
@@ -38,16 +42,27 @@
 
 /* standard file protocol */
 
+/* amount of data prefetched ahead of the read position in mmap mode */
+#define MMAP_READAHEAD (4 << 20)
+
 typedef struct FileContext {
     const AVClass *class;
     int fd;
     int trunc;
     int follow;
+    int use_mmap;
+
+    /* mmap mode, map holds the whole file */
+    AVBufferRef *map;
+    int64_t map_size;
+    int64_t pos;
+    int64_t ra_start, ra_end;   ///< range prefetched with madvise
 } FileContext;
 
 static const AVOption file_options[] = {
     { "truncate", "Truncate existing files on write", offsetof(FileContext, trunc), AV_OPT_TYPE_INT, { .i64 = 1 }, 0, 1, AV_OPT_FLAG_ENCODING_PARAM },
     { "follow", "Follow a file as it is being written", offsetof(FileContext, follow), AV_OPT_TYPE_INT, { .i64 = 0 }, 0, 1, AV_OPT_FLAG_DECODING_PARAM },
+    { "mmap", "Map the file in memory and read packets from it without copying", offsetof(FileContext, use_mmap), AV_OPT_TYPE_INT, { .i64 = 0 }, 0, 1, AV_OPT_FLAG_DECODING_PARAM },
     { NULL }
 };
 
@@ -58,10 +73,112 @@ static const AVClass file_class = {
     .version    = LIBAVUTIL_VERSION_INT,
 };
 
+#if HAVE_MMAP
+/**
+ * Prefetch the data following an access to [pos, pos + size) in the mapping.
+ * Sequential accesses extend the prefetched range, jumps restart it.
+ */
+static void mmap_readahead(FileContext *c, int64_t pos, int size)
+{
+    int64_t start, end;
+    int64_t page_mask = sysconf(_SC_PAGESIZE) - 1;
+
+    if (pos < c->ra_start || pos > c->ra_end) {
+        c->ra_start = pos;
+        c->ra_end   = pos;
+    }
+    if (pos + size + MMAP_READAHEAD / 2 <= c->ra_end)
+        return;
+
+    start = FFMAX(pos, c->ra_end) & ~page_mask;
+    end   = FFMIN(pos + size + MMAP_READAHEAD, c->map_size);
+    if (end > start)
+        posix_madvise(c->map->data + start, end - start, POSIX_MADV_WILLNEED);
+    c->ra_end = end;
+}
+
+static void file_unmap(void *opaque, uint8_t *data)
+{
+    munmap(data, (size_t)(uintptr_t)opaque);
+}
+
+static int file_map(URLContext *h)
+{
+    FileContext *c = h->priv_data;
+    struct stat st;
+    void *ptr;
+
+    if (fstat(c->fd, &st) < 0 || !S_ISREG(st.st_mode) || st.st_size <= 0 ||
+        st.st_size != (size_t)st.st_size)
+        return AVERROR(ENOSYS);
+
+    ptr = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, c->fd, 0);
+    if (ptr == MAP_FAILED)
+        return AVERROR(errno);
+
+    /* the buffer size is not used, the mapping may be larger than INT_MAX */
+    c->map = av_buffer_create(ptr, 0, file_unmap,
+                              (void *)(uintptr_t)st.st_size,
+                              AV_BUFFER_FLAG_READONLY);
+    if (!c->map) {
+        munmap(ptr, st.st_size);
+        return AVERROR(ENOMEM);
+    }
+    c->map_size = st.st_size;
+
+    return 0;
+}
+
+static void file_unref_map(void *opaque, uint8_t *data)
+{
+    AVBufferRef *map = opaque;
+    av_buffer_unref(&map);
+}
+
+static int file_read_ref(URLContext *h, int64_t offset, int size,
+                         AVBufferRef **buf)
+{
+    FileContext *c = h->priv_data;
+    AVBufferRef *map;
+
+    /* the padding of the packet has to be readable as well */
+    if (!c->map || offset < 0 || size <= 0 ||
+        offset + size + AV_INPUT_BUFFER_PADDING_SIZE > c->map_size)
+        return AVERROR(ENOSYS);
+
+    map = av_buffer_ref(c->map);
+    if (!map)
+        return AVERROR(ENOMEM);
+
+    *buf = av_buffer_create(c->map->data + offset, size, file_unref_map,
+                            map, AV_BUFFER_FLAG_READONLY);
+    if (!*buf) {
+        av_buffer_unref(&map);
+        return AVERROR(ENOMEM);
+    }
+
+    mmap_readahead(c, offset, size);
+
+    return size;
+}
+#endif
+
 static int file_read(URLContext *h, unsigned char *buf, int size)
 {
     FileContext *c = h->priv_data;
-    int ret = read(c->fd, buf, size);
+    int ret;
+
+#if HAVE_MMAP
+    if (c->map) {
+        size = FFMIN(size, FFMAX(c->map_size - c->pos, 0));
+        memcpy(buf, c->map->data + c->pos, size);
+        mmap_readahead(c, c->pos, size);
+        c->pos += size;
+        return size;
+    }
+#endif
+
+    ret = read(c->fd, buf, size);
     if (ret == 0 && c->follow)
         return AVERROR(EAGAIN);
     return (ret == -1) ? AVERROR(errno) : ret;
@@ -126,6 +243,17 @@ static int file_open(URLContext *h, const char *filename, int flags)
     if (fd == -1)
         return AVERROR(errno);
     c->fd = fd;
+
+#if HAVE_MMAP
+    /* a followed file keeps growing past the mapping */
+    if (c->use_mmap && !(flags & AVIO_FLAG_WRITE) && !c->follow) {
+        int ret = file_map(h);
+        if (ret < 0)
+            av_log(h, AV_LOG_VERBOSE,
+                   "Cannot map the file, reading it instead.\n");
+    }
+#endif
+
     return 0;
 }
 
@@ -142,6 +270,20 @@ static int64_t file_seek(URLContext *h, int64_t pos, int whence)
         return ret < 0 ? AVERROR(errno) : st.st_size;
     }
 
+#if HAVE_MMAP
+    if (c->map) {
+        if (whence == SEEK_CUR)
+            pos += c->pos;
+        else if (whence == SEEK_END)
+            pos += c->map_size;
+        else if (whence != SEEK_SET)
+            return AVERROR(EINVAL);
+        if (pos < 0)
+            return AVERROR(EINVAL);
+        return c->pos = pos;
+    }
+#endif
+
     ret = lseek(c->fd, pos, whence);
 
     return ret < 0 ? AVERROR(errno) : ret;
@@ -150,6 +292,9 @@ static int64_t file_seek(URLContext *h, int64_t pos, int whence)
 static int file_close(URLContext *h)
 {
     FileContext *c = h->priv_data;
+
+    /* packets may still reference the mapping, it outlives the descriptor */
+    av_buffer_unref(&c->map);
     return close(c->fd);
 }
 
@@ -157,6 +302,9 @@ const URLProtocol ff_file_protocol = {
     .name                = "file",
     .url_open            = file_open,
     .url_read            = file_read,
+#if HAVE_MMAP
+    .url_read_ref        = file_read_ref,
+#endif
     .url_write           = file_write,
     .url_seek            = file_seek,
     .url_close           = file_close,
@@ -35,7 +35,16 @@
 #include "internal.h"
 #include "avio_internal.h"
 
+#if HAVE_PTHREADS
+#include <pthread.h>
+#elif HAVE_W32THREADS
+#include "compat/w32pthreads.h"
+#endif
+
+#define HLS_PREFETCH (HAVE_PTHREADS || HAVE_W32THREADS)
+
 #define INITIAL_BUFFER_SIZE 32768
+#define PREFETCH_CHUNK_SIZE 65536
 
 /*
  * An apple http stream consists of a playlist with media segment files,
@@ -62,6 +71,18 @@ struct segment {
     uint8_t iv[16];
 };
 
+/*
+ * A segment downloaded into memory by the prefetch threads.
+ * seq_no is -1 for an unused slot.
+ */
+struct prefetch_slot {
+    int seq_no;
+    int done;
+    int ret;
+    uint8_t *data;
+    int size;
+};
+
 /*
  * Each variant has its own demuxer. If it currently is active,
  * it has an open AVIOContext too, and potentially an AVPacket
@@ -90,9 +111,32 @@ struct variant {
 
     char key_url[MAX_URL_SIZE];
     uint8_t key[16];
+
+    /* Prefetching: prefetch threads download the segments from fetch_seq_no
+     * to fetch_seq_no + prefetch into slots in parallel, one of them reloads
+     * the playlist of live streams. While they run, the playlist fields
+     * above are protected by mutex. seg_data is the segment currently being
+     * demuxed. */
+    struct prefetch_slot *slots;
+    int fetch_seq_no;
+    int fetch_ret;
+    uint8_t *seg_data;
+    int seg_size, seg_pos;
+#if HLS_PREFETCH
+    AVFormatContext *fetch_ctx; ///< opens the files of the prefetch threads
+    pthread_t *threads;
+    int nb_threads;
+    pthread_mutex_t mutex;
+    pthread_mutex_t key_mutex;
+    pthread_cond_t cond;
+    int thread_exit;
+    int reloading;
+    int64_t reload_interval;
+#endif
 };
 
 typedef struct HLSContext {
+    const AVClass *class;
     AVFormatContext *ctx;
     int n_variants;
     struct variant **variants;
@@ -104,6 +148,8 @@ typedef struct HLSContext {
     int seek_flags;
     AVIOInterruptCB *interrupt_callback;
     AVDictionary *avio_opts;
+    int prefetch;
+    int http_persistent;
 } HLSContext;
 
 static int read_chomp_line(AVIOContext *s, char *buf, int maxlen)
@@ -123,11 +169,43 @@ static void free_segment_list(struct variant *var)
     var->n_segments = 0;
 }
 
+static void stop_prefetch(struct variant *var)
+{
+    HLSContext *c;
+    int i;
+
+    if (!var->slots)
+        return;
+    c = var->parent->priv_data;
+
+#if HLS_PREFETCH
+    pthread_mutex_lock(&var->mutex);
+    var->thread_exit = 1;
+    pthread_cond_broadcast(&var->cond);
+    pthread_mutex_unlock(&var->mutex);
+    for (i = 0; i < var->nb_threads; i++)
+        pthread_join(var->threads[i], NULL);
+    av_freep(&var->threads);
+    var->nb_threads = 0;
+    avformat_free_context(var->fetch_ctx);
+    var->fetch_ctx = NULL;
+    pthread_cond_destroy(&var->cond);
+    pthread_mutex_destroy(&var->key_mutex);
+    pthread_mutex_destroy(&var->mutex);
+#endif
+
+    for (i = 0; i <= c->prefetch; i++)
+        av_free(var->slots[i].data);
+    av_freep(&var->slots);
+    av_freep(&var->seg_data);
+}
+
 static void free_variant_list(HLSContext *c)
 {
     int i;
     for (i = 0; i < c->n_variants; i++) {
         struct variant *var = c->variants[i];
+        stop_prefetch(var);
         free_segment_list(var);
         av_packet_unref(&var->pkt);
         av_free(var->pb.buffer);
@@ -358,25 +436,31 @@ fail:
     return ret;
 }
 
-static int open_input(struct variant *var)
+static int open_input(struct variant *var, struct segment *seg,
+                      AVIOContext **in)
 {
     HLSContext *c = var->parent->priv_data;
-    struct segment *seg = var->segments[var->cur_seq_no - var->start_seq_no];
+    AVFormatContext *s = var->parent;
+
+#if HLS_PREFETCH
+    if (var->fetch_ctx)
+        s = var->fetch_ctx;
+#endif
     if (seg->key_type == KEY_NONE) {
-        return open_url(var->parent, &var->input, seg->url, c->avio_opts);
+        return open_url(s, in, seg->url, c->avio_opts);
     } else if (seg->key_type == KEY_AES_128) {
         AVDictionary *opts = NULL;
         char iv[33], key[33], url[MAX_URL_SIZE];
         int ret;
         if (strcmp(seg->key, var->key_url)) {
             AVIOContext *pb;
-            if (open_url(var->parent, &pb, seg->key, c->avio_opts) == 0) {
+            if (open_url(s, &pb, seg->key, c->avio_opts) == 0) {
                 ret = avio_read(pb, var->key, sizeof(var->key));
                 if (ret != sizeof(var->key)) {
                     av_log(NULL, AV_LOG_ERROR, "Unable to read key file %s\n",
                            seg->key);
                 }
-                ff_format_io_close(var->parent, &pb);
+                ff_format_io_close(s, &pb);
             } else {
                 av_log(NULL, AV_LOG_ERROR, "Unable to open key file %s\n",
                        seg->key);
@@ -395,13 +479,348 @@ static int open_input(struct variant *var)
         av_dict_set(&opts, "key", key, 0);
         av_dict_set(&opts, "iv", iv, 0);
 
-        ret = open_url(var->parent, &var->input, url, opts);
+        ret = open_url(s, in, url, opts);
         av_dict_free(&opts);
         return ret;
     }
     return AVERROR(ENOSYS);
 }
 
+#if HLS_PREFETCH
+static int fetch_segment(struct variant *v, struct segment *seg,
+                         uint8_t **data, int *size)
+{
+    AVIOContext *in = NULL;
+    int ret, len = 0, alloc = 0;
+
+    *data = NULL;
+    /* the cached key of the variant is shared by the threads */
+    if (seg->key_type != KEY_NONE)
+        pthread_mutex_lock(&v->key_mutex);
+    ret = open_input(v, seg, &in);
+    if (seg->key_type != KEY_NONE)
+        pthread_mutex_unlock(&v->key_mutex);
+    if (ret < 0)
+        return ret;
+
+    for (;;) {
+        if (len == alloc) {
+            if (alloc > INT_MAX / 2) {
+                ret = AVERROR(ENOMEM);
+                break;
+            }
+            alloc = alloc ? 2 * alloc : PREFETCH_CHUNK_SIZE;
+            if ((ret = av_reallocp(data, alloc)) < 0)
+                break;
+        }
+        ret = avio_read(in, *data + len, alloc - len);
+        if (ret <= 0)
+            break;
+        len += ret;
+    }
+    ff_format_io_close(v->fetch_ctx, &in);
+
+    /* a read error ends the segment, like in read_data() */
+    if (ret == AVERROR(ENOMEM)) {
+        av_freep(data);
+        return ret;
+    }
+    *size = len;
+    return 0;
+}
+
+/* Reload a live playlist without holding the lock, then swap it in. */
+static int reload_playlist(struct variant *v)
+{
+    HLSContext *c = v->parent->priv_data;
+    struct variant *tmp;
+    AVIOContext *in;
+    int ret;
+
+    if ((ret = open_url(v->fetch_ctx, &in, v->url, c->avio_opts)) < 0)
+        return ret;
+    if (!(tmp = av_mallocz(sizeof(*tmp)))) {
+        ff_format_io_close(v->fetch_ctx, &in);
+        return AVERROR(ENOMEM);
+    }
+
+    ret = parse_playlist(c, v->url, tmp, in);
+    ff_format_io_close(v->fetch_ctx, &in);
+
+    pthread_mutex_lock(&v->mutex);
+    if (ret >= 0) {
+        free_segment_list(v);
+        v->segments        = tmp->segments;
+        v->n_segments      = tmp->n_segments;
+        v->start_seq_no    = tmp->start_seq_no;
+        v->target_duration = tmp->target_duration;
+        v->finished        = tmp->finished;
+        tmp->segments      = NULL;
+        tmp->n_segments    = 0;
+    }
+    v->last_load_time = av_gettime_relative();
+    pthread_mutex_unlock(&v->mutex);
+
+    free_segment_list(tmp);
+    av_free(tmp);
+    return ret;
+}
+
+static struct prefetch_slot *find_slot(struct variant *v, int seq_no)
+{
+    HLSContext *c = v->parent->priv_data;
+    int i;
+
+    for (i = 0; i <= c->prefetch; i++)
+        if (v->slots[i].seq_no == seq_no)
+            return &v->slots[i];
+    return NULL;
+}
+
+static void *prefetch_thread(void *arg)
+{
+    struct variant *v = arg;
+    HLSContext *c = v->parent->priv_data;
+    int i, ret;
+
+    pthread_mutex_lock(&v->mutex);
+    while (!v->thread_exit && v->fetch_ret >= 0) {
+        struct prefetch_slot *slot = NULL;
+        int end = FFMIN(v->fetch_seq_no + c->prefetch + 1,
+                        v->start_seq_no + v->n_segments);
+        int seq;
+
+        /* drop the segments left behind, e.g. by a seek */
+        for (i = 0; i <= c->prefetch; i++) {
+            if (v->slots[i].done && (v->slots[i].seq_no < v->fetch_seq_no ||
+                v->slots[i].seq_no > v->fetch_seq_no + c->prefetch)) {
+                av_freep(&v->slots[i].data);
+                v->slots[i].seq_no = -1;
+            }
+        }
+
+        for (seq = FFMAX(v->fetch_seq_no, v->start_seq_no); seq < end; seq++)
+            if (!find_slot(v, seq))
+                break;
+        if (seq < end)
+            slot = find_slot(v, -1);
+
+        if (slot) {
+            struct segment seg = *v->segments[seq - v->start_seq_no];
+            uint8_t *data;
+            int size = 0;
+
+            slot->seq_no = seq;
+            slot->done   = 0;
+            pthread_mutex_unlock(&v->mutex);
+
+            ret = fetch_segment(v, &seg, &data, &size);
+
+            pthread_mutex_lock(&v->mutex);
+            slot->data = data;
+            slot->size = size;
+            slot->ret  = ret;
+            slot->done = 1;
+            pthread_cond_broadcast(&v->cond);
+            continue;
+        }
+
+        if (!v->finished && !v->reloading &&
+            end == v->start_seq_no + v->n_segments) {
+            int n_segments = v->n_segments;
+
+            if (!v->reload_interval)
+                v->reload_interval = n_segments ?
+                                     v->segments[n_segments - 1]->duration :
+                                     v->target_duration;
+            if (av_gettime_relative() - v->last_load_time >=
+                v->reload_interval) {
+                int last = v->start_seq_no + n_segments;
+
+                v->reloading = 1;
+                pthread_mutex_unlock(&v->mutex);
+                ret = reload_playlist(v);
+                pthread_mutex_lock(&v->mutex);
+                v->reloading = 0;
+
+                if (ret < 0)
+                    v->fetch_ret = ret;
+                /* poll faster while no new segments show up */
+                else if (v->start_seq_no + v->n_segments > last)
+                    v->reload_interval = 0;
+                else
+                    v->reload_interval = v->target_duration / 2;
+                pthread_cond_broadcast(&v->cond);
+                continue;
+            }
+        }
+
+        if (v->finished || v->reloading ||
+            end < v->start_seq_no + v->n_segments) {
+            pthread_cond_wait(&v->cond, &v->mutex);
+        } else {
+            pthread_mutex_unlock(&v->mutex);
+            av_usleep(100 * 1000);
+            pthread_mutex_lock(&v->mutex);
+        }
+    }
+    pthread_mutex_unlock(&v->mutex);
+
+    return NULL;
+}
+
+/* Wait for the segment cur_seq_no and make it the current one. */
+static int get_prefetched(struct variant *v)
+{
+    struct prefetch_slot *slot;
+    int ret = 0;
+
+    pthread_mutex_lock(&v->mutex);
+    for (;;) {
+        if (v->cur_seq_no < v->start_seq_no) {
+            av_log(NULL, AV_LOG_WARNING,
+                   "skipping %d segments ahead, expired from playlists\n",
+                   v->start_seq_no - v->cur_seq_no);
+            v->cur_seq_no = v->start_seq_no;
+        }
+        if (v->fetch_seq_no != v->cur_seq_no) {
+            v->fetch_seq_no = v->cur_seq_no;
+            pthread_cond_broadcast(&v->cond);
+        }
+
+        slot = find_slot(v, v->cur_seq_no);
+        if (slot && slot->done) {
+            ret          = slot->ret;
+            v->seg_data  = slot->data;
+            v->seg_size  = slot->size;
+            v->seg_pos   = 0;
+            slot->data   = NULL;
+            slot->seq_no = -1;
+            pthread_cond_broadcast(&v->cond);
+            break;
+        }
+        if (v->cur_seq_no >= v->start_seq_no + v->n_segments && v->finished) {
+            ret = AVERROR_EOF;
+            break;
+        }
+        if (v->fetch_ret < 0) {
+            ret = v->fetch_ret;
+            break;
+        }
+        pthread_cond_wait(&v->cond, &v->mutex);
+    }
+    pthread_mutex_unlock(&v->mutex);
+
+    return ret;
+}
+
+/* Abort the downloads of the prefetch threads when they are stopped, or
+ * when the caller interrupts the demuxer. */
+static int prefetch_interrupt_cb(void *opaque)
+{
+    struct variant *v = opaque;
+    HLSContext *c = v->parent->priv_data;
+    int thread_exit;
+
+    pthread_mutex_lock(&v->mutex);
+    thread_exit = v->thread_exit;
+    pthread_mutex_unlock(&v->mutex);
+
+    return thread_exit || ff_check_interrupt(c->interrupt_callback);
+}
+
+/* The files are opened through the callbacks of the parent, but with an
+ * interrupt callback of their own. */
+static int alloc_fetch_context(struct variant *v)
+{
+    AVFormatContext *s = v->parent, *ctx;
+
+    if (!(ctx = v->fetch_ctx = avformat_alloc_context()))
+        return AVERROR(ENOMEM);
+
+    ctx->io_open  = s->io_open;
+    ctx->io_close = s->io_close;
+    ctx->opaque   = s->opaque;
+    ctx->interrupt_callback.callback = prefetch_interrupt_cb;
+    ctx->interrupt_callback.opaque   = v;
+
+    av_freep(&ctx->protocol_blacklist);
+    if (s->protocol_whitelist &&
+        !(ctx->protocol_whitelist = av_strdup(s->protocol_whitelist)))
+        return AVERROR(ENOMEM);
+    if (s->protocol_blacklist &&
+        !(ctx->protocol_blacklist = av_strdup(s->protocol_blacklist)))
+        return AVERROR(ENOMEM);
+
+    return 0;
+}
+
+static int start_prefetch(struct variant *v)
+{
+    HLSContext *c = v->parent->priv_data;
+    int i, ret;
+
+    v->slots = av_malloc_array(c->prefetch + 1, sizeof(*v->slots));
+    if (!v->slots)
+        return AVERROR(ENOMEM);
+    for (i = 0; i <= c->prefetch; i++) {
+        v->slots[i].seq_no = -1;
+        v->slots[i].data   = NULL;
+    }
+    v->fetch_seq_no    = v->cur_seq_no;
+    v->fetch_ret       = 0;
+    v->thread_exit     = 0;
+    v->reloading       = 0;
+    v->reload_interval = 0;
+
+    v->threads = av_malloc_array(c->prefetch, sizeof(*v->threads));
+    if (!v->threads) {
+        av_freep(&v->slots);
+        return AVERROR(ENOMEM);
+    }
+    if ((ret = alloc_fetch_context(v)) < 0) {
+        avformat_free_context(v->fetch_ctx);
+        v->fetch_ctx = NULL;
+        av_freep(&v->threads);
+        av_freep(&v->slots);
+        return ret;
+    }
+
+    pthread_mutex_init(&v->mutex, NULL);
+    pthread_mutex_init(&v->key_mutex, NULL);
+    pthread_cond_init(&v->cond, NULL);
+    for (i = 0; i < c->prefetch; i++) {
+        if ((ret = pthread_create(&v->threads[i], NULL, prefetch_thread, v))) {
+            /* stop_prefetch() joins the threads started so far */
+            av_log(v->parent, AV_LOG_ERROR,
+                   "Unable to start a prefetch thread\n");
+            return AVERROR(ret);
+        }
+        v->nb_threads++;
+    }
+    return 0;
+}
+#endif
+
+static int read_prefetched(struct variant *v, uint8_t *buf, int buf_size)
+{
+    int ret;
+
+#if HLS_PREFETCH
+    if (!v->seg_data && (ret = get_prefetched(v)) < 0)
+        return ret;
+#endif
+    ret = FFMIN(buf_size, v->seg_size - v->seg_pos);
+    if (ret <= 0) {
+        av_freep(&v->seg_data);
+        v->seg_size = v->seg_pos = 0;
+        return 0;
+    }
+    memcpy(buf, v->seg_data + v->seg_pos, ret);
+    v->seg_pos += ret;
+    return ret;
+}
+
 static int read_data(void *opaque, uint8_t *buf, int buf_size)
 {
     struct variant *v = opaque;
@@ -409,6 +828,12 @@ static int read_data(void *opaque, uint8_t *buf, int buf_size)
     int ret, i;
 
 restart:
+    if (v->slots) {
+        ret = read_prefetched(v, buf, buf_size);
+        if (ret)
+            return ret;
+        goto next_segment;
+    }
     if (!v->input) {
         /* If this is a live stream and the reload interval has elapsed since
          * the last playlist reload, reload the variant playlists now. */
@@ -444,7 +869,8 @@ reload:
             goto reload;
         }
 
-        ret = open_input(v);
+        ret = open_input(v, v->segments[v->cur_seq_no - v->start_seq_no],
+                         &v->input);
         if (ret < 0)
             return ret;
     }
@@ -452,6 +878,7 @@ reload:
     if (ret > 0)
         return ret;
     ff_format_io_close(c->ctx, &v->input);
+next_segment:
     v->cur_seq_no++;
 
     c->end_of_segment = 1;
@@ -469,6 +896,7 @@ reload:
     if (!v->needed) {
         av_log(v->parent, AV_LOG_INFO, "No longer receiving variant %d\n",
                v->index);
+        stop_prefetch(v);
         return AVERROR_EOF;
     }
     goto restart;
@@ -484,10 +912,16 @@ static int save_avio_options(AVFormatContext *s)
 
     while (*opt) {
         if (av_opt_get(s->pb, *opt, AV_OPT_SEARCH_CHILDREN, &buf) >= 0) {
-            ret = av_dict_set(&c->avio_opts, *opt, buf,
-                              AV_DICT_DONT_STRDUP_VAL);
-            if (ret < 0)
-                return ret;
+            /* An empty headers option would end the requests with a stray
+             * blank line, which makes servers drop kept alive connections. */
+            if (!buf[0]) {
+                av_freep(&buf);
+            } else {
+                ret = av_dict_set(&c->avio_opts, *opt, buf,
+                                  AV_DICT_DONT_STRDUP_VAL);
+                if (ret < 0)
+                    return ret;
+            }
         }
         opt++;
     }
@@ -519,6 +953,10 @@ static int hls_read_header(AVFormatContext *s)
     if ((ret = save_avio_options(s)) < 0)
         goto fail;
 
+    if (c->http_persistent &&
+        (ret = av_dict_set(&c->avio_opts, "connection_pool", "1", 0)) < 0)
+        goto fail;
+
     if (c->n_variants == 0) {
         av_log(NULL, AV_LOG_WARNING, "Empty playlist\n");
         ret = AVERROR_EOF;
@@ -549,11 +987,18 @@ static int hls_read_header(AVFormatContext *s)
         s->duration = duration;
     }
 
+#if !HLS_PREFETCH
+    if (c->prefetch)
+        av_log(s, AV_LOG_WARNING,
+               "Prefetching is not supported without threads\n");
+#endif
+
     /* Open the demuxer for each variant */
     for (i = 0; i < c->n_variants; i++) {
         struct variant *v = c->variants[i];
         AVInputFormat *in_fmt = NULL;
         char bitrate_str[20];
+        char url[MAX_URL_SIZE];
         AVProgram *program;
 
         if (v->n_segments == 0)
@@ -574,12 +1019,21 @@ static int hls_read_header(AVFormatContext *s)
         if (!v->finished && v->n_segments > 3)
             v->cur_seq_no = v->start_seq_no + v->n_segments - 3;
 
+        /* the prefetch threads may reload the playlist from now on */
+        av_strlcpy(url, v->segments[0]->url, sizeof(url));
+#if HLS_PREFETCH
+        if (c->prefetch && (ret = start_prefetch(v)) < 0) {
+            avformat_free_context(v->ctx);
+            v->ctx = NULL;
+            goto fail;
+        }
+#endif
+
         v->read_buffer = av_malloc(INITIAL_BUFFER_SIZE);
         ffio_init_context(&v->pb, v->read_buffer, INITIAL_BUFFER_SIZE, 0, v,
                           read_data, NULL, NULL);
         v->pb.seekable = 0;
-        ret = av_probe_input_buffer(&v->pb, &in_fmt, v->segments[0]->url,
-                                    NULL, 0, 0);
+        ret = av_probe_input_buffer(&v->pb, &in_fmt, url, NULL, 0, 0);
         if (ret < 0) {
             /* Free the ctx - it isn't initialized properly at this point,
              * so avformat_close_input shouldn't be called. If
@@ -592,7 +1046,7 @@ static int hls_read_header(AVFormatContext *s)
         v->ctx->pb       = &v->pb;
         v->ctx->io_open  = nested_io_open;
         v->stream_offset = stream_offset;
-        ret = avformat_open_input(&v->ctx, v->segments[0]->url, in_fmt, NULL);
+        ret = avformat_open_input(&v->ctx, url, in_fmt, NULL);
         if (ret < 0)
             goto fail;
 
@@ -659,9 +1113,18 @@ static int recheck_discard_flags(AVFormatContext *s, int first)
             v->cur_seq_no = c->cur_seq_no;
             v->pb.eof_reached = 0;
             av_log(s, AV_LOG_INFO, "Now receiving variant %d\n", i);
+#if HLS_PREFETCH
+            if (c->prefetch && !v->slots && start_prefetch(v) < 0) {
+                av_log(s, AV_LOG_WARNING,
+                       "Not prefetching the segments of variant %d\n", i);
+                stop_prefetch(v);
+            }
+#endif
         } else if (first && !v->cur_needed && v->needed) {
             if (v->input)
                 ff_format_io_close(s, &v->input);
+            /* only the variants that are read are prefetched */
+            stop_prefetch(v);
             v->needed = 0;
             changed = 1;
             av_log(s, AV_LOG_INFO, "No longer receiving variant %d\n", i);
@@ -814,11 +1277,18 @@ static int hls_read_seek(AVFormatContext *s, int stream_index,
         reset_packet(&var->pkt);
         var->pb.eof_reached = 0;
         /* Clear any buffered data */
+        av_freep(&var->seg_data);
+        var->seg_size = var->seg_pos = 0;
         var->pb.buf_end = var->pb.buf_ptr = var->pb.buffer;
         /* Reset the pos, to let the mpegts demuxer know we've seeked. */
         var->pb.pos = 0;
 
-        /* Locate the segment that contains the target timestamp */
+        /* Locate the segment that contains the target timestamp, the
+         * prefetch threads may be reloading the playlist meanwhile */
+#if HLS_PREFETCH
+        if (var->slots)
+            pthread_mutex_lock(&var->mutex);
+#endif
         for (j = 0; j < var->n_segments; j++) {
             if (timestamp >= pos &&
                 timestamp < pos + var->segments[j]->duration) {
@@ -828,6 +1298,10 @@ static int hls_read_seek(AVFormatContext *s, int stream_index,
             }
             pos += var->segments[j]->duration;
         }
+#if HLS_PREFETCH
+        if (var->slots)
+            pthread_mutex_unlock(&var->mutex);
+#endif
         if (ret)
             c->seek_timestamp = AV_NOPTS_VALUE;
     }
@@ -847,6 +1321,23 @@ static int hls_probe(AVProbeData *p)
     return 0;
 }
 
+#define OFFSET(x) offsetof(HLSContext, x)
+#define FLAGS AV_OPT_FLAG_DECODING_PARAM
+static const AVOption hls_options[] = {
+    { "prefetch", "Number of segments to download ahead in the background",
+      OFFSET(prefetch), AV_OPT_TYPE_INT, { .i64 = 0 }, 0, 64, FLAGS },
+    { "http_persistent", "Reuse HTTP connections from a process-wide pool",
+      OFFSET(http_persistent), AV_OPT_TYPE_INT, { .i64 = 0 }, 0, 1, FLAGS },
+    { NULL },
+};
+
+static const AVClass hls_class = {
+    .class_name = "hls demuxer",
+    .item_name  = av_default_item_name,
+    .option     = hls_options,
+    .version    = LIBAVUTIL_VERSION_INT,
+};
+
 AVInputFormat ff_hls_demuxer = {
     .name           = "hls,applehttp",
     .long_name      = NULL_IF_CONFIG_SMALL("Apple HTTP Live Streaming"),
@@ -856,4 +1347,5 @@ AVInputFormat ff_hls_demuxer = {
     .read_packet    = hls_read_packet,
     .read_close     = hls_close,
     .read_seek      = hls_read_seek,
+    .priv_class     = &hls_class,
 };
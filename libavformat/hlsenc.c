@@ -37,11 +37,27 @@
 #include "libavutil/log.h"
 
 #include "avformat.h"
+#include "avio_internal.h"
+#include "hlsplaylist.h"
 #include "internal.h"
 
+enum HLSSegmentType {
+    SEGMENT_TYPE_MPEGTS,
+    SEGMENT_TYPE_FMP4,
+};
+
+typedef struct PartEntry {
+    int64_t duration;     // part duration in AV_TIME_BASE units
+    int64_t pos;
+    int64_t size;
+    int independent;
+} PartEntry;
+
 typedef struct ListEntry {
     char  name[1024];
     int64_t duration;     // segment duration in AV_TIME_BASE units
+    PartEntry *parts;     // only kept for the last three target durations
+    int nb_parts;
     struct ListEntry *next;
 } ListEntry;
 
@@ -79,8 +95,38 @@ typedef struct HLSContext {
     char *key_basename;
 
     AVDictionary *enc_opts;
+
+    int segment_type;      // Set by a private option.
+    char *fmp4_init_filename; // Set by a private option.
+    char *init_filename;
+    int init_written;
+    AVIOContext *out;      // fmp4 segment, the mp4 muxer writes to a dynamic buffer
+
+    float part_time;       // Set by a private option.
+    int64_t part_target;   // in AV_TIME_BASE units, 0 if parts are disabled
+    int64_t part_start_pts;
+    int64_t part_last_dts; // of the last packet parts can be cut before
+    int64_t part_pos;
+    int part_independent;
+    PartEntry *parts;      // parts of the segment being written
+    int nb_parts;
+
+    int http_persistent;   // Set by a private option.
 } HLSContext;
 
+static void set_http_options(HLSContext *hls, AVDictionary **options)
+{
+    if (hls->http_persistent)
+        av_dict_set(options, "connection_pool", "1", 0);
+}
+
+/* Only local files can be written aside and renamed into place, remote
+ * ones are written directly. */
+static int use_temp_file(const char *filename)
+{
+    return !strstr(filename, "://") || av_strstart(filename, "file:", NULL);
+}
+
 
 static int randomize(uint8_t *buf, int len)
 {
@@ -117,6 +163,7 @@ static int setup_encryption(AVFormatContext *s)
 {
     HLSContext *hls = s->priv_data;
     AVIOContext *out = NULL;
+    AVDictionary *opts = NULL;
     int len, ret;
     uint8_t buf[16];
     uint8_t *k = NULL;
@@ -176,7 +223,10 @@ static int setup_encryption(AVFormatContext *s)
             return ret;
     }
 
-    if ((ret = s->io_open(s, &out, hls->key_basename, AVIO_FLAG_WRITE, NULL)) < 0)
+    set_http_options(hls, &opts);
+    ret = s->io_open(s, &out, hls->key_basename, AVIO_FLAG_WRITE, &opts);
+    av_dict_free(&opts);
+    if (ret < 0)
         return ret;
 
     avio_write(out, k, 16);
@@ -214,6 +264,46 @@ static int hls_mux_init(AVFormatContext *s)
     return 0;
 }
 
+/* in AV_TIME_BASE units, rounded up to seconds as in the playlist */
+static int64_t get_target_duration(HLSContext *hls)
+{
+    ListEntry *en;
+    int64_t target_duration = 0;
+
+    for (en = hls->list; en; en = en->next) {
+        if (target_duration < en->duration)
+            target_duration = en->duration;
+    }
+    // With partial segments the playlist is written before the first
+    // segment is complete.
+    if (!target_duration)
+        target_duration = hls->recording_time;
+
+    return av_rescale_rnd(target_duration, 1, AV_TIME_BASE, AV_ROUND_UP) *
+           AV_TIME_BASE;
+}
+
+/*
+ * Drop the parts of the segments which end more than three target durations
+ * before the end of the playlist, the clients joining at the hold back point
+ * need the more recent ones.
+ */
+static void drop_old_parts(HLSContext *hls)
+{
+    ListEntry *en;
+    int64_t after = 0, window = 3 * get_target_duration(hls);
+
+    for (en = hls->list; en; en = en->next)
+        after += en->duration;
+    for (en = hls->list; en; en = en->next) {
+        after -= en->duration;
+        if (after < window)
+            break;
+        av_freep(&en->parts);
+        en->nb_parts = 0;
+    }
+}
+
 static int append_entry(HLSContext *hls, int64_t duration, const char *name)
 {
     ListEntry *en = av_malloc(sizeof(*en));
@@ -224,8 +314,13 @@ static int append_entry(HLSContext *hls, int64_t duration, const char *name)
     av_strlcpy(en->name, name, sizeof(en->name));
 
     en->duration = duration;
+    en->parts    = hls->parts;
+    en->nb_parts = hls->nb_parts;
     en->next     = NULL;
 
+    hls->parts    = NULL;
+    hls->nb_parts = 0;
+
     if (!hls->list)
         hls->list = en;
     else
@@ -236,10 +331,13 @@ static int append_entry(HLSContext *hls, int64_t duration, const char *name)
     if (hls->nb_entries >= hls->size) {
         en = hls->list;
         hls->list = en->next;
+        av_free(en->parts);
         av_free(en);
     } else
         hls->nb_entries++;
 
+    drop_old_parts(hls);
+
     hls->sequence++;
 
     return 0;
@@ -252,38 +350,39 @@ static void free_entries(HLSContext *hls)
     while(p) {
         en = p;
         p = p->next;
+        av_free(en->parts);
         av_free(en);
     }
+    av_freep(&hls->parts);
 }
 
 static int hls_window(AVFormatContext *s, int last)
 {
     HLSContext *hls = s->priv_data;
     ListEntry *en;
-    int64_t target_duration = 0;
     int ret = 0;
     AVIOContext *out = NULL;
+    AVDictionary *opts = NULL;
     char temp_filename[1024];
     int64_t sequence = FFMAX(hls->start_sequence, hls->sequence - hls->size);
+    int use_temp = use_temp_file(s->filename);
+    int i;
 
-    snprintf(temp_filename, sizeof(temp_filename), "%s.tmp", s->filename);
-    if ((ret = s->io_open(s, &out, temp_filename, AVIO_FLAG_WRITE, NULL)) < 0)
+    snprintf(temp_filename, sizeof(temp_filename), use_temp ? "%s.tmp" : "%s",
+             s->filename);
+    set_http_options(hls, &opts);
+    ret = s->io_open(s, &out, temp_filename, AVIO_FLAG_WRITE, &opts);
+    av_dict_free(&opts);
+    if (ret < 0)
         goto fail;
 
-    for (en = hls->list; en; en = en->next) {
-        if (target_duration < en->duration)
-            target_duration = en->duration;
-    }
-
-    avio_printf(out, "#EXTM3U\n");
-    avio_printf(out, "#EXT-X-VERSION:%d\n", hls->version);
-    if (hls->allowcache == 0 || hls->allowcache == 1) {
-        avio_printf(out, "#EXT-X-ALLOW-CACHE:%s\n", hls->allowcache == 0 ? "NO" : "YES");
-    }
-    avio_printf(out, "#EXT-X-TARGETDURATION:%"PRId64"\n",
-                av_rescale_rnd(target_duration, 1, AV_TIME_BASE,
-                               AV_ROUND_UP));
-    avio_printf(out, "#EXT-X-MEDIA-SEQUENCE:%"PRId64"\n", sequence);
+    ff_hls_write_playlist_header(out, hls->version, hls->allowcache,
+                                 get_target_duration(hls) / AV_TIME_BASE,
+                                 sequence);
+    if (hls->part_target)
+        ff_hls_write_part_info(out, hls->part_target);
+    if (hls->segment_type == SEGMENT_TYPE_FMP4)
+        ff_hls_write_init_file(out, hls->baseurl, hls->fmp4_init_filename, 0, 0);
 
     av_log(s, AV_LOG_VERBOSE, "EXT-X-MEDIA-SEQUENCE:%"PRId64"\n",
            sequence);
@@ -307,23 +406,26 @@ static int hls_window(AVFormatContext *s, int last)
             avio_printf(out, "\n");
         }
 
-        if (hls->version > 2)
-            avio_printf(out, "#EXTINF:%f\n",
-                        (double)en->duration / AV_TIME_BASE);
-        else
-            avio_printf(out, "#EXTINF:%"PRId64",\n",
-                        av_rescale(en->duration, 1, AV_TIME_BASE));
-        if (hls->baseurl)
-            avio_printf(out, "%s", hls->baseurl);
-        avio_printf(out, "%s\n", en->name);
+        for (i = 0; i < en->nb_parts; i++)
+            ff_hls_write_part(out, hls->baseurl, en->name,
+                              en->parts[i].duration, en->parts[i].size,
+                              en->parts[i].pos, en->parts[i].independent);
+        ff_hls_write_file_entry(out, hls->version, hls->baseurl, en->name,
+                                en->duration, 0, 0);
     }
 
-    if (last)
-        avio_printf(out, "#EXT-X-ENDLIST\n");
+    if (last) {
+        ff_hls_write_end_list(out);
+    } else {
+        for (i = 0; i < hls->nb_parts; i++)
+            ff_hls_write_part(out, hls->baseurl, av_basename(hls->avf->filename),
+                              hls->parts[i].duration, hls->parts[i].size,
+                              hls->parts[i].pos, hls->parts[i].independent);
+    }
 
 fail:
     ff_format_io_close(s, &out);
-    if (ret >= 0)
+    if (ret >= 0 && use_temp)
         ff_rename(temp_filename, s->filename);
     return ret;
 }
@@ -356,19 +458,109 @@ static int hls_start(AVFormatContext *s)
                 goto fail;
         }
     }
+    set_http_options(c, &opts);
 
-    if ((err = s->io_open(s, &oc->pb, oc->filename, AVIO_FLAG_WRITE, &opts)) < 0)
-        return err;
+    if (c->segment_type == SEGMENT_TYPE_FMP4)
+        err = s->io_open(s, &c->out, oc->filename, AVIO_FLAG_WRITE, &opts);
+    else
+        err = s->io_open(s, &oc->pb, oc->filename, AVIO_FLAG_WRITE, &opts);
+    if (err < 0)
+        goto fail;
 
-    if (oc->oformat->priv_class && oc->priv_data)
+    if (c->segment_type == SEGMENT_TYPE_MPEGTS &&
+        oc->oformat->priv_class && oc->priv_data)
         av_opt_set(oc->priv_data, "mpegts_flags", "resend_headers", 0);
 
+    c->part_pos = 0;
+
 fail:
     av_dict_free(&opts);
 
     return err;
 }
 
+static int flush_dynbuf(HLSContext *hls, AVIOContext *out)
+{
+    AVFormatContext *oc = hls->avf;
+    uint8_t *buf;
+    int size;
+
+    av_write_frame(oc, NULL);
+
+    size = avio_close_dyn_buf(oc->pb, &buf);
+    oc->pb = NULL;
+    avio_write(out, buf, size);
+    av_free(buf);
+
+    return avio_open_dyn_buf(&oc->pb);
+}
+
+static int hls_write_init(AVFormatContext *s)
+{
+    HLSContext *hls = s->priv_data;
+    AVIOContext *out = NULL;
+    AVDictionary *opts = NULL;
+    int ret;
+
+    set_http_options(hls, &opts);
+    ret = s->io_open(s, &out, hls->init_filename, AVIO_FLAG_WRITE, &opts);
+    av_dict_free(&opts);
+    if (ret < 0)
+        return ret;
+
+    // With delay_moov the first flush only outputs the moov.
+    ret = flush_dynbuf(hls, out);
+    ff_format_io_close(s, &out);
+    hls->init_written = 1;
+
+    return ret;
+}
+
+/**
+ * Write out the data buffered by the segment muxer and, if partial
+ * segments are enabled, record it as a part ending at pts.
+ */
+static int hls_flush(AVFormatContext *s, int64_t pts)
+{
+    HLSContext *hls = s->priv_data;
+    AVFormatContext *oc = hls->avf;
+    AVIOContext *pb = oc->pb;
+    PartEntry *part;
+    int64_t pos;
+    int ret;
+
+    if (hls->segment_type == SEGMENT_TYPE_FMP4) {
+        if (!hls->init_written && (ret = hls_write_init(s)) < 0)
+            return ret;
+        if ((ret = flush_dynbuf(hls, hls->out)) < 0)
+            return ret;
+        pb = hls->out;
+    } else {
+        av_write_frame(oc, NULL);
+    }
+    avio_flush(pb);
+
+    pos = avio_tell(pb);
+    if (!hls->part_target || pos <= hls->part_pos)
+        return 0;
+
+    if ((ret = av_reallocp_array(&hls->parts, hls->nb_parts + 1,
+                                 sizeof(*hls->parts))) < 0) {
+        hls->nb_parts = 0;
+        return ret;
+    }
+    part = &hls->parts[hls->nb_parts++];
+    part->duration    = pts - hls->part_start_pts;
+    part->pos         = hls->part_pos;
+    part->size        = pos - hls->part_pos;
+    part->independent = hls->part_independent;
+
+    hls->part_start_pts = pts;
+    hls->part_pos       = pos;
+
+    return 0;
+}
+
 static int read_chomp_line(AVIOContext *s, char *buf, int maxlen)
 {
     int len = ff_get_line(s, buf, maxlen);
@@ -426,7 +618,8 @@ static int hls_recover(AVFormatContext *s)
 static int hls_setup(AVFormatContext *s)
 {
     HLSContext *hls = s->priv_data;
-    const char *pattern = "%d.ts";
+    const char *pattern = hls->segment_type == SEGMENT_TYPE_FMP4 ? "%d.m4s"
+                                                                 : "%d.ts";
     int basename_size = strlen(s->filename) + strlen(pattern) + 1;
     char *p;
     int ret;
@@ -449,6 +642,18 @@ static int hls_setup(AVFormatContext *s)
     if (p)
         *p = '\0';
 
+    if (hls->segment_type == SEGMENT_TYPE_FMP4) {
+        const char *name = av_basename(s->filename);
+        int len = name - s->filename + strlen(hls->fmp4_init_filename) + 1;
+
+        hls->init_filename = av_malloc(len);
+        if (!hls->init_filename)
+            return AVERROR(ENOMEM);
+
+        av_strlcpy(hls->init_filename, s->filename, name - s->filename + 1);
+        av_strlcat(hls->init_filename, hls->fmp4_init_filename, len);
+    }
+
     if (hls->encrypt) {
         ret = setup_encryption(s);
         if (ret < 0)
@@ -469,11 +674,24 @@ static int hls_setup(AVFormatContext *s)
 static int hls_write_header(AVFormatContext *s)
 {
     HLSContext *hls = s->priv_data;
+    AVDictionary *opts = NULL;
     int ret, i;
 
     hls->sequence       = hls->start_sequence;
     hls->recording_time = hls->time * AV_TIME_BASE;
+    hls->part_target    = hls->part_time * AV_TIME_BASE;
     hls->start_pts      = AV_NOPTS_VALUE;
+    hls->part_last_dts  = AV_NOPTS_VALUE;
+
+    if (hls->part_target && hls->encrypt) {
+        av_log(s, AV_LOG_ERROR,
+               "Partial segments cannot be used with encryption.\n");
+        return AVERROR(EINVAL);
+    }
+
+    // EXT-X-MAP without EXT-X-I-FRAMES-ONLY needs version 6.
+    if (hls->segment_type == SEGMENT_TYPE_FMP4 || hls->part_target)
+        hls->version = FFMAX(hls->version, 6);
 
     for (i = 0; i < s->nb_streams; i++)
         hls->has_video +=
@@ -484,7 +702,8 @@ static int hls_write_header(AVFormatContext *s)
                "More than a single video stream present, "
                "expect issues decoding it.\n");
 
-    hls->oformat = av_guess_format("mpegts", NULL, NULL);
+    hls->oformat = av_guess_format(hls->segment_type == SEGMENT_TYPE_FMP4 ?
+                                   "mp4" : "mpegts", NULL, NULL);
 
     if (!hls->oformat) {
         ret = AVERROR_MUXER_NOT_FOUND;
@@ -497,18 +716,34 @@ static int hls_write_header(AVFormatContext *s)
     if ((ret = hls_mux_init(s)) < 0)
         goto fail;
 
+    if (hls->segment_type == SEGMENT_TYPE_FMP4) {
+        if ((ret = avio_open_dyn_buf(&hls->avf->pb)) < 0)
+            goto fail;
+        // The same fragments dashenc produces, cut on our requests.
+        av_dict_set(&opts, "movflags", "frag_custom+dash+delay_moov", 0);
+    }
+
     if ((ret = hls_start(s)) < 0)
         goto fail;
 
-    if ((ret = avformat_write_header(hls->avf, NULL)) < 0)
+    ret = avformat_write_header(hls->avf, &opts);
+    av_dict_free(&opts);
+    if (ret < 0)
         return ret;
 
 
 fail:
     if (ret) {
+        av_dict_free(&opts);
         av_free(hls->basename);
-        if (hls->avf)
+        av_freep(&hls->init_filename);
+        if (hls->avf) {
+            if (hls->segment_type == SEGMENT_TYPE_FMP4) {
+                ffio_free_dyn_buf(&hls->avf->pb);
+                ff_format_io_close(s, &hls->out);
+            }
             avformat_free_context(hls->avf);
+        }
 
         free_encryption(s);
     }
@@ -522,23 +757,48 @@ static int hls_write_packet(AVFormatContext *s, AVPacket *pkt)
     AVStream *st = s->streams[pkt->stream_index];
     int64_t end_pts = hls->recording_time * hls->number;
     int64_t pts     = av_rescale_q(pkt->pts, st->time_base, AV_TIME_BASE_Q);
-    int ret, can_split = 1;
-
-    if (hls->start_pts == AV_NOPTS_VALUE) {
-        hls->start_pts = pts;
-        hls->end_pts   = pts;
-    }
+    int64_t dts     = av_rescale_q(pkt->dts, st->time_base, AV_TIME_BASE_Q);
+    int64_t pkt_duration = 0;
+    int ret, can_split = 1, can_cut_part;
 
     if (hls->has_video) {
         can_split = st->codecpar->codec_type == AVMEDIA_TYPE_VIDEO &&
                     pkt->flags & AV_PKT_FLAG_KEY;
     }
-    if (pkt->pts == AV_NOPTS_VALUE)
+    can_cut_part = !hls->has_video ||
+                   st->codecpar->codec_type == AVMEDIA_TYPE_VIDEO;
+
+    if (hls->start_pts == AV_NOPTS_VALUE) {
+        hls->start_pts        = pts;
+        hls->end_pts          = pts;
+        hls->part_start_pts   = pts;
+        hls->part_independent = can_split;
+    }
+
+    if (pkt->pts == AV_NOPTS_VALUE) {
+        can_cut_part = 0;
         can_split = 0;
-    else
+    } else
         hls->duration = pts - hls->end_pts;
 
+    /* The parts must not be longer than the target, so a part is cut before
+     * the packet that would make it so. Without a duration, the packet is
+     * assumed to last as long as the previous one. */
+    if (can_cut_part) {
+        if (pkt->duration > 0)
+            pkt_duration = av_rescale_q(pkt->duration, st->time_base,
+                                        AV_TIME_BASE_Q);
+        else if (pkt->dts != AV_NOPTS_VALUE &&
+                 hls->part_last_dts != AV_NOPTS_VALUE)
+            pkt_duration = FFMAX(dts - hls->part_last_dts, 0);
+        if (pkt->dts != AV_NOPTS_VALUE)
+            hls->part_last_dts = dts;
+    }
+
     if (can_split && pts - hls->start_pts >= end_pts) {
+        if ((ret = hls_flush(s, pts)) < 0)
+            return ret;
+
         ret = append_entry(hls, hls->duration, av_basename(hls->avf->filename));
         if (ret)
             return ret;
@@ -546,8 +806,10 @@ static int hls_write_packet(AVFormatContext *s, AVPacket *pkt)
         hls->end_pts = pts;
         hls->duration = 0;
 
-        av_write_frame(oc, NULL); /* Flush any buffered data */
-        ff_format_io_close(s, &oc->pb);
+        if (hls->segment_type == SEGMENT_TYPE_FMP4)
+            ff_format_io_close(s, &hls->out);
+        else
+            ff_format_io_close(s, &oc->pb);
 
         ret = hls_start(s);
 
@@ -555,6 +817,17 @@ static int hls_write_packet(AVFormatContext *s, AVPacket *pkt)
             return ret;
 
         oc = hls->avf;
+        hls->part_independent = 1;
+
+        if ((ret = hls_window(s, 0)) < 0)
+            return ret;
+    } else if (hls->part_target && can_cut_part &&
+               pts > hls->part_start_pts &&
+               pts + pkt_duration - hls->part_start_pts > hls->part_target) {
+        if ((ret = hls_flush(s, pts)) < 0)
+            return ret;
+
+        hls->part_independent = can_split;
 
         if ((ret = hls_window(s, 0)) < 0)
             return ret;
@@ -570,12 +843,21 @@ static int hls_write_trailer(struct AVFormatContext *s)
     HLSContext *hls = s->priv_data;
     AVFormatContext *oc = hls->avf;
 
+    hls_flush(s, hls->end_pts + hls->duration);
+
     av_write_trailer(oc);
-    ff_format_io_close(s, &oc->pb);
+    if (hls->segment_type == SEGMENT_TYPE_FMP4) {
+        // The trailer only holds the mfra, the segment is already complete.
+        ffio_free_dyn_buf(&oc->pb);
+        ff_format_io_close(s, &hls->out);
+    } else {
+        ff_format_io_close(s, &oc->pb);
+    }
+    append_entry(hls, hls->duration, av_basename(oc->filename));
+    hls_window(s, 1);
     avformat_free_context(oc);
     av_free(hls->basename);
-    append_entry(hls, hls->duration, av_basename(hls->avf->filename));
-    hls_window(s, 1);
+    av_freep(&hls->init_filename);
 
     free_entries(hls);
     free_encryption(s);
@@ -592,7 +874,13 @@ static const AVOption options[] = {
     {"hls_wrap",      "number after which the index wraps",      OFFSET(wrap),    AV_OPT_TYPE_INT,    {.i64 = 0},     0, INT_MAX, E},
     {"hls_allow_cache", "explicitly set whether the client MAY (1) or MUST NOT (0) cache media segments", OFFSET(allowcache), AV_OPT_TYPE_INT, {.i64 = -1}, INT_MIN, INT_MAX, E},
     {"hls_base_url",  "url to prepend to each playlist entry",   OFFSET(baseurl), AV_OPT_TYPE_STRING, {.str = NULL},  0, 0,       E},
-    {"hls_version",   "protocol version",                        OFFSET(version), AV_OPT_TYPE_INT,    {.i64 = 3},     2, 3, E},
+    {"hls_version",   "protocol version",                        OFFSET(version), AV_OPT_TYPE_INT,    {.i64 = 3},     2, 7, E},
+    {"hls_segment_type", "type of the media segments",           OFFSET(segment_type), AV_OPT_TYPE_INT, {.i64 = SEGMENT_TYPE_MPEGTS}, 0, SEGMENT_TYPE_FMP4, E, "segment_type"},
+    {"mpegts",        "MPEG-TS segments",                        0, AV_OPT_TYPE_CONST, {.i64 = SEGMENT_TYPE_MPEGTS}, 0, 0, E, "segment_type"},
+    {"fmp4",          "fragmented MP4 (CMAF) segments",          0, AV_OPT_TYPE_CONST, {.i64 = SEGMENT_TYPE_FMP4},   0, 0, E, "segment_type"},
+    {"hls_fmp4_init_filename", "name of the fragmented MP4 initialization section", OFFSET(fmp4_init_filename), AV_OPT_TYPE_STRING, {.str = "init.mp4"}, 0, 0, E},
+    {"hls_part_time", "partial segment length in seconds, 0 to disable", OFFSET(part_time), AV_OPT_TYPE_FLOAT, {.dbl = 0}, 0, FLT_MAX, E},
+    {"http_persistent", "reuse HTTP connections from a process-wide pool", OFFSET(http_persistent), AV_OPT_TYPE_INT, {.i64 = 0}, 0, 1, E},
     {"hls_enc",       "AES128 encryption support",               OFFSET(encrypt), AV_OPT_TYPE_INT,    {.i64 = 0},     0, 1, E},
     {"hls_enc_key",   "use the specified hex-coded 16byte key to encrypt the segments",  OFFSET(key), AV_OPT_TYPE_BINARY, .flags = E},
     {"hls_enc_key_url", "url to access the key to decrypt the segments",    OFFSET(key_url), AV_OPT_TYPE_STRING, {.str = NULL},  0, 0, E},
@@ -0,0 +1,118 @@
+/*
+ * Apple HTTP Live Streaming playlist writing
+ *
+ * This file is part of Libav.
+ *
+ * Libav is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * Libav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with Libav; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <stdint.h>
+
+#include "libavutil/avutil.h"
+#include "libavutil/mathematics.h"
+
+#include "avformat.h"
+#include "hlsplaylist.h"
+
+void ff_hls_write_playlist_version(AVIOContext *out, int version)
+{
+    avio_printf(out, "#EXTM3U\n");
+    avio_printf(out, "#EXT-X-VERSION:%d\n", version);
+}
+
+void ff_hls_write_playlist_header(AVIOContext *out, int version, int allowcache,
+                                  int64_t target_duration, int64_t sequence)
+{
+    ff_hls_write_playlist_version(out, version);
+    if (allowcache == 0 || allowcache == 1) {
+        avio_printf(out, "#EXT-X-ALLOW-CACHE:%s\n", allowcache == 0 ? "NO" : "YES");
+    }
+    avio_printf(out, "#EXT-X-TARGETDURATION:%"PRId64"\n", target_duration);
+    avio_printf(out, "#EXT-X-MEDIA-SEQUENCE:%"PRId64"\n", sequence);
+}
+
+void ff_hls_write_part_info(AVIOContext *out, int64_t part_target)
+{
+    // The clients must stay at least three parts behind the live edge.
+    avio_printf(out, "#EXT-X-SERVER-CONTROL:PART-HOLD-BACK=%.3f\n",
+                3.0 * part_target / AV_TIME_BASE);
+    avio_printf(out, "#EXT-X-PART-INF:PART-TARGET=%.3f\n",
+                (double)part_target / AV_TIME_BASE);
+}
+
+void ff_hls_write_init_file(AVIOContext *out, const char *baseurl,
+                            const char *filename, int64_t size, int64_t pos)
+{
+    avio_printf(out, "#EXT-X-MAP:URI=\"%s%s\"", baseurl ? baseurl : "", filename);
+    if (size > 0)
+        avio_printf(out, ",BYTERANGE=\"%"PRId64"@%"PRId64"\"", size, pos);
+    avio_printf(out, "\n");
+}
+
+void ff_hls_write_part(AVIOContext *out, const char *baseurl,
+                       const char *filename, int64_t duration,
+                       int64_t size, int64_t pos, int independent)
+{
+    avio_printf(out, "#EXT-X-PART:DURATION=%.3f,URI=\"%s%s\"",
+                (double)duration / AV_TIME_BASE, baseurl ? baseurl : "",
+                filename);
+    if (size > 0)
+        avio_printf(out, ",BYTERANGE=\"%"PRId64"@%"PRId64"\"", size, pos);
+    if (independent)
+        avio_printf(out, ",INDEPENDENT=YES");
+    avio_printf(out, "\n");
+}
+
+void ff_hls_write_file_entry(AVIOContext *out, int version,
+                             const char *baseurl, const char *filename,
+                             int64_t duration, int64_t size, int64_t pos)
+{
+    if (version > 2)
+        avio_printf(out, "#EXTINF:%f\n", (double)duration / AV_TIME_BASE);
+    else
+        avio_printf(out, "#EXTINF:%"PRId64",\n",
+                    av_rescale(duration, 1, AV_TIME_BASE));
+    if (size > 0)
+        avio_printf(out, "#EXT-X-BYTERANGE:%"PRId64"@%"PRId64"\n", size, pos);
+    if (baseurl)
+        avio_printf(out, "%s", baseurl);
+    avio_printf(out, "%s\n", filename);
+}
+
+void ff_hls_write_end_list(AVIOContext *out)
+{
+    avio_printf(out, "#EXT-X-ENDLIST\n");
+}
+
+void ff_hls_write_audio_rendition(AVIOContext *out, const char *group_id,
+                                  const char *name, const char *filename,
+                                  int is_default)
+{
+    avio_printf(out, "#EXT-X-MEDIA:TYPE=AUDIO,GROUP-ID=\"%s\",NAME=\"%s\","
+                "DEFAULT=%s,AUTOSELECT=YES,URI=\"%s\"\n", group_id, name,
+                is_default ? "YES" : "NO", filename);
+}
+
+void ff_hls_write_stream_info(AVIOContext *out, int bandwidth,
+                              const char *codecs, const char *audio_group,
+                              const char *filename)
+{
+    avio_printf(out, "#EXT-X-STREAM-INF:BANDWIDTH=%d", bandwidth);
+    if (codecs && codecs[0])
+        avio_printf(out, ",CODECS=\"%s\"", codecs);
+    if (audio_group)
+        avio_printf(out, ",AUDIO=\"%s\"", audio_group);
+    avio_printf(out, "\n%s\n", filename);
+}
@@ -0,0 +1,96 @@
+/*
+ * Apple HTTP Live Streaming playlist writing
+ *
+ * This file is part of Libav.
+ *
+ * Libav is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * Libav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with Libav; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVFORMAT_HLSPLAYLIST_H
+#define AVFORMAT_HLSPLAYLIST_H
+
+#include <stdint.h>
+
+#include "avio.h"
+
+/**
+ * Write the tags opening a master playlist.
+ */
+void ff_hls_write_playlist_version(AVIOContext *out, int version);
+
+/**
+ * Write the tags opening a media playlist.
+ *
+ * @param allowcache      0 or 1 to write EXT-X-ALLOW-CACHE, any other value
+ *                        to omit it
+ * @param target_duration maximum segment duration in seconds
+ */
+void ff_hls_write_playlist_header(AVIOContext *out, int version, int allowcache,
+                                  int64_t target_duration, int64_t sequence);
+
+/**
+ * Write the tags announcing partial segments of about part_target
+ * AV_TIME_BASE units, with a matching hold back for the clients.
+ */
+void ff_hls_write_part_info(AVIOContext *out, int64_t part_target);
+
+/**
+ * Write the EXT-X-MAP tag pointing to the initialization section.
+ * A BYTERANGE attribute is added if size is positive.
+ */
+void ff_hls_write_init_file(AVIOContext *out, const char *baseurl,
+                            const char *filename, int64_t size, int64_t pos);
+
+/**
+ * Write an EXT-X-PART tag for size bytes at pos in filename.
+ *
+ * @param duration    part duration in AV_TIME_BASE units
+ * @param independent whether the part starts with a random access point
+ */
+void ff_hls_write_part(AVIOContext *out, const char *baseurl,
+                       const char *filename, int64_t duration,
+                       int64_t size, int64_t pos, int independent);
+
+/**
+ * Write the EXTINF tag and the uri of a media segment.
+ * An EXT-X-BYTERANGE tag is added if size is positive.
+ *
+ * @param duration segment duration in AV_TIME_BASE units, written as an
+ *                 integer for versions below 3
+ */
+void ff_hls_write_file_entry(AVIOContext *out, int version,
+                             const char *baseurl, const char *filename,
+                             int64_t duration, int64_t size, int64_t pos);
+
+void ff_hls_write_end_list(AVIOContext *out);
+
+/**
+ * Write an audio rendition of group_id to a master playlist.
+ */
+void ff_hls_write_audio_rendition(AVIOContext *out, const char *group_id,
+                                  const char *name, const char *filename,
+                                  int is_default);
+
+/**
+ * Write a variant stream to a master playlist.
+ *
+ * @param codecs      RFC 6381 codec string, omitted if NULL or empty
+ * @param audio_group group of the audio renditions, omitted if NULL
+ */
+void ff_hls_write_stream_info(AVIOContext *out, int bandwidth,
+                              const char *codecs, const char *audio_group,
+                              const char *filename);
+
+#endif /* AVFORMAT_HLSPLAYLIST_H */
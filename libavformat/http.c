@@ -27,6 +27,8 @@
 
 #include "libavutil/avstring.h"
 #include "libavutil/opt.h"
+#include "libavutil/thread.h"
+#include "libavutil/time.h"
 
 #include "avformat.h"
 #include "http.h"
@@ -44,10 +46,29 @@
  * path names). */
 #define BUFFER_SIZE   MAX_URL_SIZE
 #define MAX_REDIRECTS 8
+/* Leftover reply bytes worth reading to keep a connection rather than
+ * opening a new one. */
+#define POOL_MAX_DRAIN (64 * 1024)
+
+/**
+ * A connection which can be kept alive in the pool once its request is
+ * done, and handed over to the next request to the same server.
+ */
+typedef struct HTTPPoolConnection {
+    URLContext *hd;
+    /* The lower protocol url, e.g. tls://host:443, used as the pool key. */
+    char key[1024];
+    /* The connection is opened with an interrupt callback forwarding to
+     * the one of its current user, so that it can outlive its opener. */
+    AVIOInterruptCB interrupt_callback;
+    int64_t idle_since;
+    struct HTTPPoolConnection *next;
+} HTTPPoolConnection;
 
 typedef struct HTTPContext {
     const AVClass *class;
     URLContext *hd;
+    HTTPPoolConnection *conn;
     unsigned char buffer[BUFFER_SIZE], *buf_ptr, *buf_end;
     int line_count;
     int http_code;
@@ -71,6 +92,9 @@ typedef struct HTTPContext {
     int end_header;
     /* A flag which indicates if we use persistent connections. */
     int multiple_requests;
+    int connection_pool;
+    int pool_max_idle;
+    int64_t pool_idle_timeout;
     uint8_t *post_data;
     int post_datalen;
     int icy;
@@ -103,6 +127,9 @@ static const AVOption options[] = {
     { "user_agent", "override User-Agent header", OFFSET(user_agent), AV_OPT_TYPE_STRING, { .str = DEFAULT_USER_AGENT }, 0, 0, D },
     { "user-agent", "override User-Agent header, for compatibility with ffmpeg", OFFSET(user_agent), AV_OPT_TYPE_STRING, { .str = DEFAULT_USER_AGENT }, 0, 0, D },
     { "multiple_requests", "use persistent connections", OFFSET(multiple_requests), AV_OPT_TYPE_INT, { .i64 = 0 }, 0, 1, D | E },
+    { "connection_pool", "keep the connection alive in a process-wide pool and reuse pooled connections", OFFSET(connection_pool), AV_OPT_TYPE_INT, { .i64 = 0 }, 0, 1, D | E },
+    { "pool_max_idle", "maximum number of idle pooled connections per server", OFFSET(pool_max_idle), AV_OPT_TYPE_INT, { .i64 = 4 }, 1, INT_MAX, D | E },
+    { "pool_idle_timeout", "time after which idle pooled connections are closed (in microseconds)", OFFSET(pool_idle_timeout), AV_OPT_TYPE_INT64, { .i64 = 30000000 }, 0, INT64_MAX, D | E },
     { "post_data", "set custom HTTP post data", OFFSET(post_data), AV_OPT_TYPE_BINARY, .flags = D | E },
     { "mime_type", "export the MIME type", OFFSET(mime_type), AV_OPT_TYPE_STRING, { 0 }, 0, 0, AV_OPT_FLAG_EXPORT | AV_OPT_FLAG_READONLY },
     { "icy", "request ICY metadata", OFFSET(icy), AV_OPT_TYPE_INT, { .i64 = 1 }, 0, 1, D },
@@ -123,6 +150,246 @@ static const AVOption options[] = {
 static int http_connect(URLContext *h, const char *path, const char *local_path,
                         const char *hoststr, const char *auth,
                         const char *proxyauth, int *new_location);
+static int http_read_header(URLContext *h, int *new_location);
+static int http_buf_read(URLContext *h, uint8_t *buf, int size);
+
+static AVOnce pool_init_once = AV_ONCE_INIT;
+static AVMutex pool_mutex;
+/* Idle connections, the most recently used first. */
+static HTTPPoolConnection *pool;
+
+static void pool_init(void)
+{
+    ff_mutex_init(&pool_mutex, NULL);
+}
+
+static int pool_interrupt_cb(void *opaque)
+{
+    HTTPPoolConnection *conn = opaque;
+    return ff_check_interrupt(&conn->interrupt_callback);
+}
+
+static void pool_free_connection(HTTPPoolConnection *conn)
+{
+    ffurl_close(conn->hd);
+    av_free(conn);
+}
+
+/**
+ * Check that an idle connection has not been closed by the server,
+ * which would make it readable.
+ */
+static int pool_connection_alive(HTTPPoolConnection *conn)
+{
+    struct pollfd p = { ffurl_get_file_handle(conn->hd), POLLIN, 0 };
+
+    if (p.fd < 0)
+        return 0;
+    return poll(&p, 1, 0) == 0;
+}
+
+/**
+ * Take an idle connection to key out of the pool, closing the expired
+ * and dead ones on the way.
+ */
+static HTTPPoolConnection *pool_get(const char *key, int64_t idle_timeout)
+{
+    HTTPPoolConnection **p, *conn, *found = NULL, *closed = NULL;
+    int64_t now = av_gettime_relative();
+
+    ff_thread_once(&pool_init_once, pool_init);
+
+    ff_mutex_lock(&pool_mutex);
+    p = &pool;
+    while ((conn = *p)) {
+        if (now - conn->idle_since > idle_timeout ||
+            (!found && !strcmp(conn->key, key) &&
+             !pool_connection_alive(conn))) {
+            *p         = conn->next;
+            conn->next = closed;
+            closed     = conn;
+        } else if (!found && !strcmp(conn->key, key)) {
+            *p    = conn->next;
+            found = conn;
+        } else {
+            p = &conn->next;
+        }
+    }
+    ff_mutex_unlock(&pool_mutex);
+
+    while ((conn = closed)) {
+        closed = conn->next;
+        pool_free_connection(conn);
+    }
+
+    if (found)
+        found->next = NULL;
+    return found;
+}
+
+/**
+ * Park an idle connection in the pool, or close it if there already are
+ * max_idle connections to the same server.
+ */
+static void pool_put(HTTPPoolConnection *conn, int max_idle)
+{
+    HTTPPoolConnection *cur;
+    int idle = 0;
+
+    ff_thread_once(&pool_init_once, pool_init);
+
+    conn->interrupt_callback.callback = NULL;
+    conn->interrupt_callback.opaque   = NULL;
+    conn->idle_since                  = av_gettime_relative();
+
+    ff_mutex_lock(&pool_mutex);
+    for (cur = pool; cur; cur = cur->next)
+        idle += !strcmp(cur->key, conn->key);
+    if (idle < max_idle) {
+        conn->next = pool;
+        pool       = conn;
+        conn       = NULL;
+    }
+    ff_mutex_unlock(&pool_mutex);
+
+    if (conn)
+        pool_free_connection(conn);
+}
+
+/**
+ * Get the key of the pooled connections to the lower protocol url opened
+ * with options.
+ *
+ * The TLS options decide which servers are trusted and which certificate
+ * the client presents, so a connection must not be handed to a request
+ * made with other ones. They are part of the key.
+ *
+ * @return 0 on success, a negative value if the key does not fit, in which
+ *         case the connection must not be pooled
+ */
+static int pool_key(char *key, int size, const char *url, AVDictionary *options)
+{
+    static const char *const tls_options[] = {
+        "tls_verify", "ca_file", "cert_file", "key_file",
+    };
+    AVDictionaryEntry *e;
+    int i;
+
+    if (av_strlcpy(key, url, size) >= size)
+        return AVERROR(ENAMETOOLONG);
+    for (i = 0; i < FF_ARRAY_ELEMS(tls_options); i++) {
+        if ((e = av_dict_get(options, tls_options[i], NULL, 0)) &&
+            av_strlcatf(key, size, " %s=%s", e->key, e->value) >= size)
+            return AVERROR(ENAMETOOLONG);
+    }
+    return 0;
+}
+
+static int http_open_hd(URLContext *h, const char *url, const char *key,
+                        AVDictionary **options)
+{
+    HTTPContext *s = h->priv_data;
+    AVIOInterruptCB int_cb = h->interrupt_callback;
+    int err;
+
+    if (key) {
+        s->conn = av_mallocz(sizeof(*s->conn));
+        if (!s->conn)
+            return AVERROR(ENOMEM);
+        av_strlcpy(s->conn->key, key, sizeof(s->conn->key));
+        s->conn->interrupt_callback = h->interrupt_callback;
+        int_cb.callback = pool_interrupt_cb;
+        int_cb.opaque   = s->conn;
+    }
+
+    err = ffurl_open(&s->hd, url, AVIO_FLAG_READ_WRITE,
+                     &int_cb, options, h->protocols, h);
+    if (err < 0) {
+        av_freep(&s->conn);
+        return err;
+    }
+    if (s->conn)
+        s->conn->hd = s->hd;
+    return 0;
+}
+
+static void http_close_hd(HTTPContext *s)
+{
+    if (s->hd)
+        ffurl_close(s->hd);
+    s->hd = NULL;
+    av_freep(&s->conn);
+}
+
+void ff_http_pool_uninit(void)
+{
+    HTTPPoolConnection *conn, *next;
+
+    ff_thread_once(&pool_init_once, pool_init);
+
+    ff_mutex_lock(&pool_mutex);
+    conn = pool;
+    pool = NULL;
+    ff_mutex_unlock(&pool_mutex);
+
+    for (; conn; conn = next) {
+        next = conn->next;
+        pool_free_connection(conn);
+    }
+}
+
+/**
+ * Check whether the connection can carry another request once this one
+ * is done, reading what is left of the reply.
+ */
+static int http_connection_reusable(URLContext *h)
+{
+    HTTPContext *s = h->priv_data;
+    uint8_t buf[1024];
+    int new_location, ret;
+
+    if (!s->hd || s->willclose)
+        return 0;
+
+    if (!s->end_header) {
+        /* Uploads read the reply only after the end of the data. */
+        if (!s->end_chunked_post ||
+            http_read_header(h, &new_location) < 0 || s->willclose)
+            return 0;
+    }
+
+    /* The end of the reply must be known and close enough. */
+    if (s->chunksize >= 0 || s->filesize < 0 || s->end_off ||
+        s->filesize - s->off > POOL_MAX_DRAIN)
+        return 0;
+    while (s->off < s->filesize) {
+        ret = http_buf_read(h, buf, FFMIN(sizeof(buf), s->filesize - s->off));
+        if (ret <= 0)
+            return 0;
+    }
+
+    return s->buf_ptr == s->buf_end;
+}
+
+/**
+ * Give the connection back to the pool if it can carry another request,
+ * close it otherwise.
+ */
+static void http_release_hd(URLContext *h)
+{
+    HTTPContext *s = h->priv_data;
+    int64_t off = s->off;
+
+    if (s->conn && http_connection_reusable(h)) {
+        pool_put(s->conn, s->pool_max_idle);
+        s->conn = NULL;
+        s->hd   = NULL;
+    }
+    http_close_hd(s);
+    /* reading the body of a redirect or an authentication request does not
+     * move the position of the next request */
+    s->off = off;
+}
 
 void ff_http_init_auth_state(URLContext *dest, const URLContext *src)
 {
@@ -140,8 +407,9 @@ static int http_open_cnx_internal(URLContext *h, AVDictionary **options)
     char hostname[1024], hoststr[1024], proto[10];
     char auth[1024], proxyauth[1024] = "";
     char path1[MAX_URL_SIZE];
-    char buf[1024], urlbuf[MAX_URL_SIZE];
-    int port, use_proxy, err, location_changed = 0;
+    char buf[1024], urlbuf[MAX_URL_SIZE], key[1024];
+    const char *pooled_key = NULL;
+    int port, use_proxy, err, location_changed = 0, reused = 0;
     HTTPContext *s = h->priv_data;
 
     av_url_split(proto, sizeof(proto), auth, sizeof(auth),
@@ -179,15 +447,36 @@ static int http_open_cnx_internal(URLContext *h, AVDictionary **options)
 
     ff_url_join(buf, sizeof(buf), lower_proto, NULL, hostname, port, NULL);
 
+    if (s->connection_pool &&
+        pool_key(key, sizeof(key), buf, options ? *options : NULL) >= 0)
+        pooled_key = key;
+
+    if (!s->hd && pooled_key &&
+        (s->conn = pool_get(pooled_key, s->pool_idle_timeout))) {
+        s->conn->interrupt_callback = h->interrupt_callback;
+        s->hd = s->conn->hd;
+        reused = 1;
+    }
+
     if (!s->hd) {
-        err = ffurl_open(&s->hd, buf, AVIO_FLAG_READ_WRITE,
-                         &h->interrupt_callback, options, h->protocols, h);
+        err = http_open_hd(h, buf, pooled_key, options);
         if (err < 0)
             return err;
     }
 
     err = http_connect(h, path, local_path, hoststr,
                        auth, proxyauth, &location_changed);
+    if (err < 0 && reused) {
+        /* The server may have dropped the idle connection just as we
+         * used it, retry once on a new one. */
+        av_log(h, AV_LOG_DEBUG, "Pooled connection to %s failed, reconnecting\n",
+               buf);
+        http_close_hd(s);
+        if ((err = http_open_hd(h, buf, pooled_key, options)) < 0)
+            return err;
+        err = http_connect(h, path, local_path, hoststr,
+                           auth, proxyauth, &location_changed);
+    }
     if (err < 0)
         return err;
 
@@ -212,8 +501,7 @@ redo:
     if (s->http_code == 401) {
         if ((cur_auth_type == HTTP_AUTH_NONE || s->auth_state.stale) &&
             s->auth_state.auth_type != HTTP_AUTH_NONE && attempts < 4) {
-            ffurl_close(s->hd);
-            s->hd = NULL;
+            http_release_hd(h);
             goto redo;
         } else
             goto fail;
@@ -221,8 +509,7 @@ redo:
     if (s->http_code == 407) {
         if ((cur_proxy_auth_type == HTTP_AUTH_NONE || s->proxy_auth_state.stale) &&
             s->proxy_auth_state.auth_type != HTTP_AUTH_NONE && attempts < 4) {
-            ffurl_close(s->hd);
-            s->hd = NULL;
+            http_release_hd(h);
             goto redo;
         } else
             goto fail;
@@ -231,8 +518,7 @@ redo:
          s->http_code == 303 || s->http_code == 307) &&
         location_changed == 1) {
         /* url moved, get next */
-        ffurl_close(s->hd);
-        s->hd = NULL;
+        http_release_hd(h);
         if (redirects++ >= MAX_REDIRECTS)
             return AVERROR(EIO);
         /* Restart the authentication process with the new target, which
@@ -245,9 +531,7 @@ redo:
     return 0;
 
 fail:
-    if (s->hd)
-        ffurl_close(s->hd);
-    s->hd = NULL;
+    http_close_hd(s);
     return AVERROR(EIO);
 }
 
@@ -623,7 +907,7 @@ static int http_connect(URLContext *h, const char *path, const char *local_path,
                            "Expect: 100-continue\r\n");
 
     if (!has_header(s->headers, "\r\nConnection: ")) {
-        if (s->multiple_requests)
+        if (s->multiple_requests || s->connection_pool)
             len += av_strlcpy(headers + len, "Connection: keep-alive\r\n",
                               sizeof(headers) - len);
         else
@@ -951,8 +1235,7 @@ static int http_close(URLContext *h)
         /* Close the write direction by sending the end of chunked encoding. */
         ret = http_shutdown(h, h->flags);
 
-    if (s->hd)
-        ffurl_close(s->hd);
+    http_release_hd(h);
     av_dict_free(&s->chained_options);
     return ret;
 }
@@ -961,6 +1244,7 @@ static int64_t http_seek(URLContext *h, int64_t off, int whence)
 {
     HTTPContext *s = h->priv_data;
     URLContext *old_hd = s->hd;
+    HTTPPoolConnection *old_conn = s->conn;
     int64_t old_off = s->off;
     uint8_t old_buf[BUFFER_SIZE];
     int old_buf_size, ret;
@@ -977,7 +1261,8 @@ static int64_t http_seek(URLContext *h, int64_t off, int whence)
     /* we save the old context in case the seek fails */
     old_buf_size = s->buf_end - s->buf_ptr;
     memcpy(old_buf, s->buf_ptr, old_buf_size);
-    s->hd = NULL;
+    s->hd   = NULL;
+    s->conn = NULL;
     if (whence == SEEK_CUR)
         off += s->off;
     else if (whence == SEEK_END)
@@ -992,11 +1277,13 @@ static int64_t http_seek(URLContext *h, int64_t off, int whence)
         s->buf_ptr = s->buffer;
         s->buf_end = s->buffer + old_buf_size;
         s->hd      = old_hd;
+        s->conn    = old_conn;
         s->off     = old_off;
         return ret;
     }
     av_dict_free(&options);
     ffurl_close(old_hd);
+    av_free(old_conn);
     return off;
 }
 
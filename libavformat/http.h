@@ -47,4 +47,9 @@ void ff_http_init_auth_state(URLContext *dest, const URLContext *src);
  */
 int ff_http_do_new_request(URLContext *h, const char *uri);
 
+/**
+ * Close the idle connections of the connection pool.
+ */
+void ff_http_pool_uninit(void);
+
 #endif /* AVFORMAT_HTTP_H */
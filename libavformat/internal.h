@@ -236,6 +236,14 @@ void ff_put_v(AVIOContext *bc, uint64_t val);
  */
 int ff_get_line(AVIOContext *s, char *buf, int maxlen);
 
+/**
+ * Like av_get_packet(), but when the protocol allows it the packet
+ * references its data in place instead of holding a copy.
+ * Such packets are read-only and their padding is not zeroed, so this is
+ * only suitable for demuxers that do not modify the packet data.
+ */
+int ff_get_packet_ref(AVIOContext *s, AVPacket *pkt, int size);
+
 #define SPACE_CHARS " \t\r\n"
 
 /**
@@ -94,8 +94,10 @@ typedef struct EbmlList {
 
 typedef struct EbmlBin {
     int      size;
+    AVBufferRef *buf;
     uint8_t *data;
     int64_t  pos;
+    int      mapped;    ///< buf references the input in place, see ffio_read_ref()
 } EbmlBin;
 
 typedef struct Ebml {
@@ -769,18 +771,29 @@ static int ebml_read_ascii(AVIOContext *pb, int size, char **str)
  */
 static int ebml_read_binary(AVIOContext *pb, int length, EbmlBin *bin)
 {
-    av_free(bin->data);
-    bin->size = 0;
-
-    if (!(bin->data = av_mallocz(length + AV_INPUT_BUFFER_PADDING_SIZE)))
-        return AVERROR(ENOMEM);
+    av_buffer_unref(&bin->buf);
+    bin->data   = NULL;
+    bin->size   = 0;
+    bin->mapped = 0;
 
     bin->pos  = avio_tell(pb);
-    if (avio_read(pb, bin->data, length) != length) {
-        av_freep(&bin->data);
-        return AVERROR(EIO);
+
+    /* Blocks are handed out as packets referencing this buffer, so when the
+     * protocol allows it avoid copying the data at all. */
+    if (ffio_read_ref(pb, length, &bin->buf) >= 0) {
+        bin->mapped = 1;
+    } else {
+        if (!(bin->buf = av_buffer_alloc(length + AV_INPUT_BUFFER_PADDING_SIZE)))
+            return AVERROR(ENOMEM);
+        memset(bin->buf->data + length, 0, AV_INPUT_BUFFER_PADDING_SIZE);
+
+        if (avio_read(pb, bin->buf->data, length) != length) {
+            av_buffer_unref(&bin->buf);
+            return AVERROR(EIO);
+        }
     }
 
+    bin->data = bin->buf->data;
     bin->size = length;
 
     return 0;
@@ -995,7 +1008,7 @@ static void ebml_free(EbmlSyntax *syntax, void *data)
             av_freep(data_off);
             break;
         case EBML_BIN:
-            av_freep(&((EbmlBin *) data_off)->data);
+            av_buffer_unref(&((EbmlBin *) data_off)->buf);
             break;
         case EBML_NEST:
             if (syntax[i].list_elem_size) {
@@ -1766,8 +1779,19 @@ static int matroska_parse_tracks(AVFormatContext *s)
                            "Failed to decode codec private data\n");
                 }
 
-                if (codec_priv != track->codec_priv.data)
-                    av_free(codec_priv);
+                if (codec_priv != track->codec_priv.data) {
+                    av_buffer_unref(&track->codec_priv.buf);
+                    if (track->codec_priv.data) {
+                        track->codec_priv.buf = av_buffer_create(track->codec_priv.data,
+                                                                 track->codec_priv.size,
+                                                                 NULL, NULL, 0);
+                        if (!track->codec_priv.buf) {
+                            av_freep(&track->codec_priv.data);
+                            track->codec_priv.size = 0;
+                            return AVERROR(ENOMEM);
+                        }
+                    }
+                }
             }
         }
 
@@ -2503,7 +2527,7 @@ fail:
 
 static int matroska_parse_frame(MatroskaDemuxContext *matroska,
                                 MatroskaTrack *track, AVStream *st,
-                                uint8_t *data, int pkt_size,
+                                AVBufferRef *buf, uint8_t *data, int pkt_size,
                                 uint64_t timecode, uint64_t duration,
                                 int64_t pos, int is_keyframe)
 {
@@ -2536,26 +2560,44 @@ static int matroska_parse_frame(MatroskaDemuxContext *matroska,
 
     pkt = av_mallocz(sizeof(AVPacket));
     if (!pkt) {
-        av_freep(&pkt_data);
-        return AVERROR(ENOMEM);
-    }
-    /* XXX: prevent data copy... */
-    if (av_new_packet(pkt, pkt_size + offset) < 0) {
-        av_free(pkt);
-        av_freep(&pkt_data);
+        if (pkt_data != data)
+            av_freep(&pkt_data);
         return AVERROR(ENOMEM);
     }
+    av_init_packet(pkt);
 
-    if (st->codecpar->codec_id == AV_CODEC_ID_PRORES) {
-        uint8_t *buf = pkt->data;
-        bytestream_put_be32(&buf, pkt_size);
-        bytestream_put_be32(&buf, MKBETAG('i', 'c', 'p', 'f'));
-    }
+    /* buf is only set for mapped blocks.
+     * A frame stored as is in a mapped block is referenced in place, unless
+     * it is modified later on, as SSA packets are. The padding of such
+     * packets holds whatever follows them in the input. */
+    if (buf && pkt_data == data && !offset &&
+        st->codecpar->codec_id != AV_CODEC_ID_SSA) {
+        pkt->buf = av_buffer_ref(buf);
+        if (!pkt->buf) {
+            av_free(pkt);
+            return AVERROR(ENOMEM);
+        }
+        pkt->data = data;
+        pkt->size = pkt_size;
+    } else {
+        if (av_new_packet(pkt, pkt_size + offset) < 0) {
+            av_free(pkt);
+            if (pkt_data != data)
+                av_freep(&pkt_data);
+            return AVERROR(ENOMEM);
+        }
 
-    memcpy(pkt->data + offset, pkt_data, pkt_size);
+        if (st->codecpar->codec_id == AV_CODEC_ID_PRORES) {
+            uint8_t *buf = pkt->data;
+            bytestream_put_be32(&buf, pkt_size);
+            bytestream_put_be32(&buf, MKBETAG('i', 'c', 'p', 'f'));
+        }
 
-    if (pkt_data != data)
-        av_free(pkt_data);
+        memcpy(pkt->data + offset, pkt_data, pkt_size);
+
+        if (pkt_data != data)
+            av_free(pkt_data);
+    }
 
     pkt->flags        = is_keyframe;
     pkt->stream_index = st->index;
@@ -2596,7 +2638,8 @@ fail:
     return res;
 }
 
-static int matroska_parse_block(MatroskaDemuxContext *matroska, uint8_t *data,
+static int matroska_parse_block(MatroskaDemuxContext *matroska,
+                                AVBufferRef *buf, uint8_t *data,
                                 int size, int64_t pos, uint64_t cluster_time,
                                 uint64_t block_duration, int is_keyframe,
                                 int64_t cluster_pos)
@@ -2686,8 +2729,8 @@ static int matroska_parse_block(MatroskaDemuxContext *matroska, uint8_t *data,
             if (res)
                 goto end;
         } else {
-            res = matroska_parse_frame(matroska, track, st, data, lace_size[n],
-                                       timecode, duration, pos,
+            res = matroska_parse_frame(matroska, track, st, buf, data,
+                                       lace_size[n], timecode, duration, pos,
                                        !n ? is_keyframe : 0);
             if (res)
                 goto end;
@@ -2745,7 +2788,9 @@ static int matroska_parse_cluster_incremental(MatroskaDemuxContext *matroska)
             int is_keyframe = blocks[i].non_simple ? !blocks[i].reference : -1;
             if (!blocks[i].non_simple)
                 blocks[i].duration = AV_NOPTS_VALUE;
-            res = matroska_parse_block(matroska, blocks[i].bin.data,
+            res = matroska_parse_block(matroska,
+                                       blocks[i].bin.mapped ? blocks[i].bin.buf : NULL,
+                                       blocks[i].bin.data,
                                        blocks[i].bin.size, blocks[i].bin.pos,
                                        matroska->current_cluster.timecode,
                                        blocks[i].duration, is_keyframe,
@@ -2780,7 +2825,9 @@ static int matroska_parse_cluster(MatroskaDemuxContext *matroska)
             int is_keyframe = blocks[i].non_simple ? !blocks[i].reference : -1;
             if (!blocks[i].non_simple)
                 blocks[i].duration = AV_NOPTS_VALUE;
-            res = matroska_parse_block(matroska, blocks[i].bin.data,
+            res = matroska_parse_block(matroska,
+                                       blocks[i].bin.mapped ? blocks[i].bin.buf : NULL,
+                                       blocks[i].bin.data,
                                        blocks[i].bin.size, blocks[i].bin.pos,
                                        cluster.timecode, blocks[i].duration,
                                        is_keyframe, pos);
@@ -3941,7 +3941,12 @@ static int mov_read_packet(AVFormatContext *s, AVPacket *pkt)
                    sc->ffindex, sample->pos);
             return AVERROR_INVALIDDATA;
         }
-        ret = av_get_packet(sc->pb, pkt, sample->size);
+        /* the DV demuxer consumes the packet data, everything else is
+         * passed through untouched and can reference the input in place */
+        if (mov->dv_demux && sc->dv_audio_container)
+            ret = av_get_packet(sc->pb, pkt, sample->size);
+        else
+            ret = ff_get_packet_ref(sc->pb, pkt, sample->size);
         if (ret < 0)
             return ret;
         if (sc->has_palette) {
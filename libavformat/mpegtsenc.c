@@ -1033,7 +1033,7 @@ static void mpegts_write_pes(AVFormatContext *s, AVStream *st,
         mpegts_prefix_m2ts_header(s);
         avio_write(s->pb, buf, TS_PACKET_SIZE);
     }
-    avio_flush(s->pb);
+    ffio_end_packet(s->pb);
 }
 
 static int mpegts_write_packet_internal(AVFormatContext *s, AVPacket *pkt)
@@ -20,6 +20,7 @@
  */
 
 #include "avformat.h"
+#include "avio_internal.h"
 #include "mpegts.h"
 #include "internal.h"
 #include "libavutil/mathematics.h"
@@ -315,7 +316,7 @@ void ff_rtp_send_data(AVFormatContext *s1, const uint8_t *buf1, int len, int m)
     avio_wb32(s1->pb, s->ssrc);
 
     avio_write(s1->pb, buf1, len);
-    avio_flush(s1->pb);
+    ffio_end_packet(s1->pb);
 
     s->seq = (s->seq + 1) & 0xffff;
     s->octet_count += len;
@@ -514,6 +514,31 @@ static int rtp_write(URLContext *h, const uint8_t *buf, int size)
     return ret;
 }
 
+static int rtp_write_vec(URLContext *h, const uint8_t * const *bufs,
+                         const int *sizes, int nb_bufs)
+{
+    RTPContext *s = h->priv_data;
+    int i, rtcp, ret;
+
+    /* replies to the source address are not worth batching */
+    if (s->write_to_source || sizes[0] < 2) {
+        ret = rtp_write(h, bufs[0], sizes[0]);
+        return ret < 0 ? ret : 1;
+    }
+
+    /* send the leading run of packets going to the same socket */
+    rtcp = RTP_PT_IS_RTCP(bufs[0][1]);
+    for (i = 0; i < nb_bufs; i++) {
+        if (sizes[i] < 2 || RTP_PT_IS_RTCP(bufs[i][1]) != rtcp)
+            break;
+        if ((bufs[i][0] & 0xc0) != (RTP_VERSION << 6))
+            av_log(h, AV_LOG_WARNING, "Data doesn't look like RTP packets, "
+                                      "make sure the RTP muxer is used\n");
+    }
+
+    return ffurl_write_vec(rtcp ? s->rtcp_hd : s->rtp_hd, bufs, sizes, i);
+}
+
 static int rtp_close(URLContext *h)
 {
     RTPContext *s = h->priv_data;
@@ -579,6 +604,7 @@ const URLProtocol ff_rtp_protocol = {
     .url_open                  = rtp_open,
     .url_read                  = rtp_read,
     .url_write                 = rtp_write,
+    .url_write_vec             = rtp_write_vec,
     .url_close                 = rtp_close,
     .url_get_file_handle       = rtp_get_file_handle,
     .url_get_multi_file_handle = rtp_get_multi_file_handle,
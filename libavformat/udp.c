@@ -26,17 +26,29 @@
 
 #define _DEFAULT_SOURCE
 #define _BSD_SOURCE     /* Needed for using struct ip_mreq with recent glibc */
+#define _GNU_SOURCE     /* Needed for recvmmsg() and sendmmsg() */
+
+#include "config.h"
 
 #include "avformat.h"
 #include "avio_internal.h"
 #include "libavutil/parseutils.h"
 #include "libavutil/avstring.h"
+#include "libavutil/fifo.h"
 #include "libavutil/opt.h"
 #include "internal.h"
 #include "network.h"
 #include "os_support.h"
 #include "url.h"
 
+#if HAVE_PTHREADS
+#include <pthread.h>
+#elif HAVE_W32THREADS
+#include "compat/w32pthreads.h"
+#endif
+
+#define UDP_RX_THREAD (HAVE_PTHREADS || HAVE_W32THREADS)
+
 #ifndef IPV6_ADD_MEMBERSHIP
 #define IPV6_ADD_MEMBERSHIP IPV6_JOIN_GROUP
 #define IPV6_DROP_MEMBERSHIP IPV6_LEAVE_GROUP
@@ -57,10 +69,26 @@ typedef struct UDPContext {
     char *localaddr;
     char *sources;
     char *block;
+
+    /* receive thread and its circular buffer */
+    int fifo_size;
+    int overrun_nonfatal;
+    AVFifoBuffer *fifo;
+    uint8_t *rx_buf;
+#if UDP_RX_THREAD
+    pthread_t rx_thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    int thread_exit;
+    int thread_ret;
+#endif
 } UDPContext;
 
 #define UDP_TX_BUF_SIZE 32768
 #define UDP_MAX_PKT_SIZE 65536
+#define UDP_RX_BATCH 32         /* datagrams fetched by one recvmmsg() */
+#define UDP_TX_BATCH 32         /* datagrams sent by one sendmmsg() */
+#define UDP_FIFO_UNIT 188       /* fifo_size is counted in TS packets */
 
 #define OFFSET(x) offsetof(UDPContext, x)
 #define D AV_OPT_FLAG_DECODING_PARAM
@@ -75,6 +103,8 @@ static const AVOption options[] = {
     { "localaddr",      "Local address",                                   OFFSET(localaddr),      AV_OPT_TYPE_STRING, { .str = NULL },               .flags = D|E },
     { "sources",        "Source list",                                     OFFSET(sources),        AV_OPT_TYPE_STRING, { .str = NULL },               .flags = D|E },
     { "block",          "Block list",                                      OFFSET(block),          AV_OPT_TYPE_STRING, { .str = NULL },               .flags = D|E },
+    { "fifo_size",      "Receive circular buffer size (in 188 byte packets), 0 disables the receive thread", OFFSET(fifo_size), AV_OPT_TYPE_INT, { .i64 = 0 }, 0, INT_MAX / UDP_FIFO_UNIT, .flags = D },
+    { "overrun_nonfatal", "Drop datagrams instead of failing when the circular buffer overruns", OFFSET(overrun_nonfatal), AV_OPT_TYPE_INT, { .i64 = 0 }, 0, 1, .flags = D },
     { NULL }
 };
 
@@ -437,6 +467,135 @@ static int parse_source_list(char *buf, char **sources, int *num_sources,
     return 0;
 }
 
+#if UDP_RX_THREAD
+/**
+ * Receive the datagrams waiting on the socket into s->rx_buf.
+ * @param len receives the size of each datagram
+ * @return the number of datagrams or a negative error code
+ */
+static int udp_recv_batch(UDPContext *s, int *len)
+{
+#if HAVE_RECVMMSG
+    struct mmsghdr msg[UDP_RX_BATCH] = { { { 0 } } };
+    struct iovec iov[UDP_RX_BATCH];
+    int i, ret;
+
+    for (i = 0; i < UDP_RX_BATCH; i++) {
+        iov[i].iov_base           = s->rx_buf + i * UDP_MAX_PKT_SIZE;
+        iov[i].iov_len            = UDP_MAX_PKT_SIZE;
+        msg[i].msg_hdr.msg_iov    = &iov[i];
+        msg[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    ret = recvmmsg(s->udp_fd, msg, UDP_RX_BATCH, 0, NULL);
+    if (ret < 0)
+        return ff_neterrno();
+
+    for (i = 0; i < ret; i++)
+        len[i] = msg[i].msg_len;
+
+    return ret;
+#else
+    int ret = recv(s->udp_fd, s->rx_buf, UDP_MAX_PKT_SIZE, 0);
+    if (ret < 0)
+        return ff_neterrno();
+
+    len[0] = ret;
+    return 1;
+#endif
+}
+
+static void *attribute_align_arg udp_rx_thread(void *arg)
+{
+    URLContext *h = arg;
+    UDPContext *s = h->priv_data;
+    int len[UDP_RX_BATCH];
+    int i, n, ret = 0;
+
+    for (;;) {
+        ret = ff_network_wait_fd(s->udp_fd, 0);
+
+        pthread_mutex_lock(&s->mutex);
+        if (s->thread_exit) {
+            pthread_mutex_unlock(&s->mutex);
+            return NULL;
+        }
+        /* wake the reader up now and then even without data, so that it
+         * can check the interrupt callback */
+        if (ret == AVERROR(EAGAIN))
+            pthread_cond_signal(&s->cond);
+        pthread_mutex_unlock(&s->mutex);
+
+        if (ret == AVERROR(EAGAIN))
+            continue;
+        if (ret < 0)
+            break;
+
+        n = udp_recv_batch(s, len);
+        if (n == AVERROR(EAGAIN))
+            continue;
+        if (n < 0) {
+            ret = n;
+            break;
+        }
+
+        pthread_mutex_lock(&s->mutex);
+        for (i = 0; i < n; i++) {
+            if (av_fifo_space(s->fifo) < len[i] + (int)sizeof(len[i])) {
+                if (s->overrun_nonfatal) {
+                    av_log(h, AV_LOG_WARNING,
+                           "Circular buffer overrun, dropping a datagram.\n");
+                    continue;
+                }
+                av_log(h, AV_LOG_ERROR,
+                       "Circular buffer overrun. Increase fifo_size or set "
+                       "overrun_nonfatal to drop datagrams instead.\n");
+                s->thread_ret = AVERROR(EIO);
+                pthread_cond_signal(&s->cond);
+                pthread_mutex_unlock(&s->mutex);
+                return NULL;
+            }
+            av_fifo_generic_write(s->fifo, &len[i], sizeof(len[i]), NULL);
+            av_fifo_generic_write(s->fifo, s->rx_buf + i * UDP_MAX_PKT_SIZE,
+                                  len[i], NULL);
+        }
+        pthread_cond_signal(&s->cond);
+        pthread_mutex_unlock(&s->mutex);
+    }
+
+    pthread_mutex_lock(&s->mutex);
+    s->thread_ret = ret;
+    pthread_cond_signal(&s->cond);
+    pthread_mutex_unlock(&s->mutex);
+
+    return NULL;
+}
+
+static int udp_read_fifo(URLContext *h, uint8_t *buf, int size)
+{
+    UDPContext *s = h->priv_data;
+    int len, ret;
+
+    pthread_mutex_lock(&s->mutex);
+    if (!av_fifo_size(s->fifo) && !s->thread_ret &&
+        !(h->flags & AVIO_FLAG_NONBLOCK))
+        pthread_cond_wait(&s->cond, &s->mutex);
+
+    if (av_fifo_size(s->fifo)) {
+        av_fifo_generic_read(s->fifo, &len, sizeof(len), NULL);
+        ret = FFMIN(len, size);
+        av_fifo_generic_read(s->fifo, buf, ret, NULL);
+        /* like recv(), drop what does not fit in buf */
+        av_fifo_drain(s->fifo, len - ret);
+    } else {
+        ret = s->thread_ret ? s->thread_ret : AVERROR(EAGAIN);
+    }
+    pthread_mutex_unlock(&s->mutex);
+
+    return ret;
+}
+#endif
+
 /* put it in UDP context */
 /* return non zero if error */
 static int udp_open(URLContext *h, const char *uri, int flags)
@@ -513,6 +672,12 @@ static int udp_open(URLContext *h, const char *uri, int flags)
                                   FF_ARRAY_ELEMS(exclude_sources)))
                 goto fail;
         }
+        if (av_find_info_tag(buf, sizeof(buf), "fifo_size", p)) {
+            s->fifo_size = strtol(buf, NULL, 10);
+        }
+        if (av_find_info_tag(buf, sizeof(buf), "overrun_nonfatal", p)) {
+            s->overrun_nonfatal = strtol(buf, NULL, 10);
+        }
     }
 
     /* fill the dest addr */
@@ -630,8 +795,38 @@ static int udp_open(URLContext *h, const char *uri, int flags)
         av_freep(&exclude_sources[i]);
 
     s->udp_fd = udp_fd;
+
+    if (!is_output && s->fifo_size > 0) {
+#if UDP_RX_THREAD
+        int ret;
+
+        if (s->fifo_size > INT_MAX / UDP_FIFO_UNIT)
+            goto fail;
+        s->fifo   = av_fifo_alloc(s->fifo_size * UDP_FIFO_UNIT);
+        s->rx_buf = av_malloc(UDP_RX_BATCH * UDP_MAX_PKT_SIZE);
+        if (!s->fifo || !s->rx_buf)
+            goto fail;
+
+        pthread_mutex_init(&s->mutex, NULL);
+        pthread_cond_init(&s->cond, NULL);
+        ret = pthread_create(&s->rx_thread, NULL, udp_rx_thread, h);
+        if (ret) {
+            av_log(h, AV_LOG_ERROR, "Failed to create the receive thread.\n");
+            pthread_cond_destroy(&s->cond);
+            pthread_mutex_destroy(&s->mutex);
+            goto fail;
+        }
+#else
+        av_log(h, AV_LOG_WARNING,
+               "fifo_size is not supported without threads, ignoring it\n");
+#endif
+    }
+
     return 0;
  fail:
+    av_fifo_free(s->fifo);
+    s->fifo = NULL;
+    av_freep(&s->rx_buf);
     if (udp_fd >= 0)
         closesocket(udp_fd);
     for (i = 0; i < num_include_sources; i++)
@@ -646,6 +841,11 @@ static int udp_read(URLContext *h, uint8_t *buf, int size)
     UDPContext *s = h->priv_data;
     int ret;
 
+#if UDP_RX_THREAD
+    if (s->fifo)
+        return udp_read_fifo(h, buf, size);
+#endif
+
     if (!(h->flags & AVIO_FLAG_NONBLOCK)) {
         ret = ff_network_wait_fd(s->udp_fd, 0);
         if (ret < 0)
@@ -676,10 +876,56 @@ static int udp_write(URLContext *h, const uint8_t *buf, int size)
     return ret < 0 ? ff_neterrno() : ret;
 }
 
+#if HAVE_SENDMMSG
+static int udp_write_vec(URLContext *h, const uint8_t * const *bufs,
+                         const int *sizes, int nb_bufs)
+{
+    UDPContext *s = h->priv_data;
+    struct mmsghdr msg[UDP_TX_BATCH] = { { { 0 } } };
+    struct iovec iov[UDP_TX_BATCH];
+    int i, ret;
+
+    if (!(h->flags & AVIO_FLAG_NONBLOCK)) {
+        ret = ff_network_wait_fd(s->udp_fd, 1);
+        if (ret < 0)
+            return ret;
+    }
+
+    nb_bufs = FFMIN(nb_bufs, UDP_TX_BATCH);
+    for (i = 0; i < nb_bufs; i++) {
+        iov[i].iov_base           = (void *)bufs[i];
+        iov[i].iov_len            = sizes[i];
+        msg[i].msg_hdr.msg_iov    = &iov[i];
+        msg[i].msg_hdr.msg_iovlen = 1;
+        if (!s->is_connected) {
+            msg[i].msg_hdr.msg_name    = &s->dest_addr;
+            msg[i].msg_hdr.msg_namelen = s->dest_addr_len;
+        }
+    }
+
+    ret = sendmmsg(s->udp_fd, msg, nb_bufs, 0);
+    return ret < 0 ? ff_neterrno() : ret;
+}
+#endif
+
 static int udp_close(URLContext *h)
 {
     UDPContext *s = h->priv_data;
 
+#if UDP_RX_THREAD
+    if (s->fifo) {
+        pthread_mutex_lock(&s->mutex);
+        s->thread_exit = 1;
+        pthread_mutex_unlock(&s->mutex);
+        pthread_join(s->rx_thread, NULL);
+        pthread_cond_destroy(&s->cond);
+        pthread_mutex_destroy(&s->mutex);
+    }
+#endif
+    av_fifo_free(s->fifo);
+    s->fifo = NULL;
+    av_freep(&s->rx_buf);
+
     if (s->is_multicast && (h->flags & AVIO_FLAG_READ))
         udp_leave_multicast_group(s->udp_fd, (struct sockaddr *)&s->dest_addr);
     closesocket(s->udp_fd);
@@ -691,6 +937,9 @@ const URLProtocol ff_udp_protocol = {
     .url_open            = udp_open,
     .url_read            = udp_read,
     .url_write           = udp_write,
+#if HAVE_SENDMMSG
+    .url_write_vec       = udp_write_vec,
+#endif
     .url_close           = udp_close,
     .url_get_file_handle = udp_get_file_handle,
     .priv_data_size      = sizeof(UDPContext),
@@ -27,6 +27,7 @@
 #include "avio.h"
 #include "libavformat/version.h"
 
+#include "libavutil/buffer.h"
 #include "libavutil/dict.h"
 #include "libavutil/log.h"
 
@@ -75,7 +76,24 @@ typedef struct URLProtocol {
      * retry_transfer_wrapper in avio.c.
      */
     int     (*url_read)( URLContext *h, unsigned char *buf, int size);
+    /**
+     * Return a read-only reference to size bytes of data at the absolute
+     * offset, followed by AV_INPUT_BUFFER_PADDING_SIZE readable bytes,
+     * without copying it. The read position is not changed.
+     * Return AVERROR(ENOSYS) if that is not possible for this range.
+     */
+    int     (*url_read_ref)(URLContext *h, int64_t offset, int size,
+                            AVBufferRef **buf);
     int     (*url_write)(URLContext *h, const unsigned char *buf, int size);
+    /**
+     * Write nb_bufs buffers at once, each of them as url_write() would,
+     * e.g. one datagram per buffer for packet based protocols.
+     * Return the number of buffers completely written, which may be less
+     * than nb_bufs, or a negative error code. Interrupt and retry handling
+     * is done by ffurl_write_vec().
+     */
+    int     (*url_write_vec)(URLContext *h, const uint8_t * const *bufs,
+                             const int *sizes, int nb_bufs);
     int64_t (*url_seek)( URLContext *h, int64_t pos, int whence);
     int     (*url_close)(URLContext *h);
     int (*url_read_pause)(URLContext *h, int pause);
@@ -157,6 +175,14 @@ int ffurl_open(URLContext **puc, const char *filename, int flags,
  */
 int ffurl_read(URLContext *h, unsigned char *buf, int size);
 
+/**
+ * Reference size bytes of data at offset without copying them.
+ *
+ * @return size on success, AVERROR(ENOSYS) if the protocol cannot do it
+ * @see URLProtocol.url_read_ref
+ */
+int ffurl_read_ref(URLContext *h, int64_t offset, int size, AVBufferRef **buf);
+
 /**
  * Read as many bytes as possible (up to size), calling the
  * read function multiple times if necessary.
@@ -174,6 +200,17 @@ int ffurl_read_complete(URLContext *h, unsigned char *buf, int size);
  */
 int ffurl_write(URLContext *h, const unsigned char *buf, int size);
 
+/**
+ * Write nb_bufs buffers to the resource accessed by h, with as few calls
+ * into the protocol as it allows. Each buffer is written as if by its own
+ * ffurl_write() call, so packet boundaries are kept.
+ *
+ * @return nb_bufs on success, a negative AVERROR code on failure
+ * @see URLProtocol.url_write_vec
+ */
+int ffurl_write_vec(URLContext *h, const uint8_t * const *bufs,
+                    const int *sizes, int nb_bufs);
+
 /**
  * Change the position that will be used by the next read/write
  * operation on the resource accessed by h.
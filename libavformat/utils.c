@@ -41,6 +41,8 @@
 
 #include "audiointerleave.h"
 #include "avformat.h"
+#include "avio_internal.h"
+#include "http.h"
 #include "id3v2.h"
 #include "internal.h"
 #include "metadata.h"
@@ -124,6 +126,23 @@ int av_get_packet(AVIOContext *s, AVPacket *pkt, int size)
     return append_packet_chunked(s, pkt, size);
 }
 
+int ff_get_packet_ref(AVIOContext *s, AVPacket *pkt, int size)
+{
+    AVBufferRef *buf;
+    int64_t pos = avio_tell(s);
+
+    if (size <= 0 || ffio_read_ref(s, size, &buf) < 0)
+        return av_get_packet(s, pkt, size);
+
+    av_init_packet(pkt);
+    pkt->buf  = buf;
+    pkt->data = buf->data;
+    pkt->size = size;
+    pkt->pos  = pos;
+
+    return size;
+}
+
 int av_append_packet(AVIOContext *s, AVPacket *pkt, int size)
 {
     if (!pkt->size)
@@ -3223,6 +3242,10 @@ int avformat_network_init(void)
 
 int avformat_network_deinit(void)
 {
+#if CONFIG_HTTP_PROTOCOL || CONFIG_HTTPS_PROTOCOL || CONFIG_HTTPPROXY_PROTOCOL
+    /* the pooled tls connections need the tls library */
+    ff_http_pool_uninit();
+#endif
 #if CONFIG_NETWORK
     ff_network_close();
     ff_tls_deinit();
@@ -112,5 +112,7 @@ void ff_audio_resample_init_aarch64(ResampleContext *c,
                                     enum AVSampleFormat sample_fmt);
 void ff_audio_resample_init_arm(ResampleContext *c,
                                 enum AVSampleFormat sample_fmt);
+void ff_audio_resample_init_x86(ResampleContext *c,
+                                enum AVSampleFormat sample_fmt);
 
 #endif /* AVRESAMPLE_INTERNAL_H */
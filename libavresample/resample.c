@@ -174,6 +174,8 @@ ResampleContext *ff_audio_resample_init(AVAudioResampleContext *avr)
         ff_audio_resample_init_aarch64(c, avr->internal_sample_fmt);
     if (ARCH_ARM)
         ff_audio_resample_init_arm(c, avr->internal_sample_fmt);
+    if (ARCH_X86)
+        ff_audio_resample_init_x86(c, avr->internal_sample_fmt);
 
     felem_size = av_get_bytes_per_sample(avr->internal_sample_fmt);
     c->filter_bank = av_mallocz(c->filter_length * (phase_count + 1) * felem_size);
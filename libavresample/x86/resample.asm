@@ -0,0 +1,304 @@
+;******************************************************************************
+;* x86 optimized resampling filter
+;*
+;* This file is part of Libav.
+;*
+;* Libav is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* Libav is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with Libav; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;******************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION .text
+
+; The kernels only compute the dot products of one window of src with one or
+; two filter phases, the rounding and the interpolation between the phases
+; are left to the C wrappers. Neither src nor the filters need to be aligned
+; and nothing is read past len.
+
+; Per-format helpers:
+;   ZERO_<fmt>   %1       clear the accumulator m%1
+;   MAC_<fmt>    %1, %2   m%1 += m2 * [%2], the samples are loaded into m2
+;                         (and m6 for s32) by LOAD_<fmt>
+;   MAC1_<fmt>   %1, %2   the same for the element at [%2] into lane 0 of xm%1
+;   FOLD_<fmt>   %1       add the upper half of ymm%1 to its lower half
+;   STORE_<fmt>  %1, %2   horizontally add xm%1 and store the sum to [%2]
+
+%macro ZERO_FP 1
+    xorps           m%1, m%1
+%endmacro
+
+%macro ZERO_INT 1
+    pxor            m%1, m%1
+%endmacro
+
+;-------------------------------------------------------------------------------
+; float
+;-------------------------------------------------------------------------------
+%define ZERO_flt ZERO_FP
+
+%macro LOAD_flt 1
+    movu             m2, [%1]
+%endmacro
+
+%macro MAC_flt 2
+    movu             m3, [%2]
+    FMULADD_PS      m%1, m2, m3, m%1, m3
+%endmacro
+
+%macro LOAD1_flt 1
+    movss           xm2, [%1]
+%endmacro
+
+%macro MAC1_flt 2
+    movss           xm3, [%2]
+    mulss           xm3, xm2
+    addss          xm%1, xm3
+%endmacro
+
+%macro FOLD_flt 1
+    vextractf128    xm3, m%1, 1
+    addps          xm%1, xm3
+%endmacro
+
+%macro STORE_flt 2
+    movhlps         xm3, xm%1
+    addps          xm%1, xm3
+    shufps          xm3, xm%1, xm%1, q0001
+    addss          xm%1, xm3
+    movss          [%2], xm%1
+%endmacro
+
+;-------------------------------------------------------------------------------
+; double
+;-------------------------------------------------------------------------------
+%define ZERO_dbl ZERO_FP
+
+%macro LOAD_dbl 1
+    movu             m2, [%1]
+%endmacro
+
+%macro MAC_dbl 2
+    movu             m3, [%2]
+%if cpuflag(fma3)
+    fmaddpd         m%1, m2, m3, m%1
+%else
+    mulpd            m3, m2
+    addpd           m%1, m3
+%endif
+%endmacro
+
+%macro LOAD1_dbl 1
+    movsd           xm2, [%1]
+%endmacro
+
+%macro MAC1_dbl 2
+    movsd           xm3, [%2]
+    mulsd           xm3, xm2
+    addsd          xm%1, xm3
+%endmacro
+
+%macro FOLD_dbl 1
+    vextractf128    xm3, m%1, 1
+    addpd          xm%1, xm3
+%endmacro
+
+%macro STORE_dbl 2
+    movhlps         xm3, xm%1
+    addsd          xm%1, xm3
+    movsd          [%2], xm%1
+%endmacro
+
+;-------------------------------------------------------------------------------
+; int16_t samples, int32_t sums
+;-------------------------------------------------------------------------------
+%define ZERO_s16 ZERO_INT
+
+%macro LOAD_s16 1
+    movu             m2, [%1]
+%endmacro
+
+%macro MAC_s16 2
+    movu             m3, [%2]
+    pmaddwd          m3, m2
+    paddd           m%1, m3
+%endmacro
+
+%macro LOAD1_s16 1
+    pxor            xm2, xm2
+    pinsrw          xm2, [%1], 0
+%endmacro
+
+%macro MAC1_s16 2
+    pxor            xm3, xm3
+    pinsrw          xm3, [%2], 0
+    pmaddwd         xm3, xm2
+    paddd          xm%1, xm3
+%endmacro
+
+%macro FOLD_s16 1
+    vextracti128    xm3, m%1, 1
+    paddd          xm%1, xm3
+%endmacro
+
+%macro STORE_s16 2
+    pshufd          xm3, xm%1, q1032
+    paddd          xm%1, xm3
+    pshufd          xm3, xm%1, q0001
+    paddd          xm%1, xm3
+    movd           [%2], xm%1
+%endmacro
+
+;-------------------------------------------------------------------------------
+; int32_t samples, int64_t sums
+;-------------------------------------------------------------------------------
+%define ZERO_s32 ZERO_INT
+
+; pmuldq only multiplies the even dwords, the odd ones are shifted down into
+; m6 and m4 and multiplied separately
+%macro LOAD_s32 1
+    movu             m2, [%1]
+    psrlq            m6, m2, 32
+%endmacro
+
+%macro MAC_s32 2
+    movu             m3, [%2]
+    psrlq            m4, m3, 32
+    pmuldq           m3, m2
+    pmuldq           m4, m6
+    paddq           m%1, m3
+    paddq           m%1, m4
+%endmacro
+
+%macro LOAD1_s32 1
+    movd            xm2, [%1]
+%endmacro
+
+%macro MAC1_s32 2
+    movd            xm3, [%2]
+    pmuldq          xm3, xm2
+    paddq          xm%1, xm3
+%endmacro
+
+%macro FOLD_s32 1
+    vextracti128    xm3, m%1, 1
+    paddq          xm%1, xm3
+%endmacro
+
+%macro STORE_s32 2
+    pshufd          xm3, xm%1, q1032
+    paddq          xm%1, xm3
+    movq           [%2], xm%1
+%endmacro
+
+;------------------------------------------------------------------------------
+; void ff_resample_dot_<fmt>(FELEM2 *val, const FELEM *src,
+;                            const FELEM *filter, int len);
+; void ff_resample_dot2_<fmt>(FELEM2 val[2], const FELEM *src,
+;                             const FELEM *filter, int len);
+;
+; dot2 also computes the dot product with the next phase, which is stored in
+; the filter bank right after the first one, for linear interpolation.
+;------------------------------------------------------------------------------
+
+; %1 = format, %2 = log2 of the sample size, %3 = log2 of the sum size,
+; %4 = number of filter phases (1 or 2)
+%macro RESAMPLE_DOT 4
+%if %4 == 2
+cglobal resample_dot2_%1, 4, 5, 7, val, src, filter, len, filter2
+%else
+cglobal resample_dot_%1, 4, 4, 7, val, src, filter, len
+%endif
+%define SSIZE (1 << %2)
+%define STEP (mmsize >> %2)
+    movsxdifnidn   lenq, lend
+    lea            srcq, [srcq    + lenq*SSIZE]
+    lea         filterq, [filterq + lenq*SSIZE]
+%if %4 == 2
+    lea        filter2q, [filterq + lenq*SSIZE]
+%endif
+    neg            lenq
+    ZERO_%1           0
+%if %4 == 2
+    ZERO_%1           1
+%endif
+    add            lenq, STEP
+    jg .tail
+.loop:
+    LOAD_%1  srcq    + lenq*SSIZE - mmsize
+    MAC_%1  0, filterq  + lenq*SSIZE - mmsize
+%if %4 == 2
+    MAC_%1  1, filter2q + lenq*SSIZE - mmsize
+%endif
+    add            lenq, STEP
+    jle .loop
+.tail:
+%if mmsize == 32
+    FOLD_%1           0
+%if %4 == 2
+    FOLD_%1           1
+%endif
+%endif
+    sub            lenq, STEP
+    jz .end
+.tail_loop:
+    LOAD1_%1 srcq    + lenq*SSIZE
+    MAC1_%1 0, filterq  + lenq*SSIZE
+%if %4 == 2
+    MAC1_%1 1, filter2q + lenq*SSIZE
+%endif
+    inc            lenq
+    jl .tail_loop
+.end:
+    STORE_%1 0, valq
+%if %4 == 2
+    STORE_%1 1, valq + (1 << %3)
+%endif
+    RET
+%undef SSIZE
+%undef STEP
+%endmacro
+
+%macro RESAMPLE_DOTS 3
+RESAMPLE_DOT %1, %2, %3, 1
+RESAMPLE_DOT %1, %2, %3, 2
+%endmacro
+
+INIT_XMM sse
+RESAMPLE_DOTS flt, 2, 2
+
+INIT_XMM sse2
+RESAMPLE_DOTS dbl, 3, 3
+RESAMPLE_DOTS s16, 1, 2
+
+INIT_XMM sse4
+RESAMPLE_DOTS s32, 2, 3
+
+%if HAVE_AVX_EXTERNAL
+INIT_YMM avx
+RESAMPLE_DOTS flt, 2, 2
+RESAMPLE_DOTS dbl, 3, 3
+%endif
+
+%if HAVE_FMA3_EXTERNAL
+INIT_YMM fma3
+RESAMPLE_DOTS flt, 2, 2
+RESAMPLE_DOTS dbl, 3, 3
+%endif
+
+%if HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+RESAMPLE_DOTS s16, 1, 2
+RESAMPLE_DOTS s32, 2, 3
+%endif
@@ -0,0 +1,124 @@
+/*
+ * This file is part of Libav.
+ *
+ * Libav is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * Libav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with Libav; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <stdint.h>
+
+#include "config.h"
+#include "libavutil/attributes.h"
+#include "libavutil/common.h"
+#include "libavutil/cpu.h"
+#include "libavutil/samplefmt.h"
+#include "libavutil/x86/cpu.h"
+#include "libavresample/internal.h"
+#include "libavresample/resample.h"
+
+#define OUT_FP(d, v)  d = v
+#define OUT_S16(d, v) d = av_clip_int16((v + (1 << 14)) >> 15)
+#define OUT_S32(d, v) d = av_clipl_int32((v + (1 << 29)) >> 30)
+
+/* The asm only computes the dot products, the output rounding and the linear
+ * interpolation are the same as in resample_template.c. */
+#define RESAMPLE_FUNCS(fmt, opt, felem, felem2, feleml, out)                  \
+void ff_resample_dot_  ## fmt ## _ ## opt(felem2 *val, const felem *src,       \
+                                         const felem *filter, int len);       \
+void ff_resample_dot2_ ## fmt ## _ ## opt(felem2 *val, const felem *src,       \
+                                         const felem *filter, int len);       \
+                                                                              \
+static void resample_one_ ## fmt ## _ ## opt(ResampleContext *c, void *dst0,  \
+                                             int dst_index, const void *src0, \
+                                             unsigned int index, int frac)    \
+{                                                                             \
+    felem *dst          = dst0;                                               \
+    const felem *src    = src0;                                               \
+    const felem *filter = (const felem *)c->filter_bank +                     \
+                          c->filter_length * (index & c->phase_mask);         \
+    felem2 val;                                                               \
+                                                                              \
+    ff_resample_dot_ ## fmt ## _ ## opt(&val, src + (index >> c->phase_shift), \
+                                       filter, c->filter_length);             \
+    out(dst[dst_index], val);                                                 \
+}                                                                             \
+                                                                              \
+static void resample_linear_ ## fmt ## _ ## opt(ResampleContext *c,           \
+                                                void *dst0, int dst_index,    \
+                                                const void *src0,             \
+                                                unsigned int index, int frac) \
+{                                                                             \
+    felem *dst          = dst0;                                               \
+    const felem *src    = src0;                                               \
+    const felem *filter = (const felem *)c->filter_bank +                     \
+                          c->filter_length * (index & c->phase_mask);         \
+    felem2 val[2];                                                            \
+                                                                              \
+    ff_resample_dot2_ ## fmt ## _ ## opt(val, src + (index >> c->phase_shift), \
+                                        filter, c->filter_length);            \
+    val[0] += (val[1] - val[0]) * (feleml)frac / c->src_incr;                 \
+    out(dst[dst_index], val[0]);                                              \
+}
+
+RESAMPLE_FUNCS(flt, sse,  float,   float,   float,   OUT_FP)
+RESAMPLE_FUNCS(flt, avx,  float,   float,   float,   OUT_FP)
+RESAMPLE_FUNCS(flt, fma3, float,   float,   float,   OUT_FP)
+RESAMPLE_FUNCS(dbl, sse2, double,  double,  double,  OUT_FP)
+RESAMPLE_FUNCS(dbl, avx,  double,  double,  double,  OUT_FP)
+RESAMPLE_FUNCS(dbl, fma3, double,  double,  double,  OUT_FP)
+RESAMPLE_FUNCS(s16, sse2, int16_t, int32_t, int64_t, OUT_S16)
+RESAMPLE_FUNCS(s16, avx2, int16_t, int32_t, int64_t, OUT_S16)
+RESAMPLE_FUNCS(s32, sse4, int32_t, int64_t, int64_t, OUT_S32)
+RESAMPLE_FUNCS(s32, avx2, int32_t, int64_t, int64_t, OUT_S32)
+
+#define SET_RESAMPLE_FUNC(fmt, opt)                                           \
+    c->resample_one = c->linear ? resample_linear_ ## fmt ## _ ## opt         \
+                                : resample_one_    ## fmt ## _ ## opt
+
+av_cold void ff_audio_resample_init_x86(ResampleContext *c,
+                                        enum AVSampleFormat sample_fmt)
+{
+    int cpu_flags = av_get_cpu_flags();
+
+    switch (sample_fmt) {
+    case AV_SAMPLE_FMT_DBLP:
+        if (EXTERNAL_SSE2(cpu_flags))
+            SET_RESAMPLE_FUNC(dbl, sse2);
+        if (EXTERNAL_AVX_FAST(cpu_flags))
+            SET_RESAMPLE_FUNC(dbl, avx);
+        if (EXTERNAL_FMA3(cpu_flags) && !(cpu_flags & AV_CPU_FLAG_AVXSLOW))
+            SET_RESAMPLE_FUNC(dbl, fma3);
+        break;
+    case AV_SAMPLE_FMT_FLTP:
+        if (EXTERNAL_SSE(cpu_flags))
+            SET_RESAMPLE_FUNC(flt, sse);
+        if (EXTERNAL_AVX_FAST(cpu_flags))
+            SET_RESAMPLE_FUNC(flt, avx);
+        if (EXTERNAL_FMA3(cpu_flags) && !(cpu_flags & AV_CPU_FLAG_AVXSLOW))
+            SET_RESAMPLE_FUNC(flt, fma3);
+        break;
+    case AV_SAMPLE_FMT_S16P:
+        if (EXTERNAL_SSE2(cpu_flags))
+            SET_RESAMPLE_FUNC(s16, sse2);
+        if (EXTERNAL_AVX2(cpu_flags))
+            SET_RESAMPLE_FUNC(s16, avx2);
+        break;
+    case AV_SAMPLE_FMT_S32P:
+        if (EXTERNAL_SSE4(cpu_flags))
+            SET_RESAMPLE_FUNC(s32, sse4);
+        if (EXTERNAL_AVX2(cpu_flags))
+            SET_RESAMPLE_FUNC(s32, avx2);
+        break;
+    }
+}
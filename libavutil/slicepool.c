@@ -0,0 +1,293 @@
+/*
+ * This file is part of Libav.
+ *
+ * Libav is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * Libav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with Libav; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "config.h"
+
+#include <stdatomic.h>
+
+#include "common.h"
+#include "cpu.h"
+#include "error.h"
+#include "mem.h"
+#include "slicepool_internal.h"
+
+#if HAVE_THREADS
+
+#if HAVE_PTHREADS
+#include <pthread.h>
+#elif HAVE_W32THREADS
+#include "compat/w32pthreads.h"
+#endif
+
+/**
+ * The jobs of one avpriv_slice_pool_execute() call, on the stack of the
+ * calling thread.
+ */
+typedef struct SliceBatch {
+    avpriv_slice_pool_func *func;
+    void *arg;
+    int nb_jobs;
+    int max_threads;
+
+    atomic_int next_job;    ///< next job to be claimed by one of the threads
+
+    /* protected by the pool lock */
+    int nb_threads;         ///< threads that have joined, the caller included
+    int nb_active;          ///< threads still running jobs
+    int queued;             ///< whether the batch is in the pool queue
+    struct SliceBatch *next;
+    pthread_cond_t done_cond;
+} SliceBatch;
+
+typedef struct SlicePool {
+    pthread_mutex_t lock;
+    pthread_cond_t  work_cond;
+
+    pthread_t *workers;
+    int     nb_workers;
+    int     done;
+
+    /**
+     * Batches more threads can join. A worker takes the first one and
+     * requeues it at the end, so the contexts submitting jobs take turns.
+     */
+    SliceBatch *first, *last;
+} SlicePool;
+
+static SlicePool pool;
+static pthread_once_t pool_once = PTHREAD_ONCE_INIT;
+
+static void pool_init_lock(void)
+{
+    pthread_mutex_init(&pool.lock, NULL);
+    pthread_cond_init(&pool.work_cond, NULL);
+}
+
+static void queue_batch(SliceBatch *b)
+{
+    b->next   = NULL;
+    b->queued = 1;
+    if (pool.last)
+        pool.last->next = b;
+    else
+        pool.first = b;
+    pool.last = b;
+}
+
+static void dequeue_batch(SliceBatch *b)
+{
+    SliceBatch **p = &pool.first, *prev = NULL;
+
+    while (*p != b) {
+        prev = *p;
+        p    = &(*p)->next;
+    }
+    *p = b->next;
+    if (pool.last == b)
+        pool.last = prev;
+    b->queued = 0;
+}
+
+static void *attribute_align_arg worker(void *unused)
+{
+    SliceBatch *b;
+    int threadnr, job;
+
+    pthread_mutex_lock(&pool.lock);
+    for (;;) {
+        while (!pool.first && !pool.done)
+            pthread_cond_wait(&pool.work_cond, &pool.lock);
+        if (pool.done)
+            break;
+
+        b = pool.first;
+        dequeue_batch(b);
+        if (atomic_load(&b->next_job) >= b->nb_jobs)
+            continue;
+
+        threadnr = b->nb_threads++;
+        b->nb_active++;
+        if (b->nb_threads < b->max_threads)
+            queue_batch(b);
+        pthread_mutex_unlock(&pool.lock);
+
+        while ((job = atomic_fetch_add(&b->next_job, 1)) < b->nb_jobs)
+            b->func(b->arg, job, threadnr);
+
+        pthread_mutex_lock(&pool.lock);
+        if (!--b->nb_active)
+            pthread_cond_signal(&b->done_cond);
+    }
+    pthread_mutex_unlock(&pool.lock);
+
+    return NULL;
+}
+
+int av_slice_pool_init(int nb_threads)
+{
+    int i, ret = 0;
+
+#if HAVE_W32THREADS
+    w32thread_init();
+#endif
+    pthread_once(&pool_once, pool_init_lock);
+
+    if (!nb_threads)
+        nb_threads = av_cpu_count();
+
+    pthread_mutex_lock(&pool.lock);
+
+    if (pool.nb_workers) {
+        ret = AVERROR(EEXIST);
+        goto end;
+    }
+
+    pool.workers = av_mallocz(sizeof(*pool.workers) * nb_threads);
+    if (!pool.workers) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+
+    pool.done = 0;
+    for (i = 0; i < nb_threads; i++) {
+        ret = pthread_create(&pool.workers[i], NULL, worker, NULL);
+        if (ret) {
+            ret = AVERROR(ret);
+            break;
+        }
+    }
+    pool.nb_workers = i;
+
+end:
+    pthread_mutex_unlock(&pool.lock);
+
+    if (ret < 0)
+        av_slice_pool_uninit();
+
+    return ret;
+}
+
+void av_slice_pool_uninit(void)
+{
+    int i;
+
+    pthread_once(&pool_once, pool_init_lock);
+
+    pthread_mutex_lock(&pool.lock);
+    pool.done = 1;
+    pthread_cond_broadcast(&pool.work_cond);
+    pthread_mutex_unlock(&pool.lock);
+
+    for (i = 0; i < pool.nb_workers; i++)
+        pthread_join(pool.workers[i], NULL);
+
+    pthread_mutex_lock(&pool.lock);
+    av_freep(&pool.workers);
+    pool.nb_workers = 0;
+    pthread_mutex_unlock(&pool.lock);
+}
+
+int avpriv_slice_pool_enabled(void)
+{
+    int ret;
+
+    pthread_once(&pool_once, pool_init_lock);
+
+    pthread_mutex_lock(&pool.lock);
+    ret = pool.nb_workers > 0;
+    pthread_mutex_unlock(&pool.lock);
+
+    return ret;
+}
+
+void avpriv_slice_pool_execute(avpriv_slice_pool_func *func, void *arg,
+                               int nb_jobs, int max_threads)
+{
+    SliceBatch b = { 0 };
+    int i, job;
+
+    if (nb_jobs <= 0)
+        return;
+
+    pthread_once(&pool_once, pool_init_lock);
+
+    pthread_mutex_lock(&pool.lock);
+
+    if (!pool.nb_workers || pool.done || nb_jobs == 1 || max_threads <= 1) {
+        pthread_mutex_unlock(&pool.lock);
+        for (job = 0; job < nb_jobs; job++)
+            func(arg, job, 0);
+        return;
+    }
+
+    b.func        = func;
+    b.arg         = arg;
+    b.nb_jobs     = nb_jobs;
+    b.max_threads = max_threads;
+    b.nb_threads  = 1;
+    b.nb_active   = 1;
+    atomic_init(&b.next_job, 0);
+    pthread_cond_init(&b.done_cond, NULL);
+
+    queue_batch(&b);
+    /* wake no more workers than can join */
+    for (i = 1; i < FFMIN(nb_jobs, max_threads) && i <= pool.nb_workers; i++)
+        pthread_cond_signal(&pool.work_cond);
+
+    pthread_mutex_unlock(&pool.lock);
+
+    while ((job = atomic_fetch_add(&b.next_job, 1)) < nb_jobs)
+        func(arg, job, 0);
+
+    pthread_mutex_lock(&pool.lock);
+    if (b.queued)
+        dequeue_batch(&b);
+    b.nb_active--;
+    while (b.nb_active)
+        pthread_cond_wait(&b.done_cond, &pool.lock);
+    pthread_mutex_unlock(&pool.lock);
+
+    pthread_cond_destroy(&b.done_cond);
+}
+
+#else
+
+int av_slice_pool_init(int nb_threads)
+{
+    return AVERROR(ENOSYS);
+}
+
+void av_slice_pool_uninit(void)
+{
+}
+
+int avpriv_slice_pool_enabled(void)
+{
+    return 0;
+}
+
+void avpriv_slice_pool_execute(avpriv_slice_pool_func *func, void *arg,
+                               int nb_jobs, int max_threads)
+{
+    int job;
+
+    for (job = 0; job < nb_jobs; job++)
+        func(arg, job, 0);
+}
+
+#endif /* HAVE_THREADS */
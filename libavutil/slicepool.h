@@ -0,0 +1,66 @@
+/*
+ * This file is part of Libav.
+ *
+ * Libav is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * Libav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with Libav; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * Shared slice thread pool
+ */
+
+#ifndef AVUTIL_SLICEPOOL_H
+#define AVUTIL_SLICEPOOL_H
+
+/**
+ * @addtogroup lavu
+ * @{
+ *
+ * @defgroup lavu_slicepool Shared slice thread pool
+ *
+ * By default, every codec context, filtergraph and scaling context doing
+ * slice threading starts its own worker threads, so a process running many
+ * of them at once ends up with far more threads than CPUs. Once the shared
+ * pool exists, the contexts set up for slice threading afterwards run their
+ * jobs on its threads instead. The contexts submitting jobs at the same time
+ * are served in turn, and each still runs on at most as many threads as it
+ * was configured for.
+ *
+ * @{
+ */
+
+/**
+ * Create the shared slice thread pool.
+ *
+ * @param nb_threads number of worker threads, 0 for one per CPU
+ * @return 0 on success, AVERROR(EEXIST) if the pool already exists,
+ *         another negative error code on failure
+ */
+int av_slice_pool_init(int nb_threads);
+
+/**
+ * Stop the worker threads of the shared slice thread pool and free it.
+ *
+ * No job may be running on the pool anymore. Contexts set up to use it run
+ * their jobs on the calling thread afterwards.
+ */
+void av_slice_pool_uninit(void);
+
+/**
+ * @}
+ * @}
+ */
+
+#endif /* AVUTIL_SLICEPOOL_H */
@@ -0,0 +1,54 @@
+/*
+ * This file is part of Libav.
+ *
+ * Libav is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * Libav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with Libav; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVUTIL_SLICEPOOL_INTERNAL_H
+#define AVUTIL_SLICEPOOL_INTERNAL_H
+
+#include "slicepool.h"
+
+/**
+ * A job run by avpriv_slice_pool_execute().
+ *
+ * @param arg      the arg passed to avpriv_slice_pool_execute()
+ * @param jobnr    index of the job, in [0, nb_jobs)
+ * @param threadnr index of the thread running the job, in [0, max_threads),
+ *                 no two threads run jobs of one call with the same index
+ */
+typedef void (avpriv_slice_pool_func)(void *arg, int jobnr, int threadnr);
+
+/**
+ * @return whether the shared slice thread pool exists
+ */
+int avpriv_slice_pool_enabled(void);
+
+/**
+ * Run nb_jobs jobs on the shared slice thread pool and the calling thread,
+ * and return once all of them are done. Without a pool, the jobs are run on
+ * the calling thread.
+ *
+ * The jobs are not guaranteed to run at the same time, even if there are no
+ * more of them than max_threads: a job must never wait on a job with a
+ * higher index, which may only start once it is done.
+ *
+ * @param max_threads maximum number of threads running the jobs, the calling
+ *                    thread included; it runs them with threadnr 0
+ */
+void avpriv_slice_pool_execute(avpriv_slice_pool_func *func, void *arg,
+                               int nb_jobs, int max_threads);
+
+#endif /* AVUTIL_SLICEPOOL_INTERNAL_H */
@@ -0,0 +1,112 @@
+/*
+ * This file is part of Libav.
+ *
+ * Libav is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * Libav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with Libav; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * This test program submits jobs to the shared slice thread pool from several
+ * threads at once, and checks that every job runs exactly once and that the
+ * thread indexes of each submitter stay within its thread count.
+ */
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "libavutil/slicepool_internal.h"
+#include "libavutil/thread.h"
+
+#define NB_SUBMITTERS 6
+#define NB_EXECUTES   200
+#define MAX_JOBS      64
+
+typedef struct Submitter {
+    int max_threads;
+    atomic_int runs[MAX_JOBS];
+    atomic_int busy[MAX_JOBS];
+    atomic_int errors;
+} Submitter;
+
+static void job(void *arg, int jobnr, int threadnr)
+{
+    Submitter *s = arg;
+
+    if (threadnr < 0 || threadnr >= s->max_threads) {
+        atomic_fetch_add(&s->errors, 1);
+        return;
+    }
+    if (atomic_fetch_add(&s->busy[threadnr], 1))
+        atomic_fetch_add(&s->errors, 1);
+    atomic_fetch_add(&s->runs[jobnr], 1);
+    atomic_fetch_sub(&s->busy[threadnr], 1);
+}
+
+static void *submit(void *arg)
+{
+    Submitter *s = arg;
+    int i, j, nb_jobs;
+
+    for (i = 0; i < NB_EXECUTES; i++) {
+        nb_jobs = 1 + (i * 7 + s->max_threads) % MAX_JOBS;
+
+        for (j = 0; j < MAX_JOBS; j++)
+            atomic_store(&s->runs[j], 0);
+
+        avpriv_slice_pool_execute(job, s, nb_jobs, s->max_threads);
+
+        for (j = 0; j < MAX_JOBS; j++)
+            if (atomic_load(&s->runs[j]) != (j < nb_jobs))
+                atomic_fetch_add(&s->errors, 1);
+    }
+
+    return NULL;
+}
+
+int main(void)
+{
+    Submitter s[NB_SUBMITTERS] = { { 0 } };
+    pthread_t threads[NB_SUBMITTERS];
+    int i, ret;
+
+    if ((ret = av_slice_pool_init(4)) < 0) {
+        fprintf(stderr, "av_slice_pool_init failed: %d.\n", ret);
+        return 1;
+    }
+    if (av_slice_pool_init(4) >= 0)
+        return 2;
+
+    for (i = 0; i < NB_SUBMITTERS; i++) {
+        s[i].max_threads = 1 + i;
+        if ((ret = pthread_create(&threads[i], NULL, submit, &s[i]))) {
+            fprintf(stderr, "pthread_create failed: %s.\n", strerror(ret));
+            return 1;
+        }
+    }
+
+    ret = 0;
+    for (i = 0; i < NB_SUBMITTERS; i++) {
+        pthread_join(threads[i], NULL);
+        if (atomic_load(&s[i].errors)) {
+            fprintf(stderr, "submitter %d: %d errors.\n", i,
+                    atomic_load(&s[i].errors));
+            ret = 3;
+        }
+    }
+
+    av_slice_pool_uninit();
+
+    return ret;
+}
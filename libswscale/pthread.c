@@ -0,0 +1,237 @@
+/*
+ * This file is part of Libav.
+ *
+ * Libav is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * Libav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with Libav; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * Libswscale multithreading support
+ */
+
+#include "config.h"
+
+#include "libavutil/common.h"
+#include "libavutil/mem.h"
+#include "libavutil/slicepool_internal.h"
+
+#include "swscale_internal.h"
+
+#if HAVE_PTHREADS
+#include <pthread.h>
+#elif HAVE_W32THREADS
+#include "compat/w32pthreads.h"
+#endif
+
+typedef struct SwsThreadContext {
+    int nb_threads;
+    pthread_t *workers;
+    sws_thread_func *func;
+
+    /* per-execute parameters */
+    SwsContext *ctx;
+    void *arg;
+    int nb_jobs;
+
+    pthread_cond_t last_job_cond;
+    pthread_cond_t current_job_cond;
+    pthread_mutex_t current_job_lock;
+    int current_job;
+    unsigned int current_execute;
+    int done;
+
+    int shared;                 ///< the jobs run on the shared slice thread pool
+} SwsThreadContext;
+
+/**
+ * Parameters of one ff_sws_thread_execute() call on the shared slice thread
+ * pool.
+ */
+typedef struct SharedExecute {
+    SwsContext *ctx;
+    sws_thread_func *func;
+    void *arg;
+    int nb_jobs;
+} SharedExecute;
+
+static void shared_worker(void *v, int jobnr, int threadnr)
+{
+    SharedExecute *e = v;
+
+    e->func(e->ctx, e->arg, jobnr, e->nb_jobs);
+}
+
+static void* attribute_align_arg worker(void *v)
+{
+    SwsThreadContext *c = v;
+    int our_job      = c->nb_jobs;
+    int nb_threads   = c->nb_threads;
+    unsigned int last_execute = 0;
+    int self_id;
+
+    pthread_mutex_lock(&c->current_job_lock);
+    self_id = c->current_job++;
+    for (;;) {
+        while (our_job >= c->nb_jobs) {
+            if (c->current_job == nb_threads + c->nb_jobs)
+                pthread_cond_signal(&c->last_job_cond);
+
+            while (last_execute == c->current_execute && !c->done)
+                pthread_cond_wait(&c->current_job_cond, &c->current_job_lock);
+            last_execute = c->current_execute;
+            our_job = self_id;
+
+            if (c->done) {
+                pthread_mutex_unlock(&c->current_job_lock);
+                return NULL;
+            }
+        }
+        pthread_mutex_unlock(&c->current_job_lock);
+
+        c->func(c->ctx, c->arg, our_job, c->nb_jobs);
+
+        pthread_mutex_lock(&c->current_job_lock);
+        our_job = c->current_job++;
+    }
+}
+
+static void slice_thread_uninit(SwsThreadContext *c)
+{
+    int i;
+
+    if (c->shared)
+        return;
+
+    pthread_mutex_lock(&c->current_job_lock);
+    c->done = 1;
+    pthread_cond_broadcast(&c->current_job_cond);
+    pthread_mutex_unlock(&c->current_job_lock);
+
+    for (i = 0; i < c->nb_threads; i++)
+         pthread_join(c->workers[i], NULL);
+
+    pthread_mutex_destroy(&c->current_job_lock);
+    pthread_cond_destroy(&c->current_job_cond);
+    pthread_cond_destroy(&c->last_job_cond);
+    av_freep(&c->workers);
+}
+
+static void slice_thread_park_workers(SwsThreadContext *c)
+{
+    while (c->current_job != c->nb_threads + c->nb_jobs)
+        pthread_cond_wait(&c->last_job_cond, &c->current_job_lock);
+    pthread_mutex_unlock(&c->current_job_lock);
+}
+
+void ff_sws_thread_execute(SwsContext *ctx, sws_thread_func *func, void *arg,
+                           int nb_jobs)
+{
+    SwsThreadContext *c = ctx->thread;
+
+    if (nb_jobs <= 0)
+        return;
+
+    if (c->shared) {
+        SharedExecute e = {
+            .ctx     = ctx,
+            .func    = func,
+            .arg     = arg,
+            .nb_jobs = nb_jobs,
+        };
+        avpriv_slice_pool_execute(shared_worker, &e, nb_jobs, c->nb_threads);
+        return;
+    }
+
+    pthread_mutex_lock(&c->current_job_lock);
+
+    c->current_job = c->nb_threads;
+    c->nb_jobs     = nb_jobs;
+    c->ctx         = ctx;
+    c->arg         = arg;
+    c->func        = func;
+    c->current_execute++;
+
+    pthread_cond_broadcast(&c->current_job_cond);
+
+    slice_thread_park_workers(c);
+}
+
+static int thread_init_internal(SwsThreadContext *c, int nb_threads)
+{
+    int i, ret;
+
+    c->nb_threads = nb_threads;
+
+    if (avpriv_slice_pool_enabled()) {
+        c->shared = 1;
+        return c->nb_threads;
+    }
+
+    c->workers = av_mallocz(sizeof(*c->workers) * nb_threads);
+    if (!c->workers)
+        return AVERROR(ENOMEM);
+
+    c->current_job = 0;
+    c->nb_jobs     = 0;
+    c->done        = 0;
+
+    pthread_cond_init(&c->current_job_cond, NULL);
+    pthread_cond_init(&c->last_job_cond,    NULL);
+
+    pthread_mutex_init(&c->current_job_lock, NULL);
+    pthread_mutex_lock(&c->current_job_lock);
+    for (i = 0; i < nb_threads; i++) {
+        ret = pthread_create(&c->workers[i], NULL, worker, c);
+        if (ret) {
+           pthread_mutex_unlock(&c->current_job_lock);
+           c->nb_threads = i;
+           slice_thread_uninit(c);
+           return AVERROR(ret);
+        }
+    }
+
+    slice_thread_park_workers(c);
+
+    return c->nb_threads;
+}
+
+int ff_sws_thread_init(SwsContext *c, int nb_threads)
+{
+    int ret;
+
+#if HAVE_W32THREADS
+    w32thread_init();
+#endif
+
+    if (nb_threads <= 1)
+        return 1;
+
+    c->thread = av_mallocz(sizeof(*c->thread));
+    if (!c->thread)
+        return AVERROR(ENOMEM);
+
+    ret = thread_init_internal(c->thread, nb_threads);
+    if (ret <= 1)
+        av_freep(&c->thread);
+
+    return ret;
+}
+
+void ff_sws_thread_free(SwsContext *c)
+{
+    if (c->thread)
+        slice_thread_uninit(c->thread);
+    av_freep(&c->thread);
+}
@@ -437,7 +437,7 @@ static int swscale(SwsContext *c, const uint8_t *src[],
     if (srcSliceY == 0) {
         lumBufIndex  = -1;
         chrBufIndex  = -1;
-        dstY         = 0;
+        dstY         = c->dstSliceStart;
         lastInLumBuf = -1;
         lastInChrBuf = -1;
     }
@@ -447,7 +447,7 @@ static int swscale(SwsContext *c, const uint8_t *src[],
     }
     lastDstY = dstY;
 
-    for (; dstY < dstH; dstY++) {
+    for (; dstY < c->dstSliceEnd; dstY++) {
         const int chrDstY = dstY >> c->chrDstVSubSample;
         uint8_t *dest[4]  = {
             dst[0] + dstStride[0] * dstY,
@@ -286,6 +286,18 @@ typedef struct SwsContext {
     uint32_t pal_yuv[256];
     uint32_t pal_rgb[256];
 
+    /**
+     * @name Slice threading.
+     * The destination picture is split into horizontal bands, each one
+     * scaled by its own context with its own line buffers.
+     */
+    //@{
+    int nb_threads;               ///< Number of threads requested by the user, 0 for auto.
+    int nb_slice_ctx;             ///< Number of bands/per-band contexts, 0 if not threaded.
+    struct SwsContext **slice_ctx;
+    struct SwsThreadContext *thread;
+    //@}
+
     /**
      * @name Scaled horizontal lines ring buffer.
      * The horizontal scaler keeps just enough scaled lines in a ring buffer
@@ -346,6 +358,8 @@ typedef struct SwsContext {
     int canMMXEXTBeUsed;
 
     int dstY;                     ///< Last destination vertical line output from last slice.
+    int dstSliceStart;            ///< First destination line output by this context.
+    int dstSliceEnd;              ///< Last destination line output by this context + 1.
     int flags;                    ///< Flags passed by the user to select scaler algorithm, optimizations, subsampling, etc...
     void *yuvTable;             // pointer to the yuv->rgb table start so it can be freed()
     uint8_t *table_rV[256];
@@ -722,6 +736,24 @@ void ff_get_unscaled_swscale_ppc(SwsContext *c);
  */
 SwsFunc ff_getSwsFunc(SwsContext *c);
 
+typedef void (sws_thread_func)(SwsContext *c, void *arg, int jobnr, int nb_jobs);
+
+/**
+ * Start the worker threads used by the slice contexts.
+ *
+ * @return the number of threads running, 1 if threading is not used,
+ *         or a negative error code
+ */
+int ff_sws_thread_init(SwsContext *c, int nb_threads);
+void ff_sws_thread_free(SwsContext *c);
+
+/**
+ * Run func for each job in [0, nb_jobs) on the worker threads and wait for
+ * all of them to finish.
+ */
+void ff_sws_thread_execute(SwsContext *c, sws_thread_func *func, void *arg,
+                           int nb_jobs);
+
 void ff_sws_init_input_funcs(SwsContext *c);
 void ff_sws_init_output_funcs(SwsContext *c,
                               yuv2planar1_fn *yuv2plane1,
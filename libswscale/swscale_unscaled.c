@@ -1204,6 +1204,32 @@ static void reset_ptr(const uint8_t *src[], enum AVPixelFormat format)
         }                                                              \
     } while (0)
 
+typedef struct SwsSliceArgs {
+    const uint8_t **src;
+    const int *srcStride;
+    uint8_t **dst;
+    const int *dstStride;
+} SwsSliceArgs;
+
+static void scale_slice(SwsContext *c, void *arg, int jobnr, int nb_jobs)
+{
+    const SwsSliceArgs *a = arg;
+    SwsContext *s = c->slice_ctx[jobnr];
+    const uint8_t *src[4] = { a->src[0], a->src[1], a->src[2], a->src[3] };
+    uint8_t *dst[4] = { a->dst[0], a->dst[1], a->dst[2], a->dst[3] };
+    int srcStride[4] = { a->srcStride[0], a->srcStride[1], a->srcStride[2],
+                         a->srcStride[3] };
+    int dstStride[4] = { a->dstStride[0], a->dstStride[1], a->dstStride[2],
+                         a->dstStride[3] };
+
+    if (usePal(c->srcFormat)) {
+        memcpy(s->pal_yuv, c->pal_yuv, sizeof(s->pal_yuv));
+        memcpy(s->pal_rgb, c->pal_rgb, sizeof(s->pal_rgb));
+    }
+
+    s->swscale(s, src, srcStride, 0, c->srcH, dst, dstStride);
+}
+
 /**
  * swscale wrapper, so we don't need to export the SwsContext.
  * Assumes planar YUV to be in YUV order instead of YVU.
@@ -1311,6 +1337,15 @@ int attribute_align_arg sws_scale(struct SwsContext *c,
         if (srcSliceY + srcSliceH == c->srcH)
             c->sliceDir = 0;
 
+        /* whole pictures are split in bands scaled in parallel */
+        if (HAVE_THREADS && c->nb_slice_ctx && srcSliceY == 0 &&
+            srcSliceH == c->srcH) {
+            SwsSliceArgs args = { src2, srcStride2, dst2, dstStride2 };
+
+            ff_sws_thread_execute(c, scale_slice, &args, c->nb_slice_ctx);
+            return c->dstH;
+        }
+
         return c->swscale(c, src2, srcStride2, srcSliceY, srcSliceH, dst2,
                           dstStride2);
     } else {
@@ -808,6 +808,12 @@ int sws_setColorspaceDetails(struct SwsContext *c, const int inv_table[4],
 {
     const AVPixFmtDescriptor *desc_dst = av_pix_fmt_desc_get(c->dstFormat);
     const AVPixFmtDescriptor *desc_src = av_pix_fmt_desc_get(c->srcFormat);
+    int i;
+
+    for (i = 0; i < c->nb_slice_ctx; i++)
+        sws_setColorspaceDetails(c->slice_ctx[i], inv_table, srcRange, table,
+                                 dstRange, brightness, contrast, saturation);
+
     memcpy(c->srcColorspaceTable, inv_table, sizeof(int) * 4);
     memcpy(c->dstColorspaceTable, table, sizeof(int) * 4);
 
@@ -882,6 +888,66 @@ SwsContext *sws_alloc_context(void)
     return c;
 }
 
+/* Split the destination picture into horizontal bands, each one scaled
+ * by its own context on a worker thread. */
+static av_cold int init_slice_contexts(SwsContext *c, SwsFilter *srcFilter,
+                                       SwsFilter *dstFilter)
+{
+    int align      = 1 << c->chrDstVSubSample;
+    int nb_threads = c->nb_threads;
+    int nb_slices, i, ret;
+
+    if (!nb_threads)
+        nb_threads = av_cpu_count();
+
+    /* every band scales horizontally the source lines its vertical filter
+     * shares with the previous one, so keep them reasonably tall */
+    nb_slices = FFMIN(nb_threads, c->dstH / 16);
+    if (nb_slices <= 1)
+        return 0;
+
+    ret = ff_sws_thread_init(c, nb_slices);
+    if (ret <= 1)
+        return FFMIN(ret, 0);
+
+    c->slice_ctx = av_mallocz(sizeof(*c->slice_ctx) * nb_slices);
+    if (!c->slice_ctx)
+        return AVERROR(ENOMEM);
+    c->nb_slice_ctx = nb_slices;
+
+    for (i = 0; i < nb_slices; i++) {
+        SwsContext *s = sws_alloc_context();
+        if (!s)
+            return AVERROR(ENOMEM);
+        c->slice_ctx[i] = s;
+
+        s->flags     = c->flags;
+        s->srcW      = c->srcW;
+        s->srcH      = c->srcH;
+        s->srcFormat = c->srcFormat;
+        s->dstW      = c->dstW;
+        s->dstH      = c->dstH;
+        s->dstFormat = c->dstFormat;
+        s->param[0]  = c->param[0];
+        s->param[1]  = c->param[1];
+        sws_setColorspaceDetails(s, c->srcColorspaceTable, c->srcRange,
+                                 c->dstColorspaceTable, c->dstRange,
+                                 c->brightness, c->contrast, c->saturation);
+
+        ret = sws_init_context(s, srcFilter, dstFilter);
+        if (ret < 0)
+            return ret;
+
+        /* start every band on a chroma line */
+        s->dstSliceStart = (int)((int64_t)c->dstH *  i      / nb_slices) & ~(align - 1);
+        s->dstSliceEnd   = (int)((int64_t)c->dstH * (i + 1) / nb_slices) & ~(align - 1);
+        if (i == nb_slices - 1)
+            s->dstSliceEnd = c->dstH;
+    }
+
+    return 0;
+}
+
 av_cold int sws_init_context(SwsContext *c, SwsFilter *srcFilter,
                              SwsFilter *dstFilter)
 {
@@ -895,11 +961,28 @@ av_cold int sws_init_context(SwsContext *c, SwsFilter *srcFilter,
     int dstH              = c->dstH;
     int dst_stride        = FFALIGN(dstW * sizeof(int16_t) + 16, 16);
     int dst_stride_px     = dst_stride >> 1;
-    int flags, cpu_flags;
-    enum AVPixelFormat srcFormat = c->srcFormat;
-    enum AVPixelFormat dstFormat = c->dstFormat;
-    const AVPixFmtDescriptor *desc_src = av_pix_fmt_desc_get(srcFormat);
-    const AVPixFmtDescriptor *desc_dst = av_pix_fmt_desc_get(dstFormat);
+    int flags, cpu_flags, ret;
+    enum AVPixelFormat srcFormat;
+    enum AVPixelFormat dstFormat;
+    const AVPixFmtDescriptor *desc_src;
+    const AVPixFmtDescriptor *desc_dst;
+
+    /* contexts configured through AVOptions instead of sws_getContext() may
+     * still carry the deprecated full range formats */
+    if (handle_jpeg(&c->srcFormat))
+        c->srcRange = 1;
+    if (handle_jpeg(&c->dstFormat))
+        c->dstRange = 1;
+    if (!c->contrast && !c->saturation)
+        sws_setColorspaceDetails(c, ff_yuv2rgb_coeffs[SWS_CS_DEFAULT],
+                                 c->srcRange,
+                                 ff_yuv2rgb_coeffs[SWS_CS_DEFAULT] /* FIXME*/,
+                                 c->dstRange, 0, 1 << 16, 1 << 16);
+
+    srcFormat = c->srcFormat;
+    dstFormat = c->dstFormat;
+    desc_src  = av_pix_fmt_desc_get(srcFormat);
+    desc_dst  = av_pix_fmt_desc_get(dstFormat);
 
     cpu_flags = av_get_cpu_flags();
     flags     = c->flags;
@@ -1037,6 +1120,9 @@ av_cold int sws_init_context(SwsContext *c, SwsFilter *srcFilter,
     c->chrDstW = AV_CEIL_RSHIFT(dstW, c->chrDstHSubSample);
     c->chrDstH = AV_CEIL_RSHIFT(dstH, c->chrDstVSubSample);
 
+    c->dstSliceStart = 0;
+    c->dstSliceEnd   = dstH;
+
     /* unscaled special cases */
     if (unscaled && !usesHFilter && !usesVFilter &&
         (c->srcRange == c->dstRange || isAnyRGB(dstFormat))) {
@@ -1332,6 +1418,13 @@ av_cold int sws_init_context(SwsContext *c, SwsFilter *srcFilter,
     }
 
     c->swscale = ff_getSwsFunc(c);
+
+    if (HAVE_THREADS && c->nb_threads != 1) {
+        ret = init_slice_contexts(c, srcFilter, dstFilter);
+        if (ret < 0)
+            return ret;
+    }
+
     return 0;
 fail: // FIXME replace things by appropriate error codes
     return -1;
@@ -1703,6 +1796,12 @@ void sws_freeContext(SwsContext *c)
     if (!c)
         return;
 
+    if (HAVE_THREADS)
+        ff_sws_thread_free(c);
+    for (i = 0; i < c->nb_slice_ctx; i++)
+        sws_freeContext(c->slice_ctx[i]);
+    av_freep(&c->slice_ctx);
+
     if (c->lumPixBuf) {
         for (i = 0; i < c->vLumBufSize; i++)
             av_freep(&c->lumPixBuf[i]);
@@ -77,6 +77,9 @@ static const struct {
     { "dcadsp", checkasm_check_dcadsp },
     { "synth_filter", checkasm_check_synth_filter },
 #endif
+#if CONFIG_FLACDSP
+    { "flacdsp", checkasm_check_flacdsp },
+#endif
 #if CONFIG_FMTCONVERT
     { "fmtconvert", checkasm_check_fmtconvert },
 #endif
@@ -91,12 +94,17 @@ static const struct {
 #endif
 #if CONFIG_HEVC_DECODER
     { "hevc_add_res", checkasm_check_hevc_add_res },
+    { "hevc_deblock", checkasm_check_hevc_deblock },
     { "hevc_idct", checkasm_check_hevc_idct },
     { "hevc_mc", checkasm_check_hevc_mc },
+    { "hevc_sao", checkasm_check_hevc_sao },
 #endif
 #if CONFIG_HUFFYUVDSP
     { "huffyuvdsp", checkasm_check_huffyuvdsp },
 #endif
+#if CONFIG_AVRESAMPLE
+    { "resample", checkasm_check_resample },
+#endif
 #if CONFIG_V210_ENCODER
     { "v210enc", checkasm_check_v210enc },
 #endif
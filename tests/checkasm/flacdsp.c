@@ -0,0 +1,190 @@
+/*
+ * This file is part of Libav.
+ *
+ * Libav is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * Libav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with Libav; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "libavutil/common.h"
+#include "libavutil/internal.h"
+#include "libavutil/samplefmt.h"
+
+#include "libavcodec/flacdsp.h"
+#include "libavcodec/mathops.h"
+
+#include "checkasm.h"
+
+#define BUF_SIZE 1024
+/* the decoder buffers are padded to 32 samples */
+#define PAD      32
+#define MAX_CH   8
+
+static const char *const modes[] = { "indep", "ls", "rs", "ms" };
+
+/* Fill the input channels with what the encoder would produce for random
+ * bps-bit left and right channels in the given mode. */
+static void randomize_channels(int32_t **in, int mode, int channels, int bps)
+{
+    int i, j;
+
+    for (i = 0; i < BUF_SIZE; i++) {
+        int l = sign_extend(rnd(), bps);
+        int r = sign_extend(rnd(), bps);
+
+        switch (mode) {
+        case 0:
+            in[0][i] = l;
+            for (j = 1; j < channels; j++)
+                in[j][i] = sign_extend(rnd(), bps);
+            break;
+        case 1:
+            in[0][i] = l;
+            in[1][i] = l - r;
+            break;
+        case 2:
+            in[0][i] = l - r;
+            in[1][i] = r;
+            break;
+        case 3:
+            in[0][i] = (l + r) >> 1;
+            in[1][i] = l - r;
+            break;
+        }
+    }
+}
+
+static void check_decorrelate(enum AVSampleFormat fmt, int bps, int mode,
+                              int channels)
+{
+    LOCAL_ALIGNED_32(int32_t, in_buf, [MAX_CH * (BUF_SIZE + PAD)]);
+    LOCAL_ALIGNED_32(uint8_t, out0_buf, [MAX_CH * (BUF_SIZE + PAD) * 4]);
+    LOCAL_ALIGNED_32(uint8_t, out1_buf, [MAX_CH * (BUF_SIZE + PAD) * 4]);
+    int32_t *in[MAX_CH];
+    uint8_t *out0[MAX_CH], *out1[MAX_CH];
+    int planar = av_sample_fmt_is_planar(fmt);
+    int size   = av_get_bytes_per_sample(fmt);
+    int shift  = size * 8 - bps;
+    FLACDSPContext c;
+    int i, len;
+
+    declare_func(void, uint8_t **out, int32_t **in, int channels, int len,
+                 int shift);
+
+    ff_flacdsp_init(&c, fmt, channels, bps);
+
+    for (i = 0; i < MAX_CH; i++) {
+        in[i]   = in_buf   + i * (BUF_SIZE + PAD);
+        out0[i] = out0_buf + i * (BUF_SIZE + PAD) * size;
+        out1[i] = out1_buf + i * (BUF_SIZE + PAD) * size;
+    }
+
+    if (check_func(c.decorrelate[mode], "flac_decorrelate_%s_%dch_%s",
+                   modes[mode], channels, av_get_sample_fmt_name(fmt))) {
+        for (i = 0; i < 8; i++) {
+            len = 1 + rnd() % BUF_SIZE;
+
+            randomize_channels(in, mode, channels, bps);
+            memset(out0_buf, 0, MAX_CH * (BUF_SIZE + PAD) * 4);
+            memset(out1_buf, 0, MAX_CH * (BUF_SIZE + PAD) * 4);
+
+            call_ref(out0, in, channels, len, shift);
+            call_new(out1, in, channels, len, shift);
+
+            if (planar) {
+                int ch;
+                for (ch = 0; ch < channels; ch++)
+                    if (memcmp(out0[ch], out1[ch], len * size))
+                        fail();
+            } else if (memcmp(out0[0], out1[0], len * channels * size)) {
+                fail();
+            }
+        }
+        bench_new(out1, in, channels, BUF_SIZE, shift);
+    }
+}
+
+static void check_lpc(int bps)
+{
+    LOCAL_ALIGNED_32(int32_t, smp,  [BUF_SIZE + PAD]);
+    LOCAL_ALIGNED_32(int32_t, dst0, [BUF_SIZE + PAD]);
+    LOCAL_ALIGNED_32(int32_t, dst1, [BUF_SIZE + PAD]);
+    /* keep the 16-bit sums within 32 bits, as a real encoder does */
+    int precision = bps > 16 ? 15 : 11;
+    int coeffs[32];
+    FLACDSPContext c;
+    int i, j, order, qlevel, len;
+
+    declare_func(void, int32_t *samples, const int coeffs[32], int order,
+                 int qlevel, int len);
+
+    ff_flacdsp_init(&c, bps > 16 ? AV_SAMPLE_FMT_S32 : AV_SAMPLE_FMT_S16, 2,
+                    bps);
+
+    if (check_func(c.lpc, "flac_lpc_%d", bps > 16 ? 32 : 16)) {
+        for (order = 1; order <= 32; order++) {
+            len    = 1 + rnd() % BUF_SIZE;
+            qlevel = rnd() % 16;
+            for (i = 0; i < order; i++)
+                coeffs[i] = sign_extend(rnd(), precision);
+
+            /* turn random samples into residuals */
+            for (i = 0; i < BUF_SIZE + PAD; i++)
+                smp[i] = sign_extend(rnd(), bps);
+            memcpy(dst0, smp, sizeof(*smp) * (BUF_SIZE + PAD));
+            for (i = order; i < len; i++) {
+                int64_t sum = 0;
+                for (j = 0; j < order; j++)
+                    sum += (int64_t)coeffs[j] * smp[i - order + j];
+                dst0[i] = smp[i] - (int)(sum >> qlevel);
+            }
+            memcpy(dst1, dst0, sizeof(*dst0) * (BUF_SIZE + PAD));
+
+            call_ref(dst0, coeffs, order, qlevel, len);
+            call_new(dst1, coeffs, order, qlevel, len);
+            if (memcmp(dst0, dst1, sizeof(*dst0) * len))
+                fail();
+        }
+        bench_new(dst1, coeffs, 32, 15, BUF_SIZE);
+    }
+}
+
+void checkasm_check_flacdsp(void)
+{
+    static const struct {
+        enum AVSampleFormat fmt;
+        int bps;
+    } fmts[] = {
+        { AV_SAMPLE_FMT_S16,  16 },
+        { AV_SAMPLE_FMT_S16P, 16 },
+        { AV_SAMPLE_FMT_S32,  24 },
+        { AV_SAMPLE_FMT_S32P, 24 },
+    };
+    int i, mode;
+
+    for (i = 0; i < FF_ARRAY_ELEMS(fmts); i++) {
+        check_decorrelate(fmts[i].fmt, fmts[i].bps, 0, 1);
+        check_decorrelate(fmts[i].fmt, fmts[i].bps, 0, 2);
+        check_decorrelate(fmts[i].fmt, fmts[i].bps, 0, 6);
+        for (mode = 1; mode < FF_ARRAY_ELEMS(modes); mode++)
+            check_decorrelate(fmts[i].fmt, fmts[i].bps, mode, 2);
+    }
+    report("decorrelate");
+
+    check_lpc(16);
+    check_lpc(24);
+    report("lpc");
+}
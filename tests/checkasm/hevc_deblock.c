@@ -0,0 +1,157 @@
+/*
+ * This file is part of Libav.
+ *
+ * Libav is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Libav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Libav; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+
+#include "libavutil/common.h"
+#include "libavutil/intreadwrite.h"
+
+#include "libavcodec/hevcdsp.h"
+
+#include "checkasm.h"
+
+#define SIZE     16
+#define STRIDE   (SIZE * 2)
+#define BUF_SIZE (SIZE * STRIDE)
+
+/*
+ * Fill the block with lines crossing an edge in the middle of it. The lines
+ * are smooth ramps with a step at the edge and a bit of noise, so that all
+ * of the strong, normal and no filtering decisions are taken.
+ */
+static void randomize_block(uint8_t *buf, int bit_depth, int horiz)
+{
+    int max = (1 << bit_depth) - 1;
+    int shift = bit_depth - 8;
+    int line, k;
+
+    memset(buf, 0, BUF_SIZE);
+    for (line = 0; line < SIZE; line++) {
+        int base  = (32 + rnd() % 192) << shift;
+        int slope = (rnd() % 5 - 2) << shift;
+        int step  = (rnd() % 41 - 20) << shift;
+        int noise = rnd() % 4;
+
+        for (k = 0; k < SIZE; k++) {
+            int v = base + slope * k + (k >= SIZE / 2 ? step : 0) +
+                    ((rnd() % (noise + 1)) << shift);
+            int x = horiz ? line : k;
+            int y = horiz ? k    : line;
+
+            v = av_clip(v, 0, max);
+            if (bit_depth > 8)
+                AV_WN16A(buf + y * STRIDE + x * 2, v);
+            else
+                buf[y * STRIDE + x] = v;
+        }
+    }
+}
+
+static void check_loop_filter_luma(HEVCDSPContext h, int bit_depth)
+{
+    LOCAL_ALIGNED(32, uint8_t, buf0, [BUF_SIZE]);
+    LOCAL_ALIGNED(32, uint8_t, buf1, [BUF_SIZE]);
+    int pixel_shift = bit_depth > 8;
+    uint8_t no_p[2] = { 0 }, no_q[2] = { 0 };
+    int tc[2];
+    int dir, i;
+    declare_func(void, uint8_t *pix, ptrdiff_t stride, int beta, int *tc,
+                 uint8_t *no_p, uint8_t *no_q);
+
+    for (dir = 0; dir < 2; dir++) {
+        void (*func)(uint8_t *, ptrdiff_t, int, int *, uint8_t *, uint8_t *) =
+            dir ? h.hevc_v_loop_filter_luma : h.hevc_h_loop_filter_luma;
+        /* the 8 filtered samples along the edge start at 4 */
+        ptrdiff_t offset = dir ? 4 * STRIDE + (8 << pixel_shift)
+                               : 8 * STRIDE + (4 << pixel_shift);
+
+        if (check_func(func, "hevc_%c_loop_filter_luma_%d",
+                       dir ? 'v' : 'h', bit_depth)) {
+            for (i = 0; i < 32; i++) {
+                int beta = rnd() % 65;
+
+                tc[0] = rnd() % 25;
+                tc[1] = rnd() % 25;
+                randomize_block(buf0, bit_depth, !dir);
+                memcpy(buf1, buf0, BUF_SIZE);
+
+                call_ref(buf0 + offset, STRIDE, beta, tc, no_p, no_q);
+                call_new(buf1 + offset, STRIDE, beta, tc, no_p, no_q);
+                if (memcmp(buf0, buf1, BUF_SIZE))
+                    fail();
+            }
+            bench_new(buf1 + offset, STRIDE, 64, tc, no_p, no_q);
+        }
+    }
+}
+
+static void check_loop_filter_chroma(HEVCDSPContext h, int bit_depth)
+{
+    LOCAL_ALIGNED(32, uint8_t, buf0, [BUF_SIZE]);
+    LOCAL_ALIGNED(32, uint8_t, buf1, [BUF_SIZE]);
+    int pixel_shift = bit_depth > 8;
+    uint8_t no_p[2] = { 0 }, no_q[2] = { 0 };
+    int tc[2];
+    int dir, i;
+    declare_func(void, uint8_t *pix, ptrdiff_t stride, int *tc,
+                 uint8_t *no_p, uint8_t *no_q);
+
+    for (dir = 0; dir < 2; dir++) {
+        void (*func)(uint8_t *, ptrdiff_t, int *, uint8_t *, uint8_t *) =
+            dir ? h.hevc_v_loop_filter_chroma : h.hevc_h_loop_filter_chroma;
+        ptrdiff_t offset = dir ? 4 * STRIDE + (8 << pixel_shift)
+                               : 8 * STRIDE + (4 << pixel_shift);
+
+        if (check_func(func, "hevc_%c_loop_filter_chroma_%d",
+                       dir ? 'v' : 'h', bit_depth)) {
+            for (i = 0; i < 32; i++) {
+                tc[0] = rnd() % 25;
+                tc[1] = rnd() % 25;
+                randomize_block(buf0, bit_depth, !dir);
+                memcpy(buf1, buf0, BUF_SIZE);
+
+                call_ref(buf0 + offset, STRIDE, tc, no_p, no_q);
+                call_new(buf1 + offset, STRIDE, tc, no_p, no_q);
+                if (memcmp(buf0, buf1, BUF_SIZE))
+                    fail();
+            }
+            bench_new(buf1 + offset, STRIDE, tc, no_p, no_q);
+        }
+    }
+}
+
+void checkasm_check_hevc_deblock(void)
+{
+    int bit_depth;
+
+    for (bit_depth = 8; bit_depth <= 10; bit_depth++) {
+        HEVCDSPContext h;
+
+        ff_hevc_dsp_init(&h, bit_depth);
+        check_loop_filter_luma(h, bit_depth);
+    }
+    report("loop_filter_luma");
+
+    for (bit_depth = 8; bit_depth <= 10; bit_depth++) {
+        HEVCDSPContext h;
+
+        ff_hevc_dsp_init(&h, bit_depth);
+        check_loop_filter_chroma(h, bit_depth);
+    }
+    report("loop_filter_chroma");
+}
@@ -0,0 +1,159 @@
+/*
+ * This file is part of Libav.
+ *
+ * Libav is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Libav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Libav; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+
+#include "libavutil/common.h"
+#include "libavutil/intreadwrite.h"
+
+#include "libavcodec/hevcdsp.h"
+
+#include "checkasm.h"
+
+#define MAX_SIZE 64
+/* room for the neighbours of the edge filter and for whole-vector reads
+ * past the end of a row */
+#define BORDER   32
+#define STRIDE   ((MAX_SIZE + 2 * BORDER) * 2)
+#define BUF_SIZE (STRIDE * (MAX_SIZE + 2))
+#define OFFSET   (STRIDE + BORDER * 2)
+
+static const int sao_widths[] = { 1, 2, 3, 4, 5, 7, 8, 9, 14, 15, 16, 17,
+                                  24, 31, 32, 33, 48, 54, 63, 64 };
+
+static void randomize_pixels(uint8_t *buf, int bit_depth)
+{
+    int max  = (1 << bit_depth) - 1;
+    /* a narrow range around a random level gives equal neighbours for the
+     * edge filter, the levels at the ends exercise clipping */
+    int base = rnd() % 3 == 0 ? 0 : rnd() % 3 == 0 ? max - 3 : rnd() % (max - 3);
+    int full = rnd() & 1;
+    int i;
+
+    for (i = 0; i < BUF_SIZE / 2; i++) {
+        int v = full ? rnd() & max : base + (rnd() & 3);
+        if (bit_depth > 8)
+            AV_WN16A(buf + 2 * i, v);
+        else
+            buf[i] = v;
+    }
+}
+
+static void randomize_offsets(int *offset_val, int bit_depth, int edge)
+{
+    int max = (1 << (FFMIN(bit_depth, 10) - 5)) - 1;
+    int i;
+
+    offset_val[0] = 0;
+    for (i = 1; i < 5; i++) {
+        int v = rnd() % (max + 1);
+        if (edge ? i > 2 : rnd() & 1)
+            v = -v;
+        offset_val[i] = v;
+    }
+}
+
+static void check_sao_band(HEVCDSPContext h, int bit_depth)
+{
+    LOCAL_ALIGNED(32, uint8_t, src,  [BUF_SIZE]);
+    LOCAL_ALIGNED(32, uint8_t, dst0, [BUF_SIZE]);
+    LOCAL_ALIGNED(32, uint8_t, dst1, [BUF_SIZE]);
+    int offset_val[5];
+    int i;
+    declare_func(void, uint8_t *dst, uint8_t *src, ptrdiff_t stride,
+                 const int *offset_val, int band_position,
+                 int width, int height);
+
+    if (check_func(h.sao_band_filter, "hevc_sao_band_%d", bit_depth)) {
+        for (i = 0; i < FF_ARRAY_ELEMS(sao_widths); i++) {
+            int width         = sao_widths[i];
+            int height        = 1 + rnd() % MAX_SIZE;
+            int band_position = rnd() & 31;
+
+            randomize_pixels(src, bit_depth);
+            randomize_offsets(offset_val, bit_depth, 0);
+            memset(dst0, 0xaa, BUF_SIZE);
+            memset(dst1, 0xaa, BUF_SIZE);
+
+            call_ref(dst0 + OFFSET, src + OFFSET, STRIDE, offset_val,
+                     band_position, width, height);
+            call_new(dst1 + OFFSET, src + OFFSET, STRIDE, offset_val,
+                     band_position, width, height);
+            if (memcmp(dst0, dst1, BUF_SIZE))
+                fail();
+        }
+        bench_new(dst1 + OFFSET, src + OFFSET, STRIDE, offset_val, 0,
+                  MAX_SIZE, MAX_SIZE);
+    }
+}
+
+static void check_sao_edge(HEVCDSPContext h, int bit_depth)
+{
+    LOCAL_ALIGNED(32, uint8_t, src,  [BUF_SIZE]);
+    LOCAL_ALIGNED(32, uint8_t, dst0, [BUF_SIZE]);
+    LOCAL_ALIGNED(32, uint8_t, dst1, [BUF_SIZE]);
+    int offset_val[5];
+    int i, eo_class;
+    declare_func(void, uint8_t *dst, uint8_t *src, ptrdiff_t stride,
+                 const int *offset_val, int eo_class,
+                 int width, int height);
+
+    if (check_func(h.sao_edge_filter, "hevc_sao_edge_%d", bit_depth)) {
+        for (eo_class = 0; eo_class < 4; eo_class++) {
+            for (i = 0; i < FF_ARRAY_ELEMS(sao_widths); i++) {
+                int width  = sao_widths[i];
+                int height = 1 + rnd() % MAX_SIZE;
+
+                randomize_pixels(src, bit_depth);
+                randomize_offsets(offset_val, bit_depth, 1);
+                memset(dst0, 0xaa, BUF_SIZE);
+                memset(dst1, 0xaa, BUF_SIZE);
+
+                call_ref(dst0 + OFFSET, src + OFFSET, STRIDE, offset_val,
+                         eo_class, width, height);
+                call_new(dst1 + OFFSET, src + OFFSET, STRIDE, offset_val,
+                         eo_class, width, height);
+                if (memcmp(dst0, dst1, BUF_SIZE))
+                    fail();
+            }
+        }
+        bench_new(dst1 + OFFSET, src + OFFSET, STRIDE, offset_val, 0,
+                  MAX_SIZE, MAX_SIZE);
+    }
+}
+
+void checkasm_check_hevc_sao(void)
+{
+    int bit_depth;
+
+    for (bit_depth = 8; bit_depth <= 10; bit_depth++) {
+        HEVCDSPContext h;
+
+        ff_hevc_dsp_init(&h, bit_depth);
+        check_sao_band(h, bit_depth);
+    }
+    report("sao_band");
+
+    for (bit_depth = 8; bit_depth <= 10; bit_depth++) {
+        HEVCDSPContext h;
+
+        ff_hevc_dsp_init(&h, bit_depth);
+        check_sao_edge(h, bit_depth);
+    }
+    report("sao_edge");
+}
@@ -0,0 +1,159 @@
+/*
+ * This file is part of Libav.
+ *
+ * Libav is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Libav is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Libav; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "libavutil/common.h"
+#include "libavutil/internal.h"
+#include "libavutil/opt.h"
+#include "libavutil/samplefmt.h"
+
+#include "libavresample/avresample.h"
+#include "libavresample/internal.h"
+#include "libavresample/resample.h"
+
+#include "checkasm.h"
+
+#define SRC_LEN 256
+#define DST_LEN 8
+
+/* filter_size values giving odd and even filter lengths around the vector
+ * widths, the 44100 -> 32000 Hz filter is about 1.7 times longer */
+static const int filter_sizes[] = { 1, 2, 3, 4, 5, 7, 8, 9, 13, 16, 17, 32 };
+
+static void randomize_src(uint8_t *buf, enum AVSampleFormat fmt)
+{
+    int i;
+
+    for (i = 0; i < SRC_LEN; i++) {
+        switch (fmt) {
+        case AV_SAMPLE_FMT_S16P:
+            ((int16_t *)buf)[i] = rnd();
+            break;
+        case AV_SAMPLE_FMT_S32P:
+            ((int32_t *)buf)[i] = rnd();
+            break;
+        case AV_SAMPLE_FMT_FLTP:
+            ((float *)buf)[i]   = (int32_t)rnd() / (float)INT32_MAX;
+            break;
+        case AV_SAMPLE_FMT_DBLP:
+            ((double *)buf)[i]  = (int32_t)rnd() / (double)INT32_MAX;
+            break;
+        }
+    }
+}
+
+static int compare_dst(const uint8_t *dst0, const uint8_t *dst1,
+                       enum AVSampleFormat fmt)
+{
+    int i;
+
+    switch (fmt) {
+    case AV_SAMPLE_FMT_FLTP:
+        for (i = 0; i < DST_LEN; i++)
+            if (!float_near_abs_eps(((const float *)dst0)[i],
+                                    ((const float *)dst1)[i], 1e-5))
+                return 1;
+        return 0;
+    case AV_SAMPLE_FMT_DBLP:
+        for (i = 0; i < DST_LEN; i++)
+            if (fabs(((const double *)dst0)[i] -
+                     ((const double *)dst1)[i]) > 1e-12)
+                return 1;
+        return 0;
+    default:
+        return memcmp(dst0, dst1, DST_LEN * av_get_bytes_per_sample(fmt));
+    }
+}
+
+static void check_resample_one(AVAudioResampleContext *avr,
+                               enum AVSampleFormat fmt, int linear)
+{
+    LOCAL_ALIGNED(32, uint8_t, src,  [SRC_LEN * 8]);
+    LOCAL_ALIGNED(32, uint8_t, dst0, [DST_LEN * 8]);
+    LOCAL_ALIGNED(32, uint8_t, dst1, [DST_LEN * 8]);
+    ResampleContext *c = NULL;
+    int i, j;
+    declare_func(void, ResampleContext *c, void *dst0, int dst_index,
+                 const void *src0, unsigned int index, int frac);
+
+    for (i = 0; i < FF_ARRAY_ELEMS(filter_sizes); i++) {
+        av_opt_set_int(avr, "filter_size",   filter_sizes[i], 0);
+        av_opt_set_int(avr, "linear_interp", linear,          0);
+        avr->internal_sample_fmt = fmt;
+        avr->resample_channels   = 1;
+
+        c = ff_audio_resample_init(avr);
+        if (!c) {
+            fprintf(stderr, "checkasm: resample init failed\n");
+            return;
+        }
+
+        if (check_func(c->resample_one, "resample_%s_%s_%d",
+                       linear ? "linear" : "one", av_get_sample_fmt_name(fmt),
+                       c->filter_length)) {
+            int max_index = (SRC_LEN - c->filter_length) << c->phase_shift;
+
+            for (j = 0; j < 16; j++) {
+                int dst_index      = rnd() % DST_LEN;
+                unsigned int index = rnd() % max_index;
+                int frac           = rnd() % c->src_incr;
+
+                randomize_src(src, fmt);
+                memset(dst0, 0, DST_LEN * 8);
+                memset(dst1, 0, DST_LEN * 8);
+
+                call_ref(c, dst0, dst_index, src, index, frac);
+                call_new(c, dst1, dst_index, src, index, frac);
+                if (compare_dst(dst0, dst1, fmt))
+                    fail();
+            }
+            bench_new(c, dst1, 0, src, 0, 0);
+        }
+
+        ff_audio_resample_free(&c);
+    }
+}
+
+void checkasm_check_resample(void)
+{
+    static const enum AVSampleFormat fmts[] = {
+        AV_SAMPLE_FMT_S16P, AV_SAMPLE_FMT_S32P,
+        AV_SAMPLE_FMT_FLTP, AV_SAMPLE_FMT_DBLP,
+    };
+    AVAudioResampleContext *avr;
+    int i, linear;
+
+    avr = avresample_alloc_context();
+    if (!avr) {
+        fprintf(stderr, "checkasm: resample context allocation failed\n");
+        return;
+    }
+    av_opt_set_int(avr, "in_sample_rate",  44100, 0);
+    av_opt_set_int(avr, "out_sample_rate", 32000, 0);
+
+    for (linear = 0; linear < 2; linear++) {
+        for (i = 0; i < FF_ARRAY_ELEMS(fmts); i++)
+            check_resample_one(avr, fmts[i], linear);
+        report(linear ? "resample_linear" : "resample_one");
+    }
+
+    avresample_free(&avr);
+}
@@ -36,6 +36,64 @@ static const uint32_t pixel_mask[3] = { 0xffffffff, 0x03ff03ff, 0x0fff0fff };
 #define BIT_DEPTH 8
 #define SIZEOF_PIXEL ((BIT_DEPTH + 7) / 8)
 
+static void check_ipred(void)
+{
+    LOCAL_ALIGNED_32(uint8_t, a_buf, [64 * 2]);
+    LOCAL_ALIGNED_32(uint8_t, l, [32]);
+    LOCAL_ALIGNED_32(uint8_t, dst0, [32 * 32]);
+    LOCAL_ALIGNED_32(uint8_t, dst1, [32 * 32]);
+    uint8_t *a = &a_buf[32];
+    declare_func(void, uint8_t *dst, ptrdiff_t stride,
+                 const uint8_t *left, const uint8_t *top);
+    VP9DSPContext dsp;
+    int tx, mode, i;
+    static const char *const mode_names[N_INTRA_PRED_MODES] = {
+        [VERT_PRED]            = "vert",
+        [HOR_PRED]             = "hor",
+        [DC_PRED]              = "dc",
+        [DIAG_DOWN_LEFT_PRED]  = "diag_downleft",
+        [DIAG_DOWN_RIGHT_PRED] = "diag_downright",
+        [VERT_RIGHT_PRED]      = "vert_right",
+        [HOR_DOWN_PRED]        = "hor_down",
+        [VERT_LEFT_PRED]       = "vert_left",
+        [HOR_UP_PRED]          = "hor_up",
+        [TM_VP8_PRED]          = "tm",
+        [LEFT_DC_PRED]         = "dc_left",
+        [TOP_DC_PRED]          = "dc_top",
+        [DC_128_PRED]          = "dc_128",
+        [DC_127_PRED]          = "dc_127",
+        [DC_129_PRED]          = "dc_129",
+    };
+
+    ff_vp9dsp_init(&dsp);
+
+    for (tx = TX_4X4; tx < N_TXFM_SIZES; tx++) {
+        int sz = 4 << tx;
+
+        for (mode = 0; mode < N_INTRA_PRED_MODES; mode++) {
+            if (check_func(dsp.intra_pred[tx][mode], "vp9_%s_%dx%d",
+                           mode_names[mode], sz, sz)) {
+                // the whole buffers are randomized, so that reading past
+                // the edges the C version uses shows up as a mismatch
+                for (i = 0; i < 64 * 2; i++)
+                    a_buf[i] = rnd();
+                for (i = 0; i < 32; i++)
+                    l[i] = rnd();
+                for (i = 0; i < 32 * 32; i++)
+                    dst0[i] = dst1[i] = rnd();
+
+                call_ref(dst0, 32, l, a);
+                call_new(dst1, 32, l, a);
+                if (memcmp(dst0, dst1, 32 * 32))
+                    fail();
+
+                bench_new(dst1, 32, l, a);
+            }
+        }
+    }
+    report("ipred");
+}
+
 #define randomize_buffers() \
     do { \
         uint32_t mask = pixel_mask[(BIT_DEPTH - 8) >> 1];                  \
@@ -559,6 +617,7 @@ static void check_mc(void)
 
 void checkasm_check_vp9dsp(void)
 {
+    check_ipred();
     check_itxfm();
     check_loopfilter();
     check_mc();
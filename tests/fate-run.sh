@@ -25,6 +25,7 @@ cmp_unit=${15:-2}
 gen=${16:-no}
 hwaccel=${17:-none}
 report_type=${18:-standard}
+ref_test=${19}
 
 outdir="tests/data/fate"
 outfile="${outdir}/${test}"
@@ -152,6 +153,24 @@ enc_dec(){
     tests/tiny_psnr $srcfile $decfile $cmp_unit $cmp_shift
 }
 
+# mux into a directory of its own, print the HLS playlists and the md5 of
+# the other files written
+playlist(){
+    dir="${outdir}/${test}.dir"
+    file=$1
+    shift
+    rm -rf "$dir"
+    mkdir -p "$dir"
+    avconv "$@" -y $(target_path "$dir/$file") || return
+    for f in $(cd "$dir" && ls); do
+        case "$f" in
+        *.m3u8) echo "$f:"; cat "$dir/$f" ;;
+        *)      do_md5sum "$dir/$f" ;;
+        esac
+    done
+    cleanfiles="$cleanfiles $dir/*"
+}
+
 lavftest(){
     t="${test#lavf-}"
     ref=${base}/ref/lavf/$t
@@ -161,7 +180,8 @@ lavftest(){
 video_filter(){
     filters=$1
     shift
-    label=${test#filter-}
+    label=${ref_test:-$test}
+    label=${label#filter-}
     raw_src="${target_path}/tests/vsynth1/%02d.pgm"
     printf '%-20s' $label
     avconv $DEC_OPTS -f image2 -c:v pgmyuv -i $raw_src \
@@ -202,6 +222,14 @@ exec 3>&2
 eval $command >"$outfile" 2>$errfile
 err=$?
 
+# a test sharing the reference of another one is named after it with a
+# suffix, drop that from the names of its files
+if test -n "$ref_test"; then
+    suffix=${test#$ref_test}
+    sed "s/${suffix}\./\./g" "$outfile" >"$outfile.tmp"
+    mv -f "$outfile.tmp" "$outfile"
+fi
+
 if [ $err -gt 128 ]; then
     sig=$(kill -l $err 2>/dev/null)
     test "${sig}" = "${sig%[!A-Za-z]*}" || unset sig
@@ -62,6 +62,12 @@ FATE_ACODEC-$(call ENCDEC, FLAC, FLAC) += fate-acodec-flac
 fate-acodec-flac: FMT = flac
 fate-acodec-flac: CODEC = flac -compression_level 2
 
+FATE_ACODEC-$(call ENCDEC, FLAC, FLAC) += fate-acodec-flac-slice-threads
+fate-acodec-flac-slice-threads: FMT = flac
+fate-acodec-flac-slice-threads: CODEC = flac -compression_level 2 -threads 4 -thread_type slice
+fate-acodec-flac-slice-threads: REF = $(SRC_PATH)/tests/ref/acodec/flac
+fate-acodec-flac-slice-threads: REF_TEST = acodec-flac
+
 FATE_ACODEC += $(FATE_ACODEC-yes)
 
 $(FATE_ACODEC): tests/data/asynth-44100-2.wav
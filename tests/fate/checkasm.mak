@@ -2,14 +2,18 @@ FATE_CHECKASM = fate-checkasm-audiodsp                                  \
                 fate-checkasm-blockdsp                                  \
                 fate-checkasm-bswapdsp                                  \
                 fate-checkasm-dcadsp                                    \
+                fate-checkasm-flacdsp                                   \
                 fate-checkasm-fmtconvert                                \
                 fate-checkasm-h264dsp                                   \
                 fate-checkasm-h264pred                                  \
                 fate-checkasm-h264qpel                                  \
                 fate-checkasm-hevc_add_res                              \
+                fate-checkasm-hevc_deblock                              \
                 fate-checkasm-hevc_idct                                 \
                 fate-checkasm-hevc_mc                                   \
+                fate-checkasm-hevc_sao                                  \
                 fate-checkasm-huffyuvdsp                                \
+                fate-checkasm-resample                                  \
                 fate-checkasm-synth_filter                              \
                 fate-checkasm-v210enc                                   \
                 fate-checkasm-vp8dsp                                    \
@@ -155,6 +155,31 @@ endef
 $(foreach N,$(HEVC_SAMPLES),$(eval $(call FATE_HEVC_TEST,$(N))))
 $(foreach N,$(HEVC_SAMPLES_10BIT),$(eval $(call FATE_HEVC_TEST_10BIT,$(N))))
 
+# the samples with several substreams per slice segment, decoded with slice
+# threads, both private to the decoder and from the shared pool
+HEVC_SAMPLES_SLICE_THREADS =    \
+    TILES_A_Cisco_2             \
+    TILES_B_Cisco_1             \
+    WPP_A_ericsson_MAIN_2       \
+    WPP_B_ericsson_MAIN_2       \
+    WPP_C_ericsson_MAIN_2       \
+    WPP_D_ericsson_MAIN_2       \
+    WPP_E_ericsson_MAIN_2       \
+    WPP_F_ericsson_MAIN_2       \
+
+define FATE_HEVC_SLICE_THREADS_TEST
+FATE_HEVC += fate-hevc-conformance-$(1)-slice-threads
+fate-hevc-conformance-$(1)-slice-threads: CMD = framecrc -vsync 0 -i $(TARGET_SAMPLES)/hevc-conformance/$(1).bit -pix_fmt yuv420p
+fate-hevc-conformance-$(1)-slice-threads: REF = $(SRC_PATH)/tests/ref/fate/hevc-conformance-$(1)
+FATE_HEVC += fate-hevc-conformance-$(1)-slice-pool
+fate-hevc-conformance-$(1)-slice-pool: CMD = framecrc -slice_threads 2 -vsync 0 -i $(TARGET_SAMPLES)/hevc-conformance/$(1).bit -pix_fmt yuv420p
+fate-hevc-conformance-$(1)-slice-pool: REF = $(SRC_PATH)/tests/ref/fate/hevc-conformance-$(1)
+fate-hevc-conformance-$(1)-slice-threads fate-hevc-conformance-$(1)-slice-pool: THREADS = 4
+fate-hevc-conformance-$(1)-slice-threads fate-hevc-conformance-$(1)-slice-pool: THREAD_TYPE = slice
+endef
+
+$(foreach N,$(HEVC_SAMPLES_SLICE_THREADS),$(eval $(call FATE_HEVC_SLICE_THREADS_TEST,$(N))))
+
 fate-hevc-paramchange-yuv420p-yuv420p10: CMD = framecrc -vsync 0 -i $(TARGET_SAMPLES)/hevc/paramchange_yuv420p_yuv420p10.hevc
 FATE_HEVC += fate-hevc-paramchange-yuv420p-yuv420p10
 
@@ -0,0 +1,19 @@
+HLS_INPUT = -f rawvideo -s 352x288 -i $(TARGET_PATH)/tests/data/vsynth1.yuv \
+            -c:v mpeg4 -g 5 -flags +bitexact -fflags +bitexact
+
+FATE_HLS-$(call ALLYES, MPEG4_ENCODER HLS_MUXER MPEGTS_MUXER) += fate-hls-mpegts-parts
+fate-hls-mpegts-parts: CMD = playlist index.m3u8 $(HLS_INPUT) -f hls -hls_time 0.4 -hls_part_time 0.2 -hls_list_size 10
+
+FATE_HLS-$(call ALLYES, MPEG4_ENCODER HLS_MUXER MP4_MUXER) += fate-hls-fmp4
+fate-hls-fmp4: CMD = playlist index.m3u8 $(HLS_INPUT) -f hls -hls_segment_type fmp4 -hls_time 0.4
+
+FATE_HLS-$(call ALLYES, MPEG4_ENCODER HLS_MUXER MP4_MUXER) += fate-hls-fmp4-parts
+fate-hls-fmp4-parts: CMD = playlist index.m3u8 $(HLS_INPUT) -f hls -hls_segment_type fmp4 -hls_time 0.4 -hls_part_time 0.2
+
+FATE_HLS-$(call ALLYES, MPEG4_ENCODER DASH_MUXER MP4_MUXER) += fate-dash-hls-playlist
+fate-dash-hls-playlist: CMD = playlist index.mpd $(HLS_INPUT) -f dash -hls_playlist 1 -min_seg_duration 400000
+
+$(FATE_HLS-yes): tests/data/vsynth1.yuv
+
+FATE_AVCONV += $(FATE_HLS-yes)
+fate-hls: $(FATE_HLS-yes)
@@ -68,6 +68,11 @@ FATE_LIBAVUTIL += fate-sha
 fate-sha: libavutil/tests/sha$(EXESUF)
 fate-sha: CMD = run libavutil/tests/sha
 
+FATE_LIBAVUTIL-$(HAVE_THREADS) += fate-slicepool
+fate-slicepool: libavutil/tests/slicepool$(EXESUF)
+fate-slicepool: CMD = run libavutil/tests/slicepool
+fate-slicepool: CMP = null
+
 FATE_LIBAVUTIL += fate-tree
 fate-tree: libavutil/tests/tree$(EXESUF)
 fate-tree: CMD = run libavutil/tests/tree
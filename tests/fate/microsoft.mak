@@ -71,5 +71,37 @@ fate-vc1-ism: CMD = framecrc -i $(TARGET_SAMPLES)/isom/vc1-wmapro.ism -an
 FATE_SAMPLES_AVCONV-$(CONFIG_VC1_DECODER) += $(FATE_VC1-yes)
 fate-vc1: $(FATE_VC1-yes)
 
+# the tests above decoded again with frame threads, against the same references
+FATE_VC1_FRAME_THREADS-$(CONFIG_VC1_DEMUXER) += fate-vc1_sa00040-frame-threads
+fate-vc1_sa00040-frame-threads: CMD = framecrc -i $(TARGET_SAMPLES)/vc1/SA00040.vc1
+
+FATE_VC1_FRAME_THREADS-$(CONFIG_VC1_DEMUXER) += fate-vc1_sa00050-frame-threads
+fate-vc1_sa00050-frame-threads: CMD = framecrc -i $(TARGET_SAMPLES)/vc1/SA00050.vc1
+
+FATE_VC1_FRAME_THREADS-$(CONFIG_VC1_DEMUXER) += fate-vc1_sa10091-frame-threads
+fate-vc1_sa10091-frame-threads: CMD = framecrc -i $(TARGET_SAMPLES)/vc1/SA10091.vc1
+
+FATE_VC1_FRAME_THREADS-$(CONFIG_VC1_DEMUXER) += fate-vc1_sa10143-frame-threads
+fate-vc1_sa10143-frame-threads: CMD = framecrc -i $(TARGET_SAMPLES)/vc1/SA10143.vc1
+
+FATE_VC1_FRAME_THREADS-$(CONFIG_VC1_DEMUXER) += fate-vc1_sa20021-frame-threads
+fate-vc1_sa20021-frame-threads: CMD = framecrc -i $(TARGET_SAMPLES)/vc1/SA20021.vc1
+
+FATE_VC1_FRAME_THREADS-$(CONFIG_VC1_DEMUXER) += fate-vc1_ilaced_twomv-frame-threads
+fate-vc1_ilaced_twomv-frame-threads: CMD = framecrc -flags +bitexact -i $(TARGET_SAMPLES)/vc1/ilaced_twomv.vc1
+
+FATE_VC1_FRAME_THREADS-$(CONFIG_MOV_DEMUXER) += fate-vc1-ism-frame-threads
+fate-vc1-ism-frame-threads: CMD = framecrc -i $(TARGET_SAMPLES)/isom/vc1-wmapro.ism -an
+
+FATE_VC1_FRAME_THREADS-$(CONFIG_ASF_DEMUXER) += fate-wmv3-drm-dec-frame-threads
+fate-wmv3-drm-dec-frame-threads: CMD = framecrc -cryptokey 137381538c84c068111902a59c5cf6c340247c39 -i $(TARGET_SAMPLES)/wmv3/wmv_drm.wmv -an -frames:v 129
+
+$(FATE_VC1_FRAME_THREADS-yes): REF = $(SRC_PATH)/tests/ref/fate/$(@:fate-%-frame-threads=%)
+$(FATE_VC1_FRAME_THREADS-yes): THREADS = 4
+$(FATE_VC1_FRAME_THREADS-yes): THREAD_TYPE = frame
+
+FATE_SAMPLES_AVCONV-$(CONFIG_VC1_DECODER) += $(FATE_VC1_FRAME_THREADS-yes)
+fate-vc1-frame-threads: $(FATE_VC1_FRAME_THREADS-yes)
+
 FATE_SAMPLES_AVCONV-$(CONFIG_ASF_DEMUXER) += fate-asf-repldata
 fate-asf-repldata: CMD = framecrc -i $(TARGET_SAMPLES)/asf/bug821-2.asf -c copy
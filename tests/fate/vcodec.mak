@@ -59,7 +59,8 @@ fate-vsynth%-dv-50:              FMT     = dv
 FATE_VCODEC-$(call ENCDEC, FFV1, AVI)   += ffv1
 fate-vsynth%-ffv1:               ENCOPTS = -slices 4 -strict -2
 
-FATE_VCODEC-$(call ENCDEC, FFVHUFF, AVI) += ffvhuff
+FATE_VCODEC-$(call ENCDEC, FFVHUFF, AVI) += ffvhuff ffvhuff-slice-threads
+fate-vsynth%-ffvhuff-slice-threads: ENCOPTS = -threads 4 -thread_type slice
 
 FATE_VCODEC-$(call ENCDEC, FLASHSV, FLV) += flashsv
 fate-vsynth%-flashsv:            ENCOPTS = -sws_flags neighbor+full_chroma_int
@@ -82,6 +83,21 @@ FATE_VCODEC-$(call ENCDEC, HUFFYUV, AVI) += huffyuv
 fate-vsynth%-huffyuv:            ENCOPTS = -pix_fmt yuv422p -sws_flags neighbor
 fate-vsynth%-huffyuv:            DECOPTS = -strict -2 -sws_flags neighbor
 
+FATE_VCODEC-$(call ENCDEC, HUFFYUV, AVI) += huffyuv-slice-threads       \
+                                            huffyuv-bgra                \
+                                            huffyuv-bgra-slice-threads  \
+                                            huffyuv-rgb24               \
+                                            huffyuv-rgb24-slice-threads
+fate-vsynth%-huffyuv-slice-threads:       ENCOPTS = -pix_fmt yuv422p -sws_flags neighbor \
+                                                    -threads 4 -thread_type slice
+fate-vsynth%-huffyuv-bgra:                ENCOPTS = -pix_fmt bgra
+fate-vsynth%-huffyuv-bgra-slice-threads:  ENCOPTS = -pix_fmt bgra \
+                                                    -threads 4 -thread_type slice
+fate-vsynth%-huffyuv-rgb24:               ENCOPTS = -pix_fmt rgb24
+fate-vsynth%-huffyuv-rgb24-slice-threads: ENCOPTS = -pix_fmt rgb24 \
+                                                    -threads 4 -thread_type slice
+fate-vsynth%-huffyuv-slice-threads:       DECOPTS = -strict -2 -sws_flags neighbor
+
 FATE_VCODEC-$(call ENCDEC, JPEGLS, AVI) += jpegls
 fate-vsynth%-jpegls:             ENCOPTS = -sws_flags neighbor+full_chroma_int
 fate-vsynth%-jpegls:             DECOPTS = -sws_flags area
@@ -92,6 +108,19 @@ fate-vsynth%-ljpeg:              ENCOPTS = -strict -1
 FATE_VCODEC-$(call ENCDEC, MJPEG, AVI)  += mjpeg
 fate-vsynth%-mjpeg:              ENCOPTS = -qscale 9 -pix_fmt yuvj420p
 
+FATE_VCODEC-$(call ENCDEC, MJPEG, AVI)  += mjpeg-frame-threads        \
+                                           mjpeg-restart              \
+                                           mjpeg-restart-slice-threads
+fate-vsynth%-mjpeg-frame-threads:          ENCOPTS     = -qscale 9 -pix_fmt yuvj420p
+fate-vsynth%-mjpeg-frame-threads:          THREADS     = 4
+fate-vsynth%-mjpeg-frame-threads:          THREAD_TYPE = frame
+fate-vsynth%-mjpeg-restart:                ENCOPTS     = -qscale 9 -pix_fmt yuvj420p \
+                                                         -restart_rows 1
+fate-vsynth%-mjpeg-restart-slice-threads:  ENCOPTS     = -qscale 9 -pix_fmt yuvj420p \
+                                                         -restart_rows 1
+fate-vsynth%-mjpeg-restart-slice-threads:  THREADS     = 4
+fate-vsynth%-mjpeg-restart-slice-threads:  THREAD_TYPE = slice
+
 FATE_VCODEC-$(call ENCDEC, MPEG1VIDEO, MPEG1VIDEO MPEGVIDEO) += mpeg1 mpeg1b
 fate-vsynth%-mpeg1:              FMT     = mpeg1video
 fate-vsynth%-mpeg1:              CODEC   = mpeg1video
@@ -106,6 +135,8 @@ FATE_MPEG2 = mpeg2                                                      \
              mpeg2-idct-int                                             \
              mpeg2-ilace                                                \
              mpeg2-ivlc-qprd                                            \
+             mpeg2-lookahead                                            \
+             mpeg2-lookahead-vbv                                        \
              mpeg2-thread                                               \
              mpeg2-thread-ivlc
 
@@ -132,6 +163,11 @@ fate-vsynth%-mpeg2-ivlc-qprd:    ENCOPTS = -b:v 500k                    \
                                            -intra_vlc 1                 \
                                            -cmp 2 -subcmp 2             \
                                            -mbd rd
+fate-vsynth%-mpeg2-lookahead:    ENCOPTS = -qscale 10 -bf 3 -b_strategy 3 \
+                                           -lookahead 6
+fate-vsynth%-mpeg2-lookahead-vbv: ENCOPTS = -b:v 1000k -maxrate 1200k    \
+                                           -bufsize 800k -bf 3          \
+                                           -b_strategy 3 -lookahead 6
 fate-vsynth%-mpeg2-thread:       ENCOPTS = -qscale 10 -bf 2 -flags +ildct+ilme \
                                            -threads 2 -slices 2
 fate-vsynth%-mpeg2-thread-ivlc:  ENCOPTS = -qscale 10 -bf 2 -flags +ildct+ilme \
@@ -189,6 +225,14 @@ fate-vsynth%-msmpeg4:            ENCOPTS = -qscale 10
 FATE_VCODEC-$(call ENCDEC, MSMPEG4V2, AVI) += msmpeg4v2
 fate-vsynth%-msmpeg4v2:          ENCOPTS = -qscale 10
 
+FATE_VCODEC-$(call ENCDEC, PNG, AVI)    += png-frame-threads          \
+                                           png-slice-threads
+fate-vsynth%-png-frame-threads:  ENCOPTS     = -pix_fmt rgb24
+fate-vsynth%-png-frame-threads:  THREADS     = 4
+fate-vsynth%-png-frame-threads:  THREAD_TYPE = frame
+fate-vsynth%-png-slice-threads:  ENCOPTS     = -pix_fmt rgb24 -threads 4 \
+                                               -thread_type slice
+
 FATE_VCODEC-$(call ENCDEC, PRORES, MOV) += prores
 fate-vsynth%-prores:             ENCOPTS = -profile hq
 fate-vsynth%-prores:             FMT     = mov
@@ -217,6 +261,27 @@ FATE_VCODEC-$(call ENCDEC, SVQ1, MOV)   += svq1
 fate-vsynth%-svq1:               ENCOPTS = -qscale 3 -pix_fmt yuv410p
 fate-vsynth%-svq1:               FMT     = mov
 
+FATE_VCODEC-$(call ENCDEC, UTVIDEO, AVI) += utvideo-rgb24               \
+                                            utvideo-rgb24-slice-threads \
+                                            utvideo-rgba                \
+                                            utvideo-rgba-slice-threads  \
+                                            utvideo-yuv420p             \
+                                            utvideo-yuv420p-slice-threads \
+                                            utvideo-yuv422p             \
+                                            utvideo-yuv422p-slice-threads
+fate-vsynth%-utvideo-rgb24:                 ENCOPTS = -pix_fmt rgb24
+fate-vsynth%-utvideo-rgb24-slice-threads:   ENCOPTS = -pix_fmt rgb24 \
+                                                      -threads 4 -thread_type slice
+fate-vsynth%-utvideo-rgba:                  ENCOPTS = -pix_fmt rgba
+fate-vsynth%-utvideo-rgba-slice-threads:    ENCOPTS = -pix_fmt rgba \
+                                                      -threads 4 -thread_type slice
+fate-vsynth%-utvideo-yuv420p:               ENCOPTS = -pix_fmt yuv420p
+fate-vsynth%-utvideo-yuv420p-slice-threads: ENCOPTS = -pix_fmt yuv420p \
+                                                      -threads 4 -thread_type slice
+fate-vsynth%-utvideo-yuv422p:               ENCOPTS = -pix_fmt yuv422p
+fate-vsynth%-utvideo-yuv422p-slice-threads: ENCOPTS = -pix_fmt yuv422p \
+                                                      -threads 4 -thread_type slice
+
 FATE_VCODEC-$(call ENCDEC, V210, AVI)   += v210 v210-10
 fate-vsynth%-v210-10:            ENCOPTS = -pix_fmt yuv422p10
 
@@ -229,6 +294,14 @@ fate-vsynth%-wmv2:               ENCOPTS = -qscale 10
 FATE_VCODEC-$(call ENCDEC, RAWVIDEO, AVI) += yuv
 fate-vsynth%-yuv:                CODEC = rawvideo
 
+# the slice threaded encoders write the same files as the serial ones
+VCODEC_SLICE_THREADS = ffvhuff huffyuv huffyuv-bgra huffyuv-rgb24        \
+                       utvideo-rgb24 utvideo-rgba utvideo-yuv420p utvideo-yuv422p
+VSYNTH_SLICE_THREADS = $(VCODEC_SLICE_THREADS:%=fate-vsynth1-%-slice-threads) \
+                       $(VCODEC_SLICE_THREADS:%=fate-vsynth2-%-slice-threads)
+$(VSYNTH_SLICE_THREADS): REF_TEST = $(@:fate-%-slice-threads=%)
+$(VSYNTH_SLICE_THREADS): REF = $(SRC_PATH)/tests/ref/vsynth/$(REF_TEST)
+
 FATE_VCODEC += $(FATE_VCODEC-yes)
 FATE_VSYNTH1 = $(FATE_VCODEC:%=fate-vsynth1-%)
 FATE_VSYNTH2 = $(FATE_VCODEC:%=fate-vsynth2-%)